@@ -22,8 +22,12 @@
 #import <AlicloudHTTPDNS/HttpdnsLog.h>
 #import <AlicloudHTTPDNS/HttpdnsPublicConstant.h>
 #import <AlicloudHTTPDNS/HttpdnsService.h>
+#import <AlicloudHTTPDNS/HttpdnsSockaddr.h>
 #import <AlicloudHTTPDNS/HttpdnsRequest.h>
 #import <AlicloudHTTPDNS/HttpDnsResult.h>
+#import <AlicloudHTTPDNS/HttpdnsResolveTrace.h>
+#import <AlicloudHTTPDNS/HttpdnsStatistics.h>
+#import <AlicloudHTTPDNS/HttpdnsStartupMetrics.h>
 #import <AlicloudHTTPDNS/HttpdnsLoggerProtocol.h>
 #import <AlicloudHTTPDNS/HttpdnsDegradationDelegate.h>
 #import <AlicloudHTTPDNS/HttpdnsIpStackDetector.h>
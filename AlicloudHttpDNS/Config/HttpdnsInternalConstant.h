@@ -17,6 +17,45 @@ static const int HTTPDNS_PRE_RESOLVE_BATCH_SIZE = 5;
 
 static const int HTTPDNS_DEFAULT_REQUEST_TIMEOUT_INTERVAL = 3;
 
+// 开启持久化缓存后，启动时预加载到内存的最近更新记录数量，其余记录在首次访问时再从数据库读取
+static const int HTTPDNS_PERSISTENT_CACHE_PRELOAD_COUNT = 20;
+
+// 竞速建连时每个地址族参与竞速的排序靠前的地址数量
+static const NSUInteger HTTPDNS_CONNECTION_RACE_MAX_IPS_PER_FAMILY = 2;
+
+// 没有解析记录的地址族作为负缓存保存的默认时长（秒）
+static const int64_t HTTPDNS_DEFAULT_NEGATIVE_CACHE_TTL = 300;
+
+// 解析连续失败后的初始退避时长（秒），之后每次失败翻倍，不超过负缓存时长
+static const int64_t HTTPDNS_FAILURE_BACKOFF_BASE_INTERVAL = 2;
+static const int HTTPDNS_MAX_FAILURE_BACKOFF_SHIFT = 16;
+
+// 域名访问频率按指数衰减累计，经过一个半衰期后之前的访问次数减半（秒）
+static const NSTimeInterval HTTPDNS_HOST_ACCESS_HALF_LIFE = 24 * 60 * 60;
+
+// 最多跟踪的域名数量，超出时淘汰衰减后频率最低的域名
+static const NSUInteger HTTPDNS_HOST_ACCESS_MAX_TRACKED_COUNT = 256;
+
+// 超过该时长没有访问的域名不再自动预解析，也不再持久化（秒）
+static const NSTimeInterval HTTPDNS_HOST_ACCESS_RECENT_WINDOW = 3 * 24 * 60 * 60;
+
+// 某域名解析后该时长内解析的其他域名记为它的后继（秒）
+static const NSTimeInterval HTTPDNS_HOST_TRANSITION_WINDOW = 1;
+
+// 统计后继关系的源域名数量上限，以及每个源域名的后继数量上限
+static const NSUInteger HTTPDNS_HOST_TRANSITION_MAX_SOURCE_COUNT = 128;
+static const NSUInteger HTTPDNS_HOST_TRANSITION_MAX_SUCCESSOR_COUNT = 8;
+
+// 预测后继的最低转移概率和衰减后的最低出现次数
+static const double HTTPDNS_HOST_TRANSITION_MIN_PROBABILITY = 0.5;
+static const double HTTPDNS_HOST_TRANSITION_MIN_SCORE = 2;
+
+// 预测的域名在预解析后该时长内被解析计为命中（秒）
+static const NSTimeInterval HTTPDNS_PREDICTED_HOST_HIT_WINDOW = 30;
+
+// 预测的域名缓存在该时长内将过期时也一并刷新（秒）
+static const int64_t HTTPDNS_PREDICTED_HOST_REFRESH_AHEAD = 10;
+
 static const NSUInteger HTTPDNS_DEFAULT_AUTH_TIMEOUT_INTERVAL = 10 * 60;
 
 static NSString *const ALICLOUD_HTTPDNS_VALID_SERVER_CERTIFICATE_IP = @"203.107.1.1";
@@ -37,6 +76,8 @@ static NSString *const kAlicloudHttpdnsRegionConfigV6HostKey = @"service_ipv6";
 
 static NSString *const kAlicloudHttpdnsRegionKey = @"HttpdnsRegion";
 
+static NSString *const kAlicloudHttpdnsInstallationIdKey = @"HttpdnsInstallationId";
+
 #define SECONDS_OF_ONE_YEAR 365 * 24 * 60 * 60
 
 static NSString *const ALICLOUD_HTTPDNS_ERROR_DOMAIN = @"HttpdnsErrorDomain";
@@ -15,6 +15,7 @@
 #import "HttpdnsService.h"
 #import "HttpdnsUtil.h"
 #import "HttpdnsHostObject.h"
+#import "HttpdnsClock.h"
 
 @implementation HttpdnsLocalResolver
 
@@ -131,7 +132,7 @@
     [HttpdnsUtil processCustomTTL:hostObject forHost:host service:service];
 
     // 当前时间(自1970年以来的秒数)
-    int64_t now = (int64_t)[[NSDate date] timeIntervalSince1970];
+    int64_t now = HttpdnsClockCurrentEpoch();
 
     // 更新最后查询时间
     [hostObject setLastIPv4LookupTime:now];
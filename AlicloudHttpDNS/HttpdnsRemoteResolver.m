@@ -17,6 +17,7 @@
  * under the License.
  */
 #import "HttpdnsRequest.h"
+#import "HttpdnsRequest_Internal.h"
 #import "HttpdnsRemoteResolver.h"
 #import "HttpdnsUtil.h"
 #import "HttpdnsLog_Internal.h"
@@ -30,6 +31,9 @@
 #import "HttpdnsRequestManager.h"
 #import "HttpdnsIpStackDetector.h"
 #import "HttpdnsNWHTTPClient.h"
+#import "HttpdnsResolveTrace_Internal.h"
+#import "HttpdnsMetrics.h"
+#import "HttpdnsClock.h"
 #import <stdint.h>
 
 
@@ -130,7 +134,10 @@ static dispatch_queue_t _streamOperateSyncQueue = 0;
 
     if (mode == 1) {  // 只处理AES-CBC模式
         // 需要解密
+        HttpdnsResolveTrace *trace = [HttpdnsResolveTrace currentTrace];
+        uint64_t phaseStartTime = trace ? HttpdnsResolveTraceNow() : 0;
         data = [self decryptData:data withMode:mode];
+        [trace addSpanWithPhase:HttpdnsResolveTracePhaseDecrypt startTime:phaseStartTime];
     } else if (mode != 0) {
         // 不支持的加密模式（如AES-GCM）
         HttpdnsLogDebug("Unsupported encryption mode: %ld", (long)mode);
@@ -319,10 +326,10 @@ static dispatch_queue_t _streamOperateSyncQueue = 0;
     if (ttl) {
         if (isIPv6) {
             hostObject.v6ttl = [ttl longLongValue];
-            hostObject.lastIPv6LookupTime = [NSDate date].timeIntervalSince1970;
+            hostObject.lastIPv6LookupTime = HttpdnsClockNow();
         } else {
             hostObject.v4ttl = [ttl longLongValue];
-            hostObject.lastIPv4LookupTime = [NSDate date].timeIntervalSince1970;
+            hostObject.lastIPv4LookupTime = HttpdnsClockNow();
         }
     } else {
         if (isIPv6) {
@@ -408,7 +415,7 @@ static dispatch_queue_t _streamOperateSyncQueue = 0;
     [paramsToSign setObject:@"1.0" forKey:@"v"];
 
     // 域名参数，参与签名并加密
-    [paramsToEncrypt setObject:request.host forKey:@"dn"];
+    [paramsToEncrypt setObject:[request resolvingHostsString] forKey:@"dn"];
 
     // 查询类型，参与签名并加密
     [paramsToEncrypt setObject:[self getQueryTypeString:request.queryIpType] forKey:@"q"];
@@ -643,15 +650,20 @@ static dispatch_queue_t _streamOperateSyncQueue = 0;
 
     NSTimeInterval timeout = httpdnsService.timeoutInterval > 0 ? httpdnsService.timeoutInterval : 10.0;
     NSString *userAgent = [HttpdnsUtil generateUserAgent];
+    HttpdnsMetricsIncrement(HttpdnsMetricCounterNetworkRequest);
+    uint64_t requestStartTime = HttpdnsMetricsNow();
     HttpdnsNWHTTPClientResponse *httpResponse = [self.httpClient performRequestWithURLString:fullUrlStr
                                                                                     userAgent:userAgent
                                                                                       timeout:timeout
                                                                                         error:error];
+    HttpdnsMetricsRecordLatencySince(HttpdnsMetricHistogramNetworkRequest, requestStartTime);
     if (!httpResponse) {
+        HttpdnsMetricsIncrement(HttpdnsMetricCounterNetworkFailure);
         return nil;
     }
 
     if (httpResponse.statusCode != 200) {
+        HttpdnsMetricsIncrement(HttpdnsMetricCounterNetworkFailure);
         if (error) {
             NSString *errorMessage = [NSString stringWithFormat:@"Unsupported http status code: %ld", (long)httpResponse.statusCode];
             *error = [NSError errorWithDomain:ALICLOUD_HTTPDNS_ERROR_DOMAIN
@@ -661,8 +673,11 @@ static dispatch_queue_t _streamOperateSyncQueue = 0;
         return nil;
     }
 
+    HttpdnsResolveTrace *trace = [HttpdnsResolveTrace currentTrace];
+    uint64_t phaseStartTime = trace ? HttpdnsResolveTraceNow() : 0;
     NSError *jsonError = nil;
     id jsonValue = [NSJSONSerialization JSONObjectWithData:httpResponse.body options:kNilOptions error:&jsonError];
+    [trace addSpanWithPhase:HttpdnsResolveTracePhaseJSONParse startTime:phaseStartTime];
     if (jsonError) {
         if (error) {
             *error = jsonError;
@@ -18,12 +18,17 @@
  */
 
 #import <Foundation/Foundation.h>
+#import <sys/socket.h>
 #import "HttpdnsRequest.h"
 
 @class HttpDnsService;
 
 
 @class HttpdnsHostObject;
+@class HttpdnsResult;
+@class HttpdnsResolveTrace;
+@class HttpdnsResolveRecorder;
+@class HttpdnsStartupMetrics;
 
 @interface HttpdnsRequestManager : NSObject
 
@@ -31,6 +36,23 @@
 
 - (instancetype)initWithAccountId:(NSInteger)accountId ownerService:(HttpDnsService *)service;
 
+// 打开数据库、探测IP协议栈、启动网络状态监听，各阶段耗时记录到startupMetrics；需在performInitialization:deferred:的block中调用
+- (void)setUpComponentsWithStartupMetrics:(HttpdnsStartupMetrics *)startupMetrics;
+
+// 执行组件初始化，deferred为YES时在内部串行队列上异步执行；执行完成前发起的网络请求和数据库操作会等待其完成
+- (void)performInitialization:(dispatch_block_t)block deferred:(BOOL)deferred;
+
+- (BOOL)isInitialized;
+
+// 阻塞等待组件初始化完成，已完成时只有一次原子读的开销
+- (void)waitForInitialization;
+
+// 最多等待timeout秒，返回初始化是否已完成；用于有超时要求的解析路径
+- (BOOL)waitForInitializationWithTimeout:(NSTimeInterval)timeout;
+
+// 初始化已完成时直接执行，否则在初始化完成后于内部串行队列上执行
+- (void)performAfterInitialization:(dispatch_block_t)block;
+
 - (void)setExpiredIPEnabled:(BOOL)enable;
 
 - (void)setCachedIPEnabled:(BOOL)enable discardRecordsHasExpiredFor:(NSTimeInterval)duration;
@@ -39,6 +61,27 @@
 
 - (void)setPreResolveAfterNetworkChanged:(BOOL)enable;
 
+// 没有记录的地址族的负缓存时长，同时作为连续失败退避时长的上限
+- (void)setNegativeCacheTTL:(NSTimeInterval)ttl;
+
+// 经由完整解析流程、由负缓存直接应答的查询次数；命中不可变结果缓存的查询不计入
+- (NSUInteger)negativeCacheHitCount;
+
+// 处于失败退避期而没有发起请求的查询次数
+- (NSUInteger)failureBackoffHitCount;
+
+// 按采样率追踪完整解析流程中各阶段的耗时，追踪结束后在内部串行队列上回调；采样率为0或handler为nil时关闭
+- (void)setResolveTraceSampleRate:(double)sampleRate handler:(void (^)(HttpdnsResolveTrace *trace))handler;
+
+// 把之后的解析事件写入recorder，替换下来的recorder会被关闭；传nil停止记录
+- (void)setResolveRecorder:(HttpdnsResolveRecorder *)recorder;
+
+// 统计域名的衰减访问频率，开启时和网络切换后预解析最多maxHostCount个最近使用的热门域名
+- (void)setHotHostPrefetchEnabled:(BOOL)enable maxHostCount:(NSUInteger)maxHostCount;
+
+// 学习域名之间的先后关系，解析某域名时把大概率紧随其后、且缓存缺失或即将过期的域名一起批量解析
+- (void)setPredictivePreResolveEnabled:(BOOL)enable;
+
 - (void)preResolveHosts:(NSArray *)hosts queryType:(HttpdnsQueryIPType)queryType;
 
 - (HttpdnsHostObject *)resolveHost:(HttpdnsRequest *)request;
@@ -50,6 +93,23 @@
 
 - (void)cleanMemoryAndPersistentCacheOfAllHosts;
 
+// 应用侧建连的结果反馈到对应缓存的IP排序统计中，costTime为-1表示建连失败
+// 只累积样本，不改变顺序，一轮建连结束后调用commitConnectionCostsForCacheKey:统一排序
+- (void)reportConnectionCost:(NSInteger)costTime forIp:(NSString *)ip cacheKey:(NSString *)cacheKey;
+
+// 按累积的样本重新排序并落盘
+- (void)commitConnectionCostsForCacheKey:(NSString *)cacheKey;
+
+// 内存缓存中未过期时返回缓存中已构造结果的浅拷贝，缓存对象变化前重复调用不会重新构造IP数组；不可直接使用时返回nil
+- (HttpdnsResult *)memoizedResultForRequest:(HttpdnsRequest *)request builder:(HttpdnsResult * (^)(HttpdnsHostObject *hostObject))builder;
+
+// 只查内存缓存中未过期的结果并写入sockaddr数组，不创建Objective-C对象；不可直接使用时返回-1
+- (NSInteger)copyFreshSockaddrsForCacheKey:(const char *)cacheKey
+                               queryIpType:(HttpdnsQueryIPType)queryIpType
+                                      port:(uint16_t)port
+                                        to:(struct sockaddr_storage *)sockaddrs
+                                  maxCount:(NSUInteger)maxCount;
+
 
 #pragma mark - Expose to Testcases
 
@@ -63,4 +123,19 @@
 
 - (void)syncLoadCacheFromDbToMemory;
 
+- (NSInteger)memoryCacheCount;
+
+- (void)syncRebuildCacheSnapshot;
+
+- (void)syncPersistHostAccessRecords;
+
+// 按访问频率从高到低排列的待预解析域名
+- (NSArray<NSString *> *)hotHostsForPrefetch;
+
+// 等待已提交的异步解析任务执行完毕
+- (void)waitForAsyncResolveTasks;
+
+// 等待已提交的持久化缓存读写任务执行完毕
+- (void)waitForPersistentCacheTasks;
+
 @end
@@ -37,16 +37,39 @@
 #import "HttpdnsIPQualityDetector.h"
 #import "HttpdnsIpStackDetector.h"
 #import "HttpdnsDB.h"
+#import "HttpdnsCacheSnapshot.h"
+#import "HttpdnsResolveTrace_Internal.h"
+#import "HttpdnsMetrics.h"
+#import "HttpdnsClock.h"
+#import "HttpdnsResolveRecorder.h"
+#import "HttpdnsStartupMetrics_Internal.h"
+#import "HttpdnsHostAccessTracker.h"
+#import "HttpdnsHostTransitionPredictor.h"
+#import <UIKit/UIKit.h>
+#import <stdatomic.h>
 
 
 static dispatch_queue_t _persistentCacheConcurrentQueue = NULL;
 static dispatch_queue_t _asyncResolveHostQueue = NULL;
+static dispatch_queue_t _resolveTraceCallbackQueue = NULL;
+static dispatch_queue_t _initializationQueue = NULL;
 
 typedef struct {
     BOOL isResultUsable;
     BOOL isResolvingRequired;
 } HostObjectExamingResult;
 
+// 连续解析失败的退避状态
+@interface HttpdnsResolveFailureEntry : NSObject
+
+@property (nonatomic, assign) NSUInteger consecutiveFailures;
+@property (nonatomic, assign) int64_t retryNotBefore;
+
+@end
+
+@implementation HttpdnsResolveFailureEntry
+@end
+
 @interface HttpdnsRequestManager()
 
 @property (nonatomic, strong) dispatch_queue_t cacheQueue;
@@ -54,9 +77,16 @@ typedef struct {
 @property (nonatomic, weak) HttpDnsService *ownerService;
 
 @property (atomic, setter=setPersistentCacheIpEnabled:, assign) BOOL persistentCacheIpEnabled;
+// 过期超过该时长的持久化记录不再加载（秒）
+@property (atomic, assign) NSTimeInterval atomicDiscardExpiredDuration;
 @property (atomic, setter=setDegradeToLocalDNSEnabled:, assign) BOOL degradeToLocalDNSEnabled;
 @property (atomic, assign) BOOL atomicExpiredIPEnabled;
 @property (atomic, assign) BOOL atomicPreResolveAfterNetworkChanged;
+@property (atomic, assign) int64_t atomicNegativeCacheTTL;
+@property (atomic, assign) BOOL atomicHotHostPrefetchEnabled;
+@property (atomic, assign) NSUInteger atomicHotHostPrefetchCount;
+@property (atomic, assign) BOOL atomicPredictivePreResolveEnabled;
+@property (atomic, copy) void (^resolveTraceHandler)(HttpdnsResolveTrace *trace);
 
 @property (atomic, assign) NSTimeInterval lastUpdateTimestamp;
 @property (atomic, assign) HttpdnsNetworkStatus lastNetworkStatus;
@@ -66,6 +96,32 @@ typedef struct {
 @implementation HttpdnsRequestManager {
     HttpdnsHostObjectInMemoryCache *_hostObjectInMemoryCache;
     HttpdnsDB *_httpdnsDB;
+    // 数据库的mmap只读快照，冷启动时数据库尚未加载完成也能命中
+    HttpdnsCacheSnapshot *_cacheSnapshot;
+    // 数据库自上次生成快照后是否有变化，数据库队列、调用方线程和通知回调都会读写
+    atomic_bool _cacheSnapshotDirty;
+    // 已持久化但尚未加载到内存的cacheKey，内存未命中时据此决定是否回查数据库
+    NSMutableSet<NSString *> *_persistedCacheKeyIndex;
+    // 从数据库加载、尚未做过IP质量探测的cacheKey，首次被访问时再发起探测
+    NSMutableSet<NSString *> *_pendingQualityDetectionCacheKeys;
+    // 解析连续失败的cacheKey，退避期内不再发起请求
+    NSMutableDictionary<NSString *, HttpdnsResolveFailureEntry *> *_resolveFailureEntries;
+    atomic_ulong _negativeCacheHitCount;
+    atomic_ulong _failureBackoffHitCount;
+    // 追踪采样阈值，arc4random()的结果小于该值时采样，为0时不追踪
+    atomic_ullong _resolveTraceSampleThreshold;
+    // 是否在记录解析事件，未记录时热路径上不加锁读取_resolveRecorder
+    atomic_bool _resolveRecording;
+    HttpdnsResolveRecorder *_resolveRecorder;
+    // 数据库、IP协议栈探测等组件是否初始化完成，完成前网络请求和数据库操作在_initializationGroup上等待
+    atomic_bool _initialized;
+    dispatch_group_t _initializationGroup;
+    // 域名的衰减访问频率，只在开启热门域名自动预解析后统计
+    HttpdnsHostAccessTracker *_hostAccessTracker;
+    // 持久化的访问频率是否已合并到内存
+    BOOL _hostAccessRecordsLoaded;
+    // 域名之间的先后关系，只在开启预测预解析后统计
+    HttpdnsHostTransitionPredictor *_hostTransitionPredictor;
 }
 
 + (void)initialize {
@@ -73,6 +129,8 @@ typedef struct {
     dispatch_once(&onceToken, ^{
         _persistentCacheConcurrentQueue = dispatch_queue_create("com.alibaba.sdk.httpdns.persistentCacheOperationQueue", DISPATCH_QUEUE_CONCURRENT);
         _asyncResolveHostQueue = dispatch_queue_create("com.alibaba.sdk.httpdns.asyncResolveHostQueue", DISPATCH_QUEUE_CONCURRENT);
+        _resolveTraceCallbackQueue = dispatch_queue_create("com.alibaba.sdk.httpdns.resolveTraceCallbackQueue", DISPATCH_QUEUE_SERIAL);
+        _initializationQueue = dispatch_queue_create("com.alibaba.sdk.httpdns.initializationQueue", DISPATCH_QUEUE_SERIAL);
     });
 }
 
@@ -81,39 +139,117 @@ typedef struct {
         _accountId = accountId;
         _ownerService = service;
 
-        HttpdnsReachability *reachability = [HttpdnsReachability sharedInstance];
         self.atomicExpiredIPEnabled = NO;
         self.atomicPreResolveAfterNetworkChanged = NO;
+        self.atomicNegativeCacheTTL = HTTPDNS_DEFAULT_NEGATIVE_CACHE_TTL;
+        _resolveFailureEntries = [NSMutableDictionary dictionary];
+        atomic_init(&_negativeCacheHitCount, 0);
+        atomic_init(&_failureBackoffHitCount, 0);
+        atomic_init(&_resolveTraceSampleThreshold, 0);
+        atomic_init(&_resolveRecording, false);
+        atomic_init(&_initialized, false);
+        atomic_init(&_cacheSnapshotDirty, false);
+        _initializationGroup = dispatch_group_create();
         _hostObjectInMemoryCache = [[HttpdnsHostObjectInMemoryCache alloc] init];
-        _httpdnsDB = [[HttpdnsDB alloc] initWithAccountId:accountId];
-        [[HttpdnsIpStackDetector sharedInstance] redetectIpStack];
-
-        _lastNetworkStatus = reachability.currentReachabilityStatus;
-        _lastUpdateTimestamp = [NSDate date].timeIntervalSince1970;
+        NSString *snapshotPath = [[HttpdnsPersistenceUtils httpdnsDataDirectory] stringByAppendingPathComponent:[NSString stringWithFormat:@"%ld_v20250406.snapshot", (long)accountId]];
+        _cacheSnapshot = [[HttpdnsCacheSnapshot alloc] initWithPath:snapshotPath];
+        _persistedCacheKeyIndex = [NSMutableSet set];
+        _pendingQualityDetectionCacheKeys = [NSMutableSet set];
+        _hostAccessTracker = [[HttpdnsHostAccessTracker alloc] initWithHalfLife:HTTPDNS_HOST_ACCESS_HALF_LIFE
+                                                                maxTrackedCount:HTTPDNS_HOST_ACCESS_MAX_TRACKED_COUNT];
+        _hostTransitionPredictor = [[HttpdnsHostTransitionPredictor alloc] initWithHalfLife:HTTPDNS_HOST_ACCESS_HALF_LIFE
+                                                                             maxSourceCount:HTTPDNS_HOST_TRANSITION_MAX_SOURCE_COUNT
+                                                                          maxSuccessorCount:HTTPDNS_HOST_TRANSITION_MAX_SUCCESSOR_COUNT
+                                                                           transitionWindow:HTTPDNS_HOST_TRANSITION_WINDOW
+                                                                           predictionWindow:HTTPDNS_PREDICTED_HOST_HIT_WINDOW];
+        _lastUpdateTimestamp = HttpdnsClockNow();
 
         [[NSNotificationCenter defaultCenter] addObserver:self
-                                                 selector:@selector(handleReachabilityNotification:)
-                                                     name:kHttpdnsReachabilityChangedNotification
-                                                   object:reachability];
-        [reachability startNotifier];
+                                                 selector:@selector(handleEnterBackgroundNotification:)
+                                                     name:UIApplicationDidEnterBackgroundNotification
+                                                   object:nil];
     }
     return self;
 }
 
+- (void)setUpComponentsWithStartupMetrics:(HttpdnsStartupMetrics *)startupMetrics {
+    uint64_t phaseStartTime = HttpdnsMetricsNow();
+    _httpdnsDB = [[HttpdnsDB alloc] initWithAccountId:_accountId];
+    [startupMetrics recordPhase:HttpdnsStartupPhaseDatabaseOpen startTime:phaseStartTime];
+
+    phaseStartTime = HttpdnsMetricsNow();
+    [[HttpdnsIpStackDetector sharedInstance] redetectIpStack];
+    [startupMetrics recordPhase:HttpdnsStartupPhaseIpStackDetection startTime:phaseStartTime];
+
+    phaseStartTime = HttpdnsMetricsNow();
+    HttpdnsReachability *reachability = [HttpdnsReachability sharedInstance];
+    self.lastNetworkStatus = reachability.currentReachabilityStatus;
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(handleReachabilityNotification:)
+                                                 name:kHttpdnsReachabilityChangedNotification
+                                               object:reachability];
+    [reachability startNotifier];
+    [startupMetrics recordPhase:HttpdnsStartupPhaseReachabilityStart startTime:phaseStartTime];
+}
+
+- (void)performInitialization:(dispatch_block_t)block deferred:(BOOL)deferred {
+    if (!deferred) {
+        block();
+        atomic_store(&_initialized, true);
+        return;
+    }
+
+    dispatch_group_async(_initializationGroup, _initializationQueue, ^{
+        block();
+        atomic_store(&self->_initialized, true);
+    });
+}
+
+- (BOOL)isInitialized {
+    return atomic_load(&_initialized);
+}
+
+- (void)waitForInitialization {
+    if (atomic_load(&_initialized)) {
+        return;
+    }
+    dispatch_group_wait(_initializationGroup, DISPATCH_TIME_FOREVER);
+}
+
+- (BOOL)waitForInitializationWithTimeout:(NSTimeInterval)timeout {
+    if (atomic_load(&_initialized)) {
+        return YES;
+    }
+    dispatch_group_wait(_initializationGroup, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(MAX(timeout, 0) * NSEC_PER_SEC)));
+    return atomic_load(&_initialized);
+}
+
+- (void)performAfterInitialization:(dispatch_block_t)block {
+    if (atomic_load(&_initialized)) {
+        block();
+        return;
+    }
+    dispatch_group_notify(_initializationGroup, _initializationQueue, block);
+}
+
 - (void)setExpiredIPEnabled:(BOOL)enable {
     self.atomicExpiredIPEnabled = enable;
 }
 
 - (void)setCachedIPEnabled:(BOOL)enable discardRecordsHasExpiredFor:(NSTimeInterval)duration {
+    // 快照中的记录不经过数据库清理，加载时按同样的阈值过滤，需在开启前设置
+    self.atomicDiscardExpiredDuration = duration;
     // 开启允许持久化缓存
     [self setPersistentCacheIpEnabled:enable];
 
     if (enable) {
         dispatch_async(_persistentCacheConcurrentQueue, ^{
+            [self waitForInitialization];
+
             // 先清理过期时间超过阈值的缓存结果
-            [self->_httpdnsDB cleanRecordAlreadExpiredAt:[[NSDate date] timeIntervalSince1970] - duration];
+            [self->_httpdnsDB cleanRecordAlreadExpiredAt:HttpdnsClockNow() - duration];
 
-            // 再读取持久化缓存中的历史记录，加载到内存缓存里
+            // 再读取持久化缓存的索引和最近更新的记录，其余记录按需加载
             [self loadCacheFromDbToMemory];
         });
     }
@@ -123,6 +259,197 @@ typedef struct {
     self.atomicPreResolveAfterNetworkChanged = enable;
 }
 
+- (void)setNegativeCacheTTL:(NSTimeInterval)ttl {
+    self.atomicNegativeCacheTTL = ttl > 0 ? (int64_t)ttl : 0;
+}
+
+- (void)setHotHostPrefetchEnabled:(BOOL)enable maxHostCount:(NSUInteger)maxHostCount {
+    self.atomicHotHostPrefetchCount = MIN(maxHostCount, (NSUInteger)HTTPDNS_MAX_MANAGE_HOST_NUM);
+    self.atomicHotHostPrefetchEnabled = enable && maxHostCount > 0;
+    if (!self.atomicHotHostPrefetchEnabled) {
+        return;
+    }
+
+    // 合并上次运行持久化的访问频率后，立即预解析热门域名
+    dispatch_async(_persistentCacheConcurrentQueue, ^{
+        [self waitForInitialization];
+        [self loadHostAccessRecordsIfNeeded];
+        [self prefetchHotHostsWithReason:@"startup"];
+    });
+}
+
+- (void)loadHostAccessRecordsIfNeeded {
+    @synchronized (_hostAccessTracker) {
+        if (_hostAccessRecordsLoaded) {
+            return;
+        }
+        _hostAccessRecordsLoaded = YES;
+    }
+    NSArray<HttpdnsHostAccessRecord *> *records = [_httpdnsDB getAllHostAccessRecords];
+    [_hostAccessTracker mergeRecords:records];
+    HttpdnsLogDebug("Load host access records, count: %lu", (unsigned long)records.count);
+}
+
+- (NSArray<NSString *> *)hotHostsForPrefetch {
+    NSTimeInterval now = HttpdnsClockNow();
+    return [_hostAccessTracker hottestHostsWithLimit:self.atomicHotHostPrefetchCount
+                                       accessedSince:now - HTTPDNS_HOST_ACCESS_RECENT_WINDOW
+                                              atTime:now];
+}
+
+- (void)prefetchHotHostsWithReason:(NSString *)reason {
+    NSArray<NSString *> *hosts = [self hotHostsForPrefetch];
+    if (hosts.count == 0) {
+        return;
+    }
+    // 按访问频率从高到低排列，分批请求时热门域名先解析
+    HttpdnsLogDebug("Prefetch hot hosts on %@: %@", reason, hosts);
+    [self preResolveHosts:hosts queryType:HttpdnsQueryIPTypeAuto];
+}
+
+// 以域名为cacheKey、不带SDNS参数的标准解析；SDNS的结果依赖调用参数，不能以域名为cacheKey自动预解析或合并
+- (BOOL)isStandardHostRequest:(HttpdnsRequest *)request {
+    NSString *cacheKey = request.cacheKey;
+    if (cacheKey && ![cacheKey isEqualToString:request.host]) {
+        return NO;
+    }
+    return [HttpdnsUtil isEmptyDictionary:request.sdnsParams];
+}
+
+- (void)recordAccessForRequest:(HttpdnsRequest *)request {
+    if (!self.atomicHotHostPrefetchEnabled) {
+        return;
+    }
+    // 只统计标准解析，其他请求依赖调用参数，无法自动预解析
+    if (![self isStandardHostRequest:request]) {
+        return;
+    }
+    [_hostAccessTracker recordAccessForHost:request.host atTime:HttpdnsClockNow()];
+}
+
+- (void)setPredictivePreResolveEnabled:(BOOL)enable {
+    self.atomicPredictivePreResolveEnabled = enable;
+    if (!enable) {
+        [_hostTransitionPredictor removeAllTransitions];
+    }
+}
+
+// 只学习标准解析，预测出的域名同样以域名为cacheKey缓存；未开启或不适用时返回NO
+- (BOOL)recordTransitionAccessForRequest:(HttpdnsRequest *)request atTime:(NSTimeInterval)time {
+    if (!self.atomicPredictivePreResolveEnabled) {
+        return NO;
+    }
+    if (![self isStandardHostRequest:request]) {
+        return NO;
+    }
+    [_hostTransitionPredictor recordAccessForHost:request.host atTime:time];
+    return YES;
+}
+
+- (NSArray<NSString *> *)predictedHostsForRequest:(HttpdnsRequest *)request {
+    NSTimeInterval now = HttpdnsClockNow();
+    if (![self recordTransitionAccessForRequest:request atTime:now]) {
+        return nil;
+    }
+    return [self predictedSuccessorsOfHost:request.host queryIpType:request.queryIpType atTime:now blocking:request.isBlockingRequest];
+}
+
+// 不需要合并到本次请求时，只在调用线程记录访问，后继的查找和缓存检查放到后台执行
+- (void)preResolvePredictedHostsForRequest:(HttpdnsRequest *)request {
+    NSTimeInterval now = HttpdnsClockNow();
+    if (![self recordTransitionAccessForRequest:request atTime:now]) {
+        return;
+    }
+
+    NSString *host = request.host;
+    HttpdnsQueryIPType queryIpType = request.queryIpType;
+    __weak typeof(self) weakSelf = self;
+    dispatch_async(_asyncResolveHostQueue, ^{
+        __strong typeof(weakSelf) strongSelf = weakSelf;
+        if (!strongSelf) {
+            return;
+        }
+        [strongSelf preResolveHosts:[strongSelf predictedSuccessorsOfHost:host queryIpType:queryIpType atTime:now blocking:YES] queryType:queryIpType];
+    });
+}
+
+// blocking为NO时不在当前线程读数据库，只在内存中的后继视为已缓存
+- (NSArray<NSString *> *)predictedSuccessorsOfHost:(NSString *)host queryIpType:(HttpdnsQueryIPType)queryIpType atTime:(NSTimeInterval)now blocking:(BOOL)blocking {
+    // 和本次请求合并后不超过一批预解析的数量
+    NSArray<NSString *> *successors = [_hostTransitionPredictor likelySuccessorsOfHost:host
+                                                                                 limit:HTTPDNS_PRE_RESOLVE_BATCH_SIZE - 1
+                                                                        minProbability:HTTPDNS_HOST_TRANSITION_MIN_PROBABILITY
+                                                                              minScore:HTTPDNS_HOST_TRANSITION_MIN_SCORE
+                                                                                atTime:now];
+    if (successors.count == 0) {
+        return nil;
+    }
+
+    // 只预解析缓存中没有、或即将过期的后继；内存中已有可用结果时不读持久化缓存
+    int64_t refreshEpoch = HttpdnsClockCurrentEpoch() + HTTPDNS_PREDICTED_HOST_REFRESH_AHEAD;
+    NSMutableArray<NSString *> *predictedHosts = nil;
+    for (NSString *successor in successors) {
+        if ([_hostObjectInMemoryCache containsUnexpiredHostObjectForCacheKey:successor queryIpType:queryIpType atTime:refreshEpoch]) {
+            continue;
+        }
+        [self loadHostObjectFromPersistenceIfNeeded:successor blocking:blocking];
+        if ([_hostObjectInMemoryCache containsUnexpiredHostObjectForCacheKey:successor queryIpType:queryIpType atTime:refreshEpoch]) {
+            continue;
+        }
+        if (!predictedHosts) {
+            predictedHosts = [NSMutableArray array];
+        }
+        [predictedHosts addObject:successor];
+    }
+    if (!predictedHosts) {
+        return nil;
+    }
+
+    // 并发的请求可能预测出相同的域名，只预解析本次新标记的
+    NSArray<NSString *> *markedHosts = [_hostTransitionPredictor markPredictedHosts:predictedHosts atTime:now];
+    if (markedHosts.count == 0) {
+        return nil;
+    }
+    HttpdnsLogDebug("Predicted hosts after %@: %@", host, markedHosts);
+    return markedHosts;
+}
+
+- (NSUInteger)negativeCacheHitCount {
+    return atomic_load(&_negativeCacheHitCount);
+}
+
+- (NSUInteger)failureBackoffHitCount {
+    return atomic_load(&_failureBackoffHitCount);
+}
+
+- (void)setResolveTraceSampleRate:(double)sampleRate handler:(void (^)(HttpdnsResolveTrace *trace))handler {
+    uint64_t threshold = 0;
+    if (handler && sampleRate > 0) {
+        threshold = sampleRate >= 1 ? ((uint64_t)UINT32_MAX + 1) : (uint64_t)(sampleRate * ((double)UINT32_MAX + 1));
+    }
+    self.resolveTraceHandler = threshold > 0 ? handler : nil;
+    atomic_store(&_resolveTraceSampleThreshold, threshold);
+}
+
+- (void)setResolveRecorder:(HttpdnsResolveRecorder *)recorder {
+    HttpdnsResolveRecorder *previousRecorder;
+    @synchronized (self) {
+        previousRecorder = _resolveRecorder;
+        _resolveRecorder = recorder;
+        atomic_store(&_resolveRecording, recorder != nil);
+    }
+    [previousRecorder close];
+}
+
+- (HttpdnsResolveRecorder *)activeResolveRecorder {
+    if (!atomic_load_explicit(&_resolveRecording, memory_order_relaxed)) {
+        return nil;
+    }
+    @synchronized (self) {
+        return _resolveRecorder;
+    }
+}
+
 - (void)preResolveHosts:(NSArray *)hosts queryType:(HttpdnsQueryIPType)queryType {
     if (![HttpdnsUtil isNotEmptyArray:hosts]) {
         return;
@@ -174,6 +501,16 @@ typedef struct {
         return nil;
     }
 
+    HttpdnsResolveRecorder *recorder = [self activeResolveRecorder];
+    uint64_t recordStartTime = recorder ? HttpdnsMetricsNow() : 0;
+    [self recordAccessForRequest:request];
+
+    HttpdnsResolveTrace *trace = [self startTraceForRequest:request];
+    uint64_t phaseStartTime = trace ? HttpdnsResolveTraceNow() : 0;
+
+    // 内存中还没有、但快照或数据库中存在的记录，在这里按需加载；非阻塞请求不在调用线程读数据库
+    [self loadHostObjectFromPersistenceIfNeeded:cacheKey blocking:request.isBlockingRequest];
+
     HttpdnsHostObject *result = [_hostObjectInMemoryCache getHostObjectByCacheKey:cacheKey createIfNotExists:^id _Nonnull {
         HttpdnsLogDebug("No cache for cacheKey: %@", cacheKey);
         HttpdnsHostObject *newObject = [HttpdnsHostObject new];
@@ -182,62 +519,130 @@ typedef struct {
         newObject.v6Ips = @[];
         return newObject;
     }];
+    [trace addSpanWithPhase:HttpdnsResolveTracePhaseCacheLookup startTime:phaseStartTime];
+
+    // 从数据库加载的记录，在首次被访问时才发起IP质量探测
+    if ([self takePendingQualityDetectionCacheKey:cacheKey]) {
+        [self initiateQualityDetectionForHostObject:result forHost:host cacheKey:cacheKey];
+    }
 
     HostObjectExamingResult examingResult = [self examineHttpdnsHostObject:result underQueryType:request.queryIpType];
     BOOL isCachedResultUsable = examingResult.isResultUsable;
     BOOL isResolvingRequired = examingResult.isResolvingRequired;
 
+    if (isResolvingRequired && [self isResolvingBackedOffForCacheKey:cacheKey]) {
+        // 连续解析失败的域名在退避期内不发请求，有可用的缓存结果时照常返回
+        HttpdnsLogDebug("Resolving is backed off due to consecutive failures, cacheKey: %@", cacheKey);
+        atomic_fetch_add(&_failureBackoffHitCount, 1);
+        isResolvingRequired = NO;
+    }
+
+    // 双栈请求只重新解析过期的地址族，未过期的一半保留在缓存中，合并结果时不受影响
+    // 从DB加载的缓存合并后会整体视为新结果，因此仍然完整解析
+    HttpdnsRequest *resolvingRequest = request;
+    if (isResolvingRequired && result && ![result isLoadFromDB]) {
+        HttpdnsQueryIPType staleQueryIpType = [result staleQueryIpTypeUnderQueryIpType:request.queryIpType];
+        if (staleQueryIpType != 0 && staleQueryIpType != request.queryIpType) {
+            HttpdnsLogDebug("Partially refresh cacheKey: %@, queryType: %ld, staleQueryType: %ld", cacheKey, request.queryIpType, staleQueryIpType);
+            resolvingRequest = [request requestNarrowedToQueryIpType:staleQueryIpType];
+        }
+    }
+
+    // 预测接下来会解析的域名：本次需要发起请求时在这里预测，合并到同一个请求中；否则在后台预测并单独批量预解析
+    if (isResolvingRequired && resolvingRequest.queryIpType == request.queryIpType) {
+        NSArray<NSString *> *predictedHosts = [self predictedHostsForRequest:request];
+        if (predictedHosts) {
+            resolvingRequest = [resolvingRequest requestWithPredictedHosts:predictedHosts];
+        }
+    } else {
+        [self preResolvePredictedHostsForRequest:request];
+    }
+
     if (isCachedResultUsable) {
+        trace.cacheHit = YES;
+        HttpdnsMetricsIncrement(examingResult.isResolvingRequired ? HttpdnsMetricCounterStaleServe : HttpdnsMetricCounterCacheHit);
         if (isResolvingRequired) {
             // 缓存结果可用，但是需要请求，因为缓存结果已经过期
             // 这种情况异步去解析就可以了
-            [self determineResolvingHostNonBlocking:request];
+            [self determineResolvingHostNonBlocking:resolvingRequest trace:trace];
+        } else {
+            [self finishTrace:trace];
+        }
+        if (((request.queryIpType & HttpdnsQueryIPTypeIpv4) && result.hasNoIpv4Record)
+            || ((request.queryIpType & HttpdnsQueryIPTypeIpv6) && result.hasNoIpv6Record)) {
+            atomic_fetch_add(&_negativeCacheHitCount, 1);
         }
         // 缓存是以cacheKey为准，这里返回前，要把host替换成用户请求的这个
         result.hostName = host;
         HttpdnsLogDebug("Reuse available cache for cacheKey: %@, result: %@", cacheKey, result);
+        [recorder recordRequest:request
+                        outcome:(examingResult.isResolvingRequired ? HttpdnsResolveRecordOutcomeStale : HttpdnsResolveRecordOutcomeHit)
+                       answered:YES
+                       fastPath:NO
+                      startTime:recordStartTime];
         // 因为缓存结果可用，可以立即返回
         return result;
     }
 
+    HttpdnsMetricsIncrement(HttpdnsMetricCounterCacheMiss);
+
+    if (!isResolvingRequired) {
+        // 缓存结果不可用，又处于失败退避期内
+        [self finishTrace:trace];
+        [recorder recordRequest:request outcome:HttpdnsResolveRecordOutcomeMiss answered:NO fastPath:NO startTime:recordStartTime];
+        return nil;
+    }
+
     if (request.isBlockingRequest) {
         // 缓存结果不可用，且是同步请求，需要等待结果
-        return [self determineResolveHostBlocking:request];
+        HttpdnsHostObject *resolvedResult = [self determineResolveHostBlocking:resolvingRequest trace:trace];
+        [recorder recordRequest:request outcome:HttpdnsResolveRecordOutcomeMiss answered:(resolvedResult != nil) fastPath:NO startTime:recordStartTime];
+        return resolvedResult;
     } else {
         // 缓存结果不可用，且是异步请求，不需要等待结果
-        [self determineResolvingHostNonBlocking:request];
+        [self determineResolvingHostNonBlocking:resolvingRequest trace:trace];
+        [recorder recordRequest:request outcome:HttpdnsResolveRecordOutcomeMiss answered:NO fastPath:NO startTime:recordStartTime];
         return nil;
     }
 }
 
-- (void)determineResolvingHostNonBlocking:(HttpdnsRequest *)request {
+- (void)determineResolvingHostNonBlocking:(HttpdnsRequest *)request trace:(HttpdnsResolveTrace *)trace {
     dispatch_async(_asyncResolveHostQueue, ^{
         HttpDnsLocker *locker = [HttpDnsLocker sharedInstance];
         if ([locker tryLock:request.cacheKey queryType:request.queryIpType]) {
+            [HttpdnsResolveTrace setCurrentTrace:trace];
             @try {
                 [self executeRequest:request retryCount:0];
             } @catch (NSException *exception) {
                 HttpdnsLogDebug("determineResolvingHostNonBlocking host: %@, exception: %@", request.host, exception);
             } @finally {
+                [HttpdnsResolveTrace setCurrentTrace:nil];
                 [locker unlock:request.cacheKey queryType:request.queryIpType];
             }
         } else {
             HttpdnsLogDebug("determineResolvingHostNonBlocking skipped due to concurrent limitation, host: %@", request.host);
+            // 附带的预测域名不能随本次请求发出，改为单独预解析
+            [self preResolveHosts:request.predictedHosts queryType:request.queryIpType];
         }
+        [self finishTrace:trace];
     });
 }
 
-- (HttpdnsHostObject *)determineResolveHostBlocking:(HttpdnsRequest *)request {
+- (HttpdnsHostObject *)determineResolveHostBlocking:(HttpdnsRequest *)request trace:(HttpdnsResolveTrace *)trace {
     dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
     __block HttpdnsHostObject *result = nil;
     dispatch_async(_asyncResolveHostQueue, ^{
         HttpDnsLocker *locker = [HttpDnsLocker sharedInstance];
+        [HttpdnsResolveTrace setCurrentTrace:trace];
         @try {
+            uint64_t phaseStartTime = trace ? HttpdnsResolveTraceNow() : 0;
             [locker lock:request.cacheKey queryType:request.queryIpType];
+            [trace addSpanWithPhase:HttpdnsResolveTracePhaseLockWait startTime:phaseStartTime];
 
             result = [self->_hostObjectInMemoryCache getHostObjectByCacheKey:request.cacheKey];
             if (result && ![result isExpiredUnderQueryIpType:request.queryIpType]) {
                 // 存在且未过期，意味着其他线程已经解析到了新的结果
+                [self preResolveHosts:request.predictedHosts queryType:request.queryIpType];
                 return;
             }
 
@@ -245,8 +650,10 @@ typedef struct {
         } @catch (NSException *exception) {
             HttpdnsLogDebug("determineResolveHostBlocking host: %@, exception: %@", request.host, exception);
         } @finally {
+            [HttpdnsResolveTrace setCurrentTrace:nil];
             [locker unlock:request.cacheKey queryType:request.queryIpType];
             dispatch_semaphore_signal(semaphore);
+            [self finishTrace:trace];
         }
     });
     dispatch_semaphore_wait(semaphore, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(request.resolveTimeoutInSecond * NSEC_PER_SEC)));
@@ -286,6 +693,9 @@ typedef struct {
 
     BOOL isDegradationResult = NO;
 
+    // 调度配置加载完成前没有可用的服务IP
+    [self waitForInitialization];
+
     if (hasRetryedCount <= HTTPDNS_MAX_REQUEST_RETRY_TIME) {
         HttpdnsLogDebug("Internal request starts, host: %@, request: %@", host, request);
 
@@ -300,27 +710,41 @@ typedef struct {
 
             // 确保一定的重试间隔
             hasRetryedCount++;
-            [NSThread sleepForTimeInterval:hasRetryedCount * 0.25];
+            HttpdnsMetricsIncrement(HttpdnsMetricCounterNetworkRetry);
+            HttpdnsClockSleep(hasRetryedCount * 0.25);
 
             return [self executeRequest:request retryCount:hasRetryedCount];
         }
 
         if ([HttpdnsUtil isEmptyArray:resultArray]) {
             HttpdnsLogDebug("Internal request get empty result array, host: %@", host);
+            [self recordResolveFailureForCacheKey:cacheKey];
             return nil;
         }
 
-        // 这个路径里，host只会有一个，所以直接取第一个处理就行
-        result = resultArray.firstObject;
+        if (request.predictedHosts.count == 0) {
+            // 这个路径里，host只会有一个，所以直接取第一个处理就行
+            result = resultArray.firstObject;
+        } else {
+            result = [self mergePredictedResults:resultArray forHost:host underQueryIpType:queryIPType];
+            if (!result) {
+                HttpdnsLogDebug("Internal request get no result for host: %@, predictedHosts: %@", host, request.predictedHosts);
+                [self recordResolveFailureForCacheKey:cacheKey];
+                return nil;
+            }
+        }
     } else {
         if (!self.degradeToLocalDNSEnabled) {
             HttpdnsLogDebug("Internal remote request retry count exceed limit, host: %@", host);
+            [self recordResolveFailureForCacheKey:cacheKey];
             return nil;
         }
 
+        HttpdnsMetricsIncrement(HttpdnsMetricCounterLocalDegradation);
         result = [[HttpdnsLocalResolver new] resolve:request];
         if (!result) {
             HttpdnsLogDebug("Fallback to local dns resolver, but still get no result, host: %@", host);
+            [self recordResolveFailureForCacheKey:cacheKey];
             return nil;
         }
 
@@ -331,11 +755,27 @@ typedef struct {
                     host, cacheKey, isDegradationResult, result);
 
     // merge之后，返回的应当是存储在缓存中的实际对象，而非请求过程中构造出来的对象
+    HttpdnsResolveTrace *trace = [HttpdnsResolveTrace currentTrace];
+    uint64_t phaseStartTime = trace ? HttpdnsResolveTraceNow() : 0;
     HttpdnsHostObject *lookupResult = [self mergeLookupResultToManager:result host:host cacheKey:cacheKey underQueryIpType:queryIPType];
+    [trace addSpanWithPhase:HttpdnsResolveTracePhaseMerge startTime:phaseStartTime];
     // 返回一个快照，避免进行中的一些缓存调整影响返回去的结果
     return [lookupResult copy];
 }
 
+// 预测的域名以域名为cacheKey写入缓存，返回请求的host对应的结果
+- (HttpdnsHostObject *)mergePredictedResults:(NSArray<HttpdnsHostObject *> *)resultArray forHost:(NSString *)host underQueryIpType:(HttpdnsQueryIPType)queryIpType {
+    HttpdnsHostObject *hostResult = nil;
+    for (HttpdnsHostObject *result in resultArray) {
+        if (!hostResult && [result.hostName caseInsensitiveCompare:host] == NSOrderedSame) {
+            hostResult = result;
+            continue;
+        }
+        [self mergeLookupResultToManager:result host:result.hostName cacheKey:result.hostName underQueryIpType:queryIpType];
+    }
+    return hostResult;
+}
+
 - (void)executePreResolveRequest:(HttpdnsRequest *)request retryCount:(int)hasRetryedCount {
     NSString *host = request.host;
     HttpdnsQueryIPType queryIPType = request.queryIpType;
@@ -347,6 +787,8 @@ typedef struct {
         return;
     }
 
+    [self waitForInitialization];
+
     HttpdnsLogDebug("PreResolve request starts, host: %@, request: %@", host, request);
 
     NSError *error = nil;
@@ -360,7 +802,8 @@ typedef struct {
 
         // 确保一定的重试间隔
         hasRetryedCount++;
-        [NSThread sleepForTimeInterval:hasRetryedCount * 0.25];
+        HttpdnsMetricsIncrement(HttpdnsMetricCounterNetworkRetry);
+        HttpdnsClockSleep(hasRetryedCount * 0.25);
 
         // 预解析重试需保持“多域名预解析”的语义，不能误用单域名执行路径
         [self executePreResolveRequest:request retryCount:hasRetryedCount];
@@ -392,19 +835,26 @@ typedef struct {
     NSArray<HttpdnsIpObject *> *v6IpObjects = [result getV6Ips];
     NSString* extra = [result getExtra];
 
-    BOOL hasNoIpv4Record = NO;
-    BOOL hasNoIpv6Record = NO;
-    if (queryIpType & HttpdnsQueryIPTypeIpv4 && [HttpdnsUtil isEmptyArray:v4IpObjects]) {
-        hasNoIpv4Record = YES;
+    HttpdnsHostObject *cachedHostObject = [_hostObjectInMemoryCache getHostObjectByCacheKey:cacheKey];
+
+    // 只查询了一个地址族时，另一个地址族的记录状态沿用缓存中的
+    BOOL hasNoIpv4Record = cachedHostObject ? cachedHostObject.hasNoIpv4Record : NO;
+    BOOL hasNoIpv6Record = cachedHostObject ? cachedHostObject.hasNoIpv6Record : NO;
+    if (queryIpType & HttpdnsQueryIPTypeIpv4) {
+        hasNoIpv4Record = [HttpdnsUtil isEmptyArray:v4IpObjects];
     }
-    if (queryIpType & HttpdnsQueryIPTypeIpv6 && [HttpdnsUtil isEmptyArray:v6IpObjects]) {
-        hasNoIpv6Record = YES;
+    if (queryIpType & HttpdnsQueryIPTypeIpv6) {
+        hasNoIpv6Record = [HttpdnsUtil isEmptyArray:v6IpObjects];
     }
 
-    HttpdnsHostObject *cachedHostObject = [_hostObjectInMemoryCache getHostObjectByCacheKey:cacheKey];
     if (!cachedHostObject) {
         HttpdnsLogDebug("Create new hostObject for cache, cacheKey: %@, host: %@", cacheKey, host);
         cachedHostObject = [[HttpdnsHostObject alloc] init];
+    } else {
+        // 新结果中仍然存在的IP沿用之前累积的探测统计，排序不必从头开始
+        [result inheritIpQualityFrom:cachedHostObject];
+        v4IpObjects = [result getV4Ips];
+        v6IpObjects = [result getV6Ips];
     }
 
     [cachedHostObject setCacheKey:cacheKey];
@@ -427,6 +877,20 @@ typedef struct {
         [cachedHostObject setLastIPv6LookupTime:result.lastIPv6LookupTime];
     }
 
+    // 查询了但没有记录的地址族写入负缓存，有效期内不再重复请求
+    HttpdnsQueryIPType noRecordQueryIpType = 0;
+    if ((queryIpType & HttpdnsQueryIPTypeIpv4) && hasNoIpv4Record) {
+        noRecordQueryIpType |= HttpdnsQueryIPTypeIpv4;
+    }
+    if ((queryIpType & HttpdnsQueryIPTypeIpv6) && hasNoIpv6Record) {
+        noRecordQueryIpType |= HttpdnsQueryIPTypeIpv6;
+    }
+    if (noRecordQueryIpType != 0) {
+        [cachedHostObject markNoRecordUnderQueryIpType:noRecordQueryIpType
+                                                   ttl:self.atomicNegativeCacheTTL
+                                                atTime:HttpdnsClockCurrentEpoch()];
+    }
+
     if ([HttpdnsUtil isNotEmptyString:extra]) {
         [cachedHostObject setExtra:extra];
     }
@@ -438,16 +902,31 @@ typedef struct {
 
     [self persistToDB:cacheKey hostObject:cachedHostObject];
 
-    NSArray *ipv4StrArray = [cachedHostObject getV4IpStrings];
+    // 已拿到新结果，数据库里的旧记录无需再加载，也无需再做延迟探测
+    [self removePersistedCacheKey:cacheKey];
+    [self clearResolveFailureForCacheKey:cacheKey];
+    [self takePendingQualityDetectionCacheKey:cacheKey];
+
+    [self initiateQualityDetectionForHostObject:cachedHostObject forHost:host cacheKey:cacheKey];
+    return cachedHostObject;
+}
+
+- (void)initiateQualityDetectionForHostObject:(HttpdnsHostObject *)hostObject forHost:(NSString *)host cacheKey:(NSString *)cacheKey {
+    // v4、v6作为同一轮探测，全部完成后统一排序
+    NSMutableArray<NSString *> *ipArray = [NSMutableArray array];
+    NSArray *ipv4StrArray = [hostObject getV4IpStrings];
     if ([HttpdnsUtil isNotEmptyArray:ipv4StrArray]) {
-        [self initiateQualityDetectionForIP:ipv4StrArray forHost:host cacheKey:cacheKey];
+        [ipArray addObjectsFromArray:ipv4StrArray];
     }
 
-    NSArray *ipv6StrArray = [cachedHostObject getV6IpStrings];
+    NSArray *ipv6StrArray = [hostObject getV6IpStrings];
     if ([HttpdnsUtil isNotEmptyArray:ipv6StrArray]) {
-        [self initiateQualityDetectionForIP:ipv6StrArray forHost:host cacheKey:cacheKey];
+        [ipArray addObjectsFromArray:ipv6StrArray];
+    }
+
+    if ([HttpdnsUtil isNotEmptyArray:ipArray]) {
+        [self initiateQualityDetectionForIP:ipArray forHost:host cacheKey:cacheKey];
     }
-    return cachedHostObject;
 }
 
 - (void)initiateQualityDetectionForIP:(NSArray *)ipArray forHost:(NSString *)host cacheKey:(NSString *)cacheKey {
@@ -457,14 +936,101 @@ typedef struct {
         return;
     }
     NSNumber *port = [dataSource objectForKey:host];
+
+    // 每个样本只累积统计，整轮结束后再排序一次，避免单个样本先到先排导致顺序抖动
+    // 检测器对每次调度都恰好回调一次，enter与leave一一对应，否则本轮永远不会结束
+    dispatch_group_t probeRound = dispatch_group_create();
     for (NSString *ip in ipArray) {
+        if ([HttpdnsUtil isEmptyString:ip]) {
+            continue;
+        }
+        dispatch_group_enter(probeRound);
         [[HttpdnsIPQualityDetector sharedInstance] scheduleIPQualityDetection:cacheKey
                                                                            ip:ip
                                                                          port:port
                                                                      callback:^(NSString * _Nonnull cacheKey, NSString * _Nonnull ip, NSInteger costTime) {
-            [self->_hostObjectInMemoryCache updateQualityForCacheKey:cacheKey forIp:ip withConnectedRT:costTime];
+            [self->_hostObjectInMemoryCache recordQualitySampleForCacheKey:cacheKey forIp:ip withConnectedRT:costTime];
+            dispatch_group_leave(probeRound);
         }];
     }
+
+    dispatch_group_notify(probeRound, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        [self->_hostObjectInMemoryCache rerankIpsForCacheKey:cacheKey];
+        HttpdnsHostObject *rankedHostObject = [self->_hostObjectInMemoryCache getHostObjectByCacheKey:cacheKey];
+        if (rankedHostObject) {
+            [self persistToDB:cacheKey hostObject:rankedHostObject];
+        }
+    });
+}
+
+- (void)reportConnectionCost:(NSInteger)costTime forIp:(NSString *)ip cacheKey:(NSString *)cacheKey {
+    if ([HttpdnsUtil isEmptyString:cacheKey] || [HttpdnsUtil isEmptyString:ip]) {
+        return;
+    }
+
+    // 真实建连的结果与后台探测样本同等对待，同一轮竞速的样本累积后再统一排序
+    [_hostObjectInMemoryCache recordQualitySampleForCacheKey:cacheKey forIp:ip withConnectedRT:costTime];
+}
+
+- (void)commitConnectionCostsForCacheKey:(NSString *)cacheKey {
+    if ([HttpdnsUtil isEmptyString:cacheKey]) {
+        return;
+    }
+
+    [_hostObjectInMemoryCache rerankIpsForCacheKey:cacheKey];
+    HttpdnsHostObject *hostObject = [_hostObjectInMemoryCache getHostObjectByCacheKey:cacheKey];
+    if (hostObject) {
+        [self persistToDB:cacheKey hostObject:hostObject];
+    }
+}
+
+- (HttpdnsResult *)memoizedResultForRequest:(HttpdnsRequest *)request builder:(HttpdnsResult * (^)(HttpdnsHostObject *hostObject))builder {
+    HttpdnsResolveRecorder *recorder = [self activeResolveRecorder];
+    uint64_t recordStartTime = recorder ? HttpdnsMetricsNow() : 0;
+    HttpdnsResult *result = [_hostObjectInMemoryCache memoizedResultForCacheKey:request.cacheKey
+                                                                    queryIpType:request.queryIpType
+                                                                           host:request.host
+                                                                         atTime:HttpdnsClockCurrentEpoch()
+                                                                        builder:builder];
+    // 未命中时调用方会继续走resolveHost，由那里计数和记录
+    if (result) {
+        HttpdnsMetricsIncrement(HttpdnsMetricCounterCacheHit);
+        [recorder recordRequest:request outcome:HttpdnsResolveRecordOutcomeHit answered:YES fastPath:YES startTime:recordStartTime];
+        [self recordAccessForRequest:request];
+        [self preResolvePredictedHostsForRequest:request];
+    }
+    return result;
+}
+
+- (NSInteger)copyFreshSockaddrsForCacheKey:(const char *)cacheKey
+                               queryIpType:(HttpdnsQueryIPType)queryIpType
+                                      port:(uint16_t)port
+                                        to:(struct sockaddr_storage *)sockaddrs
+                                  maxCount:(NSUInteger)maxCount {
+    HttpdnsResolveRecorder *recorder = [self activeResolveRecorder];
+    uint64_t recordStartTime = recorder ? HttpdnsMetricsNow() : 0;
+    NSInteger count = [_hostObjectInMemoryCache copyFreshSockaddrsForCacheKey:cacheKey
+                                                                  queryIpType:queryIpType
+                                                                         port:port
+                                                                       atTime:HttpdnsClockCurrentEpoch()
+                                                                           to:sockaddrs
+                                                                     maxCount:maxCount];
+    if (count >= 0) {
+        HttpdnsMetricsIncrement(HttpdnsMetricCounterCacheHit);
+        if (self.atomicHotHostPrefetchEnabled) {
+            [_hostAccessTracker recordAccessForHostHash:HttpdnsResolveRecordHostHash(cacheKey) atTime:HttpdnsClockNow()];
+        }
+        if (self.atomicPredictivePreResolveEnabled) {
+            // 快速路径不创建对象，只更新后继统计和预测命中，不发起预测
+            [_hostTransitionPredictor recordAccessForHostHash:HttpdnsResolveRecordHostHash(cacheKey) atTime:HttpdnsClockNow()];
+        }
+        [recorder recordHostHash:HttpdnsResolveRecordHostHash(cacheKey)
+                     queryIpType:queryIpType
+                         outcome:HttpdnsResolveRecordOutcomeHit
+                           flags:(HttpdnsResolveRecordFlagAnswered | HttpdnsResolveRecordFlagFastPath)
+                       startTime:recordStartTime];
+    }
+    return count;
 }
 
 - (BOOL)isHostsNumberLimitReached {
@@ -485,11 +1051,11 @@ typedef struct {
 
     // 重新检测协议栈代价小，所以只要网络切换就发起检测
     // 但考虑到网络切换后不稳定，还是延迟1秒才发起
-    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(1 * NSEC_PER_SEC)), dispatch_get_global_queue(0, 0), ^{
+    HttpdnsClockDispatchAfter(1, dispatch_get_global_queue(0, 0), ^{
         [[HttpdnsIpStackDetector sharedInstance] redetectIpStack];
     });
 
-    NSTimeInterval currentTimestamp = [NSDate date].timeIntervalSince1970;
+    NSTimeInterval currentTimestamp = HttpdnsClockNow();
     BOOL statusChanged = (_lastNetworkStatus != currentStatus);
 
     // 仅在以下情况下响应网络变化去尝试更新缓存:
@@ -500,9 +1066,15 @@ typedef struct {
         HttpdnsLogDebug("Processing network change: oldStatus: %ld, newStatus: %ld(%@), elapsedTime=%.2f seconds",
                         _lastNetworkStatus, currentStatus, currentStatusString, elapsedTime);
 
+        // 探测结果与所在网络相关，切换后全部重新探测
+        [[HttpdnsIPQualityDetector sharedInstance] removeAllProbeResults];
+
+        // 之前的解析失败可能由网络引起，切换后不再退避
+        [self clearAllResolveFailures];
+
         // 更新调度
         // 网络在切换过程中可能不稳定，所以发送请求前等待2秒
-        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(2.0 * NSEC_PER_SEC)), dispatch_get_global_queue(0, 0), ^{
+        HttpdnsClockDispatchAfter(2.0, dispatch_get_global_queue(0, 0), ^{
             HttpdnsScheduleCenter *scheduleCenter = self.ownerService.scheduleCenter;
             [scheduleCenter asyncUpdateRegionScheduleConfig];
         });
@@ -526,13 +1098,16 @@ typedef struct {
 
         // 预解析
         // 网络在切换过程中可能不稳定，所以在清理缓存和发送请求前等待3秒
-        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(3.0 * NSEC_PER_SEC)), dispatch_get_global_queue(0, 0), ^{
+        HttpdnsClockDispatchAfter(3.0, dispatch_get_global_queue(0, 0), ^{
             // 仅清理“hostName 键”的缓存，保留 SDNS 等自定义 cacheKey 的记录
             for (NSString *host in hostArray) {
                 [self->_hostObjectInMemoryCache removeHostObjectByCacheKey:host];
             }
 
-            if (self.atomicPreResolveAfterNetworkChanged && hostArray.count > 0) {
+            if (self.atomicHotHostPrefetchEnabled) {
+                // 只预解析最近仍在使用的热门域名，不再按缓存中的全部条目重新解析
+                [self prefetchHotHostsWithReason:@"network change"];
+            } else if (self.atomicPreResolveAfterNetworkChanged && hostArray.count > 0) {
                 HttpdnsLogDebug("Network changed, pre resolve for host-key entries: %@", hostArray);
                 [self preResolveHosts:hostArray queryType:HttpdnsQueryIPTypeAuto];
             }
@@ -561,52 +1136,227 @@ typedef struct {
 #pragma mark - Flag for Disable and Sniffer Method
 
 - (void)loadCacheFromDbToMemory {
-    NSArray<HttpdnsHostRecord *> *hostRecords = [self->_httpdnsDB getAllRecords];
-
-    if ([HttpdnsUtil isEmptyArray:hostRecords]) {
+    // 启动时只加载缓存键索引和最近更新的少量记录，避免一次性构造所有记录对象
+    NSArray<NSString *> *cacheKeys = [self->_httpdnsDB getAllCacheKeys];
+    if ([HttpdnsUtil isEmptyArray:cacheKeys]) {
         return;
     }
 
+    @synchronized (_persistedCacheKeyIndex) {
+        [_persistedCacheKeyIndex addObjectsFromArray:cacheKeys];
+    }
+
+    NSArray<HttpdnsHostRecord *> *hostRecords = [self->_httpdnsDB getRecentlyModifiedRecordsWithLimit:HTTPDNS_PERSISTENT_CACHE_PRELOAD_COUNT];
     for (HttpdnsHostRecord *hostRecord in hostRecords) {
-        NSString *hostName = hostRecord.hostName;
-        NSString *cacheKey = hostRecord.cacheKey;
+        [self loadHostRecordToMemory:hostRecord];
+    }
+
+    HttpdnsLogDebug("Load persistent cache index, total: %lu, preloaded: %lu", (unsigned long)cacheKeys.count, (unsigned long)hostRecords.count);
+}
+
+- (void)loadHostObjectFromPersistenceIfNeeded:(NSString *)cacheKey {
+    [self loadHostObjectFromPersistenceIfNeeded:cacheKey blocking:YES];
+}
+
+// blocking为NO时，快照未命中后在后台读取数据库，本次按缓存未命中处理
+- (void)loadHostObjectFromPersistenceIfNeeded:(NSString *)cacheKey blocking:(BOOL)blocking {
+    if (!_persistentCacheIpEnabled) {
+        return;
+    }
+
+    // 优先从映射的快照中读取，不依赖数据库是否已打开和加载
+    // 每个缓存键只从快照读取一次，和_persistedCacheKeyIndex一样，避免网络切换等从内存移除之后又被旧结果恢复
+    if (![_hostObjectInMemoryCache containsCacheKey:cacheKey]) {
+        HttpdnsHostRecord *snapshotRecord = [_cacheSnapshot recordForCacheKey:cacheKey];
+        if (snapshotRecord) {
+            [_cacheSnapshot removeRecordForCacheKey:cacheKey];
+            if (![self isHostRecordDiscarded:snapshotRecord]) {
+                HttpdnsLogDebug("Load persistent cache from snapshot, cacheKey: %@", cacheKey);
+                [self loadHostRecordToMemory:snapshotRecord];
+                return;
+            }
+            // 快照可能比数据库旧，丢弃后仍按索引回查数据库
+            HttpdnsLogDebug("Discard expired snapshot record, cacheKey: %@", cacheKey);
+        }
+    }
+
+    if (![self removePersistedCacheKey:cacheKey]) {
+        return;
+    }
+
+    if (blocking) {
+        [self loadHostRecordFromDBForCacheKey:cacheKey];
+        return;
+    }
+
+    __weak typeof(self) weakSelf = self;
+    dispatch_async(_persistentCacheConcurrentQueue, ^{
+        [weakSelf loadHostRecordFromDBForCacheKey:cacheKey];
+    });
+}
+
+- (void)loadHostRecordFromDBForCacheKey:(NSString *)cacheKey {
+    HttpdnsHostRecord *hostRecord = [_httpdnsDB selectByCacheKey:cacheKey];
+    if (!hostRecord) {
+        return;
+    }
+
+    HttpdnsLogDebug("Load persistent cache on demand, cacheKey: %@", cacheKey);
+    [self loadHostRecordToMemory:hostRecord];
+}
+
+// 与数据库的cleanRecordAlreadExpiredAt:一致，两种地址族都过期超过阈值时丢弃
+- (BOOL)isHostRecordDiscarded:(HttpdnsHostRecord *)hostRecord {
+    int64_t discardBound = (int64_t)(HttpdnsClockNow() - self.atomicDiscardExpiredDuration);
+    return hostRecord.v4LookupTime + hostRecord.v4ttl <= discardBound
+        && hostRecord.v6LookupTime + hostRecord.v6ttl <= discardBound;
+}
+
+- (void)loadHostRecordToMemory:(HttpdnsHostRecord *)hostRecord {
+    NSString *cacheKey = hostRecord.cacheKey;
+
+    // 内存中已有解析结果时，它比数据库中的更新，不能被覆盖；只有占位的空对象和同样来自持久层的对象可以被替换
+    HttpdnsHostObject *existingObject = [_hostObjectInMemoryCache getHostObjectByCacheKey:cacheKey];
+    if (existingObject && ![existingObject isLoadFromDB]
+        && ([HttpdnsUtil isNotEmptyArray:[existingObject getV4Ips]] || [HttpdnsUtil isNotEmptyArray:[existingObject getV6Ips]])) {
+        [self removePersistedCacheKey:cacheKey];
+        return;
+    }
 
-        HttpdnsHostObject *hostObject = [HttpdnsHostObject fromDBRecord:hostRecord];
+    HttpdnsHostObject *hostObject = [HttpdnsHostObject fromDBRecord:hostRecord];
 
-        // 从持久层加载到内存的缓存，需要做个标记，App启动后从缓存使用结果时，根据标记做特殊处理
-        [hostObject setIsLoadFromDB:YES];
+    // 从持久层加载到内存的缓存，需要做个标记，App启动后从缓存使用结果时，根据标记做特殊处理
+    [hostObject setIsLoadFromDB:YES];
 
-        [self->_hostObjectInMemoryCache setHostObject:hostObject forCacheKey:cacheKey];
+    [_hostObjectInMemoryCache setHostObject:hostObject forCacheKey:cacheKey];
+    [self removePersistedCacheKey:cacheKey];
 
-        NSArray *v4IpStrArr = [hostObject getV4IpStrings];
-        if ([HttpdnsUtil isNotEmptyArray:v4IpStrArr]) {
-            [self initiateQualityDetectionForIP:v4IpStrArr forHost:hostName cacheKey:cacheKey];
+    // IP质量探测推迟到该域名真正被访问时
+    @synchronized (_pendingQualityDetectionCacheKeys) {
+        [_pendingQualityDetectionCacheKeys addObject:cacheKey];
+    }
+}
+
+- (BOOL)removePersistedCacheKey:(NSString *)cacheKey {
+    @synchronized (_persistedCacheKeyIndex) {
+        if (![_persistedCacheKeyIndex containsObject:cacheKey]) {
+            return NO;
         }
-        NSArray *v6IpStrArr = [hostObject getV6IpStrings];
-        if ([HttpdnsUtil isNotEmptyArray:v6IpStrArr]) {
-            [self initiateQualityDetectionForIP:v6IpStrArr forHost:hostName cacheKey:cacheKey];
+        [_persistedCacheKeyIndex removeObject:cacheKey];
+        return YES;
+    }
+}
+
+- (BOOL)takePendingQualityDetectionCacheKey:(NSString *)cacheKey {
+    @synchronized (_pendingQualityDetectionCacheKeys) {
+        if (![_pendingQualityDetectionCacheKeys containsObject:cacheKey]) {
+            return NO;
+        }
+        [_pendingQualityDetectionCacheKeys removeObject:cacheKey];
+        return YES;
+    }
+}
+
+- (BOOL)isResolvingBackedOffForCacheKey:(NSString *)cacheKey {
+    int64_t currentEpoch = HttpdnsClockCurrentEpoch();
+    @synchronized (_resolveFailureEntries) {
+        HttpdnsResolveFailureEntry *entry = _resolveFailureEntries[cacheKey];
+        return entry && currentEpoch < entry.retryNotBefore;
+    }
+}
+
+- (void)recordResolveFailureForCacheKey:(NSString *)cacheKey {
+    if ([HttpdnsUtil isEmptyString:cacheKey]) {
+        return;
+    }
+
+    int64_t currentEpoch = HttpdnsClockCurrentEpoch();
+    int64_t maxInterval = self.atomicNegativeCacheTTL;
+    @synchronized (_resolveFailureEntries) {
+        HttpdnsResolveFailureEntry *entry = _resolveFailureEntries[cacheKey];
+        if (!entry) {
+            entry = [HttpdnsResolveFailureEntry new];
+            _resolveFailureEntries[cacheKey] = entry;
         }
+        entry.consecutiveFailures++;
+
+        // 每次连续失败退避时长翻倍，不超过负缓存时长
+        NSUInteger shift = MIN(entry.consecutiveFailures - 1, (NSUInteger)HTTPDNS_MAX_FAILURE_BACKOFF_SHIFT);
+        int64_t interval = MIN(HTTPDNS_FAILURE_BACKOFF_BASE_INTERVAL << shift, maxInterval);
+        entry.retryNotBefore = currentEpoch + interval;
+        HttpdnsLogDebug("Resolve failed, cacheKey: %@, consecutiveFailures: %lu, backoff: %llds",
+                        cacheKey, (unsigned long)entry.consecutiveFailures, interval);
+    }
+}
+
+- (void)clearResolveFailureForCacheKey:(NSString *)cacheKey {
+    @synchronized (_resolveFailureEntries) {
+        [_resolveFailureEntries removeObjectForKey:cacheKey];
+    }
+}
+
+- (void)clearAllResolveFailures {
+    @synchronized (_resolveFailureEntries) {
+        [_resolveFailureEntries removeAllObjects];
+    }
+}
+
+- (HttpdnsResolveTrace *)startTraceForRequest:(HttpdnsRequest *)request {
+    uint64_t threshold = atomic_load_explicit(&_resolveTraceSampleThreshold, memory_order_relaxed);
+    if (threshold == 0 || (uint64_t)arc4random() >= threshold) {
+        return nil;
     }
+    return [[HttpdnsResolveTrace alloc] initWithRequest:request];
+}
+
+- (void)finishTrace:(HttpdnsResolveTrace *)trace {
+    if (!trace) {
+        return;
+    }
+    [trace finish];
+    void (^handler)(HttpdnsResolveTrace *) = self.resolveTraceHandler;
+    if (!handler) {
+        return;
+    }
+    dispatch_async(_resolveTraceCallbackQueue, ^{
+        handler(trace);
+    });
 }
 
 - (void)cleanMemoryAndPersistentCacheOfHostArray:(NSArray<NSString *> *)hostArray {
     for (NSString *host in hostArray) {
         if ([HttpdnsUtil isNotEmptyString:host]) {
             [_hostObjectInMemoryCache removeHostObjectByCacheKey:host];
+            [self removePersistedCacheKey:host];
+            [self takePendingQualityDetectionCacheKey:host];
+            [self clearResolveFailureForCacheKey:host];
+            [_cacheSnapshot removeRecordForCacheKey:host];
         }
     }
+    atomic_store(&_cacheSnapshotDirty, true);
 
     // 清空数据库数据
     dispatch_async(_persistentCacheConcurrentQueue, ^{
+        [self waitForInitialization];
         [self->_httpdnsDB deleteByHostNameArr:hostArray];
     });
 }
 
 - (void)cleanMemoryAndPersistentCacheOfAllHosts {
     [_hostObjectInMemoryCache removeAllHostObjects];
+    @synchronized (_persistedCacheKeyIndex) {
+        [_persistedCacheKeyIndex removeAllObjects];
+    }
+    @synchronized (_pendingQualityDetectionCacheKeys) {
+        [_pendingQualityDetectionCacheKeys removeAllObjects];
+    }
+    [self clearAllResolveFailures];
+    [_cacheSnapshot removeAllRecords];
+    atomic_store(&_cacheSnapshotDirty, false);
 
     // 清空数据库数据
     dispatch_async(_persistentCacheConcurrentQueue, ^{
+        [self waitForInitialization];
         [self->_httpdnsDB deleteAll];
     });
 }
@@ -615,12 +1365,54 @@ typedef struct {
     if (!_persistentCacheIpEnabled) {
         return;
     }
+    HttpdnsResolveTrace *trace = [HttpdnsResolveTrace currentTrace];
+    uint64_t phaseStartTime = trace ? HttpdnsResolveTraceNow() : 0;
+    // 交给数据库延迟批量写入，同一cacheKey的频繁更新会被合并
+    HttpdnsHostRecord *hostRecord = [hostObject toDBRecord];
+    // 数据库还没打开时不阻塞调用方，打开后再写入
+    [self performAfterInitialization:^{
+        [self->_httpdnsDB enqueueCreateOrUpdate:hostRecord];
+        atomic_store(&self->_cacheSnapshotDirty, true);
+    }];
+    [trace addSpanWithPhase:HttpdnsResolveTracePhasePersist startTime:phaseStartTime];
+}
+
+- (void)handleEnterBackgroundNotification:(NSNotification *)notification {
+    if (self.atomicHotHostPrefetchEnabled && [_hostAccessTracker isDirty]) {
+        dispatch_async(_persistentCacheConcurrentQueue, ^{
+            [self waitForInitialization];
+            [self persistHostAccessRecords];
+        });
+    }
+
+    // 先清除标记再重建，重建期间的新写入会重新标记，留到下次重建
+    if (!_persistentCacheIpEnabled || !atomic_exchange(&_cacheSnapshotDirty, false)) {
+        return;
+    }
+
+    // 进入后台时用数据库的全部记录重建快照，供下次冷启动直接映射使用
     dispatch_async(_persistentCacheConcurrentQueue, ^{
-        HttpdnsHostRecord *hostRecord = [hostObject toDBRecord];
-        [self->_httpdnsDB createOrUpdate:hostRecord];
+        [self waitForInitialization];
+        [self rebuildCacheSnapshot];
     });
 }
 
+- (void)persistHostAccessRecords {
+    // 先合并上次运行的记录，避免覆盖掉尚未加载的历史频率
+    [self loadHostAccessRecordsIfNeeded];
+    NSArray<HttpdnsHostAccessRecord *> *records = [_hostAccessTracker recordsAccessedSince:HttpdnsClockNow() - HTTPDNS_HOST_ACCESS_RECENT_WINDOW];
+    if ([_httpdnsDB replaceAllHostAccessRecords:records]) {
+        HttpdnsLogDebug("Host access records persisted, count: %lu", (unsigned long)records.count);
+    }
+}
+
+- (void)rebuildCacheSnapshot {
+    NSArray<HttpdnsHostRecord *> *hostRecords = [_httpdnsDB getAllRecords];
+    if ([_cacheSnapshot rebuildWithRecords:hostRecords]) {
+        HttpdnsLogDebug("Cache snapshot rebuilt, records: %lu", (unsigned long)hostRecords.count);
+    }
+}
+
 #pragma mark -
 #pragma mark - 以下函数仅用于测试目的
 
@@ -632,12 +1424,38 @@ typedef struct {
 
 - (void)cleanAllHostMemoryCache {
     [_hostObjectInMemoryCache removeAllHostObjects];
+    [self clearAllResolveFailures];
 }
 
 - (void)syncLoadCacheFromDbToMemory {
+    [self waitForInitialization];
     [self loadCacheFromDbToMemory];
 }
 
+- (NSInteger)memoryCacheCount {
+    return [_hostObjectInMemoryCache count];
+}
+
+- (void)syncPersistHostAccessRecords {
+    [self waitForInitialization];
+    [self persistHostAccessRecords];
+}
+
+- (void)syncRebuildCacheSnapshot {
+    [self waitForInitialization];
+    [self rebuildCacheSnapshot];
+}
+
+- (void)waitForPersistentCacheTasks {
+    dispatch_barrier_sync(_persistentCacheConcurrentQueue, ^{});
+}
+
+- (void)waitForAsyncResolveTasks {
+    // 预解析会在任务中再向队列提交分批请求，第二次屏障等待这些请求完成
+    dispatch_barrier_sync(_asyncResolveHostQueue, ^{});
+    dispatch_barrier_sync(_asyncResolveHostQueue, ^{});
+}
+
 - (void)dealloc {
     [[NSNotificationCenter defaultCenter] removeObserver:self];
 }
@@ -18,6 +18,7 @@
  */
 
 #import <Foundation/Foundation.h>
+#import <sys/socket.h>
 // 头文件包含需使用相对目录，确保通过 CocoaPods 安装后能被模块化编译找到
 // #import "HttpdnsRequest.h"
 // #import "HttpdnsResult.h"
@@ -26,6 +27,9 @@
 
 #import <AlicloudHTTPDNS/HttpdnsRequest.h>
 #import <AlicloudHTTPDNS/HttpDnsResult.h>
+#import <AlicloudHTTPDNS/HttpdnsResolveTrace.h>
+#import <AlicloudHTTPDNS/HttpdnsStatistics.h>
+#import <AlicloudHTTPDNS/HttpdnsStartupMetrics.h>
 #import <AlicloudHTTPDNS/HttpdnsLoggerProtocol.h>
 #import <AlicloudHTTPDNS/HttpdnsDegradationDelegate.h>
 
@@ -104,6 +108,20 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (nonnull instancetype)initWithAccountID:(NSInteger)accountID secretKey:(NSString * _Nonnull)secretKey aesSecretKey:(NSString * _Nullable)aesSecretKey;
 
+/*!
+ * @brief 支持延迟初始化的初始化接口
+ * @details 打开持久化缓存数据库、探测IP协议栈、启动网络状态监听、加载调度配置等耗时操作移到SDK内部的后台队列上执行，
+ *          调用线程上只创建内存中的对象，适合在 application:didFinishLaunchingWithOptions: 中调用。
+ *          返回的实例可以立即使用：需要发起网络请求的解析和持久化缓存的读写会等待后台初始化完成后再执行；
+ *          非阻塞解析接口不会等待，自动选择查询类型时，IP协议栈探测完成前只查询IPv4。
+ *          各阶段耗时可通过 startupMetrics 获取。
+ * @param accountID 您的 HTTPDNS Account ID
+ * @param secretKey 鉴权对应的 secretKey
+ * @param aesSecretKey 加密功能对应的 aesSecretKey
+ * @param deferredInitialization 是否延迟初始化，为NO时与 initWithAccountID:secretKey:aesSecretKey: 相同
+ */
+- (nonnull instancetype)initWithAccountID:(NSInteger)accountID secretKey:(NSString * _Nonnull)secretKey aesSecretKey:(NSString * _Nullable)aesSecretKey deferredInitialization:(BOOL)deferredInitialization;
+
 
 /// 开启鉴权功能后，鉴权的签名计算默认读取设备当前时间。若担心设备时间不准确导致签名不准确，可以使用此接口校正 APP 内鉴权计算使用的时间值
 /// 注意，校正操作在 APP 的一个生命周期内生效，APP 重启后需要重新设置才能重新生效
@@ -145,6 +163,45 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)setReuseExpiredIPEnabled:(BOOL)enable;
 
 
+/// 设置负缓存时长，单位为秒，默认300秒
+/// 域名的某个地址族没有解析记录时，该时长内直接使用缓存的结论，不再重复请求；开启持久化缓存时一并持久化
+/// 连续解析失败的域名会按指数退避暂停请求，退避时长同样不超过该值
+/// @param ttl 负缓存时长，设置为0表示不缓存没有记录的结论，也不做失败退避
+- (void)setNegativeCacheTTL:(NSTimeInterval)ttl;
+
+
+/// 设置解析链路耗时追踪，用于把解析各阶段的耗时接入APM
+/// 被采样的解析在结束后，于SDK内部的串行队列上回调一次，包含缓存查询、锁等待、建连、收发、解析、合并、持久化等阶段的单调时钟时间戳
+/// 直接命中不可变结果缓存的快速路径不经过完整解析流程，不产生追踪；未开启时只有一次原子读的开销
+/// @param sampleRate 采样率，取值0-1，为0时关闭追踪
+/// @param handler 追踪回调，为nil时关闭追踪
+- (void)setResolveTraceSampleRate:(double)sampleRate handler:(nullable void (^)(HttpdnsResolveTrace *trace))handler;
+
+
+/// 获取SDK运行统计的快照，Release包中同样可用，便于接入APM
+/// 包含缓存命中、网络请求、连接池、调度轮转、IP探测等计数及耗时分布；计数在进程内从启动开始累计，快照之间相减即可得到区间内的增量
+/// 各计数只用原子操作累加，获取快照不阻塞解析流程
+/// 注意：除负缓存命中和失败退避两项外，所有计数都是进程内全局的，不区分账号；同一进程中创建了多个账号的HttpDnsService实例时，
+/// 在任一实例上获取的快照都包含所有实例的请求
+- (HttpdnsStatistics *)statisticsSnapshot;
+
+
+/// 获取SDK初始化各阶段的耗时，用于评估对App启动的影响
+/// 延迟初始化时，后台初始化完成前获取的结果中completed为NO，尚未执行的阶段耗时为0
+- (HttpdnsStartupMetrics *)startupMetrics;
+
+
+/// 开始把解析事件记录到二进制文件，用于按线上真实的访问模式离线回放，评估缓存、预解析等配置
+/// 每次解析记录一条定长事件：相对时间、域名哈希、查询类型、命中/过期复用/未命中及耗时，不记录域名明文
+/// 记录在内存中攒批后异步写入文件；已在记录时会先结束之前的文件
+/// @param path 记录文件路径，已存在时会被覆盖
+/// @param error 文件无法创建时返回错误
+- (BOOL)startRecordingResolveEventsToPath:(NSString *)path error:(NSError **)error;
+
+/// 结束记录，返回时缓冲中的事件已全部写入文件
+- (void)stopRecordingResolveEvents;
+
+
 /// 设置 HTTPDNS 域名解析请求类型 ( HTTP / HTTPS )
 /// 若不调用该接口，默认为 HTTP 请求。
 /// HTTP 请求基于底层 CFNetwork 实现，不受 ATS 限制；
@@ -205,6 +262,23 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)setPreResolveAfterNetworkChanged:(BOOL)enable;
 
 
+/// 设置是否按访问频率自动预解析热门域名，替代手工维护的预解析列表
+/// 开启后SDK按指数衰减（半衰期1天）统计各域名的解析次数，并持久化到本地数据库；开启时以及网络切换后，按频率从高到低预解析最近3天内使用过的热门域名
+/// 开启后网络切换时只预解析热门域名，不再受 setPreResolveAfterNetworkChanged: 影响；只统计未指定sdnsCacheKey的解析
+/// 建议在初始化之后立即调用，以便启动时预解析上次运行的热门域名
+/// @param enable YES: 开启 NO: 关闭
+/// @param maxHostCount 每次最多预解析的域名数量，不超过100
+- (void)setHotHostPrefetchEnabled:(BOOL)enable maxHostCount:(NSUInteger)maxHostCount;
+
+
+/// 设置是否根据域名之间的先后关系预测并预解析接下来会用到的域名
+/// 开启后SDK从解析请求中学习某域名解析后1秒内通常还会解析哪些域名，按指数衰减（半衰期1天）统计，只保留在内存中
+/// 解析某域名时，把紧随其后概率不低于50%、且缓存缺失或即将过期的域名合并到同一个批量解析请求中；本次不需要请求时单独批量预解析
+/// 只统计未指定sdnsCacheKey的解析；预测的数量和命中率可通过 statisticsSnapshot 获取
+/// @param enable YES: 开启 NO: 关闭，关闭时清空已学习的统计
+- (void)setPredictivePreResolveEnabled:(BOOL)enable;
+
+
 /// 设置当httpdns解析失败时是否降级到localDNS尝试解析
 /// 降级生效时，SDNS参数不生效，降级逻辑只解析域名，返回的结果默认使用60秒(若未指定该域名自定义TTL)作为TTL值
 /// 降级请求也不会再对ip进行优先排序
@@ -308,6 +382,33 @@ NS_ASSUME_NONNULL_BEGIN
 /// @handler 解析结果回调
 - (void)resolveHostAsync:(HttpdnsRequest *)request completionHandler:(void (^)(HttpdnsResult * nullable))handler;
 
+/// 解析域名后对排序靠前的ipv4、ipv6地址竞速建立TCP连接（RFC 8305 Happy Eyeballs），返回最先建立的连接
+/// 两个地址族交错尝试，ipv6优先，相邻两次尝试间隔250毫秒，前一个失败时立即尝试下一个；任一连接建立后取消其余尝试
+/// 各地址的建连结果会反馈到IP优选的排序统计中，影响后续解析结果的顺序
+/// @param host 需要连接的域名
+/// @param port 需要连接的端口
+/// @param queryIpType 可设置为自动选择，ipv4，ipv6. 设置为自动选择时，会自动根据当前所处网络环境选择解析ipv4或ipv6
+/// @handler 建连结果回调。成功时socketFd为已连接的阻塞模式socket，由调用方负责关闭；解析或建连失败时socketFd为-1，ip为nil
+- (void)connectToHostAsync:(NSString *)host port:(int)port byIpType:(HttpdnsQueryIPType)queryIpType completionHandler:(void (^)(int socketFd, NSString * _Nullable ip))handler;
+
+/// 解析域名后对排序靠前的ipv4、ipv6地址竞速建立TCP连接，行为同connectToHostAsync:port:byIpType:completionHandler:
+/// @param request 请求参数对象
+/// @param port 需要连接的端口
+/// @handler 建连结果回调
+- (void)connectToHostAsync:(HttpdnsRequest *)request port:(int)port completionHandler:(void (^)(int socketFd, NSString * _Nullable ip))handler;
+
+/// 伪异步解析域名，把解析结果直接写入调用方提供的sockaddr_storage数组，省去调用方再把IP字符串转换成sockaddr的开销
+/// 地址已设置好端口，按IP优选排序，两个地址族按RFC 8305交错排列，ipv6在前
+/// 缓存命中且未过期时直接从内存缓存拷贝二进制地址，不创建Objective-C对象；其余情况的行为同resolveHostSyncNonBlocking:byIpType:
+/// 纯C代码可使用HttpdnsSockaddr.h中的HttpdnsResolveSockaddrsNonBlocking
+/// @param host 需要解析的域名
+/// @param port 写入每个地址的端口
+/// @param queryIpType 可设置为自动选择，ipv4，ipv6. 设置为自动选择时，会自动根据当前所处网络环境选择解析ipv4或ipv6
+/// @param sockaddrs 调用方提供的数组
+/// @param maxCount 数组容量
+/// @return 写入的地址数量，缓存未命中时为0
+- (NSInteger)resolveHostSyncNonBlocking:(NSString *)host port:(uint16_t)port byIpType:(HttpdnsQueryIPType)queryIpType sockaddrs:(struct sockaddr_storage *)sockaddrs maxCount:(NSInteger)maxCount;
+
 /// 伪异步解析域名，不会阻塞当前线程，首次解析结果可能为空
 /// 先查询缓存，缓存中存在有效结果(未过期，或者过期但配置了可以复用过期解析结果)，则直接返回结果，如果缓存未命中，则发起异步解析请求
 /// @param host 需要解析的域名
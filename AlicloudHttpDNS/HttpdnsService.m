@@ -28,6 +28,13 @@
 #import "HttpdnsPublicConstant.h"
 #import "HttpdnsRegionConfigLoader.h"
 #import "HttpdnsIpStackDetector.h"
+#import "HttpdnsConnectionRacer.h"
+#import "HttpdnsResult_Internal.h"
+#import "HttpdnsIpSelector.h"
+#import "HttpdnsMetrics.h"
+#import "HttpdnsStatistics_Internal.h"
+#import "HttpdnsResolveRecorder.h"
+#import "HttpdnsStartupMetrics_Internal.h"
 
 
 
@@ -43,6 +50,7 @@ static HttpDnsService *httpdnsSharedStubInstance;
 @property (nonatomic, copy) NSString *secretKey;
 @property (nonatomic, copy) NSString *aesSecretKey;
 @property (nonatomic, assign) BOOL hasConfiguredAccount;
+@property (nonatomic, strong) HttpdnsStartupMetrics *startupMetricsRecorder;
 
  // 每次访问的签名有效期，SDK内部定死，当前不暴露设置接口，有效期定为10分钟。
 @property (nonatomic, assign) NSUInteger authTimeoutInterval;
@@ -137,19 +145,25 @@ static HttpDnsService *httpdnsSharedStubInstance;
 }
 
 - (nonnull instancetype)initWithAccountID:(NSInteger)accountID secretKey:(NSString *)secretKey aesSecretKey:(NSString *)aesSecretKey {
+    return [self initWithAccountID:accountID secretKey:secretKey aesSecretKey:aesSecretKey deferredInitialization:NO];
+}
+
+- (nonnull instancetype)initWithAccountID:(NSInteger)accountID secretKey:(NSString *)secretKey aesSecretKey:(NSString *)aesSecretKey deferredInitialization:(BOOL)deferredInitialization {
     HttpDnsService *existing = [HttpDnsService getInstanceByAccountId:accountID];
     if (existing) {
         return existing;
     }
 
+    HttpdnsStartupMetrics *startupMetrics = [[HttpdnsStartupMetrics alloc] initWithDeferredInitialization:deferredInitialization];
     HttpDnsService *service = [HttpDnsService instanceForAccountIDCreatingIfNeeded:accountID];
-    [service configureWithAccountID:accountID secretKey:secretKey aesSecretKey:aesSecretKey];
+    [service configureWithAccountID:accountID secretKey:secretKey aesSecretKey:aesSecretKey startupMetrics:startupMetrics];
     return service;
 }
 
 - (void)configureWithAccountID:(NSInteger)accountID
                       secretKey:(NSString *)secretKey
-                   aesSecretKey:(NSString *)aesSecretKey {
+                   aesSecretKey:(NSString *)aesSecretKey
+                 startupMetrics:(HttpdnsStartupMetrics *)startupMetrics {
     @synchronized (self) {
         if (self.hasConfiguredAccount) {
             return;
@@ -164,18 +178,35 @@ static HttpDnsService *httpdnsSharedStubInstance;
         self.enableHttpsRequest = NO;
         self.hasAllowedArbitraryLoadsInATS = NO;
         self.enableDegradeToLocalDNS = NO;
+        self.startupMetricsRecorder = startupMetrics;
 
-        self.requestManager = [[HttpdnsRequestManager alloc] initWithAccountId:accountID ownerService:self];
-
-        NSUserDefaults *userDefault = [NSUserDefaults standardUserDefaults];
-        NSString *regionKey = [NSString stringWithFormat:@"%@.%ld", kAlicloudHttpdnsRegionKey, (long)accountID];
-        NSString *cachedRegion = [userDefault objectForKey:regionKey];
+        uint64_t phaseStartTime = HttpdnsMetricsNow();
+        HttpdnsRequestManager *requestManager = [[HttpdnsRequestManager alloc] initWithAccountId:accountID ownerService:self];
+        self.requestManager = requestManager;
+        [startupMetrics recordPhase:HttpdnsStartupPhaseRequestManagerCreation startTime:phaseStartTime];
 
+        phaseStartTime = HttpdnsMetricsNow();
         HttpdnsScheduleCenter *scheduleCenter = [[HttpdnsScheduleCenter alloc] initWithAccountId:accountID];
-        [scheduleCenter initRegion:cachedRegion];
         self.scheduleCenter = scheduleCenter;
+        [startupMetrics recordPhase:HttpdnsStartupPhaseScheduleCenterCreation startTime:phaseStartTime];
+
+        // 涉及磁盘IO和系统网络接口的初始化，延迟初始化时在后台队列上执行
+        [requestManager performInitialization:^{
+            [requestManager setUpComponentsWithStartupMetrics:startupMetrics];
+
+            uint64_t scheduleStartTime = HttpdnsMetricsNow();
+            NSUserDefaults *userDefault = [NSUserDefaults standardUserDefaults];
+            NSString *regionKey = [NSString stringWithFormat:@"%@.%ld", kAlicloudHttpdnsRegionKey, (long)accountID];
+            NSString *cachedRegion = [userDefault objectForKey:regionKey];
+            [scheduleCenter initRegion:cachedRegion];
+            [startupMetrics recordPhase:HttpdnsStartupPhaseScheduleConfigLoad startTime:scheduleStartTime];
+
+            [startupMetrics markCompleted];
+            HttpdnsLogDebug("Startup finished, accountId: %ld, metrics: %@", (long)accountID, [startupMetrics snapshot]);
+        } deferred:startupMetrics.deferredInitialization];
 
         self.hasConfiguredAccount = YES;
+        [startupMetrics markCallerThreadFinished];
     }
 }
 
@@ -221,6 +252,40 @@ static HttpDnsService *httpdnsSharedStubInstance;
     [_requestManager setExpiredIPEnabled:enable];
 }
 
+- (void)setNegativeCacheTTL:(NSTimeInterval)ttl {
+    [_requestManager setNegativeCacheTTL:ttl];
+}
+
+- (void)setResolveTraceSampleRate:(double)sampleRate handler:(void (^)(HttpdnsResolveTrace *trace))handler {
+    [_requestManager setResolveTraceSampleRate:sampleRate handler:handler];
+}
+
+- (HttpdnsStatistics *)statisticsSnapshot {
+    HttpdnsStatistics *statistics = HttpdnsMetricsSnapshot();
+    // 负缓存与失败退避按账号统计，从当前实例的requestManager读取
+    statistics.negativeCacheHitCount = [_requestManager negativeCacheHitCount];
+    statistics.failureBackoffHitCount = [_requestManager failureBackoffHitCount];
+    return statistics;
+}
+
+- (HttpdnsStartupMetrics *)startupMetrics {
+    return [self.startupMetricsRecorder snapshot] ?: [[HttpdnsStartupMetrics alloc] initWithDeferredInitialization:NO];
+}
+
+- (BOOL)startRecordingResolveEventsToPath:(NSString *)path error:(NSError **)error {
+    HttpdnsResolveRecorder *recorder = [[HttpdnsResolveRecorder alloc] initWithPath:path error:error];
+    if (!recorder) {
+        HttpdnsLogDebug("Start recording resolve events failed, path: %@", path);
+        return NO;
+    }
+    [_requestManager setResolveRecorder:recorder];
+    return YES;
+}
+
+- (void)stopRecordingResolveEvents {
+    [_requestManager setResolveRecorder:nil];
+}
+
 - (void)setHTTPSRequestEnabled:(BOOL)enable {
     self.enableHttpsRequest = enable;
 }
@@ -252,8 +317,11 @@ static HttpDnsService *httpdnsSharedStubInstance;
         // 仅清空本实例缓存，调度按账号隔离
         [self cleanHostCache:nil];
 
-        // region变化后仅更新本实例的服务IP
-        [self.scheduleCenter resetRegion:region];
+        // region变化后仅更新本实例的服务IP，延迟初始化时排在调度配置加载之后
+        HttpdnsScheduleCenter *scheduleCenter = self.scheduleCenter;
+        [_requestManager performAfterInitialization:^{
+            [scheduleCenter resetRegion:region];
+        }];
     }
 }
 
@@ -302,6 +370,14 @@ static HttpDnsService *httpdnsSharedStubInstance;
     [_requestManager setPreResolveAfterNetworkChanged:enable];
 }
 
+- (void)setHotHostPrefetchEnabled:(BOOL)enable maxHostCount:(NSUInteger)maxHostCount {
+    [_requestManager setHotHostPrefetchEnabled:enable maxHostCount:maxHostCount];
+}
+
+- (void)setPredictivePreResolveEnabled:(BOOL)enable {
+    [_requestManager setPredictivePreResolveEnabled:enable];
+}
+
 - (void)setIPRankingDatasource:(NSDictionary<NSString *, NSNumber *> *)IPRankingDatasource {
     _IPRankingDataSource = IPRankingDatasource;
 }
@@ -369,10 +445,20 @@ static HttpDnsService *httpdnsSharedStubInstance;
         return nil;
     }
 
+    NSTimeInterval remainingTimeout = 0;
+    if (![self waitForInitializationWithinResolveTimeout:request remainingTimeout:&remainingTimeout]) {
+        return [self resolveHostWithoutWaiting:request];
+    }
+
     [self refineResolveRequest:request];
     [request becomeBlockingRequest];
 
-    HttpdnsHostObject *hostObject = [_requestManager resolveHost:request];
+    HttpdnsResult *memoizedResult = [self memoizedResultForRequest:request];
+    if (memoizedResult) {
+        return memoizedResult;
+    }
+
+    HttpdnsHostObject *hostObject = [_requestManager resolveHost:[self request:request limitedToResolveTimeout:remainingTimeout]];
     if (!hostObject) {
         return nil;
     }
@@ -401,6 +487,11 @@ static HttpDnsService *httpdnsSharedStubInstance;
     [self refineResolveRequest:request];
     [request becomeNonBlockingRequest];
 
+    HttpdnsResult *memoizedResult = [self memoizedResultForRequest:request];
+    if (memoizedResult) {
+        return memoizedResult;
+    }
+
     HttpdnsHostObject *hostObject = [_requestManager resolveHost:request];
     if (!hostObject) {
         return nil;
@@ -433,13 +524,25 @@ static HttpDnsService *httpdnsSharedStubInstance;
         return;
     }
 
-    [self refineResolveRequest:request];
-
     double enqueueStart = [[NSDate date] timeIntervalSince1970] * 1000;
     dispatch_async(asyncTaskConcurrentQueue, ^{
         double executeStart = [[NSDate date] timeIntervalSince1970] * 1000;
+        // 延迟初始化时在后台等待初始化完成，再按探测到的IP协议栈确定查询类型
+        NSTimeInterval remainingTimeout = 0;
+        if (![self waitForInitializationWithinResolveTimeout:request remainingTimeout:&remainingTimeout]) {
+            handler([self resolveHostWithoutWaiting:request]);
+            return;
+        }
+        [self refineResolveRequest:request];
         [request becomeBlockingRequest];
-        HttpdnsHostObject *hostObject = [self->_requestManager resolveHost:request];
+
+        HttpdnsResult *memoizedResult = [self memoizedResultForRequest:request];
+        if (memoizedResult) {
+            handler(memoizedResult);
+            return;
+        }
+
+        HttpdnsHostObject *hostObject = [self->_requestManager resolveHost:[self request:request limitedToResolveTimeout:remainingTimeout]];
         double innerEnd = [[NSDate date] timeIntervalSince1970] * 1000;
         HttpdnsLogDebug("resolveHostAsync done, inner cost time from enqueue: %fms, from execute: %fms", (innerEnd - enqueueStart), (innerEnd - executeStart));
 
@@ -451,6 +554,92 @@ static HttpDnsService *httpdnsSharedStubInstance;
     });
 }
 
+- (NSInteger)resolveHostSyncNonBlocking:(NSString *)host port:(uint16_t)port byIpType:(HttpdnsQueryIPType)queryIpType sockaddrs:(struct sockaddr_storage *)sockaddrs maxCount:(NSInteger)maxCount {
+    return [self resolveSockaddrsOfCStringHost:[host UTF8String] port:port byIpType:queryIpType sockaddrs:sockaddrs maxCount:maxCount];
+}
+
+- (NSInteger)resolveSockaddrsOfCStringHost:(const char *)host port:(uint16_t)port byIpType:(HttpdnsQueryIPType)queryIpType sockaddrs:(struct sockaddr_storage *)sockaddrs maxCount:(NSInteger)maxCount {
+    if (!host || !sockaddrs || maxCount <= 0) {
+        return 0;
+    }
+
+    // 设置了降级回调时每次都要询问，只能走完整流程
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+    BOOL hasDegradationDelegate = self.delegate != nil;
+#pragma clang diagnostic pop
+    if (!hasDegradationDelegate) {
+        // 没有sdns缓存key时缓存以域名为key，可以直接用C字符串查询
+        HttpdnsQueryIPType clarifiedQueryIpType = [self determineLegitQueryIpType:queryIpType];
+        NSInteger count = [_requestManager copyFreshSockaddrsForCacheKey:host
+                                                             queryIpType:clarifiedQueryIpType
+                                                                    port:port
+                                                                      to:sockaddrs
+                                                                maxCount:(NSUInteger)maxCount];
+        if (count >= 0) {
+            return count;
+        }
+    }
+
+    @autoreleasepool {
+        NSString *hostString = [NSString stringWithUTF8String:host];
+        if (!hostString) {
+            return 0;
+        }
+
+        HttpdnsRequest *request = [[HttpdnsRequest alloc] initWithHost:hostString queryIpType:queryIpType];
+        [self attachAccountInfoToRequest:request];
+        if (![self validateResolveRequest:request]) {
+            return 0;
+        }
+
+        if ([self _shouldDegradeHTTPDNS:request.host]) {
+            return 0;
+        }
+
+        [self refineResolveRequest:request];
+        [request becomeNonBlockingRequest];
+
+        HttpdnsHostObject *hostObject = [_requestManager resolveHost:request];
+        return (NSInteger)[hostObject copySockaddrsUnderQueryIpType:request.queryIpType port:port to:sockaddrs maxCount:(NSUInteger)maxCount];
+    }
+}
+
+- (void)connectToHostAsync:(NSString *)host port:(int)port byIpType:(HttpdnsQueryIPType)queryIpType completionHandler:(void (^)(int, NSString * _Nullable))handler {
+    HttpdnsRequest *request = [[HttpdnsRequest alloc] initWithHost:host queryIpType:queryIpType];
+    [self attachAccountInfoToRequest:request];
+    [self connectToHostAsync:request port:port completionHandler:handler];
+}
+
+- (void)connectToHostAsync:(HttpdnsRequest *)request port:(int)port completionHandler:(void (^)(int, NSString * _Nullable))handler {
+    if (!handler) {
+        return;
+    }
+
+    [self resolveHostAsync:request completionHandler:^(HttpdnsResult *result) {
+        if (!result) {
+            handler(-1, nil);
+            return;
+        }
+
+        NSArray<NSString *> *candidates = [HttpdnsConnectionRacer interleavedCandidatesWithIpv4s:result.ips
+                                                                                           ipv6s:result.ipv6s
+                                                                                    maxPerFamily:HTTPDNS_CONNECTION_RACE_MAX_IPS_PER_FAMILY];
+        // 解析时已经确定了cacheKey，建连结果反馈到同一条缓存
+        NSString *cacheKey = request.cacheKey;
+        [[HttpdnsConnectionRacer sharedInstance] raceConnectionsToIPs:candidates
+                                                                 port:port
+                                                       attemptHandler:^(NSString *ip, NSInteger costTime) {
+            [self->_requestManager reportConnectionCost:costTime forIp:ip cacheKey:cacheKey];
+        } completion:^(int socketFd, NSString *ip) {
+            HttpdnsLogDebug("connectToHostAsync done, host: %@, winner: %@", request.host, ip);
+            // 一次竞速的所有尝试作为一轮样本，结束后统一排序和落盘
+            [self->_requestManager commitConnectionCostsForCacheKey:cacheKey];
+            handler(socketFd, ip);
+        }];
+    }];
+}
+
 - (HttpdnsQueryIPType)determineLegitQueryIpType:(HttpdnsQueryIPType)specifiedQueryIpType {
     // 自动选择，需要判断当前网络环境来决定
     if (specifiedQueryIpType == HttpdnsQueryIPTypeAuto) {
@@ -476,7 +665,7 @@ static HttpDnsService *httpdnsSharedStubInstance;
 
 - (BOOL)validateResolveRequest:(HttpdnsRequest *)request {
     if (!request.host) {
-        HttpdnsLogDebug("validateResolveRequest failed, the host should not be nil.")
+        HttpdnsLogDebug("validateResolveRequest failed, the host should not be nil.");
         return NO;
     }
 
@@ -493,6 +682,40 @@ static HttpDnsService *httpdnsSharedStubInstance;
     return YES;
 }
 
+// 自动选择查询类型依赖IP协议栈探测结果，需要等待初始化完成，但等待时间不超过本次解析的超时时间
+// 最多等待request的解析超时，remainingTimeout为扣除等待时间后剩余的超时
+- (BOOL)waitForInitializationWithinResolveTimeout:(HttpdnsRequest *)request remainingTimeout:(NSTimeInterval *)remainingTimeout {
+    [request ensureResolveTimeoutInReasonableRange];
+    *remainingTimeout = request.resolveTimeoutInSecond;
+    if ([_requestManager isInitialized]) {
+        return YES;
+    }
+
+    CFAbsoluteTime waitStart = CFAbsoluteTimeGetCurrent();
+    BOOL initialized = [_requestManager waitForInitializationWithTimeout:request.resolveTimeoutInSecond];
+    *remainingTimeout = MAX(request.resolveTimeoutInSecond - (CFAbsoluteTimeGetCurrent() - waitStart), 0);
+    if (!initialized) {
+        HttpdnsLogDebug("Initialization not finished within resolve timeout, resolve without waiting, host: %@", request.host);
+    }
+    return initialized;
+}
+
+// 等待初始化花掉的时间从阻塞解析的超时中扣除，调用方总的等待不超过它设置的超时
+- (HttpdnsRequest *)request:(HttpdnsRequest *)request limitedToResolveTimeout:(NSTimeInterval)remainingTimeout {
+    if (remainingTimeout >= request.resolveTimeoutInSecond) {
+        return request;
+    }
+    return [request requestWithResolveTimeout:remainingTimeout];
+}
+
+// 超时预算已经用完：只用内存缓存应答，同时发起解析，初始化完成后结果写入缓存供之后使用
+- (HttpdnsResult *)resolveHostWithoutWaiting:(HttpdnsRequest *)request {
+    [self refineResolveRequest:request];
+    [request becomeNonBlockingRequest];
+    HttpdnsHostObject *hostObject = [_requestManager resolveHost:request];
+    return [self constructResultFromHostObject:hostObject underQueryType:request.queryIpType];
+}
+
 - (void)refineResolveRequest:(HttpdnsRequest *)request {
     if (request.accountId == 0) {
         request.accountId = self.accountID;
@@ -511,6 +734,22 @@ static HttpDnsService *httpdnsSharedStubInstance;
     [request ensureResolveTimeoutInReasonableRange];
 }
 
+- (NSArray<NSNumber *> *)expectedCostsOfIpObjects:(NSArray<HttpdnsIpObject *> *)ipObjects {
+    NSMutableArray<NSNumber *> *costs = [NSMutableArray arrayWithCapacity:ipObjects.count];
+    for (HttpdnsIpObject *ipObject in ipObjects) {
+        HttpdnsIpQuality *quality = ipObject.quality;
+        [costs addObject:@([quality isLikelyUnreachable] ? HTTPDNS_IP_SELECTION_UNREACHABLE_COST : [quality expectedCost])];
+    }
+    return [costs copy];
+}
+
+// 缓存命中且未过期时复用缓存中已构造的结果，避免每次调用都重新构造结果和IP数组
+- (HttpdnsResult *)memoizedResultForRequest:(HttpdnsRequest *)request {
+    return [_requestManager memoizedResultForRequest:request builder:^HttpdnsResult *(HttpdnsHostObject *hostObject) {
+        return [self constructResultFromHostObject:hostObject underQueryType:request.queryIpType];
+    }];
+}
+
 - (HttpdnsResult *)constructResultFromHostObject:(HttpdnsHostObject *)hostObject underQueryType:(HttpdnsQueryIPType)queryType {
     if (!hostObject) {
         return nil;
@@ -523,16 +762,15 @@ static HttpDnsService *httpdnsSharedStubInstance;
 
     HttpdnsResult *result = [HttpdnsResult new];
     result.host = [hostObject getHostName];
+    // sessionId每次启动都会变化，一致性哈希需要跨启动稳定的标识
+    result.selectionHashKey = [HttpdnsUtil installationID];
 
     // 由于结果可能是从缓存中获得，所以还要根据实际协议栈情况再筛选下结果
     if (queryType & HttpdnsQueryIPTypeIpv4) {
         NSArray *ipv4s = [hostObject getV4Ips];
         if ([HttpdnsUtil isNotEmptyArray:ipv4s]) {
-            NSMutableArray *ipv4Array = [NSMutableArray array];
-            for (HttpdnsIpObject *ipObject in ipv4s) {
-                [ipv4Array addObject:[ipObject getIpString]];
-            }
-            result.ips = [ipv4Array copy];
+            result.ips = [hostObject getV4IpStrings];
+            result.v4ExpectedCosts = [self expectedCostsOfIpObjects:ipv4s];
             result.ttl = hostObject.getV4TTL;
             result.lastUpdatedTimeInterval = hostObject.lastIPv4LookupTime;
         }
@@ -541,11 +779,8 @@ static HttpDnsService *httpdnsSharedStubInstance;
     if (queryType & HttpdnsQueryIPTypeIpv6) {
         NSArray *ipv6s = [hostObject getV6Ips];
         if ([HttpdnsUtil isNotEmptyArray:ipv6s]) {
-            NSMutableArray *ipv6Array = [NSMutableArray array];
-            for (HttpdnsIpObject *ipObject in ipv6s) {
-                [ipv6Array addObject:[ipObject getIpString]];
-            }
-            result.ipv6s = [ipv6Array copy];
+            result.ipv6s = [hostObject getV6IpStrings];
+            result.v6ExpectedCosts = [self expectedCostsOfIpObjects:ipv6s];
             result.v6ttl = hostObject.getV6TTL;
             result.v6LastUpdatedTimeInterval = hostObject.lastIPv6LookupTime;
         }
@@ -48,4 +48,7 @@
 
 - (NSDictionary<NSString *, NSNumber *> *)getIPRankingDatasource;
 
+// 以C字符串传入域名的sockaddr解析，缓存命中时不创建Objective-C对象
+- (NSInteger)resolveSockaddrsOfCStringHost:(const char *)host port:(uint16_t)port byIpType:(HttpdnsQueryIPType)queryIpType sockaddrs:(struct sockaddr_storage *)sockaddrs maxCount:(NSInteger)maxCount;
+
 @end
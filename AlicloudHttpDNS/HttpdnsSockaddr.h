@@ -0,0 +1,45 @@
+//
+//  HttpdnsSockaddr.h
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/28.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#ifndef HttpdnsSockaddr_h
+#define HttpdnsSockaddr_h
+
+#include <stdint.h>
+#include <sys/socket.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 与HttpdnsQueryIPType的取值一致，供纯C代码使用
+#define HTTPDNS_SOCKADDR_QUERY_AUTO 0
+#define HTTPDNS_SOCKADDR_QUERY_IPV4 1
+#define HTTPDNS_SOCKADDR_QUERY_IPV6 2
+#define HTTPDNS_SOCKADDR_QUERY_BOTH 3
+
+/// 使用[HttpDnsService sharedInstance]伪异步解析域名，把结果直接写入调用方提供的sockaddr_storage数组
+/// 地址已设置好端口，按IP优选排序，两个地址族按RFC 8305交错排列，ipv6在前
+/// 缓存命中且未过期时只拷贝内存中的二进制地址，不创建Objective-C对象，适合在请求热路径上调用
+/// 缓存未命中时返回0，同时在后台发起解析
+/// @param host 需要解析的域名，UTF-8编码
+/// @param port 写入每个地址的端口
+/// @param queryIpType HTTPDNS_SOCKADDR_QUERY_*
+/// @param sockaddrs 调用方提供的数组
+/// @param maxCount 数组容量
+/// @return 写入的地址数量
+int HttpdnsResolveSockaddrsNonBlocking(const char *host,
+                                       uint16_t port,
+                                       unsigned int queryIpType,
+                                       struct sockaddr_storage *sockaddrs,
+                                       int maxCount);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HttpdnsSockaddr_h */
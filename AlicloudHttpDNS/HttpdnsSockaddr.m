@@ -0,0 +1,27 @@
+//
+//  HttpdnsSockaddr.m
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/28.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "HttpdnsSockaddr.h"
+#import "HttpdnsService_Internal.h"
+
+int HttpdnsResolveSockaddrsNonBlocking(const char *host,
+                                       uint16_t port,
+                                       unsigned int queryIpType,
+                                       struct sockaddr_storage *sockaddrs,
+                                       int maxCount) {
+    if (!host || !sockaddrs || maxCount <= 0) {
+        return 0;
+    }
+
+    HttpDnsService *service = [HttpDnsService sharedInstance];
+    return (int)[service resolveSockaddrsOfCStringHost:host
+                                                  port:port
+                                              byIpType:(HttpdnsQueryIPType)queryIpType
+                                             sockaddrs:sockaddrs
+                                              maxCount:maxCount];
+}
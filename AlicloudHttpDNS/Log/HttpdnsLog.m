@@ -19,55 +19,88 @@
 
 
 #import "HttpdnsLog_Internal.h"
+#import <stdatomic.h>
 
-static BOOL HttpdnsLogIsEnabled = NO;
+static atomic_bool HttpdnsLogIsEnabled = false;
+
+static atomic_bool sHasLogHandler = false;
 
 static id<HttpdnsLoggerProtocol> sLogHandler;
 
+BOOL HttpdnsLogIsActive(void) {
+    return atomic_load_explicit(&HttpdnsLogIsEnabled, memory_order_relaxed)
+        || atomic_load_explicit(&sHasLogHandler, memory_order_relaxed);
+}
+
 @implementation HttpdnsLog
 
 + (void)enableLog {
-    HttpdnsLogIsEnabled = YES;
+    atomic_store(&HttpdnsLogIsEnabled, true);
 }
 
 + (void)disableLog {
-    HttpdnsLogIsEnabled = NO;
+    atomic_store(&HttpdnsLogIsEnabled, false);
 }
 
 + (BOOL)isEnabled {
-    return HttpdnsLogIsEnabled;
+    return atomic_load(&HttpdnsLogIsEnabled);
 }
 
 + (void)setLogHandler:(id<HttpdnsLoggerProtocol>)handler {
     SEL sel = NSSelectorFromString(@"log:");
     if (handler && [handler respondsToSelector:sel]) {
-        sLogHandler = handler;
+        @synchronized (self) {
+            sLogHandler = handler;
+        }
+        atomic_store(&sHasLogHandler, true);
     }
 }
 
 + (void)unsetLogHandler {
-    sLogHandler = nil;
+    // 先把缓冲区中的日志交给原来的handler
+    HttpdnsLogBufferFlush();
+    atomic_store(&sHasLogHandler, false);
+    @synchronized (self) {
+        sLogHandler = nil;
+    }
 }
 
 + (BOOL)validLogHandler {
-    return (sLogHandler != nil);
+    return atomic_load(&sHasLogHandler);
 }
 
-+ (void)outputToLogHandler:(NSString *)logStr {
-    if (sLogHandler) {
-        [sLogHandler log:logStr];
++ (id<HttpdnsLoggerProtocol>)currentLogHandler {
+    @synchronized (self) {
+        return sLogHandler;
+    }
+}
+
++ (void)outputToLogHandler:(id<HttpdnsLoggerProtocol>)handler logs:(NSArray<NSString *> *)logs {
+    if (!handler || logs.count == 0) {
+        return;
+    }
+    @try {
+        if ([handler respondsToSelector:@selector(logBatch:)]) {
+            [handler logBatch:logs];
+            return;
+        }
+        for (NSString *logStr in logs) {
+            [handler log:logStr];
+        }
+    } @catch (NSException *exception) {
     }
 }
 
-+ (NSString *)getFormattedDateTimeStr {
++ (NSString *)formattedDateTimeStrOfAbsoluteTime:(CFAbsoluteTime)time {
     static NSDateFormatter *dateFormatter;
     static dispatch_once_t onceToken;
     dispatch_once(&onceToken, ^{
         dateFormatter = [[NSDateFormatter alloc] init];
+        [dateFormatter setDateFormat:@"yyyy-MM-dd HH:mm:ss.SSS"];
     });
 
-    [dateFormatter setDateFormat:@"yyyy-MM-dd HH:mm:ss.SSS"];
-    return [dateFormatter stringFromDate:[NSDate date]];
+    // 只在日志处理队列上调用，NSDateFormatter不需要额外加锁
+    return [dateFormatter stringFromDate:[NSDate dateWithTimeIntervalSinceReferenceDate:time]];
 }
 
 @end
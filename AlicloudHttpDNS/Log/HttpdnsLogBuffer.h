@@ -0,0 +1,39 @@
+//
+//  HttpdnsLogBuffer.h
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * 异步日志缓冲区
+ *
+ * 写入线程只把格式串指针和参数值写入一个多生产者单消费者的无锁环形缓冲区，
+ * 由后台队列统一格式化，再批量交给日志回调和控制台输出。
+ * 对象参数在写入时保留一份拷贝（不可变对象只增加引用计数），C字符串参数会复制一份；
+ * 参数过多或格式串中有不支持的写法时，退化为在写入线程直接格式化。
+ * 缓冲区写满时丢弃新的记录并计数，下一批输出时提示丢弃的数量。
+ */
+
+/**
+ * 写入一条日志记录
+ * @param format 静态的C格式串，必须在整个进程生命周期内有效
+ */
+FOUNDATION_EXTERN void HttpdnsLogBufferWrite(const char *format, ...);
+
+/**
+ * 同步处理缓冲区中所有已写入的记录
+ */
+FOUNDATION_EXTERN void HttpdnsLogBufferFlush(void);
+
+/**
+ * 因缓冲区写满而丢弃的记录总数
+ */
+FOUNDATION_EXTERN NSUInteger HttpdnsLogBufferDroppedCount(void);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,459 @@
+//
+//  HttpdnsLogBuffer.m
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "HttpdnsLogBuffer.h"
+#import "HttpdnsLog_Internal.h"
+#import <stdatomic.h>
+#import <pthread/pthread.h>
+
+// 环形缓冲区容量，必须是2的幂
+#define HTTPDNS_LOG_BUFFER_CAPACITY 1024
+// 单条记录最多保存的参数个数
+#define HTTPDNS_LOG_MAX_ARGS 8
+
+// 第一条记录写入后延迟处理，期间写入的记录合并为一批输出
+static const int64_t kHttpdnsLogDrainDelayInNanoseconds = 50 * NSEC_PER_MSEC;
+
+typedef union {
+    int64_t i;
+    uint64_t u;
+    double d;
+    char *s;
+    const void *p;
+} HttpdnsLogArg;
+
+typedef struct {
+    _Atomic(size_t) sequence;
+    // format为NULL时表示已在写入线程格式化，args[0].p为持有的NSString
+    const char *format;
+    uint64_t threadId;
+    CFAbsoluteTime timestamp;
+    HttpdnsLogArg args[HTTPDNS_LOG_MAX_ARGS];
+} HttpdnsLogRecord;
+
+typedef struct {
+    // 格式说明在格式串中的起止位置
+    const char *start;
+    const char *end;
+    // 标志、宽度、精度部分的结束位置
+    const char *modifierStart;
+    char conversion;
+    BOOL isWide;
+    BOOL isLongDouble;
+    BOOL hasStar;
+} HttpdnsLogSpec;
+
+static HttpdnsLogRecord sRecords[HTTPDNS_LOG_BUFFER_CAPACITY];
+static _Atomic(size_t) sEnqueuePosition = 0;
+// 只在处理队列上访问
+static size_t sDequeuePosition = 0;
+static atomic_bool sDrainScheduled = false;
+static atomic_ulong sDroppedCount = 0;
+static unsigned long sReportedDroppedCount = 0;
+static dispatch_queue_t sDrainQueue;
+static void *sDrainQueueKey = &sDrainQueueKey;
+
+static __thread uint64_t sCurrentThreadId = 0;
+
+static void HttpdnsLogBufferDrain(void);
+
+static void HttpdnsLogBufferSetupIfNeeded(void) {
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        for (size_t i = 0; i < HTTPDNS_LOG_BUFFER_CAPACITY; i++) {
+            atomic_init(&sRecords[i].sequence, i);
+        }
+        sDrainQueue = dispatch_queue_create("com.alibaba.sdk.httpdns.logDrainQueue", DISPATCH_QUEUE_SERIAL);
+        dispatch_queue_set_specific(sDrainQueue, sDrainQueueKey, sDrainQueueKey, NULL);
+    });
+}
+
+static uint64_t HttpdnsLogCurrentThreadId(void) {
+    if (sCurrentThreadId == 0) {
+        pthread_threadid_np(NULL, &sCurrentThreadId);
+    }
+    return sCurrentThreadId;
+}
+
+// 解析下一个格式说明，没有时返回NULL
+static const char *HttpdnsLogNextSpec(const char *cursor, HttpdnsLogSpec *spec) {
+    const char *p = strchr(cursor, '%');
+    if (!p) {
+        return NULL;
+    }
+    memset(spec, 0, sizeof(HttpdnsLogSpec));
+    spec->start = p++;
+    while (*p && strchr("-+ #0'", *p)) {
+        p++;
+    }
+    while (*p && (isdigit((unsigned char)*p) || *p == '.' || *p == '*')) {
+        if (*p == '*') {
+            spec->hasStar = YES;
+        }
+        p++;
+    }
+    spec->modifierStart = p;
+    while (*p && strchr("hlqLzjt", *p)) {
+        if (*p == 'l' || *p == 'q' || *p == 'z' || *p == 'j' || *p == 't') {
+            spec->isWide = YES;
+        } else if (*p == 'L') {
+            spec->isLongDouble = YES;
+        }
+        p++;
+    }
+    spec->conversion = *p;
+    if (*p) {
+        p++;
+    }
+    spec->end = p;
+    return p;
+}
+
+static BOOL HttpdnsLogIsIntegerConversion(char conversion) {
+    return conversion && strchr("diuoxXc", conversion) != NULL;
+}
+
+static BOOL HttpdnsLogIsFloatConversion(char conversion) {
+    return conversion && strchr("fFeEgGaA", conversion) != NULL;
+}
+
+static void HttpdnsLogReleaseArgs(const char *format, HttpdnsLogArg *args, int count) {
+    const char *cursor = format;
+    HttpdnsLogSpec spec;
+    int index = 0;
+    while (index < count && (cursor = HttpdnsLogNextSpec(cursor, &spec))) {
+        if (spec.conversion == '%') {
+            continue;
+        }
+        if (spec.conversion == 's') {
+            free(args[index].s);
+        } else if (spec.conversion == '@' && args[index].p) {
+            CFRelease(args[index].p);
+        }
+        index++;
+    }
+}
+
+// Foundation中拷贝不可变实例只增加引用计数的值类型
+static BOOL HttpdnsLogIsValueObject(id object) {
+    static Class valueClasses[9];
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        valueClasses[0] = [NSString class];
+        valueClasses[1] = [NSValue class];
+        valueClasses[2] = [NSDate class];
+        valueClasses[3] = [NSURL class];
+        valueClasses[4] = [NSData class];
+        valueClasses[5] = [NSError class];
+        valueClasses[6] = [NSArray class];
+        valueClasses[7] = [NSDictionary class];
+        valueClasses[8] = [NSSet class];
+    });
+    for (size_t i = 0; i < sizeof(valueClasses) / sizeof(valueClasses[0]); i++) {
+        if ([object isKindOfClass:valueClasses[i]]) {
+            return YES;
+        }
+    }
+    return NO;
+}
+
+// 不可变的值对象直接持有；可变对象和其他对象立即取描述，避免在后台读取仍在变化的对象，
+// 也避免像HttpdnsHostObject那样的拷贝连同IP数组一起深拷贝
+static const void *HttpdnsLogRetainObject(id object) {
+    if (!object) {
+        return NULL;
+    }
+    if (HttpdnsLogIsValueObject(object)) {
+        // 类簇无法从类型判断是否可变，不可变实例的拷贝返回自身
+        id copied = [object copy];
+        if (copied == object) {
+            return CFBridgingRetain(object);
+        }
+    }
+    return CFBridgingRetain([object description]);
+}
+
+// 按格式串读取参数，返回NO表示需要在写入线程直接格式化
+static BOOL HttpdnsLogCaptureArgs(const char *format, va_list args, HttpdnsLogArg *captured) {
+    const char *cursor = format;
+    HttpdnsLogSpec spec;
+    int count = 0;
+    while ((cursor = HttpdnsLogNextSpec(cursor, &spec))) {
+        if (spec.conversion == '%') {
+            continue;
+        }
+        BOOL supported = !spec.hasStar && count < HTTPDNS_LOG_MAX_ARGS
+                         && (HttpdnsLogIsIntegerConversion(spec.conversion)
+                             || HttpdnsLogIsFloatConversion(spec.conversion)
+                             || spec.conversion == 's' || spec.conversion == '@' || spec.conversion == 'p');
+        if (!supported) {
+            HttpdnsLogReleaseArgs(format, captured, count);
+            return NO;
+        }
+
+        HttpdnsLogArg *arg = &captured[count++];
+        switch (spec.conversion) {
+            case 'd':
+            case 'i':
+            case 'c':
+                arg->i = spec.isWide ? va_arg(args, long long) : va_arg(args, int);
+                break;
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X':
+                arg->u = spec.isWide ? va_arg(args, unsigned long long) : va_arg(args, unsigned int);
+                break;
+            case 's': {
+                const char *str = va_arg(args, const char *);
+                arg->s = str ? strdup(str) : NULL;
+                break;
+            }
+            case '@':
+                arg->p = HttpdnsLogRetainObject(va_arg(args, id));
+                break;
+            case 'p':
+                arg->p = va_arg(args, void *);
+                break;
+            default:
+                arg->d = spec.isLongDouble ? (double)va_arg(args, long double) : va_arg(args, double);
+                break;
+        }
+    }
+    return YES;
+}
+
+static void HttpdnsLogScheduleDrain(void) {
+    if (atomic_exchange(&sDrainScheduled, true)) {
+        return;
+    }
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, kHttpdnsLogDrainDelayInNanoseconds), sDrainQueue, ^{
+        HttpdnsLogBufferDrain();
+    });
+}
+
+void HttpdnsLogBufferWrite(const char *format, ...) {
+    HttpdnsLogBufferSetupIfNeeded();
+
+    HttpdnsLogArg captured[HTTPDNS_LOG_MAX_ARGS];
+    const char *recordFormat = format;
+
+    va_list args;
+    va_start(args, format);
+    va_list capturingArgs;
+    va_copy(capturingArgs, args);
+    BOOL capturedAll = HttpdnsLogCaptureArgs(format, capturingArgs, captured);
+    va_end(capturingArgs);
+    if (!capturedAll) {
+        NSString *message = nil;
+        @try {
+            message = [[NSString alloc] initWithFormat:@(format) arguments:args];
+        } @catch (NSException *exception) {
+        }
+        if (!message) {
+            va_end(args);
+            return;
+        }
+        recordFormat = NULL;
+        captured[0].p = CFBridgingRetain(message);
+    }
+    va_end(args);
+
+    size_t position = atomic_load_explicit(&sEnqueuePosition, memory_order_relaxed);
+    HttpdnsLogRecord *record;
+    for (;;) {
+        record = &sRecords[position & (HTTPDNS_LOG_BUFFER_CAPACITY - 1)];
+        size_t sequence = atomic_load_explicit(&record->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)position;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&sEnqueuePosition, &position, position + 1, memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // 缓冲区已满，丢弃本条记录
+            if (recordFormat) {
+                HttpdnsLogReleaseArgs(recordFormat, captured, HTTPDNS_LOG_MAX_ARGS);
+            } else {
+                CFRelease(captured[0].p);
+            }
+            atomic_fetch_add_explicit(&sDroppedCount, 1, memory_order_relaxed);
+            HttpdnsLogScheduleDrain();
+            return;
+        } else {
+            position = atomic_load_explicit(&sEnqueuePosition, memory_order_relaxed);
+        }
+    }
+
+    record->format = recordFormat;
+    record->threadId = HttpdnsLogCurrentThreadId();
+    record->timestamp = CFAbsoluteTimeGetCurrent();
+    memcpy(record->args, captured, sizeof(captured));
+    atomic_store_explicit(&record->sequence, position + 1, memory_order_release);
+
+    HttpdnsLogScheduleDrain();
+}
+
+// 在处理队列上按格式串把记录格式化为字符串，并释放记录持有的参数
+static NSString *HttpdnsLogRenderRecord(const char *format, HttpdnsLogArg *args) {
+    NSMutableString *message = [NSMutableString string];
+    const char *cursor = format;
+    const char *literalStart = format;
+    HttpdnsLogSpec spec;
+    int index = 0;
+    char specBuffer[32];
+    char valueBuffer[128];
+
+    while ((cursor = HttpdnsLogNextSpec(literalStart, &spec))) {
+        if (spec.start > literalStart) {
+            [message appendString:[[NSString alloc] initWithBytes:literalStart length:spec.start - literalStart encoding:NSUTF8StringEncoding] ?: @""];
+        }
+        literalStart = cursor;
+
+        if (spec.conversion == '%') {
+            [message appendString:@"%"];
+            continue;
+        }
+
+        HttpdnsLogArg *arg = &args[index++];
+        if (spec.conversion == '@') {
+            id object = arg->p ? CFBridgingRelease(arg->p) : nil;
+            [message appendString:object ? [object description] : @"(null)"];
+            continue;
+        }
+        if (spec.conversion == 's') {
+            [message appendString:arg->s ? (@(arg->s) ?: @"") : @"(null)"];
+            free(arg->s);
+            continue;
+        }
+
+        // 去掉长度修饰后按统一的类型格式化：整数取int或long long，浮点取double
+        size_t modifierLength = spec.modifierStart - spec.start;
+        if (modifierLength + 4 > sizeof(specBuffer)) {
+            continue;
+        }
+        memcpy(specBuffer, spec.start, modifierLength);
+        char *tail = specBuffer + modifierLength;
+        if (HttpdnsLogIsIntegerConversion(spec.conversion) && spec.isWide) {
+            *tail++ = 'l';
+            *tail++ = 'l';
+        }
+        *tail++ = spec.conversion;
+        *tail = '\0';
+
+        switch (spec.conversion) {
+            case 'd':
+            case 'i':
+            case 'c':
+                if (spec.isWide) {
+                    snprintf(valueBuffer, sizeof(valueBuffer), specBuffer, (long long)arg->i);
+                } else {
+                    snprintf(valueBuffer, sizeof(valueBuffer), specBuffer, (int)arg->i);
+                }
+                break;
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X':
+                if (spec.isWide) {
+                    snprintf(valueBuffer, sizeof(valueBuffer), specBuffer, (unsigned long long)arg->u);
+                } else {
+                    snprintf(valueBuffer, sizeof(valueBuffer), specBuffer, (unsigned int)arg->u);
+                }
+                break;
+            case 'p':
+                snprintf(valueBuffer, sizeof(valueBuffer), specBuffer, arg->p);
+                break;
+            default:
+                snprintf(valueBuffer, sizeof(valueBuffer), specBuffer, arg->d);
+                break;
+        }
+        [message appendString:@(valueBuffer) ?: @""];
+    }
+    if (*literalStart) {
+        [message appendString:@(literalStart) ?: @""];
+    }
+    return message;
+}
+
+static void HttpdnsLogBufferDrain(void) {
+    // 先清除标记，之后写入的记录会重新安排一次处理
+    atomic_store(&sDrainScheduled, false);
+
+    BOOL consoleEnabled = [HttpdnsLog isEnabled];
+    id<HttpdnsLoggerProtocol> handler = [HttpdnsLog currentLogHandler];
+    NSMutableArray<NSString *> *handlerLogs = handler ? [NSMutableArray array] : nil;
+
+    unsigned long droppedCount = atomic_load(&sDroppedCount);
+    if (droppedCount > sReportedDroppedCount) {
+        NSString *message = [NSString stringWithFormat:@"%lu log records dropped because the log buffer is full", droppedCount - sReportedDroppedCount];
+        sReportedDroppedCount = droppedCount;
+        if (consoleEnabled) {
+            NSLog(@"%@ HTTPDNSSDKLOG - %@", [HttpdnsLog formattedDateTimeStrOfAbsoluteTime:CFAbsoluteTimeGetCurrent()], message);
+        }
+        [handlerLogs addObject:message];
+    }
+
+    for (;;) {
+        HttpdnsLogRecord *record = &sRecords[sDequeuePosition & (HTTPDNS_LOG_BUFFER_CAPACITY - 1)];
+        size_t sequence = atomic_load_explicit(&record->sequence, memory_order_acquire);
+        if (sequence != sDequeuePosition + 1) {
+            break;
+        }
+
+        const char *format = record->format;
+        uint64_t threadId = record->threadId;
+        CFAbsoluteTime timestamp = record->timestamp;
+        HttpdnsLogArg args[HTTPDNS_LOG_MAX_ARGS];
+        memcpy(args, record->args, sizeof(args));
+        atomic_store_explicit(&record->sequence, sDequeuePosition + HTTPDNS_LOG_BUFFER_CAPACITY, memory_order_release);
+        sDequeuePosition++;
+
+        // 写入后日志开关被关闭、handler被移除时，只释放参数，不再格式化
+        if (!consoleEnabled && !handlerLogs) {
+            if (format) {
+                HttpdnsLogReleaseArgs(format, args, HTTPDNS_LOG_MAX_ARGS);
+            } else {
+                CFRelease(args[0].p);
+            }
+            continue;
+        }
+
+        @autoreleasepool {
+            NSString *message;
+            if (format) {
+                message = HttpdnsLogRenderRecord(format, args);
+            } else {
+                message = CFBridgingRelease(args[0].p);
+            }
+            if (consoleEnabled) {
+                NSLog(@"%@ HTTPDNSSDKLOG [%llu] - %@", [HttpdnsLog formattedDateTimeStrOfAbsoluteTime:timestamp], threadId, message);
+            }
+            if (handlerLogs) {
+                [handlerLogs addObject:[NSString stringWithFormat:@"[%llu] %@", threadId, message]];
+            }
+        }
+    }
+
+    [HttpdnsLog outputToLogHandler:handler logs:handlerLogs];
+}
+
+void HttpdnsLogBufferFlush(void) {
+    HttpdnsLogBufferSetupIfNeeded();
+    // logHandler在回调中再触发flush时已经在处理队列上
+    if (dispatch_get_specific(sDrainQueueKey)) {
+        HttpdnsLogBufferDrain();
+        return;
+    }
+    dispatch_sync(sDrainQueue, ^{
+        HttpdnsLogBufferDrain();
+    });
+}
+
+NSUInteger HttpdnsLogBufferDroppedCount(void) {
+    return atomic_load(&sDroppedCount);
+}
@@ -8,28 +8,41 @@
 
 #import "HttpdnsLog.h"
 #import "HttpdnsLoggerProtocol.h"
-#import <pthread/pthread.h>
-
-// logHandler输出日志，不受日志开关影响
-#define HttpdnsLogDebug(frmt, ...) \
-if ([HttpdnsLog validLogHandler]) { \
-    @try { \
-        uint64_t tid = 0; \
-        pthread_threadid_np(NULL, &tid); \
-        NSString *logFormat = [NSString stringWithFormat:@"%s", frmt]; \
-        NSString *logStr = [NSString stringWithFormat:@"[%llu] %@", tid, [NSString stringWithFormat:logFormat, ##__VA_ARGS__, nil]]; \
-        [HttpdnsLog outputToLogHandler:logStr]; \
-    } @catch (NSException *exception){ \
+#import "HttpdnsLogBuffer.h"
+
+#define HTTPDNS_LOG_LEVEL_DEBUG     0
+#define HTTPDNS_LOG_LEVEL_INFO      1
+#define HTTPDNS_LOG_LEVEL_WARNING   2
+#define HTTPDNS_LOG_LEVEL_ERROR     3
+
+// 编译期的最低日志级别，低于该级别的日志连同参数求值一起被编译器移除
+// 例如在编译选项中定义 HTTPDNS_LOG_COMPILED_MIN_LEVEL=1 可去掉所有debug日志
+#ifndef HTTPDNS_LOG_COMPILED_MIN_LEVEL
+#define HTTPDNS_LOG_COMPILED_MIN_LEVEL HTTPDNS_LOG_LEVEL_DEBUG
+#endif
+
+// 只有打开日志开关或设置了logHandler时才对参数求值并写入缓冲区，格式化和输出在后台批量进行
+// if (0) 分支不会执行，只用于让编译器检查格式串与参数类型是否匹配
+#define HttpdnsLogWithLevel(level, frmt, ...) \
+do { \
+    if ((level) >= HTTPDNS_LOG_COMPILED_MIN_LEVEL && HttpdnsLogIsActive()) { \
+        HttpdnsLogBufferWrite(frmt, ##__VA_ARGS__); \
     } \
-} \
-if ([HttpdnsLog isEnabled]) { \
-    @try { \
-        uint64_t tid = 0; \
-        pthread_threadid_np(NULL, &tid); \
-        NSLog((@"%@ HTTPDNSSDKLOG [%llu] - " frmt), [HttpdnsLog getFormattedDateTimeStr], tid, ##__VA_ARGS__); \
-    } @catch (NSException *exception){ \
+    if (0) { \
+        NSLog(@"" frmt, ##__VA_ARGS__); \
     } \
-}
+} while (0)
+
+// logHandler的输出不受日志开关影响
+#define HttpdnsLogDebug(frmt, ...)      HttpdnsLogWithLevel(HTTPDNS_LOG_LEVEL_DEBUG, frmt, ##__VA_ARGS__)
+#define HttpdnsLogInfo(frmt, ...)       HttpdnsLogWithLevel(HTTPDNS_LOG_LEVEL_INFO, frmt, ##__VA_ARGS__)
+#define HttpdnsLogWarning(frmt, ...)    HttpdnsLogWithLevel(HTTPDNS_LOG_LEVEL_WARNING, frmt, ##__VA_ARGS__)
+#define HttpdnsLogError(frmt, ...)      HttpdnsLogWithLevel(HTTPDNS_LOG_LEVEL_ERROR, frmt, ##__VA_ARGS__)
+
+/**
+ * 日志开关已打开或已设置logHandler
+ */
+FOUNDATION_EXTERN BOOL HttpdnsLogIsActive(void);
 
 
 @interface HttpdnsLog ()
@@ -37,9 +50,14 @@ if ([HttpdnsLog isEnabled]) { \
 + (void)setLogHandler:(id<HttpdnsLoggerProtocol>)handler;
 + (void)unsetLogHandler;
 + (BOOL)validLogHandler;
-+ (void)outputToLogHandler:(NSString *)logStr;
++ (id<HttpdnsLoggerProtocol>)currentLogHandler;
+
+/**
+ * 批量输出到logHandler，handler实现了logBatch:时一次交付，否则逐条调用log:
+ */
++ (void)outputToLogHandler:(id<HttpdnsLoggerProtocol>)handler logs:(NSArray<NSString *> *)logs;
 
-+ (NSString *)getFormattedDateTimeStr;
++ (NSString *)formattedDateTimeStrOfAbsoluteTime:(CFAbsoluteTime)time;
 
 
 @end
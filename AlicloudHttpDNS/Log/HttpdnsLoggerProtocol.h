@@ -15,6 +15,13 @@
 
 - (void)log:(NSString *)logStr;
 
+@optional
+
+/**
+ * 日志在后台批量输出，实现该方法后每批日志只回调一次，否则逐条回调log:
+ */
+- (void)logBatch:(NSArray<NSString *> *)logStrs;
+
 @end
 
 #endif /* HttpdnsLoggerProtocol_h */
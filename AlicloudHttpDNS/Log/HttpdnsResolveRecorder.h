@@ -0,0 +1,85 @@
+//
+//  HttpdnsResolveRecorder.h
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "HttpdnsRequest.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// 记录文件格式：文件头之后是定长记录，所有字段为小端序
+#define HTTPDNS_RESOLVE_RECORD_MAGIC "HDRR"
+#define HTTPDNS_RESOLVE_RECORD_VERSION 1
+
+typedef struct __attribute__((packed)) {
+    char magic[4];
+    uint16_t version;
+    uint16_t recordSize;
+    // 开始记录时的Unix时间戳，单位秒
+    double startTime;
+} HttpdnsResolveRecordFileHeader;
+
+typedef NS_ENUM(uint8_t, HttpdnsResolveRecordOutcome) {
+    HttpdnsResolveRecordOutcomeHit = 0,
+    HttpdnsResolveRecordOutcomeStale,
+    HttpdnsResolveRecordOutcomeMiss,
+};
+
+typedef NS_OPTIONS(uint8_t, HttpdnsResolveRecordFlags) {
+    HttpdnsResolveRecordFlagBlocking = 1 << 0,
+    HttpdnsResolveRecordFlagAnswered = 1 << 1,
+    // 由不可变结果缓存或sockaddr快速路径直接应答
+    HttpdnsResolveRecordFlagFastPath = 1 << 2,
+};
+
+typedef struct __attribute__((packed)) {
+    // 域名的FNV-1a哈希，不记录域名明文
+    uint64_t hostHash;
+    // 相对开始记录的时间，单位毫秒
+    uint32_t timestamp;
+    // 解析耗时，单位微秒
+    uint32_t latency;
+    uint8_t queryIpType;
+    uint8_t outcome;
+    uint8_t flags;
+    uint8_t reserved;
+} HttpdnsResolveRecord;
+
+FOUNDATION_EXTERN uint64_t HttpdnsResolveRecordHostHash(const char *host);
+
+// 把解析事件追加到二进制文件，供离线按真实访问模式回放
+// 记录先写入内存缓冲，攒够一批后在串行队列上落盘，解析线程上不做IO
+@interface HttpdnsResolveRecorder : NSObject
+
+@property (nonatomic, copy, readonly) NSString *path;
+
+// 已记录的事件数，包含尚未落盘的
+@property (nonatomic, assign, readonly) NSUInteger recordCount;
+
+- (nullable instancetype)initWithPath:(NSString *)path error:(NSError **)error;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+// startTime为HttpdnsMetricsNow()的返回值，耗时计算到调用时刻
+- (void)recordHostHash:(uint64_t)hostHash
+           queryIpType:(HttpdnsQueryIPType)queryIpType
+               outcome:(HttpdnsResolveRecordOutcome)outcome
+                 flags:(HttpdnsResolveRecordFlags)flags
+             startTime:(uint64_t)startTime;
+
+- (void)recordRequest:(HttpdnsRequest *)request
+              outcome:(HttpdnsResolveRecordOutcome)outcome
+             answered:(BOOL)answered
+             fastPath:(BOOL)fastPath
+            startTime:(uint64_t)startTime;
+
+// 写出缓冲中的记录并关闭文件，之后的记录被丢弃
+- (void)close;
+
+@end
+
+NS_ASSUME_NONNULL_END
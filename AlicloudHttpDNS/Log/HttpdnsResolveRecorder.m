@@ -0,0 +1,176 @@
+//
+//  HttpdnsResolveRecorder.m
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "HttpdnsResolveRecorder.h"
+#import "HttpdnsClock.h"
+#import "HttpdnsLog_Internal.h"
+#import "HttpdnsMetrics.h"
+#import "HttpdnsRequest_Internal.h"
+#import <os/lock.h>
+#import <stdio.h>
+
+// 缓冲的记录数，约5KB，攒满后交给写入队列
+#define HTTPDNS_RESOLVE_RECORD_BATCH_SIZE 256
+
+uint64_t HttpdnsResolveRecordHostHash(const char *host) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    if (!host) {
+        return hash;
+    }
+    for (const unsigned char *p = (const unsigned char *)host; *p; p++) {
+        hash ^= *p;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+@implementation HttpdnsResolveRecorder {
+    os_unfair_lock _lock;
+    HttpdnsResolveRecord *_buffer;
+    NSUInteger _bufferedCount;
+    NSUInteger _recordCount;
+    BOOL _closed;
+    uint64_t _startTime;
+    FILE *_file;
+    dispatch_queue_t _writeQueue;
+}
+
+- (instancetype)initWithPath:(NSString *)path error:(NSError **)error {
+    if (self = [super init]) {
+        _path = [path copy];
+        _file = fopen(path.fileSystemRepresentation, "wb");
+        if (!_file) {
+            if (error) {
+                *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:@{NSFilePathErrorKey: path}];
+            }
+            return nil;
+        }
+
+        HttpdnsResolveRecordFileHeader header = {0};
+        memcpy(header.magic, HTTPDNS_RESOLVE_RECORD_MAGIC, sizeof(header.magic));
+        header.version = HTTPDNS_RESOLVE_RECORD_VERSION;
+        header.recordSize = sizeof(HttpdnsResolveRecord);
+        header.startTime = HttpdnsClockNow();
+        fwrite(&header, sizeof(header), 1, _file);
+
+        _lock = OS_UNFAIR_LOCK_INIT;
+        _buffer = malloc(sizeof(HttpdnsResolveRecord) * HTTPDNS_RESOLVE_RECORD_BATCH_SIZE);
+        _startTime = HttpdnsMetricsNow();
+        _writeQueue = dispatch_queue_create("com.alibaba.sdk.httpdns.resolveRecordWriteQueue", DISPATCH_QUEUE_SERIAL);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    // 已提交的批次持有self，走到这里时写入队列上已没有任务
+    if (_file) {
+        if (!_closed && _bufferedCount > 0) {
+            fwrite(_buffer, sizeof(HttpdnsResolveRecord) * _bufferedCount, 1, _file);
+        }
+        fclose(_file);
+    }
+    free(_buffer);
+}
+
+- (NSUInteger)recordCount {
+    os_unfair_lock_lock(&_lock);
+    NSUInteger recordCount = _recordCount;
+    os_unfair_lock_unlock(&_lock);
+    return recordCount;
+}
+
+- (void)recordRequest:(HttpdnsRequest *)request
+              outcome:(HttpdnsResolveRecordOutcome)outcome
+             answered:(BOOL)answered
+             fastPath:(BOOL)fastPath
+            startTime:(uint64_t)startTime {
+    HttpdnsResolveRecordFlags flags = 0;
+    if (request.isBlockingRequest) {
+        flags |= HttpdnsResolveRecordFlagBlocking;
+    }
+    if (answered) {
+        flags |= HttpdnsResolveRecordFlagAnswered;
+    }
+    if (fastPath) {
+        flags |= HttpdnsResolveRecordFlagFastPath;
+    }
+    [self recordHostHash:HttpdnsResolveRecordHostHash(request.host.UTF8String)
+             queryIpType:request.queryIpType
+                 outcome:outcome
+                   flags:flags
+               startTime:startTime];
+}
+
+- (void)recordHostHash:(uint64_t)hostHash
+           queryIpType:(HttpdnsQueryIPType)queryIpType
+               outcome:(HttpdnsResolveRecordOutcome)outcome
+                 flags:(HttpdnsResolveRecordFlags)flags
+             startTime:(uint64_t)startTime {
+    uint64_t now = HttpdnsMetricsNow();
+    HttpdnsResolveRecord record = {
+        .hostHash = hostHash,
+        .timestamp = (uint32_t)MIN((startTime - MIN(startTime, _startTime)) / NSEC_PER_MSEC, UINT32_MAX),
+        .latency = (uint32_t)MIN((now - MIN(now, startTime)) / NSEC_PER_USEC, UINT32_MAX),
+        .queryIpType = (uint8_t)queryIpType,
+        .outcome = outcome,
+        .flags = flags,
+        .reserved = 0,
+    };
+
+    NSData *batch = nil;
+    os_unfair_lock_lock(&_lock);
+    if (!_closed) {
+        _buffer[_bufferedCount++] = record;
+        _recordCount++;
+        if (_bufferedCount == HTTPDNS_RESOLVE_RECORD_BATCH_SIZE) {
+            batch = [NSData dataWithBytes:_buffer length:sizeof(HttpdnsResolveRecord) * _bufferedCount];
+            _bufferedCount = 0;
+        }
+    }
+    os_unfair_lock_unlock(&_lock);
+
+    if (batch) {
+        dispatch_async(_writeQueue, ^{
+            [self writeBatch:batch];
+        });
+    }
+}
+
+// 只在写入队列上调用
+- (void)writeBatch:(NSData *)batch {
+    if (!_file) {
+        return;
+    }
+    if (fwrite(batch.bytes, batch.length, 1, _file) != 1) {
+        HttpdnsLogDebug("Write resolve records failed, path: %@, errno: %d", _path, errno);
+    }
+}
+
+- (void)close {
+    NSData *batch = nil;
+    os_unfair_lock_lock(&_lock);
+    if (_closed) {
+        os_unfair_lock_unlock(&_lock);
+        return;
+    }
+    _closed = YES;
+    batch = [NSData dataWithBytes:_buffer length:sizeof(HttpdnsResolveRecord) * _bufferedCount];
+    _bufferedCount = 0;
+    os_unfair_lock_unlock(&_lock);
+
+    // 同步等待之前提交的批次写完，返回时文件内容已完整
+    dispatch_sync(_writeQueue, ^{
+        [self writeBatch:batch];
+        if (self->_file) {
+            fclose(self->_file);
+            self->_file = NULL;
+        }
+    });
+}
+
+@end
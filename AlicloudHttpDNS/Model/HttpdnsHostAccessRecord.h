@@ -0,0 +1,37 @@
+//
+//  HttpdnsHostAccessRecord.h
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * 单个域名按指数衰减累计的访问频率
+ *
+ * score为最近一次访问时刻的累计值，任意时刻t的频率为 score × 2^(-(t - lastAccessTime) / 半衰期)，
+ * 只在访问时更新，不需要定时衰减
+ */
+@interface HttpdnsHostAccessRecord : NSObject <NSCopying>
+
+@property (nonatomic, copy, readonly) NSString *hostName;
+
+@property (nonatomic, assign) double score;
+
+// 最近一次访问的Unix时间戳，单位秒
+@property (nonatomic, assign) NSTimeInterval lastAccessTime;
+
+- (instancetype)initWithHostName:(NSString *)hostName score:(double)score lastAccessTime:(NSTimeInterval)lastAccessTime;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+// 衰减到指定时刻的访问频率
+- (double)scoreAtTime:(NSTimeInterval)time halfLife:(NSTimeInterval)halfLife;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,37 @@
+//
+//  HttpdnsHostAccessRecord.m
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "HttpdnsHostAccessRecord.h"
+#import <math.h>
+
+@implementation HttpdnsHostAccessRecord
+
+- (instancetype)initWithHostName:(NSString *)hostName score:(double)score lastAccessTime:(NSTimeInterval)lastAccessTime {
+    if (self = [super init]) {
+        _hostName = [hostName copy];
+        _score = score;
+        _lastAccessTime = lastAccessTime;
+    }
+    return self;
+}
+
+- (double)scoreAtTime:(NSTimeInterval)time halfLife:(NSTimeInterval)halfLife {
+    // 时钟回拨时不放大历史频率
+    NSTimeInterval elapsed = MAX(time - _lastAccessTime, 0);
+    return halfLife > 0 ? _score * exp2(-elapsed / halfLife) : _score;
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+    return [[HttpdnsHostAccessRecord allocWithZone:zone] initWithHostName:_hostName score:_score lastAccessTime:_lastAccessTime];
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"{hostName: %@, score: %.3f, lastAccessTime: %.0f}", _hostName, _score, _lastAccessTime];
+}
+
+@end
@@ -18,7 +18,9 @@
  */
 
 #import <Foundation/Foundation.h>
+#import <sys/socket.h>
 #import "HttpdnsRequest.h"
+#import "HttpdnsIpQuality.h"
 
 @class HttpdnsHostRecord;
 @class HttpdnsIPRecord;
@@ -27,9 +29,38 @@
 
 @interface HttpdnsIpObject: NSObject<NSCoding, NSCopying>
 
+// 地址以in_addr/in6_addr的二进制形式保存，不持有字符串；每次读取都重新格式化，热路径上应使用getIpCString:length:
 @property (nonatomic, copy, getter=getIpString, setter=setIp:) NSString *ip;
+
+/**
+ * 把地址格式化到调用方提供的缓冲区，不创建对象
+ * @param buffer 缓冲区，长度不小于INET6_ADDRSTRLEN时总能写下可解析的地址
+ * @return 是否写入成功；无法解析的地址不写入，返回NO
+ */
+- (BOOL)getIpCString:(char *)buffer length:(socklen_t)length;
+
+// 地址族，AF_INET或AF_INET6；无法解析的地址为AF_UNSPEC
+@property (nonatomic, assign, readonly) sa_family_t family;
+
+- (BOOL)isIPv6;
+
 @property (nonatomic, assign) NSInteger connectedRT;
 
+// 多次探测的统计，用于排序；未探测过时返回共用的默认统计，只能读取，记录样本使用addProbeSample:
+@property (nonatomic, strong) HttpdnsIpQuality *quality;
+
+/**
+ * 累积一个探测样本并同步更新connectedRT
+ * @param costTime 建连耗时（毫秒），-1表示失败
+ */
+- (void)addProbeSample:(NSInteger)costTime;
+
+/**
+ * 把地址和端口写入sockaddr_storage，不经过字符串
+ * @return sockaddr的实际长度，无法解析的地址返回0
+ */
+- (socklen_t)getSockaddr:(struct sockaddr_storage *)storage port:(uint16_t)port;
+
 @end
 
 
@@ -53,7 +84,8 @@
 @property (nonatomic, assign) int64_t lastIPv6LookupTime;
 
 // 用来标记该域名为配置v4记录或v6记录的情况，避免如双栈网络下因为某个协议查不到record需要重复请求
-// 这个信息不用持久化，一次APP启动周期内使用是合适的
+// 标记的地址族作为负缓存，IP为空，lastIPvXLookupTime和ttl记录负缓存的有效期，过期后重新请求
+// 持久化时以"IP为空但ttl有效"的形式保存，从数据库加载时据此恢复标记
 @property (nonatomic, assign) BOOL hasNoIpv4Record;
 @property (nonatomic, assign) BOOL hasNoIpv6Record;
 
@@ -68,6 +100,23 @@
 
 - (BOOL)isExpiredUnderQueryIpType:(HttpdnsQueryIPType)queryIPType;
 
+// 以给定的秒级时间戳判断是否过期，不创建NSDate，供热路径使用
+- (BOOL)isExpiredUnderQueryIpType:(HttpdnsQueryIPType)queryIPType atTime:(int64_t)currentEpoch;
+
+/**
+ * 查询类型中需要重新解析的地址族，即已过期或还没有IP的地址族
+ * 已确认没有对应记录的地址族在负缓存有效期内不需要重新解析；v4、v6的ttl分开计算，未过期的一半不会被带上
+ */
+- (HttpdnsQueryIPType)staleQueryIpTypeUnderQueryIpType:(HttpdnsQueryIPType)queryIPType;
+
+/**
+ * 把查询类型中的地址族标记为没有记录，清空IP并以负缓存时长作为ttl
+ * @param queryIPType 需要标记的地址族
+ * @param ttl 负缓存时长（秒）
+ * @param currentEpoch 当前秒级时间戳
+ */
+- (void)markNoRecordUnderQueryIpType:(HttpdnsQueryIPType)queryIPType ttl:(int64_t)ttl atTime:(int64_t)currentEpoch;
+
 + (instancetype)fromDBRecord:(HttpdnsHostRecord *)IPRecord;
 
 /**
@@ -81,10 +130,43 @@
 - (NSArray<NSString *> *)getV6IpStrings;
 
 /**
- * 更新指定IP的connectedRT值并重新排序IP列表
+ * 记录指定IP的一次探测结果并立即重新排序该IP所在的列表
  * @param ip 需要更新的IP地址
  * @param connectedRT 检测到的RT值，-1表示不可达
  */
 - (void)updateConnectedRT:(NSInteger)connectedRT forIP:(NSString *)ip;
 
+/**
+ * 记录指定IP的一次探测结果，不重新排序
+ * 一轮探测的样本都记录后再调用rerankIps，避免每个样本都打乱一次顺序
+ * @param connectedRT 检测到的RT值，-1表示不可达
+ * @param ip 需要更新的IP地址
+ */
+- (void)recordProbeSample:(NSInteger)connectedRT forIP:(NSString *)ip;
+
+/**
+ * 按期望代价对v4、v6列表重新排序，代价相同时保持原有顺序
+ */
+- (void)rerankIps;
+
+/**
+ * 从旧对象中继承相同IP的探测统计，用于解析结果更新后保留已有的排序依据
+ * @param hostObject 旧的缓存对象
+ */
+- (void)inheritIpQualityFrom:(HttpdnsHostObject *)hostObject;
+
+/**
+ * 按RFC 8305的方式交错两个地址族，ipv6在前，把排序后的地址写入调用方提供的数组
+ * 只遍历已有的IP对象，不产生新的对象
+ * @param queryType 需要输出的地址族
+ * @param port 写入每个地址的端口
+ * @param sockaddrs 调用方提供的数组
+ * @param maxCount 数组容量
+ * @return 写入的地址数量
+ */
+- (NSUInteger)copySockaddrsUnderQueryIpType:(HttpdnsQueryIPType)queryType
+                                       port:(uint16_t)port
+                                         to:(struct sockaddr_storage *)sockaddrs
+                                   maxCount:(NSUInteger)maxCount;
+
 @end
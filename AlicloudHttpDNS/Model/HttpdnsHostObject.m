@@ -23,9 +23,53 @@
 #import "HttpdnsLog_Internal.h"
 #import "HttpdnsHostRecord.h"
 #import "HttpdnsIPQualityDetector.h"
+#import "HttpdnsClock.h"
+#import <arpa/inet.h>
+
+// 解析IP字符串，IPv4地址存放在前4个字节；无法解析时返回AF_UNSPEC
+static sa_family_t HttpdnsParseIpAddress(NSString *ip, struct in6_addr *address) {
+    memset(address, 0, sizeof(*address));
+    const char *ipChars = [ip UTF8String];
+    if (!ipChars) {
+        return AF_UNSPEC;
+    }
+    // 只有IPv6地址包含冒号，据此只做一次inet_pton
+    if (strchr(ipChars, ':')) {
+        return inet_pton(AF_INET6, ipChars, address) == 1 ? AF_INET6 : AF_UNSPEC;
+    }
+    return inet_pton(AF_INET, ipChars, address) == 1 ? AF_INET : AF_UNSPEC;
+}
+
+static size_t HttpdnsAddressLength(sa_family_t family) {
+    return family == AF_INET6 ? sizeof(struct in6_addr) : sizeof(struct in_addr);
+}
+
+// 未探测过的IP共用这一份只读的默认统计，首次记录样本时才分配自己的统计
+static HttpdnsIpQuality *HttpdnsUnprobedIpQuality(void) {
+    static HttpdnsIpQuality *quality;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        quality = [[HttpdnsIpQuality alloc] init];
+    });
+    return quality;
+}
 
 
-@implementation HttpdnsIpObject
+@interface HttpdnsIpObject ()
+
+@property (nonatomic, assign) sa_family_t family;
+
+- (BOOL)hasAddress:(const struct in6_addr *)address family:(sa_family_t)family;
+
+- (BOOL)hasSameAddressAs:(HttpdnsIpObject *)other;
+
+@end
+
+@implementation HttpdnsIpObject {
+    struct in6_addr _address;
+    // 只有无法解析的地址才保存原始字符串
+    NSString *_unparsedIp;
+}
 
 - (instancetype)init {
     if (self = [super init]) {
@@ -35,10 +79,15 @@
     return self;
 }
 
+- (HttpdnsIpQuality *)quality {
+    return _quality ?: HttpdnsUnprobedIpQuality();
+}
+
 - (id)initWithCoder:(NSCoder *)aDecoder {
     if (self = [super init]) {
         self.ip = [aDecoder decodeObjectForKey:@"ip"];
         self.connectedRT = [aDecoder decodeIntegerForKey:@"connectedRT"];
+        self.quality = [aDecoder decodeObjectForKey:@"quality"] ?: [HttpdnsIpQuality qualityWithConnectedRT:self.connectedRT];
     }
     return self;
 }
@@ -46,40 +95,138 @@
 - (void)encodeWithCoder:(NSCoder *)aCoder {
     [aCoder encodeObject:self.ip forKey:@"ip"];
     [aCoder encodeInteger:self.connectedRT forKey:@"connectedRT"];
+    [aCoder encodeObject:self.quality forKey:@"quality"];
 }
 
 - (id)copyWithZone:(NSZone *)zone {
     HttpdnsIpObject *copy = [[[self class] allocWithZone:zone] init];
     if (copy) {
-        copy.ip = [self.ip copyWithZone:zone];
+        // 直接拷贝二进制地址，不经过字符串
+        copy->_address = _address;
+        copy->_family = _family;
+        copy->_unparsedIp = _unparsedIp;
         copy.connectedRT = self.connectedRT;
+        copy->_quality = [_quality copyWithZone:zone];
     }
     return copy;
 }
 
 + (NSArray<HttpdnsIpObject *> *)IPObjectsFromIPs:(NSArray<NSString *> *)IPs {
+    return [self IPObjectsFromIPs:IPs qualities:nil];
+}
+
++ (NSArray<HttpdnsIpObject *> *)IPObjectsFromIPs:(NSArray<NSString *> *)IPs qualities:(NSArray<HttpdnsIpQuality *> *)qualities {
+    // 持久化恢复的探测统计与IP一一对应，数量不一致时忽略
+    BOOL hasQualities = qualities.count == IPs.count;
     NSMutableArray *IPObjects = [NSMutableArray arrayWithCapacity:IPs.count];
-    for (NSString *IP in IPs) {
+    [IPs enumerateObjectsUsingBlock:^(NSString *IP, NSUInteger idx, BOOL *stop) {
         HttpdnsIpObject *IPObject = [HttpdnsIpObject new];
         IPObject.ip = IP;
-        IPObject.connectedRT = NSIntegerMax;
+        if (hasQualities) {
+            IPObject.quality = [qualities[idx] copy];
+            IPObject.connectedRT = [IPObject.quality connectedRT];
+        }
         [IPObjects addObject:IPObject];
-    }
+    }];
     return [IPObjects copy];
 }
 
++ (NSArray<HttpdnsIpQuality *> *)qualitiesOfIPObjects:(NSArray<HttpdnsIpObject *> *)IPObjects {
+    // 拷贝一份，避免落盘期间统计被探测回调修改
+    NSMutableArray<HttpdnsIpQuality *> *qualities = [NSMutableArray arrayWithCapacity:IPObjects.count];
+    for (HttpdnsIpObject *IPObject in IPObjects) {
+        [qualities addObject:[IPObject.quality copy]];
+    }
+    return [qualities copy];
+}
+
+- (void)setIp:(NSString *)ip {
+    _family = HttpdnsParseIpAddress(ip, &_address);
+    _unparsedIp = _family == AF_UNSPEC ? [ip copy] : nil;
+}
+
+- (NSString *)getIpString {
+    if (_family == AF_UNSPEC) {
+        return _unparsedIp;
+    }
+
+    // 不缓存结果，否则几乎每个IP对象都会因为日志、构造结果或落盘而长期持有一个字符串
+    char buffer[INET6_ADDRSTRLEN];
+    if (![self getIpCString:buffer length:sizeof(buffer)]) {
+        return nil;
+    }
+    return [NSString stringWithUTF8String:buffer];
+}
+
+- (BOOL)getIpCString:(char *)buffer length:(socklen_t)length {
+    if (_family == AF_UNSPEC || !buffer) {
+        return NO;
+    }
+    return inet_ntop(_family, &_address, buffer, length) != NULL;
+}
+
+- (BOOL)isIPv6 {
+    return _family == AF_INET6;
+}
+
+- (BOOL)hasAddress:(const struct in6_addr *)address family:(sa_family_t)family {
+    return _family == family && memcmp(&_address, address, HttpdnsAddressLength(family)) == 0;
+}
+
+- (BOOL)hasSameAddressAs:(HttpdnsIpObject *)other {
+    if (_family == AF_UNSPEC) {
+        return other->_family == AF_UNSPEC && [_unparsedIp isEqualToString:other->_unparsedIp];
+    }
+    return [other hasAddress:&_address family:_family];
+}
+
+- (socklen_t)getSockaddr:(struct sockaddr_storage *)storage port:(uint16_t)port {
+    memset(storage, 0, sizeof(*storage));
+    if (_family == AF_INET6) {
+        struct sockaddr_in6 *addr6 = (struct sockaddr_in6 *)storage;
+        addr6->sin6_len = sizeof(struct sockaddr_in6);
+        addr6->sin6_family = AF_INET6;
+        addr6->sin6_port = htons(port);
+        memcpy(&addr6->sin6_addr, &_address, sizeof(struct in6_addr));
+        return sizeof(struct sockaddr_in6);
+    }
+    if (_family == AF_INET) {
+        struct sockaddr_in *addr4 = (struct sockaddr_in *)storage;
+        addr4->sin_len = sizeof(struct sockaddr_in);
+        addr4->sin_family = AF_INET;
+        addr4->sin_port = htons(port);
+        memcpy(&addr4->sin_addr, &_address, sizeof(struct in_addr));
+        return sizeof(struct sockaddr_in);
+    }
+    return 0;
+}
+
+- (void)addProbeSample:(NSInteger)costTime {
+    if (!_quality) {
+        _quality = [[HttpdnsIpQuality alloc] init];
+    }
+    [_quality addSample:costTime];
+    self.connectedRT = [_quality connectedRT];
+}
+
 - (NSString *)description {
+    char buffer[INET6_ADDRSTRLEN];
+    const char *ip = [self getIpCString:buffer length:sizeof(buffer)] ? buffer : [_unparsedIp UTF8String];
     if (self.connectedRT == NSIntegerMax) {
-        return [NSString stringWithFormat:@"ip: %@", self.ip];
+        return [NSString stringWithFormat:@"ip: %s", ip ?: "(null)"];
     } else {
-        return [NSString stringWithFormat:@"ip: %@, connectedRT: %ld", self.ip, self.connectedRT];
+        return [NSString stringWithFormat:@"ip: %s, connectedRT: %ld", ip ?: "(null)", self.connectedRT];
     }
 }
 
 @end
 
 
-@implementation HttpdnsHostObject
+@implementation HttpdnsHostObject {
+    // IP字符串数组在首次读取时生成，IP列表被替换（包括重新排序）时失效
+    NSArray<NSString *> *_v4IpStrings;
+    NSArray<NSString *> *_v6IpStrings;
+}
 
 - (instancetype)init {
     _hostName = nil;
@@ -159,25 +306,60 @@
         copy.hasNoIpv6Record = self.hasNoIpv6Record;
         copy.extra = [self.extra copyWithZone:zone];
         copy.isLoadFromDB = self.isLoadFromDB;
+        // 拷贝的IP列表顺序相同，字符串数组不可变，可以直接共用，缓存读取返回的拷贝不需要重新生成
+        copy->_v4IpStrings = _v4IpStrings;
+        copy->_v6IpStrings = _v6IpStrings;
     }
     return copy;
 }
 
 - (BOOL)isExpiredUnderQueryIpType:(HttpdnsQueryIPType)queryIPType {
-    int64_t currentEpoch = (int64_t)[[[NSDate alloc] init] timeIntervalSince1970];
+    int64_t currentEpoch = HttpdnsClockCurrentEpoch();
+    return [self isExpiredUnderQueryIpType:queryIPType atTime:currentEpoch];
+}
+
+- (BOOL)isExpiredUnderQueryIpType:(HttpdnsQueryIPType)queryIPType atTime:(int64_t)currentEpoch {
+    // 没有记录的地址族同样按lastIPvXLookupTime和ttl判断，即负缓存的有效期
     if ((queryIPType & HttpdnsQueryIPTypeIpv4)
-        && !_hasNoIpv4Record
         && _lastIPv4LookupTime + _v4ttl <= currentEpoch) {
         return YES;
     }
     if ((queryIPType & HttpdnsQueryIPTypeIpv6)
-        && !_hasNoIpv6Record
         && _lastIPv6LookupTime + _v6ttl <= currentEpoch) {
         return YES;
     }
     return NO;
 }
 
+- (HttpdnsQueryIPType)staleQueryIpTypeUnderQueryIpType:(HttpdnsQueryIPType)queryIPType {
+    int64_t currentEpoch = HttpdnsClockCurrentEpoch();
+    HttpdnsQueryIPType staleQueryIpType = 0;
+    if ((queryIPType & HttpdnsQueryIPTypeIpv4)
+        && (([HttpdnsUtil isEmptyArray:_v4Ips] && !_hasNoIpv4Record) || _lastIPv4LookupTime + _v4ttl <= currentEpoch)) {
+        staleQueryIpType |= HttpdnsQueryIPTypeIpv4;
+    }
+    if ((queryIPType & HttpdnsQueryIPTypeIpv6)
+        && (([HttpdnsUtil isEmptyArray:_v6Ips] && !_hasNoIpv6Record) || _lastIPv6LookupTime + _v6ttl <= currentEpoch)) {
+        staleQueryIpType |= HttpdnsQueryIPTypeIpv6;
+    }
+    return staleQueryIpType;
+}
+
+- (void)markNoRecordUnderQueryIpType:(HttpdnsQueryIPType)queryIPType ttl:(int64_t)ttl atTime:(int64_t)currentEpoch {
+    if (queryIPType & HttpdnsQueryIPTypeIpv4) {
+        _hasNoIpv4Record = YES;
+        [self setV4Ips:@[]];
+        _v4ttl = ttl;
+        _lastIPv4LookupTime = currentEpoch;
+    }
+    if (queryIPType & HttpdnsQueryIPTypeIpv6) {
+        _hasNoIpv6Record = YES;
+        [self setV6Ips:@[]];
+        _v6ttl = ttl;
+        _lastIPv6LookupTime = currentEpoch;
+    }
+}
+
 + (instancetype)fromDBRecord:(HttpdnsHostRecord *)hostRecord {
     HttpdnsHostObject *hostObject = [HttpdnsHostObject new];
     [hostObject setCacheKey:hostRecord.cacheKey];
@@ -186,16 +368,25 @@
     NSArray *v4ips = hostRecord.v4ips;
     NSArray *v6ips = hostRecord.v6ips;
     if ([HttpdnsUtil isNotEmptyArray:v4ips]) {
-        [hostObject setV4Ips:[HttpdnsIpObject IPObjectsFromIPs:v4ips]];
+        [hostObject setV4Ips:[HttpdnsIpObject IPObjectsFromIPs:v4ips qualities:hostRecord.v4IpQualities]];
         [hostObject setV4TTL:hostRecord.v4ttl];
         [hostObject setLastIPv4LookupTime:hostRecord.v4LookupTime];
 
     }
     if ([HttpdnsUtil isNotEmptyArray:v6ips]) {
-        [hostObject setV6Ips:[HttpdnsIpObject IPObjectsFromIPs:v6ips]];
+        [hostObject setV6Ips:[HttpdnsIpObject IPObjectsFromIPs:v6ips qualities:hostRecord.v6IpQualities]];
         [hostObject setV6TTL:hostRecord.v6ttl];
         [hostObject setLastIPv6LookupTime:hostRecord.v6LookupTime];
     }
+
+    // IP为空但ttl仍有效的地址族是持久化的负缓存，恢复没有记录的标记；已过期的负缓存没有意义，按未解析处理
+    int64_t currentEpoch = HttpdnsClockCurrentEpoch();
+    if ([HttpdnsUtil isEmptyArray:v4ips] && hostRecord.v4ttl > 0 && hostRecord.v4LookupTime + hostRecord.v4ttl > currentEpoch) {
+        [hostObject markNoRecordUnderQueryIpType:HttpdnsQueryIPTypeIpv4 ttl:hostRecord.v4ttl atTime:hostRecord.v4LookupTime];
+    }
+    if ([HttpdnsUtil isEmptyArray:v6ips] && hostRecord.v6ttl > 0 && hostRecord.v6LookupTime + hostRecord.v6ttl > currentEpoch) {
+        [hostObject markNoRecordUnderQueryIpType:HttpdnsQueryIPTypeIpv6 ttl:hostRecord.v6ttl atTime:hostRecord.v6LookupTime];
+    }
     [hostObject setExtra:hostRecord.extra];
     [hostObject setIsLoadFromDB:YES];
     return hostObject;
@@ -207,7 +398,7 @@
     NSArray<NSString *> *v6IpStrings = [self getV6IpStrings];
 
     // 创建当前时间作为modifyAt
-    NSDate *currentDate = [NSDate date];
+    NSDate *currentDate = HttpdnsClockCurrentDate();
 
     // 使用hostName作为cacheKey，保持与fromDBRecord方法的一致性
     return [[HttpdnsHostRecord alloc] initWithId:0  // 数据库会自动分配ID
@@ -217,80 +408,157 @@
                                        modifyAt:currentDate
                                        clientIp:self.clientIp
                                        v4ips:v4IpStrings
+                                       v4IpQualities:[HttpdnsIpObject qualitiesOfIPObjects:[self getV4Ips]]
                                        v4ttl:self.v4ttl
                                        v4LookupTime:self.lastIPv4LookupTime
                                        v6ips:v6IpStrings
+                                       v6IpQualities:[HttpdnsIpObject qualitiesOfIPObjects:[self getV6Ips]]
                                        v6ttl:self.v6ttl
                                        v6LookupTime:self.lastIPv6LookupTime
                                        extra:self.extra];
 }
 
+- (void)setV4Ips:(NSArray<HttpdnsIpObject *> *)v4Ips {
+    _v4Ips = v4Ips;
+    _v4IpStrings = nil;
+}
+
+- (void)setV6Ips:(NSArray<HttpdnsIpObject *> *)v6Ips {
+    _v6Ips = v6Ips;
+    _v6IpStrings = nil;
+}
+
 - (NSArray<NSString *> *)getV4IpStrings {
-    NSArray<HttpdnsIpObject *> *ipv4Records = [self getV4Ips];
-    NSMutableArray<NSString *> *ipv4Strings = [NSMutableArray arrayWithCapacity:ipv4Records.count];
-    for (HttpdnsIpObject *IPObject in ipv4Records) {
-        [ipv4Strings addObject:[IPObject getIpString]];
+    if (!_v4IpStrings) {
+        _v4IpStrings = [HttpdnsHostObject ipStringsOfIpObjects:[self getV4Ips]];
     }
-    return [ipv4Strings copy];
+    return _v4IpStrings;
 }
 
 - (NSArray<NSString *> *)getV6IpStrings {
-    NSArray<HttpdnsIpObject *> *ipv6Records = [self getV6Ips];
-    NSMutableArray<NSString *> *ipv6sString = [NSMutableArray arrayWithCapacity:ipv6Records.count];
-    for (HttpdnsIpObject *ipObject in ipv6Records) {
-        [ipv6sString addObject:[ipObject getIpString]];
+    if (!_v6IpStrings) {
+        _v6IpStrings = [HttpdnsHostObject ipStringsOfIpObjects:[self getV6Ips]];
+    }
+    return _v6IpStrings;
+}
+
++ (NSArray<NSString *> *)ipStringsOfIpObjects:(NSArray<HttpdnsIpObject *> *)ipObjects {
+    NSMutableArray<NSString *> *ipStrings = [NSMutableArray arrayWithCapacity:ipObjects.count];
+    for (HttpdnsIpObject *ipObject in ipObjects) {
+        NSString *ipString = [ipObject getIpString];
+        if (ipString) {
+            [ipStrings addObject:ipString];
+        }
     }
-    return [ipv6sString copy];
+    return [ipStrings copy];
 }
 
 - (void)updateConnectedRT:(NSInteger)connectedRT forIP:(NSString *)ip {
-    if ([HttpdnsUtil isEmptyString:ip]) {
+    struct in6_addr address;
+    sa_family_t family = HttpdnsParseIpAddress(ip, &address);
+    if (![self recordProbeSampleAndReturnFound:connectedRT forAddress:&address family:family]) {
         return;
     }
 
-    BOOL isIPv6 = [HttpdnsUtil isIPv6Address:ip];
-
-    NSArray<HttpdnsIpObject *> *ipObjects = isIPv6 ? [self getV6Ips] : [self getV4Ips];
-    if ([HttpdnsUtil isEmptyArray:ipObjects]) {
-        return;
+    if (family == AF_INET6) {
+        [self setV6Ips:[HttpdnsHostObject rankedIpObjects:[self getV6Ips]]];
+    } else {
+        [self setV4Ips:[HttpdnsHostObject rankedIpObjects:[self getV4Ips]]];
     }
+}
 
-    // 查找匹配的IP对象并更新connectedRT
-    BOOL found = NO;
-    NSMutableArray<HttpdnsIpObject *> *mutableIpObjects = [ipObjects mutableCopy];
+- (void)recordProbeSample:(NSInteger)connectedRT forIP:(NSString *)ip {
+    struct in6_addr address;
+    sa_family_t family = HttpdnsParseIpAddress(ip, &address);
+    [self recordProbeSampleAndReturnFound:connectedRT forAddress:&address family:family];
+}
 
+- (BOOL)recordProbeSampleAndReturnFound:(NSInteger)connectedRT forAddress:(const struct in6_addr *)address family:(sa_family_t)family {
+    if (family == AF_UNSPEC) {
+        return NO;
+    }
+
+    // 按二进制地址比较，不需要为每个IP生成字符串
+    NSArray<HttpdnsIpObject *> *ipObjects = family == AF_INET6 ? [self getV6Ips] : [self getV4Ips];
     for (HttpdnsIpObject *ipObject in ipObjects) {
-        if ([ipObject.ip isEqualToString:ip]) {
-            ipObject.connectedRT = connectedRT;
-            found = YES;
-            break;
+        if ([ipObject hasAddress:address family:family]) {
+            [ipObject addProbeSample:connectedRT];
+            return YES;
         }
     }
+    return NO;
+}
+
+- (void)rerankIps {
+    if ([HttpdnsUtil isNotEmptyArray:[self getV4Ips]]) {
+        [self setV4Ips:[HttpdnsHostObject rankedIpObjects:[self getV4Ips]]];
+    }
+    if ([HttpdnsUtil isNotEmptyArray:[self getV6Ips]]) {
+        [self setV6Ips:[HttpdnsHostObject rankedIpObjects:[self getV6Ips]]];
+    }
+}
 
-    if (!found) {
++ (NSArray<HttpdnsIpObject *> *)rankedIpObjects:(NSArray<HttpdnsIpObject *> *)ipObjects {
+    // 稳定排序，代价相同（例如都未探测）时保持服务端下发的顺序
+    return [ipObjects sortedArrayWithOptions:NSSortStable usingComparator:^NSComparisonResult(HttpdnsIpObject *obj1, HttpdnsIpObject *obj2) {
+        double cost1 = [obj1.quality expectedCost];
+        double cost2 = [obj2.quality expectedCost];
+        return cost1 > cost2 ? NSOrderedDescending : (cost1 < cost2 ? NSOrderedAscending : NSOrderedSame);
+    }];
+}
+
+- (void)inheritIpQualityFrom:(HttpdnsHostObject *)hostObject {
+    if (!hostObject) {
         return;
     }
 
-    // 根据connectedRT值对IP列表进行排序，-1值放在最后
-    [mutableIpObjects sortUsingComparator:^NSComparisonResult(HttpdnsIpObject *obj1, HttpdnsIpObject *obj2) {
-        // 如果obj1的connectedRT为-1，将其排在后面
-        if (obj1.connectedRT == -1) {
-            return NSOrderedDescending;
+    // 每个地址族只有几个IP，按二进制地址逐个比较，不需要生成字符串作为key
+    BOOL inherited = [HttpdnsHostObject inheritIpQualityTo:[self getV4Ips] from:[hostObject getV4Ips]];
+    inherited = [HttpdnsHostObject inheritIpQualityTo:[self getV6Ips] from:[hostObject getV6Ips]] || inherited;
+
+    if (inherited) {
+        [self rerankIps];
+    }
+}
+
++ (BOOL)inheritIpQualityTo:(NSArray<HttpdnsIpObject *> *)currentIpObjects from:(NSArray<HttpdnsIpObject *> *)previousIpObjects {
+    BOOL inherited = NO;
+    for (HttpdnsIpObject *ipObject in currentIpObjects) {
+        if (ipObject.quality.sampleCount > 0) {
+            continue;
         }
-        // 如果obj2的connectedRT为-1，将其排在后面
-        if (obj2.connectedRT == -1) {
-            return NSOrderedAscending;
+        for (HttpdnsIpObject *previous in previousIpObjects) {
+            if (previous.quality.sampleCount > 0 && [previous hasSameAddressAs:ipObject]) {
+                ipObject.quality = [previous.quality copy];
+                ipObject.connectedRT = [ipObject.quality connectedRT];
+                inherited = YES;
+                break;
+            }
         }
-        // 否则按照connectedRT值从小到大排序
-        return obj1.connectedRT > obj2.connectedRT ? NSOrderedDescending : (obj1.connectedRT < obj2.connectedRT ? NSOrderedAscending : NSOrderedSame);
-    }];
+    }
+    return inherited;
+}
 
-    // 更新排序后的IP列表
-    if (isIPv6) {
-        [self setV6Ips:[mutableIpObjects copy]];
-    } else {
-        [self setV4Ips:[mutableIpObjects copy]];
+- (NSUInteger)copySockaddrsUnderQueryIpType:(HttpdnsQueryIPType)queryType
+                                       port:(uint16_t)port
+                                         to:(struct sockaddr_storage *)sockaddrs
+                                   maxCount:(NSUInteger)maxCount {
+    NSArray<HttpdnsIpObject *> *v4Ips = (queryType & HttpdnsQueryIPTypeIpv4) ? _v4Ips : nil;
+    NSArray<HttpdnsIpObject *> *v6Ips = (queryType & HttpdnsQueryIPTypeIpv6) ? _v6Ips : nil;
+    NSUInteger v4Count = v4Ips.count;
+    NSUInteger v6Count = v6Ips.count;
+
+    // 两个地址族交替输出，ipv6在前，各自保持排序后的顺序
+    NSUInteger written = 0;
+    for (NSUInteger i = 0; i < MAX(v4Count, v6Count) && written < maxCount; i++) {
+        if (i < v6Count && [v6Ips[i] getSockaddr:&sockaddrs[written] port:port] > 0) {
+            written++;
+        }
+        if (i < v4Count && written < maxCount && [v4Ips[i] getSockaddr:&sockaddrs[written] port:port] > 0) {
+            written++;
+        }
     }
+    return written;
 }
 
 - (NSString *)description {
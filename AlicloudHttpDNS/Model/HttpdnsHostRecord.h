@@ -7,6 +7,7 @@
 //
 
 #import <Foundation/Foundation.h>
+#import "HttpdnsIpQuality.h"
 
 @interface HttpdnsHostRecord : NSObject
 
@@ -36,6 +37,31 @@
 
 @property (nonatomic, copy, readonly) NSString *extra;
 
+// 与v4ips一一对应的探测统计；为空表示未知
+@property (nonatomic, copy, readonly) NSArray<HttpdnsIpQuality *> *v4IpQualities;
+
+// 与v6ips一一对应的探测统计；为空表示未知
+@property (nonatomic, copy, readonly) NSArray<HttpdnsIpQuality *> *v6IpQualities;
+
+// 由探测统计得出的代表耗时（毫秒），NSIntegerMax表示未探测，-1表示不可达
+- (NSArray<NSNumber *> *)v4ConnectedRTs;
+
+- (NSArray<NSNumber *> *)v6ConnectedRTs;
+
+- (instancetype)initWithId:(NSUInteger)id
+                    cacheKey:(NSString *)cacheKey
+                    hostName:(NSString *)hostName
+                    createAt:(NSDate *)createAt
+                    modifyAt:(NSDate *)modifyAt
+                    clientIp:(NSString *)clientIp
+                    v4ips:(NSArray<NSString *> *)v4ips
+                    v4ttl:(int64_t)v4ttl
+                    v4LookupTime:(int64_t)v4LookupTime
+                    v6ips:(NSArray<NSString *> *)v6ips
+                    v6ttl:(int64_t)v6ttl
+                    v6LookupTime:(int64_t)v6LookupTime
+                    extra:(NSString *)extra;
+
 - (instancetype)initWithId:(NSUInteger)id
                     cacheKey:(NSString *)cacheKey
                     hostName:(NSString *)hostName
@@ -43,9 +69,11 @@
                     modifyAt:(NSDate *)modifyAt
                     clientIp:(NSString *)clientIp
                     v4ips:(NSArray<NSString *> *)v4ips
+                    v4IpQualities:(NSArray<HttpdnsIpQuality *> *)v4IpQualities
                     v4ttl:(int64_t)v4ttl
                     v4LookupTime:(int64_t)v4LookupTime
                     v6ips:(NSArray<NSString *> *)v6ips
+                    v6IpQualities:(NSArray<HttpdnsIpQuality *> *)v6IpQualities
                     v6ttl:(int64_t)v6ttl
                     v6LookupTime:(int64_t)v6LookupTime
                     extra:(NSString *)extra;
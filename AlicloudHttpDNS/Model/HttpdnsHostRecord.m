@@ -37,6 +37,10 @@
 
 @property (nonatomic, copy) NSString *extra;
 
+@property (nonatomic, copy) NSArray<HttpdnsIpQuality *> *v4IpQualities;
+
+@property (nonatomic, copy) NSArray<HttpdnsIpQuality *> *v6IpQualities;
+
 @end
 
 
@@ -55,6 +59,38 @@
                      v6ttl:(int64_t)v6ttl
               v6LookupTime:(int64_t)v6LookupTime
                      extra:(NSString *)extra {
+    return [self initWithId:id
+                   cacheKey:cacheKey
+                   hostName:hostName
+                   createAt:createAt
+                   modifyAt:modifyAt
+                   clientIp:clientIp
+                      v4ips:v4ips
+              v4IpQualities:nil
+                      v4ttl:v4ttl
+               v4LookupTime:v4LookupTime
+                      v6ips:v6ips
+              v6IpQualities:nil
+                      v6ttl:v6ttl
+               v6LookupTime:v6LookupTime
+                      extra:extra];
+}
+
+- (instancetype)initWithId:(NSUInteger)id
+                  cacheKey:(NSString *)cacheKey
+                  hostName:(NSString *)hostName
+                  createAt:(NSDate *)createAt
+                  modifyAt:(NSDate *)modifyAt
+                  clientIp:(NSString *)clientIp
+                     v4ips:(NSArray<NSString *> *)v4ips
+             v4IpQualities:(NSArray<HttpdnsIpQuality *> *)v4IpQualities
+                     v4ttl:(int64_t)v4ttl
+              v4LookupTime:(int64_t)v4LookupTime
+                     v6ips:(NSArray<NSString *> *)v6ips
+             v6IpQualities:(NSArray<HttpdnsIpQuality *> *)v6IpQualities
+                     v6ttl:(int64_t)v6ttl
+              v6LookupTime:(int64_t)v6LookupTime
+                     extra:(NSString *)extra {
     self = [super init];
     if (self) {
         _id = id;
@@ -70,10 +106,29 @@
         _v6ttl = v6ttl;
         _v6LookupTime = v6LookupTime;
         _extra = [extra copy];
+        // 与IP数量不一致时视为未知，避免错位
+        _v4IpQualities = v4IpQualities.count == _v4ips.count ? [v4IpQualities copy] : @[];
+        _v6IpQualities = v6IpQualities.count == _v6ips.count ? [v6IpQualities copy] : @[];
     }
     return self;
 }
 
+- (NSArray<NSNumber *> *)v4ConnectedRTs {
+    return [self connectedRTsOfQualities:_v4IpQualities];
+}
+
+- (NSArray<NSNumber *> *)v6ConnectedRTs {
+    return [self connectedRTsOfQualities:_v6IpQualities];
+}
+
+- (NSArray<NSNumber *> *)connectedRTsOfQualities:(NSArray<HttpdnsIpQuality *> *)qualities {
+    NSMutableArray<NSNumber *> *connectedRTs = [NSMutableArray arrayWithCapacity:qualities.count];
+    for (HttpdnsIpQuality *quality in qualities) {
+        [connectedRTs addObject:@([quality connectedRT])];
+    }
+    return [connectedRTs copy];
+}
+
 - (NSString *)description {
     NSString *hostName = self.hostName;
     if (self.cacheKey) {
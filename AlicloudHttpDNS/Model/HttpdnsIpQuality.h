@@ -0,0 +1,68 @@
+//
+//  HttpdnsIpQuality.h
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/25.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * 单个IP的多次探测统计
+ *
+ * 建连耗时和失败率都按指数加权平均累积，排序使用期望代价：
+ * 平均耗时 + 一倍标准差 + 失败率 × 失败惩罚，单次偶然的快慢不会让排序大幅跳动
+ */
+@interface HttpdnsIpQuality : NSObject <NSCoding, NSCopying>
+
+// 成功建连耗时的指数加权平均（毫秒），还没有成功样本时为-1
+@property (nonatomic, assign, readonly) double ewmaRT;
+
+// 成功建连耗时的指数加权方差
+@property (nonatomic, assign, readonly) double rtVariance;
+
+// 指数加权的失败率，范围0~1
+@property (nonatomic, assign, readonly) double failureRate;
+
+// 累计样本数量，包括失败样本
+@property (nonatomic, assign, readonly) NSUInteger sampleCount;
+
+- (instancetype)initWithEwmaRT:(double)ewmaRT
+                    rtVariance:(double)rtVariance
+                   failureRate:(double)failureRate
+                   sampleCount:(NSUInteger)sampleCount;
+
+/**
+ * 由单次探测结果构造，用于兼容只记录了connectedRT的旧数据
+ * @param connectedRT 建连耗时，NSIntegerMax表示未探测，-1表示不可达
+ */
++ (instancetype)qualityWithConnectedRT:(NSInteger)connectedRT;
+
+/**
+ * 累积一个探测样本
+ * @param costTime 建连耗时（毫秒），-1表示失败
+ */
+- (void)addSample:(NSInteger)costTime;
+
+/**
+ * 与旧字段兼容的代表耗时：未探测为NSIntegerMax，从未成功为-1，否则为平均耗时
+ */
+- (NSInteger)connectedRT;
+
+/**
+ * 排序使用的期望代价（毫秒），越小越优先
+ * 未探测的IP视为中等质量，从未成功的IP排在最后
+ */
+- (double)expectedCost;
+
+/**
+ * 是否大概率不可达：有探测样本，且从未成功或近期失败率过半
+ */
+- (BOOL)isLikelyUnreachable;
+
+@end
+
+NS_ASSUME_NONNULL_END
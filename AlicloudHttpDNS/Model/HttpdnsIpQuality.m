@@ -0,0 +1,139 @@
+//
+//  HttpdnsIpQuality.m
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/25.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "HttpdnsIpQuality.h"
+
+// 新样本的权重，约等于最近3~5次样本决定统计值
+static const double kHttpdnsIpQualityEwmaAlpha = 0.3;
+
+// 一次失败的代价，与探测超时时间一致
+static const double kHttpdnsIpQualityFailurePenalty = 2000;
+
+// 未探测IP的期望代价，排在表现良好的IP之后、经常失败的IP之前
+static const double kHttpdnsIpQualityUnknownCost = 1000;
+
+// 失败率达到该值即视为不可达
+static const double kHttpdnsIpQualityUnreachableFailureRate = 0.5;
+
+@interface HttpdnsIpQuality ()
+
+@property (nonatomic, assign) double ewmaRT;
+@property (nonatomic, assign) double rtVariance;
+@property (nonatomic, assign) double failureRate;
+@property (nonatomic, assign) NSUInteger sampleCount;
+
+@end
+
+@implementation HttpdnsIpQuality
+
+- (instancetype)init {
+    return [self initWithEwmaRT:-1 rtVariance:0 failureRate:0 sampleCount:0];
+}
+
+- (instancetype)initWithEwmaRT:(double)ewmaRT
+                    rtVariance:(double)rtVariance
+                   failureRate:(double)failureRate
+                   sampleCount:(NSUInteger)sampleCount {
+    if (self = [super init]) {
+        _ewmaRT = ewmaRT;
+        _rtVariance = MAX(rtVariance, 0);
+        _failureRate = MIN(MAX(failureRate, 0), 1);
+        _sampleCount = sampleCount;
+    }
+    return self;
+}
+
++ (instancetype)qualityWithConnectedRT:(NSInteger)connectedRT {
+    HttpdnsIpQuality *quality = [[HttpdnsIpQuality alloc] init];
+    if (connectedRT != NSIntegerMax) {
+        [quality addSample:connectedRT];
+    }
+    return quality;
+}
+
+- (id)initWithCoder:(NSCoder *)aDecoder {
+    return [self initWithEwmaRT:[aDecoder decodeDoubleForKey:@"ewmaRT"]
+                     rtVariance:[aDecoder decodeDoubleForKey:@"rtVariance"]
+                    failureRate:[aDecoder decodeDoubleForKey:@"failureRate"]
+                    sampleCount:(NSUInteger)[aDecoder decodeIntegerForKey:@"sampleCount"]];
+}
+
+- (void)encodeWithCoder:(NSCoder *)aCoder {
+    [aCoder encodeDouble:self.ewmaRT forKey:@"ewmaRT"];
+    [aCoder encodeDouble:self.rtVariance forKey:@"rtVariance"];
+    [aCoder encodeDouble:self.failureRate forKey:@"failureRate"];
+    [aCoder encodeInteger:(NSInteger)self.sampleCount forKey:@"sampleCount"];
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+    return [[[self class] allocWithZone:zone] initWithEwmaRT:self.ewmaRT
+                                                  rtVariance:self.rtVariance
+                                                 failureRate:self.failureRate
+                                                 sampleCount:self.sampleCount];
+}
+
+- (void)addSample:(NSInteger)costTime {
+    double alpha = kHttpdnsIpQualityEwmaAlpha;
+    BOOL failed = costTime < 0;
+
+    // 第一个样本直接作为初始值，避免从0开始的偏差
+    if (_sampleCount == 0) {
+        _failureRate = failed ? 1 : 0;
+    } else {
+        _failureRate = (1 - alpha) * _failureRate + (failed ? alpha : 0);
+    }
+    _sampleCount++;
+
+    if (failed) {
+        return;
+    }
+
+    if (_ewmaRT < 0) {
+        _ewmaRT = costTime;
+        _rtVariance = 0;
+        return;
+    }
+
+    double diff = costTime - _ewmaRT;
+    _ewmaRT += alpha * diff;
+    _rtVariance = (1 - alpha) * (_rtVariance + alpha * diff * diff);
+}
+
+- (NSInteger)connectedRT {
+    if (_sampleCount == 0) {
+        return NSIntegerMax;
+    }
+    if (_ewmaRT < 0) {
+        return -1;
+    }
+    return (NSInteger)llround(_ewmaRT);
+}
+
+- (double)expectedCost {
+    if (_sampleCount == 0) {
+        return kHttpdnsIpQualityUnknownCost;
+    }
+    if (_ewmaRT < 0) {
+        return kHttpdnsIpQualityFailurePenalty * (1 + _failureRate);
+    }
+    return _ewmaRT + sqrt(_rtVariance) + _failureRate * kHttpdnsIpQualityFailurePenalty;
+}
+
+- (BOOL)isLikelyUnreachable {
+    if (_sampleCount == 0) {
+        return NO;
+    }
+    return _ewmaRT < 0 || _failureRate >= kHttpdnsIpQualityUnreachableFailureRate;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"ewmaRT: %.1f, stddev: %.1f, failureRate: %.2f, samples: %lu",
+            _ewmaRT, sqrt(_rtVariance), _failureRate, (unsigned long)_sampleCount];
+}
+
+@end
@@ -69,6 +69,37 @@ static double const RESOLVE_HOST_MAX_TIMEOUT_IN_SEC = 5;
     }
 }
 
+- (HttpdnsRequest *)requestNarrowedToQueryIpType:(HttpdnsQueryIPType)queryIpType {
+    HttpdnsRequest *request = [[HttpdnsRequest alloc] initWithHost:_host
+                                                       queryIpType:queryIpType
+                                                        sdnsParams:_sdnsParams
+                                                          cacheKey:_cacheKey
+                                                    resolveTimeout:_resolveTimeoutInSecond];
+    request.accountId = _accountId;
+    request.isBlockingRequest = _isBlockingRequest;
+    request.predictedHosts = _predictedHosts;
+    return request;
+}
+
+- (HttpdnsRequest *)requestWithResolveTimeout:(double)resolveTimeoutInSecond {
+    HttpdnsRequest *request = [self requestNarrowedToQueryIpType:_queryIpType];
+    request.resolveTimeoutInSecond = resolveTimeoutInSecond;
+    return request;
+}
+
+- (HttpdnsRequest *)requestWithPredictedHosts:(NSArray<NSString *> *)predictedHosts {
+    HttpdnsRequest *request = [self requestNarrowedToQueryIpType:_queryIpType];
+    request.predictedHosts = predictedHosts;
+    return request;
+}
+
+- (NSString *)resolvingHostsString {
+    if (_predictedHosts.count == 0) {
+        return _host;
+    }
+    return [[@[_host] arrayByAddingObjectsFromArray:_predictedHosts] componentsJoinedByString:@","];
+}
+
 - (NSString *)description {
     return [NSString stringWithFormat:@"Host: %@, isBlockingRequest: %d, queryIpType: %ld, sdnsParams: %@, cacheKey: %@", self.host, self.isBlockingRequest, self.queryIpType, self.sdnsParams, self.cacheKey];
 }
@@ -14,12 +14,27 @@
 
 @property (nonatomic, assign) BOOL isBlockingRequest;
 
+// 随本次请求一起批量解析的预测域名，结果以域名为cacheKey写入缓存
+@property (nonatomic, copy) NSArray<NSString *> *predictedHosts;
+
 - (void)becomeBlockingRequest;
 
 - (void)becomeNonBlockingRequest;
 
 - (void)ensureResolveTimeoutInReasonableRange;
 
+// 复制一个只查询指定地址族的请求，其余参数不变
+- (HttpdnsRequest *)requestNarrowedToQueryIpType:(HttpdnsQueryIPType)queryIpType;
+
+// 复制一个使用指定解析超时的请求，其余参数不变；不做范围修正，用于扣除已经花掉的等待时间
+- (HttpdnsRequest *)requestWithResolveTimeout:(double)resolveTimeoutInSecond;
+
+// 复制一个附带预测域名的请求，其余参数不变
+- (HttpdnsRequest *)requestWithPredictedHosts:(NSArray<NSString *> *)predictedHosts;
+
+// 实际发给解析服务的域名列表，附带预测域名时以逗号分隔
+- (NSString *)resolvingHostsString;
+
 @end
 
 #endif /* HttpdnsRequest_Internal_h */
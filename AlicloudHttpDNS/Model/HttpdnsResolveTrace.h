@@ -0,0 +1,79 @@
+//
+//  HttpdnsResolveTrace.h
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <AlicloudHTTPDNS/HttpdnsRequest.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// 解析链路中的阶段
+typedef NS_ENUM(NSInteger, HttpdnsResolveTracePhase) {
+    // 查询内存缓存，包括等待缓存锁和按需从持久化缓存加载
+    HttpdnsResolveTracePhaseCacheLookup = 0,
+    // 等待同一域名进行中的解析完成
+    HttpdnsResolveTracePhaseLockWait = 1,
+    // 从连接池取出可复用的连接
+    HttpdnsResolveTracePhaseConnectionDequeue = 2,
+    // 没有可复用的连接时新建连接，包括TCP和TLS握手
+    HttpdnsResolveTracePhaseConnectionHandshake = 3,
+    // 发送请求并接收完整响应
+    HttpdnsResolveTracePhaseSendReceive = 4,
+    // 解析HTTP响应
+    HttpdnsResolveTracePhaseHTTPParse = 5,
+    // 解密加密的响应数据
+    HttpdnsResolveTracePhaseDecrypt = 6,
+    // 解析响应的JSON
+    HttpdnsResolveTracePhaseJSONParse = 7,
+    // 把解析结果合并到内存缓存
+    HttpdnsResolveTracePhaseMerge = 8,
+    // 提交持久化缓存的写入
+    HttpdnsResolveTracePhasePersist = 9,
+};
+
+@interface HttpdnsResolveTraceSpan : NSObject
+
+@property (nonatomic, assign, readonly) HttpdnsResolveTracePhase phase;
+
+// 单调时钟时间戳，单位纳秒，与mach_absolute_time同一时钟源（CLOCK_UPTIME_RAW）
+@property (nonatomic, assign, readonly) uint64_t startTime;
+@property (nonatomic, assign, readonly) uint64_t endTime;
+
+// 耗时，单位纳秒
+- (uint64_t)duration;
+
+@end
+
+/// 一次解析请求在各阶段的耗时
+/// 重试时同一阶段会出现多次；合并结果时的持久化提交位于合并阶段之内
+@interface HttpdnsResolveTrace : NSObject
+
+@property (nonatomic, copy, readonly) NSString *host;
+
+@property (nonatomic, copy, readonly, nullable) NSString *cacheKey;
+
+@property (nonatomic, assign, readonly) HttpdnsQueryIPType queryIpType;
+
+// 单调时钟时间戳，单位纳秒，与span的时间戳基准相同
+@property (nonatomic, assign, readonly) uint64_t startTime;
+@property (nonatomic, assign, readonly) uint64_t endTime;
+
+// 是否直接使用了缓存结果；缓存过期需要后台刷新时，追踪在刷新完成后才结束
+@property (nonatomic, assign, readonly) BOOL cacheHit;
+
+// 按开始先后排列
+@property (nonatomic, copy, readonly) NSArray<HttpdnsResolveTraceSpan *> *spans;
+
+// 整个解析的耗时，单位纳秒
+- (uint64_t)duration;
+
+// 某一阶段所有span的耗时之和，单位纳秒
+- (uint64_t)totalDurationOfPhase:(HttpdnsResolveTracePhase)phase;
+
+@end
+
+NS_ASSUME_NONNULL_END
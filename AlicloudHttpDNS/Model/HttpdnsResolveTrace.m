@@ -0,0 +1,116 @@
+//
+//  HttpdnsResolveTrace.m
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "HttpdnsResolveTrace.h"
+#import "HttpdnsResolveTrace_Internal.h"
+#import <time.h>
+
+static __thread __unsafe_unretained HttpdnsResolveTrace *sCurrentTrace = nil;
+
+uint64_t HttpdnsResolveTraceNow(void) {
+    return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+@interface HttpdnsResolveTraceSpan ()
+
+@property (nonatomic, assign, readwrite) HttpdnsResolveTracePhase phase;
+@property (nonatomic, assign, readwrite) uint64_t startTime;
+@property (nonatomic, assign, readwrite) uint64_t endTime;
+
+@end
+
+@implementation HttpdnsResolveTraceSpan
+
+- (uint64_t)duration {
+    return self.endTime > self.startTime ? self.endTime - self.startTime : 0;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"{phase: %ld, duration: %lluns}", (long)self.phase, self.duration];
+}
+
+@end
+
+@interface HttpdnsResolveTrace ()
+
+@property (nonatomic, copy, readwrite) NSString *host;
+@property (nonatomic, copy, readwrite, nullable) NSString *cacheKey;
+@property (nonatomic, assign, readwrite) HttpdnsQueryIPType queryIpType;
+@property (nonatomic, assign, readwrite) uint64_t startTime;
+@property (nonatomic, assign, readwrite) uint64_t endTime;
+
+@end
+
+@implementation HttpdnsResolveTrace {
+    NSMutableArray<HttpdnsResolveTraceSpan *> *_spans;
+}
+
+- (instancetype)initWithRequest:(HttpdnsRequest *)request {
+    if (self = [super init]) {
+        _host = [request.host copy] ?: @"";
+        _cacheKey = [request.cacheKey copy];
+        _queryIpType = request.queryIpType;
+        _startTime = HttpdnsResolveTraceNow();
+        _spans = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)addSpanWithPhase:(HttpdnsResolveTracePhase)phase startTime:(uint64_t)startTime {
+    HttpdnsResolveTraceSpan *span = [HttpdnsResolveTraceSpan new];
+    span.phase = phase;
+    span.startTime = startTime;
+    span.endTime = HttpdnsResolveTraceNow();
+    @synchronized (self) {
+        // span在结束时记录，嵌套的阶段先于外层阶段结束，按开始时间插入保持顺序
+        NSUInteger index = _spans.count;
+        while (index > 0 && _spans[index - 1].startTime > startTime) {
+            index--;
+        }
+        [_spans insertObject:span atIndex:index];
+    }
+}
+
+- (void)finish {
+    self.endTime = HttpdnsResolveTraceNow();
+}
+
+- (NSArray<HttpdnsResolveTraceSpan *> *)spans {
+    @synchronized (self) {
+        return [_spans copy];
+    }
+}
+
+- (uint64_t)duration {
+    return self.endTime > self.startTime ? self.endTime - self.startTime : 0;
+}
+
+- (uint64_t)totalDurationOfPhase:(HttpdnsResolveTracePhase)phase {
+    uint64_t total = 0;
+    for (HttpdnsResolveTraceSpan *span in self.spans) {
+        if (span.phase == phase) {
+            total += span.duration;
+        }
+    }
+    return total;
+}
+
++ (HttpdnsResolveTrace *)currentTrace {
+    return sCurrentTrace;
+}
+
++ (void)setCurrentTrace:(HttpdnsResolveTrace *)trace {
+    sCurrentTrace = trace;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"{host: %@, cacheKey: %@, queryIpType: %lu, cacheHit: %d, duration: %lluns, spans: %@}",
+            self.host, self.cacheKey, (unsigned long)self.queryIpType, self.cacheHit, self.duration, self.spans];
+}
+
+@end
@@ -0,0 +1,35 @@
+//
+//  HttpdnsResolveTrace_Internal.h
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "HttpdnsResolveTrace.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// 追踪使用的单调时钟，单位纳秒
+FOUNDATION_EXTERN uint64_t HttpdnsResolveTraceNow(void);
+
+@interface HttpdnsResolveTrace ()
+
+@property (nonatomic, assign, readwrite) BOOL cacheHit;
+
+- (instancetype)initWithRequest:(HttpdnsRequest *)request;
+
+// 记录一个从startTime到当前时刻的阶段
+- (void)addSpanWithPhase:(HttpdnsResolveTracePhase)phase startTime:(uint64_t)startTime;
+
+- (void)finish;
+
+// 当前线程上进行中的追踪，供不持有请求对象的网络层和解析层使用；未采样时为nil
+// 不持有追踪对象，设置方需在清除前一直持有
++ (nullable HttpdnsResolveTrace *)currentTrace;
+
++ (void)setCurrentTrace:(nullable HttpdnsResolveTrace *)trace;
+
+@end
+
+NS_ASSUME_NONNULL_END
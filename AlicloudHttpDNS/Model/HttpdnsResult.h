@@ -10,6 +10,17 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+// 从解析结果中选择单个IP的策略
+typedef NS_ENUM(NSInteger, HttpdnsIpSelectionStrategy) {
+    // 总是选择排序第一的IP，与firstIpv4Address/firstIpv6Address一致
+    HttpdnsIpSelectionStrategyFirst = 0,
+    // 按建连质量加权随机选择，越快的IP被选中的概率越大
+    HttpdnsIpSelectionStrategyWeightedRandom = 1,
+    // 按客户端做一致性哈希，同一客户端在IP集合不变时总是选中同一个IP，不同客户端分散到不同IP
+    // 客户端以本地保存的安装标识区分，跨App启动保持不变，卸载重装后会变化
+    HttpdnsIpSelectionStrategyConsistentHash = 2,
+};
+
 @interface HttpdnsResult : NSObject
 
 @property (nonatomic, copy) NSString *host;
@@ -37,6 +48,15 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (nullable NSString *)firstIpv6Address;
 
+/// 按指定策略选择一个ipv4地址，用于把不同客户端的流量分散到多个IP上，避免都集中在排序第一的IP
+/// 大概率不可达的IP和明显比最优IP慢的IP不参与选择；全部不可达时返回排序第一的IP
+/// @param strategy 选择策略
+- (nullable NSString *)selectIpv4AddressWithStrategy:(HttpdnsIpSelectionStrategy)strategy;
+
+/// 按指定策略选择一个ipv6地址，规则同selectIpv4AddressWithStrategy:
+/// @param strategy 选择策略
+- (nullable NSString *)selectIpv6AddressWithStrategy:(HttpdnsIpSelectionStrategy)strategy;
+
 @end
 
 NS_ASSUME_NONNULL_END
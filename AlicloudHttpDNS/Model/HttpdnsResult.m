@@ -7,9 +7,27 @@
 //
 
 #import "HttpdnsResult.h"
+#import "HttpdnsResult_Internal.h"
+#import "HttpdnsIpSelector.h"
 
 @implementation HttpdnsResult
 
+- (HttpdnsResult *)shallowCopy {
+    // 数组属性都是不可变的，直接共用，只分配结果对象本身
+    HttpdnsResult *copy = [[HttpdnsResult alloc] init];
+    copy.host = self.host;
+    copy.ips = self.ips;
+    copy.ipv6s = self.ipv6s;
+    copy.lastUpdatedTimeInterval = self.lastUpdatedTimeInterval;
+    copy.v6LastUpdatedTimeInterval = self.v6LastUpdatedTimeInterval;
+    copy.ttl = self.ttl;
+    copy.v6ttl = self.v6ttl;
+    copy.v4ExpectedCosts = self.v4ExpectedCosts;
+    copy.v6ExpectedCosts = self.v6ExpectedCosts;
+    copy.selectionHashKey = self.selectionHashKey;
+    return copy;
+}
+
 - (BOOL)hasIpv4Address {
     return self.ips.count > 0;
 }
@@ -32,6 +50,20 @@
     return self.ipv6s.firstObject;
 }
 
+- (nullable NSString *)selectIpv4AddressWithStrategy:(HttpdnsIpSelectionStrategy)strategy {
+    return [HttpdnsIpSelector selectFromIps:self.ips
+                              expectedCosts:self.v4ExpectedCosts
+                                   strategy:strategy
+                                    hashKey:self.selectionHashKey];
+}
+
+- (nullable NSString *)selectIpv6AddressWithStrategy:(HttpdnsIpSelectionStrategy)strategy {
+    return [HttpdnsIpSelector selectFromIps:self.ipv6s
+                              expectedCosts:self.v6ExpectedCosts
+                                   strategy:strategy
+                                    hashKey:self.selectionHashKey];
+}
+
 - (NSString *)description {
     NSMutableString *result = [NSMutableString stringWithFormat:@"Host: %@", self.host];
 
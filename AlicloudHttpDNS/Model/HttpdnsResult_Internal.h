@@ -0,0 +1,35 @@
+//
+//  HttpdnsResult_Internal.h
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/27.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#ifndef HttpdnsResult_Internal_h
+#define HttpdnsResult_Internal_h
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface HttpdnsResult ()
+
+// 与ips一一对应的期望建连代价（毫秒），大概率不可达为-1；为空表示没有质量信息
+@property (nonatomic, copy, nullable) NSArray<NSNumber *> *v4ExpectedCosts;
+
+// 与ipv6s一一对应的期望建连代价，含义同v4ExpectedCosts
+@property (nonatomic, copy, nullable) NSArray<NSNumber *> *v6ExpectedCosts;
+
+// 一致性哈希使用的客户端标识
+@property (nonatomic, copy, nullable) NSString *selectionHashKey;
+
+/**
+ * 生成一个浅拷贝，与原结果共用不可变的IP数组，只分配结果对象本身
+ * 缓存中构造好的结果不直接交给调用方，每次命中返回一个浅拷贝，调用方修改拷贝不会影响缓存和其他调用方
+ */
+- (HttpdnsResult *)shallowCopy;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+#endif /* HttpdnsResult_Internal_h */
@@ -0,0 +1,49 @@
+//
+//  HttpdnsStartupMetrics.h
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// SDK初始化各阶段的耗时，单位均为毫秒
+/// 延迟初始化时，数据库、IP协议栈探测、网络状态监听和调度配置加载在后台队列上执行，不计入调用线程耗时
+@interface HttpdnsStartupMetrics : NSObject
+
+// 是否使用了延迟初始化
+@property (nonatomic, assign, readonly) BOOL deferredInitialization;
+
+// 所有组件是否已初始化完成，未完成时尚未执行的阶段耗时为0
+@property (nonatomic, assign, readonly) BOOL completed;
+
+// 初始化接口在调用线程上的耗时
+@property (nonatomic, assign, readonly) double callerThreadDurationInMilliseconds;
+
+// 从调用初始化接口到所有组件初始化完成的耗时
+@property (nonatomic, assign, readonly) double totalDurationInMilliseconds;
+
+// 创建内存缓存、映射持久化缓存快照
+@property (nonatomic, assign, readonly) double requestManagerCreationDurationInMilliseconds;
+
+// 创建调度中心，包括准备本地配置目录
+@property (nonatomic, assign, readonly) double scheduleCenterCreationDurationInMilliseconds;
+
+// 打开数据库，包括建表和表结构迁移
+@property (nonatomic, assign, readonly) double databaseOpenDurationInMilliseconds;
+
+// 探测当前网络的IP协议栈
+@property (nonatomic, assign, readonly) double ipStackDetectionDurationInMilliseconds;
+
+// 获取当前网络状态并启动网络变化监听
+@property (nonatomic, assign, readonly) double reachabilityStartDurationInMilliseconds;
+
+// 按region初始化服务IP列表并加载本地缓存的调度配置
+@property (nonatomic, assign, readonly) double scheduleConfigLoadDurationInMilliseconds;
+
+@end
+
+NS_ASSUME_NONNULL_END
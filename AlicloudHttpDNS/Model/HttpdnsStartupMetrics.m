@@ -0,0 +1,113 @@
+//
+//  HttpdnsStartupMetrics.m
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "HttpdnsStartupMetrics.h"
+#import "HttpdnsStartupMetrics_Internal.h"
+#import "HttpdnsMetrics.h"
+#import <os/lock.h>
+
+@implementation HttpdnsStartupMetrics {
+    os_unfair_lock _lock;
+    uint64_t _startTime;
+    uint64_t _callerThreadDuration;
+    uint64_t _totalDuration;
+    uint64_t _phaseDurations[HttpdnsStartupPhaseCount];
+}
+
+- (instancetype)initWithDeferredInitialization:(BOOL)deferredInitialization {
+    if (self = [super init]) {
+        _lock = OS_UNFAIR_LOCK_INIT;
+        _deferredInitialization = deferredInitialization;
+        _startTime = HttpdnsMetricsNow();
+    }
+    return self;
+}
+
+- (void)recordPhase:(HttpdnsStartupPhase)phase startTime:(uint64_t)startTime {
+    if (phase >= HttpdnsStartupPhaseCount) {
+        return;
+    }
+    uint64_t now = HttpdnsMetricsNow();
+    os_unfair_lock_lock(&_lock);
+    _phaseDurations[phase] = now - MIN(now, startTime);
+    os_unfair_lock_unlock(&_lock);
+}
+
+- (void)markCallerThreadFinished {
+    uint64_t now = HttpdnsMetricsNow();
+    os_unfair_lock_lock(&_lock);
+    _callerThreadDuration = now - MIN(now, _startTime);
+    os_unfair_lock_unlock(&_lock);
+}
+
+- (void)markCompleted {
+    uint64_t now = HttpdnsMetricsNow();
+    os_unfair_lock_lock(&_lock);
+    _totalDuration = now - MIN(now, _startTime);
+    _completed = YES;
+    os_unfair_lock_unlock(&_lock);
+}
+
+- (HttpdnsStartupMetrics *)snapshot {
+    HttpdnsStartupMetrics *snapshot = [[HttpdnsStartupMetrics alloc] initWithDeferredInitialization:_deferredInitialization];
+    os_unfair_lock_lock(&_lock);
+    snapshot->_startTime = _startTime;
+    snapshot->_callerThreadDuration = _callerThreadDuration;
+    snapshot->_totalDuration = _totalDuration;
+    snapshot->_completed = _completed;
+    memcpy(snapshot->_phaseDurations, _phaseDurations, sizeof(_phaseDurations));
+    os_unfair_lock_unlock(&_lock);
+    return snapshot;
+}
+
+static double HttpdnsStartupMilliseconds(uint64_t nanoseconds) {
+    return (double)nanoseconds / NSEC_PER_MSEC;
+}
+
+- (double)callerThreadDurationInMilliseconds {
+    return HttpdnsStartupMilliseconds(_callerThreadDuration);
+}
+
+- (double)totalDurationInMilliseconds {
+    return HttpdnsStartupMilliseconds(_totalDuration);
+}
+
+- (double)requestManagerCreationDurationInMilliseconds {
+    return HttpdnsStartupMilliseconds(_phaseDurations[HttpdnsStartupPhaseRequestManagerCreation]);
+}
+
+- (double)scheduleCenterCreationDurationInMilliseconds {
+    return HttpdnsStartupMilliseconds(_phaseDurations[HttpdnsStartupPhaseScheduleCenterCreation]);
+}
+
+- (double)databaseOpenDurationInMilliseconds {
+    return HttpdnsStartupMilliseconds(_phaseDurations[HttpdnsStartupPhaseDatabaseOpen]);
+}
+
+- (double)ipStackDetectionDurationInMilliseconds {
+    return HttpdnsStartupMilliseconds(_phaseDurations[HttpdnsStartupPhaseIpStackDetection]);
+}
+
+- (double)reachabilityStartDurationInMilliseconds {
+    return HttpdnsStartupMilliseconds(_phaseDurations[HttpdnsStartupPhaseReachabilityStart]);
+}
+
+- (double)scheduleConfigLoadDurationInMilliseconds {
+    return HttpdnsStartupMilliseconds(_phaseDurations[HttpdnsStartupPhaseScheduleConfigLoad]);
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"{deferred: %d, completed: %d, callerThread: %.3fms, total: %.3fms, "
+            @"phases: {requestManager: %.3fms, scheduleCenter: %.3fms, database: %.3fms, ipStack: %.3fms, reachability: %.3fms, scheduleConfig: %.3fms}}",
+            self.deferredInitialization, self.completed, self.callerThreadDurationInMilliseconds, self.totalDurationInMilliseconds,
+            self.requestManagerCreationDurationInMilliseconds, self.scheduleCenterCreationDurationInMilliseconds,
+            self.databaseOpenDurationInMilliseconds, self.ipStackDetectionDurationInMilliseconds,
+            self.reachabilityStartDurationInMilliseconds, self.scheduleConfigLoadDurationInMilliseconds];
+}
+
+@end
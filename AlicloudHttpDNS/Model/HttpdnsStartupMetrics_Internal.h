@@ -0,0 +1,42 @@
+//
+//  HttpdnsStartupMetrics_Internal.h
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "HttpdnsStartupMetrics.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(NSUInteger, HttpdnsStartupPhase) {
+    HttpdnsStartupPhaseRequestManagerCreation = 0,
+    HttpdnsStartupPhaseScheduleCenterCreation,
+    HttpdnsStartupPhaseDatabaseOpen,
+    HttpdnsStartupPhaseIpStackDetection,
+    HttpdnsStartupPhaseReachabilityStart,
+    HttpdnsStartupPhaseScheduleConfigLoad,
+    HttpdnsStartupPhaseCount,
+};
+
+// 初始化过程中在调用线程和初始化队列上记录，对外只返回snapshot
+@interface HttpdnsStartupMetrics ()
+
+// 创建时刻即为初始化的开始时刻
+- (instancetype)initWithDeferredInitialization:(BOOL)deferredInitialization;
+
+// startTime为HttpdnsMetricsNow()的返回值，耗时计算到调用时刻
+- (void)recordPhase:(HttpdnsStartupPhase)phase startTime:(uint64_t)startTime;
+
+// 初始化接口返回前调用
+- (void)markCallerThreadFinished;
+
+// 所有组件初始化完成后调用
+- (void)markCompleted;
+
+- (HttpdnsStartupMetrics *)snapshot;
+
+@end
+
+NS_ASSUME_NONNULL_END
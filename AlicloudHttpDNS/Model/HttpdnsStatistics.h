@@ -0,0 +1,116 @@
+//
+//  HttpdnsStatistics.h
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// 耗时分布，按对数分桶记录，每个2倍区间分为8个桶，相对误差不超过12.5%
+@interface HttpdnsLatencyHistogram : NSObject
+
+// 样本数
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+// 平均耗时，单位毫秒
+@property (nonatomic, assign, readonly) double meanInMilliseconds;
+
+// 最大耗时，单位毫秒
+@property (nonatomic, assign, readonly) double maxInMilliseconds;
+
+/// 指定分位的耗时，单位毫秒，没有样本时返回0
+/// @param percentile 分位，取值0-100，例如99表示P99
+- (double)valueInMillisecondsAtPercentile:(double)percentile;
+
+@end
+
+/// SDK运行统计的快照，计数从进程启动开始累计
+/// 计数在进程内全局累加，不按账号区分：缓存命中、网络请求、连接池、调度、探测、预解析等计数覆盖所有HttpDnsService实例；
+/// 只有负缓存与失败退避统计获取快照的实例
+@interface HttpdnsStatistics : NSObject
+
+#pragma mark - 缓存
+
+// 直接用未过期的缓存应答的次数
+@property (nonatomic, assign, readonly) NSUInteger cacheHitCount;
+
+// 缓存不存在或已过期且不能复用，需要等待或发起解析的次数
+@property (nonatomic, assign, readonly) NSUInteger cacheMissCount;
+
+// 用过期缓存应答、同时在后台刷新的次数
+@property (nonatomic, assign, readonly) NSUInteger staleServeCount;
+
+// 从内存缓存中清除的条目数
+@property (nonatomic, assign, readonly) NSUInteger cacheEvictionCount;
+
+// 由负缓存直接应答的次数
+@property (nonatomic, assign, readonly) NSUInteger negativeCacheHitCount;
+
+// 处于失败退避期而没有发起请求的次数
+@property (nonatomic, assign, readonly) NSUInteger failureBackoffHitCount;
+
+#pragma mark - 解析请求
+
+// 发往解析服务的HTTP请求数
+@property (nonatomic, assign, readonly) NSUInteger networkRequestCount;
+
+// 失败的HTTP请求数
+@property (nonatomic, assign, readonly) NSUInteger networkFailureCount;
+
+// 请求失败后的重试次数
+@property (nonatomic, assign, readonly) NSUInteger networkRetryCount;
+
+// 降级到本地DNS解析的次数
+@property (nonatomic, assign, readonly) NSUInteger localDegradationCount;
+
+// HTTP请求耗时，包括建连、收发和响应解析
+@property (nonatomic, strong, readonly) HttpdnsLatencyHistogram *networkRequestLatency;
+
+#pragma mark - 连接池
+
+// 新建的连接数
+@property (nonatomic, assign, readonly) NSUInteger connectionOpenCount;
+
+// 复用连接池中连接的次数
+@property (nonatomic, assign, readonly) NSUInteger connectionReuseCount;
+
+// 因空闲超时被关闭的连接数
+@property (nonatomic, assign, readonly) NSUInteger connectionIdleCloseCount;
+
+// 新建连接的耗时，包括TCP和TLS握手
+@property (nonatomic, strong, readonly) HttpdnsLatencyHistogram *connectionOpenLatency;
+
+#pragma mark - 调度
+
+// 请求失败后切换解析服务地址的次数
+@property (nonatomic, assign, readonly) NSUInteger serverRotationCount;
+
+#pragma mark - IP探测
+
+// 完成的IP探测次数
+@property (nonatomic, assign, readonly) NSUInteger probeCount;
+
+// 探测失败（超时或不可达）的次数
+@property (nonatomic, assign, readonly) NSUInteger probeFailureCount;
+
+// 探测成功时的建连耗时
+@property (nonatomic, strong, readonly) HttpdnsLatencyHistogram *probeLatency;
+
+#pragma mark - 预测预解析
+
+// 根据域名先后关系预测并预解析的域名数
+@property (nonatomic, assign, readonly) NSUInteger predictedPrefetchCount;
+
+// 预测的域名在预解析后30秒内被解析的次数
+@property (nonatomic, assign, readonly) NSUInteger predictedHitCount;
+
+// 预测命中率，即predictedHitCount / predictedPrefetchCount，没有预测时为0
+@property (nonatomic, assign, readonly) double predictedHitRate;
+
+@end
+
+NS_ASSUME_NONNULL_END
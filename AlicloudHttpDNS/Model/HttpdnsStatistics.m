@@ -0,0 +1,97 @@
+//
+//  HttpdnsStatistics.m
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "HttpdnsStatistics.h"
+#import "HttpdnsStatistics_Internal.h"
+#import "HttpdnsMetrics.h"
+
+@implementation HttpdnsLatencyHistogram {
+    NSData *_bucketCounts;
+    uint64_t _sumInMicroseconds;
+    uint64_t _maxInMicroseconds;
+}
+
+- (instancetype)initWithBucketCounts:(const uint64_t *)bucketCounts
+                         bucketCount:(NSUInteger)bucketCount
+                   sumInMicroseconds:(uint64_t)sumInMicroseconds
+                   maxInMicroseconds:(uint64_t)maxInMicroseconds {
+    if (self = [super init]) {
+        _bucketCounts = [NSData dataWithBytes:bucketCounts length:bucketCount * sizeof(uint64_t)];
+        _sumInMicroseconds = sumInMicroseconds;
+        _maxInMicroseconds = maxInMicroseconds;
+        uint64_t count = 0;
+        for (NSUInteger i = 0; i < bucketCount; i++) {
+            count += bucketCounts[i];
+        }
+        _count = (NSUInteger)count;
+    }
+    return self;
+}
+
+- (double)meanInMilliseconds {
+    return self.count > 0 ? (double)_sumInMicroseconds / self.count / 1000.0 : 0;
+}
+
+- (double)maxInMilliseconds {
+    return _maxInMicroseconds / 1000.0;
+}
+
+- (double)valueInMillisecondsAtPercentile:(double)percentile {
+    if (self.count == 0) {
+        return 0;
+    }
+    double clampedPercentile = MIN(MAX(percentile, 0), 100);
+    uint64_t targetCount = MAX((uint64_t)ceil(clampedPercentile / 100.0 * self.count), 1);
+
+    const uint64_t *bucketCounts = _bucketCounts.bytes;
+    NSUInteger bucketCount = _bucketCounts.length / sizeof(uint64_t);
+    uint64_t accumulated = 0;
+    for (NSUInteger i = 0; i < bucketCount; i++) {
+        accumulated += bucketCounts[i];
+        if (accumulated >= targetCount) {
+            // 取桶内最大值，不超过实际记录到的最大值
+            return MIN(HttpdnsMetricsBucketHighestValue(i), _maxInMicroseconds) / 1000.0;
+        }
+    }
+    return self.maxInMilliseconds;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"{count: %lu, mean: %.3fms, p50: %.3fms, p99: %.3fms, max: %.3fms}",
+            (unsigned long)self.count, self.meanInMilliseconds, [self valueInMillisecondsAtPercentile:50],
+            [self valueInMillisecondsAtPercentile:99], self.maxInMilliseconds];
+}
+
+@end
+
+@implementation HttpdnsStatistics
+
+- (double)predictedHitRate {
+    if (self.predictedPrefetchCount == 0) {
+        return 0;
+    }
+    return (double)self.predictedHitCount / self.predictedPrefetchCount;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"{cache: {hit: %lu, miss: %lu, stale: %lu, eviction: %lu, negativeHit: %lu, backoffHit: %lu}, "
+            @"network: {request: %lu, failure: %lu, retry: %lu, degradation: %lu, latency: %@}, "
+            @"pool: {open: %lu, reuse: %lu, idleClose: %lu, openLatency: %@}, "
+            @"scheduler: {rotation: %lu}, probe: {count: %lu, failure: %lu, latency: %@}, "
+            @"prediction: {prefetch: %lu, hit: %lu}}",
+            (unsigned long)self.cacheHitCount, (unsigned long)self.cacheMissCount, (unsigned long)self.staleServeCount,
+            (unsigned long)self.cacheEvictionCount, (unsigned long)self.negativeCacheHitCount, (unsigned long)self.failureBackoffHitCount,
+            (unsigned long)self.networkRequestCount, (unsigned long)self.networkFailureCount, (unsigned long)self.networkRetryCount,
+            (unsigned long)self.localDegradationCount, self.networkRequestLatency,
+            (unsigned long)self.connectionOpenCount, (unsigned long)self.connectionReuseCount, (unsigned long)self.connectionIdleCloseCount,
+            self.connectionOpenLatency,
+            (unsigned long)self.serverRotationCount, (unsigned long)self.probeCount, (unsigned long)self.probeFailureCount, self.probeLatency,
+            (unsigned long)self.predictedPrefetchCount, (unsigned long)self.predictedHitCount];
+}
+
+@end
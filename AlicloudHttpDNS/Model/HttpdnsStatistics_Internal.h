@@ -0,0 +1,58 @@
+//
+//  HttpdnsStatistics_Internal.h
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "HttpdnsStatistics.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface HttpdnsLatencyHistogram ()
+
+/**
+ * @param bucketCounts 各桶的样本数，下标含义见HttpdnsMetrics
+ * @param sumInMicroseconds 样本耗时之和，单位微秒
+ * @param maxInMicroseconds 最大样本，单位微秒
+ */
+- (instancetype)initWithBucketCounts:(const uint64_t *)bucketCounts
+                         bucketCount:(NSUInteger)bucketCount
+                   sumInMicroseconds:(uint64_t)sumInMicroseconds
+                   maxInMicroseconds:(uint64_t)maxInMicroseconds;
+
+@end
+
+@interface HttpdnsStatistics ()
+
+@property (nonatomic, assign, readwrite) NSUInteger cacheHitCount;
+@property (nonatomic, assign, readwrite) NSUInteger cacheMissCount;
+@property (nonatomic, assign, readwrite) NSUInteger staleServeCount;
+@property (nonatomic, assign, readwrite) NSUInteger cacheEvictionCount;
+@property (nonatomic, assign, readwrite) NSUInteger negativeCacheHitCount;
+@property (nonatomic, assign, readwrite) NSUInteger failureBackoffHitCount;
+
+@property (nonatomic, assign, readwrite) NSUInteger networkRequestCount;
+@property (nonatomic, assign, readwrite) NSUInteger networkFailureCount;
+@property (nonatomic, assign, readwrite) NSUInteger networkRetryCount;
+@property (nonatomic, assign, readwrite) NSUInteger localDegradationCount;
+@property (nonatomic, strong, readwrite) HttpdnsLatencyHistogram *networkRequestLatency;
+
+@property (nonatomic, assign, readwrite) NSUInteger connectionOpenCount;
+@property (nonatomic, assign, readwrite) NSUInteger connectionReuseCount;
+@property (nonatomic, assign, readwrite) NSUInteger connectionIdleCloseCount;
+@property (nonatomic, strong, readwrite) HttpdnsLatencyHistogram *connectionOpenLatency;
+
+@property (nonatomic, assign, readwrite) NSUInteger serverRotationCount;
+
+@property (nonatomic, assign, readwrite) NSUInteger probeCount;
+@property (nonatomic, assign, readwrite) NSUInteger probeFailureCount;
+@property (nonatomic, strong, readwrite) HttpdnsLatencyHistogram *probeLatency;
+
+@property (nonatomic, assign, readwrite) NSUInteger predictedPrefetchCount;
+@property (nonatomic, assign, readwrite) NSUInteger predictedHitCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -11,6 +11,9 @@
 #import "HttpdnsLog_Internal.h"
 #import "HttpdnsPublicConstant.h"
 #import "HttpdnsUtil.h"
+#import "HttpdnsResolveTrace_Internal.h"
+#import "HttpdnsMetrics.h"
+#import "HttpdnsClock.h"
 
 @interface HttpdnsNWHTTPClientResponse ()
 @end
@@ -146,10 +149,13 @@ static const NSTimeInterval kHttpdnsNWHTTPClientDefaultTimeout = 10.0;
     NSString *poolKey = [self connectionPoolKeyForHost:host port:portString useTLS:useTLS];
     BOOL remoteClosed = NO;
     NSError *exchangeError = nil;
+    HttpdnsResolveTrace *trace = [HttpdnsResolveTrace currentTrace];
+    uint64_t phaseStartTime = trace ? HttpdnsResolveTraceNow() : 0;
     NSData *rawResponse = [connection sendRequestData:requestData
                                               timeout:requestTimeout
                                remoteConnectionClosed:&remoteClosed
                                                 error:&exchangeError];
+    [trace addSpanWithPhase:HttpdnsResolveTracePhaseSendReceive startTime:phaseStartTime];
 
     if (!rawResponse) {
         [self returnConnection:connection forKey:poolKey shouldClose:YES];
@@ -165,7 +171,10 @@ static const NSTimeInterval kHttpdnsNWHTTPClientDefaultTimeout = 10.0;
     NSDictionary<NSString *, NSString *> *headers = nil;
     NSData *bodyData = nil;
     NSError *parseError = nil;
-    if (![self parseHTTPResponseData:rawResponse statusCode:&statusCode headers:&headers body:&bodyData error:&parseError]) {
+    phaseStartTime = trace ? HttpdnsResolveTraceNow() : 0;
+    BOOL parsed = [self parseHTTPResponseData:rawResponse statusCode:&statusCode headers:&headers body:&bodyData error:&parseError];
+    [trace addSpanWithPhase:HttpdnsResolveTracePhaseHTTPParse startTime:phaseStartTime];
+    if (!parsed) {
         [self returnConnection:connection forKey:poolKey shouldClose:YES];
         if (error) {
             *error = parseError ?: [NSError errorWithDomain:ALICLOUD_HTTPDNS_ERROR_DOMAIN
@@ -206,8 +215,10 @@ static const NSTimeInterval kHttpdnsNWHTTPClientDefaultTimeout = 10.0;
                                                   timeout:(NSTimeInterval)timeout
                                                     error:(NSError **)error {
     NSString *key = [self connectionPoolKeyForHost:host port:port useTLS:useTLS];
-    NSDate *now = [NSDate date];
+    NSDate *now = HttpdnsClockCurrentDate();
     __block HttpdnsNWReusableConnection *connection = nil;
+    HttpdnsResolveTrace *trace = [HttpdnsResolveTrace currentTrace];
+    uint64_t phaseStartTime = trace ? HttpdnsResolveTraceNow() : 0;
 
     dispatch_sync(self.poolQueue, ^{
         NSMutableArray<HttpdnsNWReusableConnection *> *pool = self.connectionPool[key];
@@ -225,14 +236,17 @@ static const NSTimeInterval kHttpdnsNWHTTPClientDefaultTimeout = 10.0;
             }
         }
     });
+    [trace addSpanWithPhase:HttpdnsResolveTracePhaseConnectionDequeue startTime:phaseStartTime];
 
     if (connection) {
 #if DEBUG
         self.connectionReuseCount++;
 #endif
+        HttpdnsMetricsIncrement(HttpdnsMetricCounterConnectionReuse);
         return connection;
     }
 
+    phaseStartTime = trace ? HttpdnsResolveTraceNow() : 0;
     HttpdnsNWReusableConnection *newConnection = [[HttpdnsNWReusableConnection alloc] initWithClient:self
                                                                                                  host:host
                                                                                                  port:port
@@ -246,10 +260,15 @@ static const NSTimeInterval kHttpdnsNWHTTPClientDefaultTimeout = 10.0;
         return nil;
     }
 
-    if (![newConnection openWithTimeout:timeout error:error]) {
+    uint64_t openStartTime = HttpdnsMetricsNow();
+    BOOL opened = [newConnection openWithTimeout:timeout error:error];
+    [trace addSpanWithPhase:HttpdnsResolveTracePhaseConnectionHandshake startTime:phaseStartTime];
+    if (!opened) {
         [newConnection invalidate];
         return nil;
     }
+    HttpdnsMetricsIncrement(HttpdnsMetricCounterConnectionOpen);
+    HttpdnsMetricsRecordLatencySince(HttpdnsMetricHistogramConnectionOpen, openStartTime);
 
 #if DEBUG
     self.connectionCreationCount++;
@@ -265,7 +284,7 @@ static const NSTimeInterval kHttpdnsNWHTTPClientDefaultTimeout = 10.0;
             self.connectionPool[key] = pool;
         }
         [pool addObject:newConnection];
-        [self pruneConnectionPool:pool referenceDate:[NSDate date]];
+        [self pruneConnectionPool:pool referenceDate:HttpdnsClockCurrentDate()];
     });
 
     return newConnection;
@@ -278,7 +297,7 @@ static const NSTimeInterval kHttpdnsNWHTTPClientDefaultTimeout = 10.0;
         return;
     }
 
-    NSDate *now = [NSDate date];
+    NSDate *now = HttpdnsClockCurrentDate();
     dispatch_async(self.poolQueue, ^{
         NSMutableArray<HttpdnsNWReusableConnection *> *pool = self.connectionPool[key];
         if (!pool) {
@@ -319,6 +338,9 @@ static const NSTimeInterval kHttpdnsNWHTTPClientDefaultTimeout = 10.0;
         NSDate *lastUsed = candidate.lastUsedDate ?: [NSDate distantPast];
         BOOL expired = !candidate.inUse && referenceDate && [referenceDate timeIntervalSinceDate:lastUsed] > idleLimit;
         if (candidate.isInvalidated || expired) {
+            if (expired && !candidate.isInvalidated) {
+                HttpdnsMetricsIncrement(HttpdnsMetricCounterConnectionIdleClose);
+            }
             [candidate invalidate];
             [pool removeObjectAtIndex:(NSUInteger)idx];
         }
@@ -10,6 +10,7 @@
 #import "HttpdnsLog_Internal.h"
 #import "HttpdnsPublicConstant.h"
 #import "HttpdnsUtil.h"
+#import "HttpdnsClock.h"
 
 @class HttpdnsNWHTTPClient;
 
@@ -102,7 +103,7 @@
     _queue = dispatch_queue_create("com.alibaba.sdk.httpdns.network.connection.reuse", DISPATCH_QUEUE_SERIAL);
     _stateSemaphore = dispatch_semaphore_create(0);
     _state = nw_connection_state_invalid;
-    _lastUsedDate = [NSDate date];
+    _lastUsedDate = HttpdnsClockCurrentDate();
 
     nw_endpoint_t endpoint = nw_endpoint_create_host(_host.UTF8String, _port.UTF8String);
     if (!endpoint) {
@@ -389,7 +390,7 @@
         *remoteConnectionClosed = exchange.remoteClosed;
     }
 
-    self.lastUsedDate = [NSDate date];
+    self.lastUsedDate = HttpdnsClockCurrentDate();
     return [exchange.buffer copy];
 }
 
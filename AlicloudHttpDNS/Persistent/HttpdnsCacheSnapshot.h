@@ -0,0 +1,61 @@
+//
+//  HttpdnsCacheSnapshot.h
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/22.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "HttpdnsHostRecord.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * 缓存快照文件，用于冷启动时免打开SQLite直接命中持久化缓存
+ *
+ * 文件由定长记录（打包存储的v4/v6地址、TTL、解析时间）、开放寻址哈希索引和字符串池组成，
+ * 初始化时通过mmap映射，查询只读取映射页，不需要解析整个文件
+ * 快照只是数据库的只读副本，数据库仍是唯一可信的数据来源，快照由数据库整体重建
+ */
+@interface HttpdnsCacheSnapshot : NSObject
+
+/**
+ * 映射指定路径的快照文件，文件不存在或校验失败时为空快照
+ * @param path 快照文件路径
+ */
+- (instancetype)initWithPath:(NSString *)path;
+
+/**
+ * 当前快照中的记录数量
+ */
+@property (nonatomic, assign, readonly) NSUInteger recordCount;
+
+/**
+ * 根据缓存键查询快照中的记录
+ * @param cacheKey 缓存键
+ * @return 查询到的记录，不存在或已被移除时返回nil
+ */
+- (nullable HttpdnsHostRecord *)recordForCacheKey:(NSString *)cacheKey;
+
+/**
+ * 用给定记录重建快照文件并重新映射，旧文件被原子替换
+ * @param records 数据库中的全部记录
+ * @return 是否成功
+ */
+- (BOOL)rebuildWithRecords:(NSArray<HttpdnsHostRecord *> *)records;
+
+/**
+ * 在下一次重建前屏蔽某个缓存键，避免已删除的记录被快照恢复
+ * @param cacheKey 缓存键
+ */
+- (void)removeRecordForCacheKey:(NSString *)cacheKey;
+
+/**
+ * 解除映射并删除快照文件
+ */
+- (void)removeAllRecords;
+
+@end
+
+NS_ASSUME_NONNULL_END
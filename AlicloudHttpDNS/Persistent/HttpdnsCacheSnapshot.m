@@ -0,0 +1,413 @@
+//
+//  HttpdnsCacheSnapshot.m
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/22.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "HttpdnsCacheSnapshot.h"
+#import "HttpdnsLog_Internal.h"
+#import <arpa/inet.h>
+#import <fcntl.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <unistd.h>
+
+// 文件标识 'HDSS'
+static const uint32_t kHttpdnsSnapshotMagic = 0x53534448;
+static const uint32_t kHttpdnsSnapshotVersion = 1;
+
+// 每种地址族最多保存的IP数量，超出部分不写入快照
+// 数据库中的IP已按质量排序，只保留排在前面的；从快照加载的记录只有这些IP，直到该域名重新解析
+#define HTTPDNS_SNAPSHOT_MAX_IPS_PER_FAMILY 8
+
+// 字符串不存在时的偏移量
+static const uint32_t kHttpdnsSnapshotNullString = UINT32_MAX;
+
+// 文件头
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t recordCount;
+    uint32_t bucketCount;
+    uint32_t bucketsOffset;
+    uint32_t recordsOffset;
+    uint32_t stringsOffset;
+    uint64_t fileSize;
+} HttpdnsSnapshotHeader;
+
+// 定长记录，字符串以(偏移, 长度)的形式引用字符串池
+typedef struct {
+    uint64_t keyHash;
+    int64_t v4ttl;
+    int64_t v4LookupTime;
+    int64_t v6ttl;
+    int64_t v6LookupTime;
+    uint32_t cacheKeyOffset;
+    uint32_t hostNameOffset;
+    uint32_t clientIpOffset;
+    uint32_t extraOffset;
+    uint32_t cacheKeyLength;
+    uint32_t hostNameLength;
+    uint32_t clientIpLength;
+    uint32_t extraLength;
+    uint8_t v4Count;
+    uint8_t v6Count;
+    uint8_t reserved[6];
+    uint8_t v4Addrs[HTTPDNS_SNAPSHOT_MAX_IPS_PER_FAMILY][4];
+    uint8_t v6Addrs[HTTPDNS_SNAPSHOT_MAX_IPS_PER_FAMILY][16];
+} HttpdnsSnapshotRecord;
+
+static inline uint32_t HttpdnsSnapshotAlign8(uint32_t value) {
+    return (value + 7) & ~7u;
+}
+
+// FNV-1a
+static uint64_t HttpdnsSnapshotHash(const char *bytes, size_t length) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+@interface HttpdnsCacheSnapshot ()
+
+@property (nonatomic, copy) NSString *path;
+@property (nonatomic, strong) NSLock *lock;
+// 在下一次重建之前需要屏蔽的缓存键
+@property (nonatomic, strong) NSMutableSet<NSString *> *removedCacheKeys;
+
+@end
+
+@implementation HttpdnsCacheSnapshot {
+    const uint8_t *_mappedBytes;
+    size_t _mappedLength;
+}
+
+- (instancetype)initWithPath:(NSString *)path {
+    self = [super init];
+    if (self) {
+        _path = [path copy];
+        _lock = [[NSLock alloc] init];
+        _removedCacheKeys = [NSMutableSet set];
+        [self mapFile];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [self unmapFile];
+}
+
+#pragma mark - Public Methods
+
+- (NSUInteger)recordCount {
+    [_lock lock];
+    NSUInteger count = _mappedBytes ? ((const HttpdnsSnapshotHeader *)_mappedBytes)->recordCount : 0;
+    [_lock unlock];
+    return count;
+}
+
+- (nullable HttpdnsHostRecord *)recordForCacheKey:(NSString *)cacheKey {
+    if (cacheKey.length == 0) {
+        return nil;
+    }
+
+    const char *keyBytes = [cacheKey UTF8String];
+    size_t keyLength = strlen(keyBytes);
+    uint64_t hash = HttpdnsSnapshotHash(keyBytes, keyLength);
+
+    [_lock lock];
+    @try {
+        if (!_mappedBytes || [_removedCacheKeys containsObject:cacheKey]) {
+            return nil;
+        }
+
+        const HttpdnsSnapshotHeader *header = (const HttpdnsSnapshotHeader *)_mappedBytes;
+        const uint32_t *buckets = (const uint32_t *)(_mappedBytes + header->bucketsOffset);
+        const HttpdnsSnapshotRecord *records = (const HttpdnsSnapshotRecord *)(_mappedBytes + header->recordsOffset);
+        uint32_t mask = header->bucketCount - 1;
+
+        // 线性探测，遇到空槽即未命中
+        for (uint32_t probe = 0, index = (uint32_t)hash & mask; probe < header->bucketCount; probe++, index = (index + 1) & mask) {
+            uint32_t slot = buckets[index];
+            if (slot == 0 || slot > header->recordCount) {
+                return nil;
+            }
+
+            const HttpdnsSnapshotRecord *record = &records[slot - 1];
+            if (record->keyHash != hash || record->cacheKeyLength != keyLength) {
+                continue;
+            }
+
+            const char *storedKey = [self stringBytesAtOffset:record->cacheKeyOffset length:record->cacheKeyLength];
+            if (storedKey && memcmp(storedKey, keyBytes, keyLength) == 0) {
+                return [self hostRecordFromSnapshotRecord:record];
+            }
+        }
+        return nil;
+    } @finally {
+        [_lock unlock];
+    }
+}
+
+- (BOOL)rebuildWithRecords:(NSArray<HttpdnsHostRecord *> *)records {
+    NSData *data = [self serializeRecords:records];
+    NSError *error = nil;
+    if (![data writeToFile:_path options:NSDataWritingAtomic error:&error]) {
+        HttpdnsLogDebug("Failed to write cache snapshot: %@", error);
+        return NO;
+    }
+
+    NSMutableSet<NSString *> *rebuiltKeys = [NSMutableSet setWithCapacity:records.count];
+    for (HttpdnsHostRecord *record in records) {
+        if (record.cacheKey) {
+            [rebuiltKeys addObject:record.cacheKey];
+        }
+    }
+
+    [_lock lock];
+    [self unmapFile];
+    [self mapFile];
+    // 新快照中已不存在的键无需继续屏蔽
+    [_removedCacheKeys intersectSet:rebuiltKeys];
+    [_lock unlock];
+
+    return YES;
+}
+
+- (void)removeRecordForCacheKey:(NSString *)cacheKey {
+    if (!cacheKey) {
+        return;
+    }
+    [_lock lock];
+    [_removedCacheKeys addObject:cacheKey];
+    [_lock unlock];
+}
+
+- (void)removeAllRecords {
+    [_lock lock];
+    [self unmapFile];
+    [_removedCacheKeys removeAllObjects];
+    [[NSFileManager defaultManager] removeItemAtPath:_path error:nil];
+    [_lock unlock];
+}
+
+#pragma mark - Mapping
+
+- (void)mapFile {
+    int fd = open([_path fileSystemRepresentation], O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(HttpdnsSnapshotHeader)) {
+        close(fd);
+        return;
+    }
+
+    void *bytes = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (bytes == MAP_FAILED) {
+        return;
+    }
+
+    _mappedBytes = (const uint8_t *)bytes;
+    _mappedLength = (size_t)st.st_size;
+
+    if (![self validateMappedBytes]) {
+        HttpdnsLogDebug("Discard invalid cache snapshot: %@", _path);
+        [self unmapFile];
+    }
+}
+
+- (void)unmapFile {
+    if (_mappedBytes) {
+        munmap((void *)_mappedBytes, _mappedLength);
+        _mappedBytes = NULL;
+        _mappedLength = 0;
+    }
+}
+
+- (BOOL)validateMappedBytes {
+    const HttpdnsSnapshotHeader *header = (const HttpdnsSnapshotHeader *)_mappedBytes;
+    if (header->magic != kHttpdnsSnapshotMagic
+        || header->version != kHttpdnsSnapshotVersion
+        || header->recordSize != sizeof(HttpdnsSnapshotRecord)
+        || header->fileSize != _mappedLength) {
+        return NO;
+    }
+
+    // 桶数量必须是2的幂
+    if (header->bucketCount == 0 || (header->bucketCount & (header->bucketCount - 1)) != 0) {
+        return NO;
+    }
+
+    uint64_t bucketsEnd = (uint64_t)header->bucketsOffset + (uint64_t)header->bucketCount * sizeof(uint32_t);
+    uint64_t recordsEnd = (uint64_t)header->recordsOffset + (uint64_t)header->recordCount * sizeof(HttpdnsSnapshotRecord);
+    return header->bucketsOffset >= sizeof(HttpdnsSnapshotHeader)
+        && bucketsEnd <= header->recordsOffset
+        && recordsEnd <= header->stringsOffset
+        && header->stringsOffset <= _mappedLength;
+}
+
+- (const char *)stringBytesAtOffset:(uint32_t)offset length:(uint32_t)length {
+    const HttpdnsSnapshotHeader *header = (const HttpdnsSnapshotHeader *)_mappedBytes;
+    uint64_t start = (uint64_t)header->stringsOffset + offset;
+    if (offset == kHttpdnsSnapshotNullString || start + length > _mappedLength) {
+        return NULL;
+    }
+    return (const char *)(_mappedBytes + start);
+}
+
+- (nullable NSString *)stringAtOffset:(uint32_t)offset length:(uint32_t)length {
+    const char *bytes = [self stringBytesAtOffset:offset length:length];
+    if (!bytes) {
+        return nil;
+    }
+    return [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+}
+
+#pragma mark - Conversion
+
+- (HttpdnsHostRecord *)hostRecordFromSnapshotRecord:(const HttpdnsSnapshotRecord *)record {
+    NSMutableArray<NSString *> *v4ips = [NSMutableArray arrayWithCapacity:record->v4Count];
+    char buffer[INET6_ADDRSTRLEN];
+    for (uint8_t i = 0; i < MIN(record->v4Count, HTTPDNS_SNAPSHOT_MAX_IPS_PER_FAMILY); i++) {
+        if (inet_ntop(AF_INET, record->v4Addrs[i], buffer, sizeof(buffer))) {
+            [v4ips addObject:[NSString stringWithUTF8String:buffer]];
+        }
+    }
+
+    NSMutableArray<NSString *> *v6ips = [NSMutableArray arrayWithCapacity:record->v6Count];
+    for (uint8_t i = 0; i < MIN(record->v6Count, HTTPDNS_SNAPSHOT_MAX_IPS_PER_FAMILY); i++) {
+        if (inet_ntop(AF_INET6, record->v6Addrs[i], buffer, sizeof(buffer))) {
+            [v6ips addObject:[NSString stringWithUTF8String:buffer]];
+        }
+    }
+
+    return [[HttpdnsHostRecord alloc] initWithId:0
+                                        cacheKey:[self stringAtOffset:record->cacheKeyOffset length:record->cacheKeyLength]
+                                        hostName:[self stringAtOffset:record->hostNameOffset length:record->hostNameLength]
+                                        createAt:nil
+                                        modifyAt:nil
+                                        clientIp:[self stringAtOffset:record->clientIpOffset length:record->clientIpLength]
+                                           v4ips:v4ips
+                                           v4ttl:record->v4ttl
+                                    v4LookupTime:record->v4LookupTime
+                                           v6ips:v6ips
+                                           v6ttl:record->v6ttl
+                                    v6LookupTime:record->v6LookupTime
+                                           extra:[self stringAtOffset:record->extraOffset length:record->extraLength]];
+}
+
+- (NSData *)serializeRecords:(NSArray<HttpdnsHostRecord *> *)records {
+    NSMutableData *strings = [NSMutableData data];
+    NSMutableData *recordData = [NSMutableData data];
+    uint32_t recordCount = 0;
+    NSUInteger truncatedCount = 0;
+
+    uint32_t (^appendString)(NSString *, uint32_t *) = ^uint32_t(NSString *string, uint32_t *length) {
+        if (!string) {
+            *length = 0;
+            return kHttpdnsSnapshotNullString;
+        }
+        NSData *bytes = [string dataUsingEncoding:NSUTF8StringEncoding];
+        uint32_t offset = (uint32_t)strings.length;
+        [strings appendData:bytes];
+        *length = (uint32_t)bytes.length;
+        return offset;
+    };
+
+    for (HttpdnsHostRecord *hostRecord in records) {
+        if (hostRecord.cacheKey.length == 0) {
+            continue;
+        }
+
+        HttpdnsSnapshotRecord record;
+        memset(&record, 0, sizeof(record));
+
+        const char *keyBytes = [hostRecord.cacheKey UTF8String];
+        record.keyHash = HttpdnsSnapshotHash(keyBytes, strlen(keyBytes));
+        record.v4ttl = hostRecord.v4ttl;
+        record.v4LookupTime = hostRecord.v4LookupTime;
+        record.v6ttl = hostRecord.v6ttl;
+        record.v6LookupTime = hostRecord.v6LookupTime;
+        record.cacheKeyOffset = appendString(hostRecord.cacheKey, &record.cacheKeyLength);
+        record.hostNameOffset = appendString(hostRecord.hostName, &record.hostNameLength);
+        record.clientIpOffset = appendString(hostRecord.clientIp, &record.clientIpLength);
+        record.extraOffset = appendString(hostRecord.extra, &record.extraLength);
+
+        for (NSString *ip in hostRecord.v4ips) {
+            if (record.v4Count >= HTTPDNS_SNAPSHOT_MAX_IPS_PER_FAMILY) {
+                break;
+            }
+            if (inet_pton(AF_INET, [ip UTF8String], record.v4Addrs[record.v4Count]) == 1) {
+                record.v4Count++;
+            }
+        }
+        for (NSString *ip in hostRecord.v6ips) {
+            if (record.v6Count >= HTTPDNS_SNAPSHOT_MAX_IPS_PER_FAMILY) {
+                break;
+            }
+            if (inet_pton(AF_INET6, [ip UTF8String], record.v6Addrs[record.v6Count]) == 1) {
+                record.v6Count++;
+            }
+        }
+
+        if (hostRecord.v4ips.count > HTTPDNS_SNAPSHOT_MAX_IPS_PER_FAMILY || hostRecord.v6ips.count > HTTPDNS_SNAPSHOT_MAX_IPS_PER_FAMILY) {
+            truncatedCount++;
+        }
+
+        [recordData appendBytes:&record length:sizeof(record)];
+        recordCount++;
+    }
+    if (truncatedCount > 0) {
+        HttpdnsLogDebug("Cache snapshot keeps at most %d ips per family, truncated records: %lu",
+                        HTTPDNS_SNAPSHOT_MAX_IPS_PER_FAMILY, (unsigned long)truncatedCount);
+    }
+
+    // 负载因子不超过0.5
+    uint32_t bucketCount = 16;
+    while (bucketCount < recordCount * 2) {
+        bucketCount <<= 1;
+    }
+    uint32_t *buckets = calloc(bucketCount, sizeof(uint32_t));
+    const HttpdnsSnapshotRecord *packedRecords = (const HttpdnsSnapshotRecord *)recordData.bytes;
+    for (uint32_t i = 0; i < recordCount; i++) {
+        uint32_t index = (uint32_t)packedRecords[i].keyHash & (bucketCount - 1);
+        while (buckets[index] != 0) {
+            index = (index + 1) & (bucketCount - 1);
+        }
+        buckets[index] = i + 1;
+    }
+
+    HttpdnsSnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = kHttpdnsSnapshotMagic;
+    header.version = kHttpdnsSnapshotVersion;
+    header.recordSize = sizeof(HttpdnsSnapshotRecord);
+    header.recordCount = recordCount;
+    header.bucketCount = bucketCount;
+    header.bucketsOffset = HttpdnsSnapshotAlign8(sizeof(HttpdnsSnapshotHeader));
+    header.recordsOffset = HttpdnsSnapshotAlign8(header.bucketsOffset + bucketCount * (uint32_t)sizeof(uint32_t));
+    header.stringsOffset = header.recordsOffset + (uint32_t)recordData.length;
+    header.fileSize = header.stringsOffset + strings.length;
+
+    NSMutableData *data = [NSMutableData dataWithLength:header.stringsOffset];
+    uint8_t *bytes = data.mutableBytes;
+    memcpy(bytes, &header, sizeof(header));
+    memcpy(bytes + header.bucketsOffset, buckets, bucketCount * sizeof(uint32_t));
+    memcpy(bytes + header.recordsOffset, recordData.bytes, recordData.length);
+    [data appendData:strings];
+    free(buckets);
+
+    return data;
+}
+
+@end
@@ -8,6 +8,7 @@
 
 #import <Foundation/Foundation.h>
 #import "HttpdnsHostRecord.h"
+#import "HttpdnsHostAccessRecord.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -30,6 +31,31 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (BOOL)createOrUpdate:(HttpdnsHostRecord *)record;
 
+/**
+ * 在同一个事务中批量创建或更新记录
+ * @param records 主机记录数组
+ * @return 是否全部成功
+ */
+- (BOOL)createOrUpdateBatch:(NSArray<HttpdnsHostRecord *> *)records;
+
+/**
+ * 延迟写入记录，立即返回
+ * 短时间内同一cacheKey的多次写入会被合并，到期后在一个事务中统一落盘；
+ * 应用进入后台或即将退出时也会立即落盘。查询和删除操作会先处理尚未落盘的记录
+ * @param record 主机记录
+ */
+- (void)enqueueCreateOrUpdate:(HttpdnsHostRecord *)record;
+
+/**
+ * 同步落盘所有尚未写入的记录
+ */
+- (void)flushPendingWrites;
+
+/**
+ * 尚未落盘的记录数量
+ */
+- (NSUInteger)pendingWriteCount;
+
 /**
  * 根据缓存键查询记录
  * @param cacheKey 缓存键
@@ -57,6 +83,19 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (NSArray<HttpdnsHostRecord *> *)getAllRecords;
 
+/**
+ * 获取所有记录的缓存键，只读取索引列，不构造记录对象
+ * @return 缓存键数组
+ */
+- (NSArray<NSString *> *)getAllCacheKeys;
+
+/**
+ * 按最近更新时间倒序获取记录
+ * @param limit 最多返回的记录数量
+ * @return 最近更新的记录数组
+ */
+- (NSArray<HttpdnsHostRecord *> *)getRecentlyModifiedRecordsWithLimit:(NSUInteger)limit;
+
 /**
  * 清理指定时间点已过期的记录
  * @param specifiedTime 指定的时间点（epoch时间）
@@ -70,6 +109,19 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (BOOL)deleteAll;
 
+/**
+ * 用给定的记录替换所有域名访问频率记录
+ * @param records 域名访问频率记录数组
+ * @return 是否成功
+ */
+- (BOOL)replaceAllHostAccessRecords:(NSArray<HttpdnsHostAccessRecord *> *)records;
+
+/**
+ * 获取所有域名访问频率记录
+ * @return 域名访问频率记录数组
+ */
+- (NSArray<HttpdnsHostAccessRecord *> *)getAllHostAccessRecords;
+
 @end
 
 NS_ASSUME_NONNULL_END
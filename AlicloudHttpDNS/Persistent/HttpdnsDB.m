@@ -8,7 +8,10 @@
 
 #import "HttpdnsDB.h"
 #import "HttpdnsPersistenceUtils.h"
+#import "HttpdnsIpQuality.h"
+#import <UIKit/UIKit.h>
 #import <sqlite3.h>
+#import <arpa/inet.h>
 
 // 表名
 static NSString *const kTableName = @"httpdns_cache_table";
@@ -27,6 +30,147 @@ static NSString *const kColumnV6Ips = @"v6_ips";
 static NSString *const kColumnV6Ttl = @"v6_ttl";
 static NSString *const kColumnV6LookupTime = @"v6_lookup_time";
 static NSString *const kColumnExtra = @"extra";
+// 冗余存储的过期时间点（lookup_time + ttl），用于索引化的过期清理
+static NSString *const kColumnV4ExpireAt = @"v4_expire_at";
+static NSString *const kColumnV6ExpireAt = @"v6_expire_at";
+// 打包存储的IP列表，替代v4_ips/v6_ips文本列，旧版本的文本列只在迁移和兜底读取时使用
+static NSString *const kColumnV4IpBlob = @"v4_ip_blob";
+static NSString *const kColumnV6IpBlob = @"v6_ip_blob";
+
+// 域名访问频率表，与缓存记录的生命周期无关，清空缓存时保留
+static NSString *const kHostAccessTableName = @"httpdns_host_access_table";
+static NSString *const kColumnAccessScore = @"score";
+static NSString *const kColumnLastAccessAt = @"last_access_at";
+
+// IP列表BLOB格式：1字节格式版本 + 1字节地址长度（4或16），之后每个条目为网络字节序的地址 + 探测统计
+// 版本1的统计只有4字节小端序的connectedRT；
+// 版本2为小端序的float32平均耗时、float32耗时方差、float32失败率和uint32样本数
+static const uint8_t kHttpdnsIpBlobVersionConnectedRT = 1;
+static const uint8_t kHttpdnsIpBlobVersion = 2;
+static const size_t kHttpdnsIpBlobHeaderSize = 2;
+static const size_t kHttpdnsIpBlobRTSize = sizeof(int32_t);
+static const size_t kHttpdnsIpBlobQualitySize = 4 * sizeof(uint32_t);
+
+static void HttpdnsPackFloat32(uint8_t *buffer, double value) {
+    Float32 floatValue = (Float32)value;
+    uint32_t bits;
+    memcpy(&bits, &floatValue, sizeof(bits));
+    bits = CFSwapInt32HostToLittle(bits);
+    memcpy(buffer, &bits, sizeof(bits));
+}
+
+static double HttpdnsUnpackFloat32(const uint8_t *buffer) {
+    uint32_t bits;
+    memcpy(&bits, buffer, sizeof(bits));
+    bits = CFSwapInt32LittleToHost(bits);
+    Float32 floatValue;
+    memcpy(&floatValue, &bits, sizeof(floatValue));
+    return floatValue;
+}
+
+static NSData *HttpdnsEncodeIpBlob(NSArray<NSString *> *ips, NSArray<HttpdnsIpQuality *> *qualities, BOOL isIPv6) {
+    if (ips.count == 0) {
+        return nil;
+    }
+
+    size_t addressSize = isIPv6 ? sizeof(struct in6_addr) : sizeof(struct in_addr);
+    size_t entrySize = addressSize + kHttpdnsIpBlobQualitySize;
+    BOOL hasQualities = qualities.count == ips.count;
+
+    NSMutableData *data = [NSMutableData dataWithCapacity:kHttpdnsIpBlobHeaderSize + entrySize * ips.count];
+    uint8_t header[] = {kHttpdnsIpBlobVersion, (uint8_t)addressSize};
+    [data appendBytes:header length:sizeof(header)];
+
+    for (NSUInteger i = 0; i < ips.count; i++) {
+        uint8_t entry[sizeof(struct in6_addr) + 4 * sizeof(uint32_t)];
+        // 无法解析的地址直接丢弃
+        if (inet_pton(isIPv6 ? AF_INET6 : AF_INET, [ips[i] UTF8String], entry) != 1) {
+            continue;
+        }
+
+        HttpdnsIpQuality *quality = hasQualities ? qualities[i] : nil;
+        uint8_t *cursor = entry + addressSize;
+        HttpdnsPackFloat32(cursor, quality ? quality.ewmaRT : -1);
+        HttpdnsPackFloat32(cursor + 4, quality.rtVariance);
+        HttpdnsPackFloat32(cursor + 8, quality.failureRate);
+        uint32_t sampleCount = (uint32_t)MIN(quality.sampleCount, (NSUInteger)UINT32_MAX);
+        uint32_t littleEndianCount = CFSwapInt32HostToLittle(sampleCount);
+        memcpy(cursor + 12, &littleEndianCount, sizeof(littleEndianCount));
+
+        [data appendBytes:entry length:entrySize];
+    }
+
+    return data.length > kHttpdnsIpBlobHeaderSize ? data : nil;
+}
+
+static BOOL HttpdnsDecodeIpBlob(const void *bytes, int length, NSArray<NSString *> **ips, NSArray<HttpdnsIpQuality *> **qualities) {
+    if (!bytes || length < (int)kHttpdnsIpBlobHeaderSize) {
+        return NO;
+    }
+
+    const uint8_t *cursor = bytes;
+    uint8_t version = cursor[0];
+    uint8_t addressSize = cursor[1];
+    if ((version != kHttpdnsIpBlobVersion && version != kHttpdnsIpBlobVersionConnectedRT)
+        || (addressSize != sizeof(struct in_addr) && addressSize != sizeof(struct in6_addr))) {
+        return NO;
+    }
+
+    size_t statsSize = version == kHttpdnsIpBlobVersion ? kHttpdnsIpBlobQualitySize : kHttpdnsIpBlobRTSize;
+    size_t entrySize = addressSize + statsSize;
+    size_t payloadSize = (size_t)length - kHttpdnsIpBlobHeaderSize;
+    if (payloadSize % entrySize != 0) {
+        return NO;
+    }
+
+    NSUInteger count = payloadSize / entrySize;
+    NSMutableArray<NSString *> *decodedIps = [NSMutableArray arrayWithCapacity:count];
+    NSMutableArray<HttpdnsIpQuality *> *decodedQualities = [NSMutableArray arrayWithCapacity:count];
+    int family = addressSize == sizeof(struct in6_addr) ? AF_INET6 : AF_INET;
+
+    cursor += kHttpdnsIpBlobHeaderSize;
+    for (NSUInteger i = 0; i < count; i++, cursor += entrySize) {
+        char ipBuffer[INET6_ADDRSTRLEN];
+        if (!inet_ntop(family, cursor, ipBuffer, sizeof(ipBuffer))) {
+            return NO;
+        }
+
+        const uint8_t *stats = cursor + addressSize;
+        HttpdnsIpQuality *quality = nil;
+        if (version == kHttpdnsIpBlobVersion) {
+            uint32_t littleEndianCount;
+            memcpy(&littleEndianCount, stats + 12, sizeof(littleEndianCount));
+            quality = [[HttpdnsIpQuality alloc] initWithEwmaRT:HttpdnsUnpackFloat32(stats)
+                                                    rtVariance:HttpdnsUnpackFloat32(stats + 4)
+                                                   failureRate:HttpdnsUnpackFloat32(stats + 8)
+                                                   sampleCount:CFSwapInt32LittleToHost(littleEndianCount)];
+        } else {
+            // 版本1只有单次探测结果
+            uint32_t littleEndianRT;
+            memcpy(&littleEndianRT, stats, kHttpdnsIpBlobRTSize);
+            int32_t packedRT = (int32_t)CFSwapInt32LittleToHost(littleEndianRT);
+            quality = [HttpdnsIpQuality qualityWithConnectedRT:packedRT == INT32_MAX ? NSIntegerMax : (NSInteger)packedRT];
+        }
+
+        [decodedIps addObject:[NSString stringWithUTF8String:ipBuffer]];
+        [decodedQualities addObject:quality];
+    }
+
+    *ips = [decodedIps copy];
+    *qualities = [decodedQualities copy];
+    return YES;
+}
+
+static void HttpdnsBindIpBlob(sqlite3_stmt *stmt, int index, NSData *blob) {
+    if (blob) {
+        sqlite3_bind_blob(stmt, index, blob.bytes, (int)blob.length, SQLITE_TRANSIENT);
+    } else {
+        sqlite3_bind_null(stmt, index);
+    }
+}
+
+// 延迟写入的合并窗口，窗口内同一cacheKey的多次更新只落盘最后一次
+static const NSTimeInterval kHttpdnsDBWriteBehindDelay = 0.5;
 
 @interface HttpdnsDB ()
 
@@ -34,6 +178,13 @@ static NSString *const kColumnExtra = @"extra";
 @property (nonatomic, copy) NSString *dbPath;
 @property (nonatomic, strong) dispatch_queue_t dbQueue;
 
+// 以下属性只在dbQueue上访问
+// 预编译语句缓存，key为SQL文本，value为包装了sqlite3_stmt指针的NSValue
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSValue *> *statementCache;
+// 待写入的记录，按cacheKey合并
+@property (nonatomic, strong) NSMutableDictionary<NSString *, HttpdnsHostRecord *> *pendingRecords;
+@property (nonatomic, assign) BOOL flushScheduled;
+
 @end
 
 @implementation HttpdnsDB
@@ -50,6 +201,9 @@ static NSString *const kColumnExtra = @"extra";
         // 创建专用队列确保线程安全
         _dbQueue = dispatch_queue_create("com.aliyun.httpdns.db", DISPATCH_QUEUE_SERIAL);
 
+        _statementCache = [NSMutableDictionary dictionary];
+        _pendingRecords = [NSMutableDictionary dictionary];
+
         // 打开数据库
         __block BOOL success = NO;
         dispatch_sync(_dbQueue, ^{
@@ -59,12 +213,28 @@ static NSString *const kColumnExtra = @"extra";
         if (!success) {
             return nil;
         }
+
+        // 进入后台或即将退出时，立即落盘尚未写入的记录
+        NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
+        [center addObserver:self
+                   selector:@selector(applicationDidEnterBackground:)
+                       name:UIApplicationDidEnterBackgroundNotification
+                     object:nil];
+        [center addObserver:self
+                   selector:@selector(flushPendingWrites)
+                       name:UIApplicationWillTerminateNotification
+                     object:nil];
     }
     return self;
 }
 
 - (void)dealloc {
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+
+    // 此时已没有其他引用，直接在当前线程处理剩余的写入，避免在dbQueue上dealloc时死锁
     if (_db) {
+        [self flushPendingWritesInternal];
+        [self finalizeAllCachedStatements];
         sqlite3_close(_db);
         _db = NULL;
     }
@@ -79,52 +249,99 @@ static NSString *const kColumnExtra = @"extra";
 
     __block BOOL result = NO;
     dispatch_sync(_dbQueue, ^{
-        // 检查记录是否存在，以便正确处理createAt
-        HttpdnsHostRecord *existingRecord = [self selectByCacheKeyInternal:record.cacheKey];
-
-        // 准备要保存的记录
-        NSDate *now = [NSDate date];
-        HttpdnsHostRecord *recordToSave;
-
-        if (existingRecord) {
-            // 更新记录，保留原始的createAt，更新modifyAt为当前时间
-            recordToSave = [[HttpdnsHostRecord alloc] initWithId:record.id
-                                                        cacheKey:record.cacheKey
-                                                        hostName:record.hostName
-                                                        createAt:existingRecord.createAt // 保留原始createAt
-                                                        modifyAt:now // 更新modifyAt
-                                                        clientIp:record.clientIp
-                                                           v4ips:record.v4ips
-                                                           v4ttl:record.v4ttl
-                                                    v4LookupTime:record.v4LookupTime
-                                                           v6ips:record.v6ips
-                                                           v6ttl:record.v6ttl
-                                                    v6LookupTime:record.v6LookupTime
-                                                           extra:record.extra];
-        } else {
-            // 新记录，设置createAt和modifyAt为当前时间
-            recordToSave = [[HttpdnsHostRecord alloc] initWithId:record.id
-                                                        cacheKey:record.cacheKey
-                                                        hostName:record.hostName
-                                                        createAt:now // 新记录的createAt
-                                                        modifyAt:now // 新记录的modifyAt
-                                                        clientIp:record.clientIp
-                                                           v4ips:record.v4ips
-                                                           v4ttl:record.v4ttl
-                                                    v4LookupTime:record.v4LookupTime
-                                                           v6ips:record.v6ips
-                                                           v6ttl:record.v6ttl
-                                                    v6LookupTime:record.v6LookupTime
-                                                           extra:record.extra];
-        }
-
-        // 使用INSERT OR REPLACE语法保存记录
-        result = [self saveRecord:recordToSave];
+        // 同一cacheKey若还有待写入的旧数据，以本次为准
+        [self.pendingRecords removeObjectForKey:record.cacheKey];
+
+        // UPSERT语句会保留已有记录的createAt，无需先查询
+        result = [self saveRecord:record modifyAt:[NSDate date]];
+    });
+
+    return result;
+}
+
+- (BOOL)createOrUpdateBatch:(NSArray<HttpdnsHostRecord *> *)records {
+    if (records.count == 0) {
+        return YES;
+    }
+
+    __block BOOL result = NO;
+    dispatch_sync(_dbQueue, ^{
+        for (HttpdnsHostRecord *record in records) {
+            if (record.cacheKey) {
+                [self.pendingRecords removeObjectForKey:record.cacheKey];
+            }
+        }
+        result = [self saveRecordsInTransaction:records];
     });
 
     return result;
 }
 
+- (void)enqueueCreateOrUpdate:(HttpdnsHostRecord *)record {
+    if (!record || !record.cacheKey) {
+        return;
+    }
+
+    __weak typeof(self) weakSelf = self;
+    dispatch_async(_dbQueue, ^{
+        __strong typeof(weakSelf) strongSelf = weakSelf;
+        if (!strongSelf) {
+            return;
+        }
+
+        strongSelf.pendingRecords[record.cacheKey] = record;
+
+        if (strongSelf.flushScheduled) {
+            return;
+        }
+        strongSelf.flushScheduled = YES;
+
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(kHttpdnsDBWriteBehindDelay * NSEC_PER_SEC)), strongSelf.dbQueue, ^{
+            [weakSelf flushPendingWritesInternal];
+        });
+    });
+}
+
+- (void)flushPendingWrites {
+    dispatch_sync(_dbQueue, ^{
+        [self flushPendingWritesInternal];
+    });
+}
+
+// 通知在主线程发出，dbQueue可能正忙于其他操作，不在主线程等待；申请后台执行时间保证落盘完成
+- (void)applicationDidEnterBackground:(NSNotification *)notification {
+    UIApplication *application = notification.object;
+    if (![application isKindOfClass:[UIApplication class]]) {
+        dispatch_async(_dbQueue, ^{
+            [self flushPendingWritesInternal];
+        });
+        return;
+    }
+
+    __block UIBackgroundTaskIdentifier taskId = UIBackgroundTaskInvalid;
+    taskId = [application beginBackgroundTaskWithName:@"com.aliyun.httpdns.db.flush" expirationHandler:^{
+        [application endBackgroundTask:taskId];
+        taskId = UIBackgroundTaskInvalid;
+    }];
+    dispatch_async(_dbQueue, ^{
+        [self flushPendingWritesInternal];
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (taskId != UIBackgroundTaskInvalid) {
+                [application endBackgroundTask:taskId];
+                taskId = UIBackgroundTaskInvalid;
+            }
+        });
+    });
+}
+
+- (NSUInteger)pendingWriteCount {
+    __block NSUInteger count = 0;
+    dispatch_sync(_dbQueue, ^{
+        count = self.pendingRecords.count;
+    });
+    return count;
+}
+
 - (nullable HttpdnsHostRecord *)selectByCacheKey:(NSString *)cacheKey {
     if (!cacheKey) {
         return nil;
@@ -132,7 +349,8 @@ static NSString *const kColumnExtra = @"extra";
 
     __block HttpdnsHostRecord *record = nil;
     dispatch_sync(_dbQueue, ^{
-        record = [self selectByCacheKeyInternal:cacheKey];
+        // 尚未落盘的记录就是最新写入，直接返回，不必为一次查询提交整批写入
+        record = self.pendingRecords[cacheKey] ?: [self selectByCacheKeyInternal:cacheKey];
     });
 
     return record;
@@ -145,14 +363,16 @@ static NSString *const kColumnExtra = @"extra";
 
     __block BOOL result = NO;
     dispatch_sync(_dbQueue, ^{
+        [self.pendingRecords removeObjectForKey:cacheKey];
+
         NSString *sql = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@ = ?", kTableName, kColumnCacheKey];
-        sqlite3_stmt *stmt;
+        sqlite3_stmt *stmt = [self cachedStatementForSQL:sql];
 
-        if (sqlite3_prepare_v2(_db, [sql UTF8String], -1, &stmt, NULL) == SQLITE_OK) {
+        if (stmt) {
             sqlite3_bind_text(stmt, 1, [cacheKey UTF8String], -1, SQLITE_TRANSIENT);
 
             result = (sqlite3_step(stmt) == SQLITE_DONE);
-            sqlite3_finalize(stmt);
+            [self resetStatement:stmt];
         }
     });
 
@@ -179,6 +399,9 @@ static NSString *const kColumnExtra = @"extra";
     __block NSInteger deletedCount = 0;
 
     dispatch_sync(_dbQueue, ^{
+        // 先落盘待写入数据，避免删除后又被延迟写入恢复
+        [self flushPendingWritesInternal];
+
         // 构建IN子句的占位符
         NSMutableString *placeholders = [NSMutableString string];
         for (NSUInteger i = 0; i < validHostNames.count; i++) {
@@ -218,6 +441,8 @@ static NSString *const kColumnExtra = @"extra";
 - (BOOL)deleteAll {
     __block BOOL result = NO;
     dispatch_sync(_dbQueue, ^{
+        [self.pendingRecords removeAllObjects];
+
         NSString *sql = [NSString stringWithFormat:@"DELETE FROM %@", kTableName];
         char *errMsg;
 
@@ -236,6 +461,8 @@ static NSString *const kColumnExtra = @"extra";
     __block NSMutableArray<HttpdnsHostRecord *> *records = [NSMutableArray array];
 
     dispatch_sync(_dbQueue, ^{
+        [self flushPendingWritesInternal];
+
         NSString *sql = [NSString stringWithFormat:@"SELECT * FROM %@", kTableName];
         sqlite3_stmt *stmt;
 
@@ -256,97 +483,198 @@ static NSString *const kColumnExtra = @"extra";
     return [records copy];
 }
 
+- (NSArray<NSString *> *)getAllCacheKeys {
+    __block NSMutableArray<NSString *> *cacheKeys = [NSMutableArray array];
+
+    dispatch_sync(_dbQueue, ^{
+        [self flushPendingWritesInternal];
+
+        // cache_key上有唯一索引，可以直接走覆盖索引
+        NSString *sql = [NSString stringWithFormat:@"SELECT %@ FROM %@", kColumnCacheKey, kTableName];
+        sqlite3_stmt *stmt = [self cachedStatementForSQL:sql];
+        if (!stmt) {
+            return;
+        }
+
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const char *cacheKeyChars = (const char *)sqlite3_column_text(stmt, 0);
+            if (cacheKeyChars) {
+                [cacheKeys addObject:[NSString stringWithUTF8String:cacheKeyChars]];
+            }
+        }
+        [self resetStatement:stmt];
+    });
+
+    return [cacheKeys copy];
+}
+
+- (NSArray<HttpdnsHostRecord *> *)getRecentlyModifiedRecordsWithLimit:(NSUInteger)limit {
+    __block NSMutableArray<HttpdnsHostRecord *> *records = [NSMutableArray array];
+    if (limit == 0) {
+        return records;
+    }
+
+    dispatch_sync(_dbQueue, ^{
+        [self flushPendingWritesInternal];
+
+        NSString *sql = [NSString stringWithFormat:@"SELECT * FROM %@ ORDER BY %@ DESC LIMIT ?", kTableName, kColumnModifyAt];
+        sqlite3_stmt *stmt = [self cachedStatementForSQL:sql];
+        if (!stmt) {
+            return;
+        }
+
+        sqlite3_bind_int64(stmt, 1, (sqlite3_int64)limit);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            HttpdnsHostRecord *record = [self recordFromStatement:stmt];
+            if (record) {
+                [records addObject:record];
+            }
+        }
+        [self resetStatement:stmt];
+    });
+
+    return [records copy];
+}
+
 - (NSInteger)cleanRecordAlreadExpiredAt:(NSTimeInterval)specifiedTime {
     __block NSInteger cleanedCount = 0;
-
-    // 获取所有记录
-    NSArray<HttpdnsHostRecord *> *allRecords = [self getAllRecords];
+    sqlite3_int64 expireBound = (sqlite3_int64)specifiedTime;
 
     dispatch_sync(_dbQueue, ^{
-        for (HttpdnsHostRecord *record in allRecords) {
-            BOOL v4Expired = NO;
-            BOOL v6Expired = NO;
+        [self flushPendingWritesInternal];
+
+        char *errMsg = NULL;
+        if (sqlite3_exec(_db, "BEGIN IMMEDIATE TRANSACTION", NULL, NULL, &errMsg) != SQLITE_OK) {
+            NSLog(@"Failed to begin transaction: %s", errMsg);
+            sqlite3_free(errMsg);
+            return;
+        }
 
-            // 检查IPv4记录是否过期
-            if (record.v4LookupTime + record.v4ttl <= specifiedTime) {
-                v4Expired = YES;
+        // 两种IP类型都过期，删除整条记录
+        NSString *deleteSql = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@ <= ?1 AND %@ <= ?1",
+                               kTableName, kColumnV4ExpireAt, kColumnV6ExpireAt];
+        sqlite3_stmt *stmt = [self cachedStatementForSQL:deleteSql];
+        if (stmt) {
+            sqlite3_bind_int64(stmt, 1, expireBound);
+            if (sqlite3_step(stmt) == SQLITE_DONE) {
+                cleanedCount += sqlite3_changes(_db);
+            } else {
+                NSLog(@"Failed to delete expired records: %s", sqlite3_errmsg(_db));
             }
+            [self resetStatement:stmt];
+        }
 
-            // 检查IPv6记录是否过期
-            if (record.v6LookupTime + record.v6ttl <= specifiedTime) {
-                v6Expired = YES;
+        // 剩余记录中只有一种IP类型过期，清空过期类型的IP
+        NSString *updateSql = [NSString stringWithFormat:
+                               @"UPDATE %@ SET "
+                               @"%@ = CASE WHEN %@ <= ?1 THEN NULL ELSE %@ END, "
+                               @"%@ = CASE WHEN %@ <= ?1 THEN NULL ELSE %@ END "
+                               @"WHERE %@ <= ?1 OR %@ <= ?1",
+                               kTableName,
+                               kColumnV4IpBlob, kColumnV4ExpireAt, kColumnV4IpBlob,
+                               kColumnV6IpBlob, kColumnV6ExpireAt, kColumnV6IpBlob,
+                               kColumnV4ExpireAt, kColumnV6ExpireAt];
+        stmt = [self cachedStatementForSQL:updateSql];
+        if (stmt) {
+            sqlite3_bind_int64(stmt, 1, expireBound);
+            if (sqlite3_step(stmt) == SQLITE_DONE) {
+                cleanedCount += sqlite3_changes(_db);
+            } else {
+                NSLog(@"Failed to update expired records: %s", sqlite3_errmsg(_db));
             }
+            [self resetStatement:stmt];
+        }
 
-            // 如果两种IP类型都过期，删除整条记录
-            if (v4Expired && v6Expired) {
-                NSString *sql = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@ = ?", kTableName, kColumnCacheKey];
-                sqlite3_stmt *stmt;
+        if (sqlite3_exec(_db, "COMMIT TRANSACTION", NULL, NULL, &errMsg) != SQLITE_OK) {
+            NSLog(@"Failed to commit transaction: %s", errMsg);
+            sqlite3_free(errMsg);
+            sqlite3_exec(_db, "ROLLBACK TRANSACTION", NULL, NULL, NULL);
+            cleanedCount = 0;
+        }
+    });
 
-                if (sqlite3_prepare_v2(_db, [sql UTF8String], -1, &stmt, NULL) == SQLITE_OK) {
-                    sqlite3_bind_text(stmt, 1, [record.cacheKey UTF8String], -1, SQLITE_TRANSIENT);
+    return cleanedCount;
+}
 
-                    if (sqlite3_step(stmt) == SQLITE_DONE) {
-                        cleanedCount++;
-                    }
+- (BOOL)replaceAllHostAccessRecords:(NSArray<HttpdnsHostAccessRecord *> *)records {
+    __block BOOL result = NO;
 
-                    sqlite3_finalize(stmt);
-                }
+    dispatch_sync(_dbQueue, ^{
+        char *errMsg = NULL;
+        if (sqlite3_exec(_db, "BEGIN IMMEDIATE TRANSACTION", NULL, NULL, &errMsg) != SQLITE_OK) {
+            NSLog(@"Failed to begin transaction: %s", errMsg);
+            sqlite3_free(errMsg);
+            return;
+        }
+
+        NSString *deleteSql = [NSString stringWithFormat:@"DELETE FROM %@", kHostAccessTableName];
+        BOOL succeeded = (sqlite3_exec(_db, [deleteSql UTF8String], NULL, NULL, &errMsg) == SQLITE_OK);
+        if (errMsg) {
+            NSLog(@"Failed to delete host access records: %s", errMsg);
+            sqlite3_free(errMsg);
+            errMsg = NULL;
+        }
+
+        NSString *insertSql = [NSString stringWithFormat:@"INSERT OR REPLACE INTO %@ (%@, %@, %@) VALUES (?, ?, ?)",
+                               kHostAccessTableName, kColumnHostName, kColumnAccessScore, kColumnLastAccessAt];
+        sqlite3_stmt *stmt = succeeded ? [self cachedStatementForSQL:insertSql] : NULL;
+        succeeded = succeeded && stmt != NULL;
+        for (HttpdnsHostAccessRecord *record in records) {
+            if (!succeeded) {
+                break;
             }
-            // 如果只有一种IP类型过期，更新记录
-            else if (v4Expired || v6Expired) {
-                NSMutableArray<NSString *> *v4ips = [NSMutableArray arrayWithArray:record.v4ips];
-                NSMutableArray<NSString *> *v6ips = [NSMutableArray arrayWithArray:record.v6ips];
-
-                // 如果IPv4过期，清空IPv4记录
-                if (v4Expired) {
-                    [v4ips removeAllObjects];
-                }
+            sqlite3_bind_text(stmt, 1, [record.hostName UTF8String], -1, SQLITE_TRANSIENT);
+            sqlite3_bind_double(stmt, 2, record.score);
+            sqlite3_bind_double(stmt, 3, record.lastAccessTime);
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                NSLog(@"Failed to insert host access record: %s", sqlite3_errmsg(_db));
+                succeeded = NO;
+            }
+            [self resetStatement:stmt];
+        }
 
-                // 如果IPv6过期，清空IPv6记录
-                if (v6Expired) {
-                    [v6ips removeAllObjects];
-                }
+        if (!succeeded) {
+            sqlite3_exec(_db, "ROLLBACK TRANSACTION", NULL, NULL, NULL);
+            return;
+        }
 
-                // 更新记录
-                NSString *sql = [NSString stringWithFormat:
-                                @"UPDATE %@ SET %@ = ?, %@ = ? WHERE %@ = ?",
-                                kTableName,
-                                kColumnV4Ips,
-                                kColumnV6Ips,
-                                kColumnCacheKey];
-                sqlite3_stmt *stmt;
-
-                if (sqlite3_prepare_v2(_db, [sql UTF8String], -1, &stmt, NULL) == SQLITE_OK) {
-                    // 绑定v4ips
-                    if (v4ips.count > 0) {
-                        NSString *v4ipsStr = [v4ips componentsJoinedByString:@","];
-                        sqlite3_bind_text(stmt, 1, [v4ipsStr UTF8String], -1, SQLITE_TRANSIENT);
-                    } else {
-                        sqlite3_bind_null(stmt, 1);
-                    }
-
-                    // 绑定v6ips
-                    if (v6ips.count > 0) {
-                        NSString *v6ipsStr = [v6ips componentsJoinedByString:@","];
-                        sqlite3_bind_text(stmt, 2, [v6ipsStr UTF8String], -1, SQLITE_TRANSIENT);
-                    } else {
-                        sqlite3_bind_null(stmt, 2);
-                    }
-
-                    // 绑定cacheKey
-                    sqlite3_bind_text(stmt, 3, [record.cacheKey UTF8String], -1, SQLITE_TRANSIENT);
-
-                    if (sqlite3_step(stmt) == SQLITE_DONE) {
-                        cleanedCount++;
-                    }
-
-                    sqlite3_finalize(stmt);
-                }
+        if (sqlite3_exec(_db, "COMMIT TRANSACTION", NULL, NULL, &errMsg) != SQLITE_OK) {
+            NSLog(@"Failed to commit transaction: %s", errMsg);
+            sqlite3_free(errMsg);
+            sqlite3_exec(_db, "ROLLBACK TRANSACTION", NULL, NULL, NULL);
+            return;
+        }
+        result = YES;
+    });
+
+    return result;
+}
+
+- (NSArray<HttpdnsHostAccessRecord *> *)getAllHostAccessRecords {
+    __block NSMutableArray<HttpdnsHostAccessRecord *> *records = [NSMutableArray array];
+
+    dispatch_sync(_dbQueue, ^{
+        NSString *sql = [NSString stringWithFormat:@"SELECT %@, %@, %@ FROM %@",
+                         kColumnHostName, kColumnAccessScore, kColumnLastAccessAt, kHostAccessTableName];
+        sqlite3_stmt *stmt = [self cachedStatementForSQL:sql];
+        if (!stmt) {
+            return;
+        }
+
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const char *hostNameChars = (const char *)sqlite3_column_text(stmt, 0);
+            if (!hostNameChars) {
+                continue;
             }
+            HttpdnsHostAccessRecord *record = [[HttpdnsHostAccessRecord alloc] initWithHostName:[NSString stringWithUTF8String:hostNameChars]
+                                                                                          score:sqlite3_column_double(stmt, 1)
+                                                                                 lastAccessTime:sqlite3_column_double(stmt, 2)];
+            [records addObject:record];
         }
+        [self resetStatement:stmt];
     });
 
-    return cleanedCount;
+    return [records copy];
 }
 
 #pragma mark - Private Methods
@@ -357,8 +685,39 @@ static NSString *const kColumnExtra = @"extra";
         return NO;
     }
 
+    // WAL模式下写入只追加日志，读写互不阻塞；配合NORMAL同步级别减少fsync次数
+    char *errMsg = NULL;
+    if (sqlite3_exec(_db, "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;", NULL, NULL, &errMsg) != SQLITE_OK) {
+        // 设置失败不影响功能，沿用默认的日志模式
+        NSLog(@"Failed to enable WAL mode: %s", errMsg);
+    }
+    if (errMsg) {
+        sqlite3_free(errMsg);
+    }
+
     // 创建表
-    return [self createTableIfNeeded];
+    return [self createTableIfNeeded] && [self createHostAccessTableIfNeeded];
+}
+
+- (BOOL)createHostAccessTableIfNeeded {
+    NSString *sql = [NSString stringWithFormat:
+                     @"CREATE TABLE IF NOT EXISTS %@ ("
+                     @"%@ TEXT PRIMARY KEY NOT NULL, "
+                     @"%@ REAL NOT NULL, "
+                     @"%@ REAL NOT NULL"
+                     @")",
+                     kHostAccessTableName,
+                     kColumnHostName,
+                     kColumnAccessScore,
+                     kColumnLastAccessAt];
+
+    char *errMsg;
+    if (sqlite3_exec(_db, [sql UTF8String], NULL, NULL, &errMsg) != SQLITE_OK) {
+        NSLog(@"Failed to create host access table: %s", errMsg);
+        sqlite3_free(errMsg);
+        return NO;
+    }
+    return YES;
 }
 
 - (BOOL)createTableIfNeeded {
@@ -376,7 +735,11 @@ static NSString *const kColumnExtra = @"extra";
                      @"%@ TEXT, "
                      @"%@ INTEGER, "
                      @"%@ INTEGER, "
-                     @"%@ TEXT"
+                     @"%@ TEXT, "
+                     @"%@ INTEGER, "
+                     @"%@ INTEGER, "
+                     @"%@ BLOB, "
+                     @"%@ BLOB"
                      @")",
                      kTableName,
                      kColumnId,
@@ -391,7 +754,11 @@ static NSString *const kColumnExtra = @"extra";
                      kColumnV6Ips,
                      kColumnV6Ttl,
                      kColumnV6LookupTime,
-                     kColumnExtra];
+                     kColumnExtra,
+                     kColumnV4ExpireAt,
+                     kColumnV6ExpireAt,
+                     kColumnV4IpBlob,
+                     kColumnV6IpBlob];
 
     char *errMsg;
     if (sqlite3_exec(_db, [sql UTF8String], NULL, NULL, &errMsg) != SQLITE_OK) {
@@ -400,32 +767,237 @@ static NSString *const kColumnExtra = @"extra";
         return NO;
     }
 
+    NSSet<NSString *> *columns = [self existingColumns];
+    if (!columns) {
+        return NO;
+    }
+
+    // 先补齐过期时间列，再把文本格式的IP转换为BLOB
+    if (![self migrateExpireColumnsIfNeeded:columns]) {
+        return NO;
+    }
+
+    if (![self migrateIpBlobColumnsIfNeeded:columns]) {
+        return NO;
+    }
+
+    // 过期清理按两个过期时间列做范围查询，启动预加载按更新时间排序
+    NSString *indexSql = [NSString stringWithFormat:
+                          @"CREATE INDEX IF NOT EXISTS idx_%@_%@ ON %@ (%@); "
+                          @"CREATE INDEX IF NOT EXISTS idx_%@_%@ ON %@ (%@); "
+                          @"CREATE INDEX IF NOT EXISTS idx_%@_%@ ON %@ (%@);",
+                          kTableName, kColumnV4ExpireAt, kTableName, kColumnV4ExpireAt,
+                          kTableName, kColumnV6ExpireAt, kTableName, kColumnV6ExpireAt,
+                          kTableName, kColumnModifyAt, kTableName, kColumnModifyAt];
+    if (sqlite3_exec(_db, [indexSql UTF8String], NULL, NULL, &errMsg) != SQLITE_OK) {
+        NSLog(@"Failed to create index: %s", errMsg);
+        sqlite3_free(errMsg);
+        return NO;
+    }
+
+    return YES;
+}
+
+- (NSSet<NSString *> *)existingColumns {
+    NSMutableSet<NSString *> *columns = [NSMutableSet set];
+    NSString *pragmaSql = [NSString stringWithFormat:@"PRAGMA table_info(%@)", kTableName];
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(_db, [pragmaSql UTF8String], -1, &stmt, NULL) != SQLITE_OK) {
+        NSLog(@"Failed to prepare table_info statement: %s", sqlite3_errmsg(_db));
+        return nil;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char *name = (const char *)sqlite3_column_text(stmt, 1);
+        if (name) {
+            [columns addObject:[NSString stringWithUTF8String:name]];
+        }
+    }
+    sqlite3_finalize(stmt);
+    return columns;
+}
+
+- (BOOL)migrateExpireColumnsIfNeeded:(NSSet<NSString *> *)columns {
+    // 旧版本创建的表没有过期时间列，追加到末尾以保持已有列的顺序
+    if ([columns containsObject:kColumnV4ExpireAt] && [columns containsObject:kColumnV6ExpireAt]) {
+        return YES;
+    }
+
+    NSMutableString *migrateSql = [NSMutableString stringWithString:@"BEGIN IMMEDIATE TRANSACTION; "];
+    if (![columns containsObject:kColumnV4ExpireAt]) {
+        [migrateSql appendFormat:@"ALTER TABLE %@ ADD COLUMN %@ INTEGER; ", kTableName, kColumnV4ExpireAt];
+    }
+    if (![columns containsObject:kColumnV6ExpireAt]) {
+        [migrateSql appendFormat:@"ALTER TABLE %@ ADD COLUMN %@ INTEGER; ", kTableName, kColumnV6ExpireAt];
+    }
+    [migrateSql appendFormat:@"UPDATE %@ SET %@ = IFNULL(%@, 0) + IFNULL(%@, 0), %@ = IFNULL(%@, 0) + IFNULL(%@, 0); COMMIT TRANSACTION;",
+                             kTableName,
+                             kColumnV4ExpireAt, kColumnV4LookupTime, kColumnV4Ttl,
+                             kColumnV6ExpireAt, kColumnV6LookupTime, kColumnV6Ttl];
+
+    char *errMsg;
+    if (sqlite3_exec(_db, [migrateSql UTF8String], NULL, NULL, &errMsg) != SQLITE_OK) {
+        NSLog(@"Failed to migrate expire columns: %s", errMsg);
+        sqlite3_free(errMsg);
+        sqlite3_exec(_db, "ROLLBACK TRANSACTION", NULL, NULL, NULL);
+        return NO;
+    }
+
     return YES;
 }
 
-- (BOOL)saveRecord:(HttpdnsHostRecord *)record {
-    // 使用INSERT OR REPLACE语法，如果记录存在则更新，不存在则插入
+- (BOOL)migrateIpBlobColumnsIfNeeded:(NSSet<NSString *> *)columns {
+    if ([columns containsObject:kColumnV4IpBlob] && [columns containsObject:kColumnV6IpBlob]) {
+        return YES;
+    }
+
+    char *errMsg = NULL;
+    NSMutableString *alterSql = [NSMutableString stringWithString:@"BEGIN IMMEDIATE TRANSACTION; "];
+    if (![columns containsObject:kColumnV4IpBlob]) {
+        [alterSql appendFormat:@"ALTER TABLE %@ ADD COLUMN %@ BLOB; ", kTableName, kColumnV4IpBlob];
+    }
+    if (![columns containsObject:kColumnV6IpBlob]) {
+        [alterSql appendFormat:@"ALTER TABLE %@ ADD COLUMN %@ BLOB; ", kTableName, kColumnV6IpBlob];
+    }
+    if (sqlite3_exec(_db, [alterSql UTF8String], NULL, NULL, &errMsg) != SQLITE_OK) {
+        NSLog(@"Failed to add ip blob columns: %s", errMsg);
+        sqlite3_free(errMsg);
+        sqlite3_exec(_db, "ROLLBACK TRANSACTION", NULL, NULL, NULL);
+        return NO;
+    }
+
+    // 先读出所有文本格式的IP，再逐行转换，避免边遍历边修改同一张表
+    NSMutableArray<NSArray *> *legacyRows = [NSMutableArray array];
+    NSString *selectSql = [NSString stringWithFormat:@"SELECT %@, %@, %@ FROM %@ WHERE %@ IS NOT NULL OR %@ IS NOT NULL",
+                           kColumnId, kColumnV4Ips, kColumnV6Ips, kTableName, kColumnV4Ips, kColumnV6Ips];
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(_db, [selectSql UTF8String], -1, &stmt, NULL) != SQLITE_OK) {
+        NSLog(@"Failed to prepare legacy ip statement: %s", sqlite3_errmsg(_db));
+        sqlite3_exec(_db, "ROLLBACK TRANSACTION", NULL, NULL, NULL);
+        return NO;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char *v4ipsChars = (const char *)sqlite3_column_text(stmt, 1);
+        const char *v6ipsChars = (const char *)sqlite3_column_text(stmt, 2);
+        NSArray<NSString *> *v4ips = v4ipsChars ? [[NSString stringWithUTF8String:v4ipsChars] componentsSeparatedByString:@","] : @[];
+        NSArray<NSString *> *v6ips = v6ipsChars ? [[NSString stringWithUTF8String:v6ipsChars] componentsSeparatedByString:@","] : @[];
+        [legacyRows addObject:@[@(sqlite3_column_int64(stmt, 0)), v4ips, v6ips]];
+    }
+    sqlite3_finalize(stmt);
+
+    NSString *updateSql = [NSString stringWithFormat:@"UPDATE %@ SET %@ = ?, %@ = ?, %@ = NULL, %@ = NULL WHERE %@ = ?",
+                           kTableName, kColumnV4IpBlob, kColumnV6IpBlob, kColumnV4Ips, kColumnV6Ips, kColumnId];
+    if (sqlite3_prepare_v2(_db, [updateSql UTF8String], -1, &stmt, NULL) != SQLITE_OK) {
+        NSLog(@"Failed to prepare ip blob migration statement: %s", sqlite3_errmsg(_db));
+        sqlite3_exec(_db, "ROLLBACK TRANSACTION", NULL, NULL, NULL);
+        return NO;
+    }
+
+    BOOL success = YES;
+    for (NSArray *row in legacyRows) {
+        HttpdnsBindIpBlob(stmt, 1, HttpdnsEncodeIpBlob(row[1], nil, NO));
+        HttpdnsBindIpBlob(stmt, 2, HttpdnsEncodeIpBlob(row[2], nil, YES));
+        sqlite3_bind_int64(stmt, 3, [row[0] longLongValue]);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            NSLog(@"Failed to migrate ip blob: %s", sqlite3_errmsg(_db));
+            success = NO;
+            break;
+        }
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+
+    if (!success || sqlite3_exec(_db, "COMMIT TRANSACTION", NULL, NULL, &errMsg) != SQLITE_OK) {
+        if (errMsg) {
+            NSLog(@"Failed to commit ip blob migration: %s", errMsg);
+            sqlite3_free(errMsg);
+        }
+        sqlite3_exec(_db, "ROLLBACK TRANSACTION", NULL, NULL, NULL);
+        return NO;
+    }
+
+    return YES;
+}
+
+- (void)flushPendingWritesInternal {
+    self.flushScheduled = NO;
+
+    if (self.pendingRecords.count == 0) {
+        return;
+    }
+
+    NSArray<HttpdnsHostRecord *> *records = [self.pendingRecords allValues];
+    [self.pendingRecords removeAllObjects];
+
+    [self saveRecordsInTransaction:records];
+}
+
+- (BOOL)saveRecordsInTransaction:(NSArray<HttpdnsHostRecord *> *)records {
+    char *errMsg = NULL;
+    if (sqlite3_exec(_db, "BEGIN IMMEDIATE TRANSACTION", NULL, NULL, &errMsg) != SQLITE_OK) {
+        NSLog(@"Failed to begin transaction: %s", errMsg);
+        sqlite3_free(errMsg);
+        return NO;
+    }
+
+    NSDate *now = [NSDate date];
+    BOOL allSucceeded = YES;
+    for (HttpdnsHostRecord *record in records) {
+        if (![self saveRecord:record modifyAt:now]) {
+            allSucceeded = NO;
+        }
+    }
+
+    if (sqlite3_exec(_db, "COMMIT TRANSACTION", NULL, NULL, &errMsg) != SQLITE_OK) {
+        NSLog(@"Failed to commit transaction: %s", errMsg);
+        sqlite3_free(errMsg);
+        sqlite3_exec(_db, "ROLLBACK TRANSACTION", NULL, NULL, NULL);
+        return NO;
+    }
+
+    return allSucceeded;
+}
+
+- (BOOL)saveRecord:(HttpdnsHostRecord *)record modifyAt:(NSDate *)modifyAt {
+    // 使用UPSERT语法，记录存在时更新除createAt外的所有字段，保留原始的id和createAt
     NSString *sql = [NSString stringWithFormat:
-                     @"INSERT OR REPLACE INTO %@ ("
-                     @"%@, %@, %@, %@, %@, %@, %@, %@, %@, %@, %@, %@) "
-                     @"VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)",
+                     @"INSERT INTO %@ ("
+                     @"%@, %@, %@, %@, %@, %@, %@, %@, %@, %@, %@, %@, %@, %@) "
+                     @"VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?) "
+                     @"ON CONFLICT(%@) DO UPDATE SET "
+                     @"%@ = excluded.%@, %@ = excluded.%@, %@ = excluded.%@, %@ = excluded.%@, "
+                     @"%@ = excluded.%@, %@ = excluded.%@, %@ = excluded.%@, %@ = excluded.%@, "
+                     @"%@ = excluded.%@, %@ = excluded.%@, %@ = excluded.%@, %@ = excluded.%@",
                      kTableName,
                      kColumnCacheKey,
                      kColumnHostName,
                      kColumnCreateAt,
                      kColumnModifyAt,
                      kColumnClientIp,
-                     kColumnV4Ips,
+                     kColumnV4IpBlob,
                      kColumnV4Ttl,
                      kColumnV4LookupTime,
-                     kColumnV6Ips,
+                     kColumnV6IpBlob,
                      kColumnV6Ttl,
                      kColumnV6LookupTime,
-                     kColumnExtra];
-
-    sqlite3_stmt *stmt;
-    if (sqlite3_prepare_v2(_db, [sql UTF8String], -1, &stmt, NULL) != SQLITE_OK) {
-        NSLog(@"Failed to prepare save statement: %s", sqlite3_errmsg(_db));
+                     kColumnExtra,
+                     kColumnV4ExpireAt,
+                     kColumnV6ExpireAt,
+                     kColumnCacheKey,
+                     kColumnHostName, kColumnHostName,
+                     kColumnModifyAt, kColumnModifyAt,
+                     kColumnClientIp, kColumnClientIp,
+                     kColumnV4IpBlob, kColumnV4IpBlob,
+                     kColumnV4Ttl, kColumnV4Ttl,
+                     kColumnV4LookupTime, kColumnV4LookupTime,
+                     kColumnV6IpBlob, kColumnV6IpBlob,
+                     kColumnV6Ttl, kColumnV6Ttl,
+                     kColumnV6LookupTime, kColumnV6LookupTime,
+                     kColumnExtra, kColumnExtra,
+                     kColumnV4ExpireAt, kColumnV4ExpireAt,
+                     kColumnV6ExpireAt, kColumnV6ExpireAt];
+
+    sqlite3_stmt *stmt = [self cachedStatementForSQL:sql];
+    if (!stmt) {
         return NO;
     }
 
@@ -438,19 +1010,11 @@ static NSString *const kColumnExtra = @"extra";
     // 绑定hostName
     sqlite3_bind_text(stmt, index++, [record.hostName UTF8String], -1, SQLITE_TRANSIENT);
 
-    // 绑定createAt
-    if (record.createAt) {
-        sqlite3_bind_double(stmt, index++, [record.createAt timeIntervalSince1970]);
-    } else {
-        sqlite3_bind_null(stmt, index++);
-    }
+    // 绑定createAt，新记录的createAt与modifyAt相同，已有记录不会更新该字段
+    sqlite3_bind_double(stmt, index++, [modifyAt timeIntervalSince1970]);
 
     // 绑定modifyAt
-    if (record.modifyAt) {
-        sqlite3_bind_double(stmt, index++, [record.modifyAt timeIntervalSince1970]);
-    } else {
-        sqlite3_bind_null(stmt, index++);
-    }
+    sqlite3_bind_double(stmt, index++, [modifyAt timeIntervalSince1970]);
 
     // 绑定clientIp
     if (record.clientIp) {
@@ -459,13 +1023,8 @@ static NSString *const kColumnExtra = @"extra";
         sqlite3_bind_null(stmt, index++);
     }
 
-    // 绑定v4ips
-    if (record.v4ips.count > 0) {
-        NSString *v4ipsStr = [record.v4ips componentsJoinedByString:@","];
-        sqlite3_bind_text(stmt, index++, [v4ipsStr UTF8String], -1, SQLITE_TRANSIENT);
-    } else {
-        sqlite3_bind_null(stmt, index++);
-    }
+    // 绑定v4ips，与探测耗时一起打包为BLOB
+    HttpdnsBindIpBlob(stmt, index++, HttpdnsEncodeIpBlob(record.v4ips, record.v4IpQualities, NO));
 
     // 绑定v4ttl
     sqlite3_bind_int64(stmt, index++, record.v4ttl);
@@ -474,12 +1033,7 @@ static NSString *const kColumnExtra = @"extra";
     sqlite3_bind_int64(stmt, index++, record.v4LookupTime);
 
     // 绑定v6ips
-    if (record.v6ips.count > 0) {
-        NSString *v6ipsStr = [record.v6ips componentsJoinedByString:@","];
-        sqlite3_bind_text(stmt, index++, [v6ipsStr UTF8String], -1, SQLITE_TRANSIENT);
-    } else {
-        sqlite3_bind_null(stmt, index++);
-    }
+    HttpdnsBindIpBlob(stmt, index++, HttpdnsEncodeIpBlob(record.v6ips, record.v6IpQualities, YES));
 
     // 绑定v6ttl
     sqlite3_bind_int64(stmt, index++, record.v6ttl);
@@ -494,18 +1048,25 @@ static NSString *const kColumnExtra = @"extra";
         sqlite3_bind_null(stmt, index++);
     }
 
+    // 绑定v4ExpireAt
+    sqlite3_bind_int64(stmt, index++, record.v4LookupTime + record.v4ttl);
+
+    // 绑定v6ExpireAt
+    sqlite3_bind_int64(stmt, index++, record.v6LookupTime + record.v6ttl);
+
     BOOL result = (sqlite3_step(stmt) == SQLITE_DONE);
-    sqlite3_finalize(stmt);
+    if (!result) {
+        NSLog(@"Failed to save record: %s", sqlite3_errmsg(_db));
+    }
+    [self resetStatement:stmt];
 
     return result;
 }
 
 - (HttpdnsHostRecord *)selectByCacheKeyInternal:(NSString *)cacheKey {
     NSString *sql = [NSString stringWithFormat:@"SELECT * FROM %@ WHERE %@ = ?", kTableName, kColumnCacheKey];
-    sqlite3_stmt *stmt;
-
-    if (sqlite3_prepare_v2(_db, [sql UTF8String], -1, &stmt, NULL) != SQLITE_OK) {
-        NSLog(@"Failed to prepare query statement: %s", sqlite3_errmsg(_db));
+    sqlite3_stmt *stmt = [self cachedStatementForSQL:sql];
+    if (!stmt) {
         return nil;
     }
 
@@ -516,10 +1077,41 @@ static NSString *const kColumnExtra = @"extra";
         record = [self recordFromStatement:stmt];
     }
 
-    sqlite3_finalize(stmt);
+    [self resetStatement:stmt];
     return record;
 }
 
+#pragma mark - Statement Cache
+
+- (sqlite3_stmt *)cachedStatementForSQL:(NSString *)sql {
+    NSValue *cached = self.statementCache[sql];
+    if (cached) {
+        return (sqlite3_stmt *)[cached pointerValue];
+    }
+
+    sqlite3_stmt *stmt = NULL;
+    if (sqlite3_prepare_v3(_db, [sql UTF8String], -1, SQLITE_PREPARE_PERSISTENT, &stmt, NULL) != SQLITE_OK) {
+        NSLog(@"Failed to prepare statement: %s", sqlite3_errmsg(_db));
+        return NULL;
+    }
+
+    self.statementCache[sql] = [NSValue valueWithPointer:stmt];
+    return stmt;
+}
+
+- (void)resetStatement:(sqlite3_stmt *)stmt {
+    // 缓存的语句使用完毕后需要重置，以便下次重新绑定参数
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+}
+
+- (void)finalizeAllCachedStatements {
+    for (NSValue *value in [_statementCache allValues]) {
+        sqlite3_finalize((sqlite3_stmt *)[value pointerValue]);
+    }
+    [_statementCache removeAllObjects];
+}
+
 - (HttpdnsHostRecord *)recordFromStatement:(sqlite3_stmt *)stmt {
     // 获取id
     NSUInteger recordId = (NSUInteger)sqlite3_column_int64(stmt, 0);
@@ -550,14 +1142,12 @@ static NSString *const kColumnExtra = @"extra";
     const char *clientIpChars = (const char *)sqlite3_column_text(stmt, 5);
     NSString *clientIp = clientIpChars ? [NSString stringWithUTF8String:clientIpChars] : nil;
 
-    // 获取v4ips
+    // 获取v4ips，优先读取BLOB列，兼容尚未转换的文本列
     NSArray<NSString *> *v4ips = nil;
-    const char *v4ipsChars = (const char *)sqlite3_column_text(stmt, 6);
-    if (v4ipsChars) {
-        NSString *v4ipsStr = [NSString stringWithUTF8String:v4ipsChars];
-        v4ips = [v4ipsStr componentsSeparatedByString:@","];
-    } else {
-        v4ips = @[];
+    NSArray<HttpdnsIpQuality *> *v4IpQualities = nil;
+    if (!HttpdnsDecodeIpBlob(sqlite3_column_blob(stmt, 15), sqlite3_column_bytes(stmt, 15), &v4ips, &v4IpQualities)) {
+        const char *v4ipsChars = (const char *)sqlite3_column_text(stmt, 6);
+        v4ips = v4ipsChars ? [[NSString stringWithUTF8String:v4ipsChars] componentsSeparatedByString:@","] : @[];
     }
 
     // 获取v4ttl
@@ -568,12 +1158,10 @@ static NSString *const kColumnExtra = @"extra";
 
     // 获取v6ips
     NSArray<NSString *> *v6ips = nil;
-    const char *v6ipsChars = (const char *)sqlite3_column_text(stmt, 9);
-    if (v6ipsChars) {
-        NSString *v6ipsStr = [NSString stringWithUTF8String:v6ipsChars];
-        v6ips = [v6ipsStr componentsSeparatedByString:@","];
-    } else {
-        v6ips = @[];
+    NSArray<HttpdnsIpQuality *> *v6IpQualities = nil;
+    if (!HttpdnsDecodeIpBlob(sqlite3_column_blob(stmt, 16), sqlite3_column_bytes(stmt, 16), &v6ips, &v6IpQualities)) {
+        const char *v6ipsChars = (const char *)sqlite3_column_text(stmt, 9);
+        v6ips = v6ipsChars ? [[NSString stringWithUTF8String:v6ipsChars] componentsSeparatedByString:@","] : @[];
     }
 
     // 获取v6ttl
@@ -597,9 +1185,11 @@ static NSString *const kColumnExtra = @"extra";
                                         modifyAt:modifyAt
                                         clientIp:clientIp
                                            v4ips:v4ips
+                                   v4IpQualities:v4IpQualities
                                            v4ttl:v4ttl
                                     v4LookupTime:v4LookupTime
                                            v6ips:v6ips
+                                   v6IpQualities:v6IpQualities
                                            v6ttl:v6ttl
                                     v6LookupTime:v6LookupTime
                                            extra:extra];
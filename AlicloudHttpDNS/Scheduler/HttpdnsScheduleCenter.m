@@ -29,6 +29,8 @@
 #import "HttpdnsPublicConstant.h"
 #import "HttpdnsRegionConfigLoader.h"
 #import "HttpdnsIpStackDetector.h"
+#import "HttpdnsMetrics.h"
+#import "HttpdnsClock.h"
 
 static NSString *const kLastUpdateUnixTimestampKey = @"last_update_unix_timestamp";
 static NSString *const kScheduleRegionConfigLocalCacheFileName = @"schedule_center_result";
@@ -86,7 +88,7 @@ static int const MAX_UPDATE_RETRY_COUNT = 2;
                                      stringByAppendingPathComponent:kScheduleRegionConfigLocalCacheFileName];
 
         // 上次更新日期默认设置为1天前，这样如果缓存没有记录，就会立即更新
-        _lastScheduleCenterConnectDate = [NSDate dateWithTimeIntervalSinceNow:(- 24 * 60 * 60)];
+        _lastScheduleCenterConnectDate = [NSDate dateWithTimeIntervalSince1970:HttpdnsClockNow() - 24 * 60 * 60];
     }
     return self;
 }
@@ -139,7 +141,7 @@ static int const MAX_UPDATE_RETRY_COUNT = 2;
 - (void)asyncUpdateRegionConfigAfterAtLeast:(NSTimeInterval)interval {
     __block BOOL shouldUpdate = NO;
     dispatch_sync(_scheduleConfigLocalOperationQueue, ^{
-        NSDate *now = [NSDate date];
+        NSDate *now = HttpdnsClockCurrentDate();
         if ([now timeIntervalSinceDate:self->_lastScheduleCenterConnectDate] > interval) {
             self->_lastScheduleCenterConnectDate = now;
             shouldUpdate = YES;
@@ -174,7 +176,7 @@ static int const MAX_UPDATE_RETRY_COUNT = 2;
             [self rotateUpdateServerHost];
 
             // 3秒之后重试
-            dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)((retryCount + 1) * NSEC_PER_SEC)), self->_scheduleFetchConfigAsyncQueue, ^{
+            HttpdnsClockDispatchAfter(retryCount + 1, self->_scheduleFetchConfigAsyncQueue, ^{
                 [self asyncUpdateRegionScheduleConfigAtRetry:retryCount + 1];
             });
 
@@ -182,7 +184,7 @@ static int const MAX_UPDATE_RETRY_COUNT = 2;
         }
 
         NSMutableDictionary *toSave = [scheduleCenterResult mutableCopy];
-        toSave[kLastUpdateUnixTimestampKey] = @([[NSDate date] timeIntervalSince1970]);
+        toSave[kLastUpdateUnixTimestampKey] = @(HttpdnsClockNow());
 
         BOOL saveSuccess = [HttpdnsPersistenceUtils saveJSON:toSave toPath:self.scheduleCenterResultPath];
         HttpdnsLogDebug("Save region config to local cache %@", saveSuccess ? @"successfully" : @"failed");
@@ -249,6 +251,7 @@ static int const MAX_UPDATE_RETRY_COUNT = 2;
 }
 
 - (void)rotateServiceServerHost {
+    HttpdnsMetricsIncrement(HttpdnsMetricCounterServerRotation);
     __block int timeToUpdate = NO;
     dispatch_sync(_scheduleConfigLocalOperationQueue, ^{
         self.currentActiveServiceHostIndex++;
@@ -0,0 +1,52 @@
+//
+//  HttpdnsClock.h
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// TTL过期、重试间隔、网络切换后的延迟任务等计时逻辑统一从这里取时间和调度
+// 默认使用系统时钟，测试中可以替换为虚拟时钟，不用真实等待就能驱动这些逻辑
+@protocol HttpdnsClock <NSObject>
+
+// 当前时间，Unix时间戳，单位秒
+- (NSTimeInterval)now;
+
+// 让当前线程等待指定时长
+- (void)sleepForTimeInterval:(NSTimeInterval)interval;
+
+// 指定时长后在queue上执行block
+- (void)dispatchAfter:(NSTimeInterval)delay queue:(dispatch_queue_t)queue block:(dispatch_block_t)block;
+
+@end
+
+@interface HttpdnsSystemClock : NSObject <HttpdnsClock>
+
++ (instancetype)sharedInstance;
+
+@end
+
+// 当前生效的时钟，没有替换过时返回系统时钟
+FOUNDATION_EXTERN id<HttpdnsClock> HttpdnsClockCurrent(void);
+
+// 替换进程内使用的时钟，传nil恢复系统时钟
+// 读取时钟的路径不加锁，被替换下来的时钟不会释放，只应在测试中调用
+FOUNDATION_EXTERN void HttpdnsClockSetCurrent(id<HttpdnsClock> _Nullable clock);
+
+FOUNDATION_EXTERN NSTimeInterval HttpdnsClockNow(void);
+
+// 当前时间取整到秒，与缓存记录中的lookupTime、ttl同一单位
+FOUNDATION_EXTERN int64_t HttpdnsClockCurrentEpoch(void);
+
+FOUNDATION_EXTERN NSDate *HttpdnsClockCurrentDate(void);
+
+FOUNDATION_EXTERN void HttpdnsClockSleep(NSTimeInterval interval);
+
+FOUNDATION_EXTERN void HttpdnsClockDispatchAfter(NSTimeInterval delay, dispatch_queue_t queue, dispatch_block_t block);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,82 @@
+//
+//  HttpdnsClock.m
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "HttpdnsClock.h"
+#import <stdatomic.h>
+#import <time.h>
+
+// 为空时使用系统时钟，缓存命中等热路径上只多一次原子读
+static _Atomic(void *) sCurrentClock = NULL;
+
+@implementation HttpdnsSystemClock
+
++ (instancetype)sharedInstance {
+    static HttpdnsSystemClock *instance = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        instance = [[HttpdnsSystemClock alloc] init];
+    });
+    return instance;
+}
+
+- (NSTimeInterval)now {
+    return CFAbsoluteTimeGetCurrent() + kCFAbsoluteTimeIntervalSince1970;
+}
+
+- (void)sleepForTimeInterval:(NSTimeInterval)interval {
+    [NSThread sleepForTimeInterval:interval];
+}
+
+- (void)dispatchAfter:(NSTimeInterval)delay queue:(dispatch_queue_t)queue block:(dispatch_block_t)block {
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), queue, block);
+}
+
+@end
+
+static inline id<HttpdnsClock> HttpdnsClockInjected(void) {
+    void *clock = atomic_load_explicit(&sCurrentClock, memory_order_acquire);
+    return (__bridge id<HttpdnsClock>)clock;
+}
+
+id<HttpdnsClock> HttpdnsClockCurrent(void) {
+    return HttpdnsClockInjected() ?: [HttpdnsSystemClock sharedInstance];
+}
+
+void HttpdnsClockSetCurrent(id<HttpdnsClock> clock) {
+    // 其他线程可能正持有旧时钟的裸指针，因此旧时钟不释放
+    void *retainedClock = clock ? (void *)CFBridgingRetain(clock) : NULL;
+    atomic_store_explicit(&sCurrentClock, retainedClock, memory_order_release);
+}
+
+NSTimeInterval HttpdnsClockNow(void) {
+    id<HttpdnsClock> clock = HttpdnsClockInjected();
+    if (!clock) {
+        return CFAbsoluteTimeGetCurrent() + kCFAbsoluteTimeIntervalSince1970;
+    }
+    return [clock now];
+}
+
+int64_t HttpdnsClockCurrentEpoch(void) {
+    id<HttpdnsClock> clock = HttpdnsClockInjected();
+    if (!clock) {
+        return (int64_t)time(NULL);
+    }
+    return (int64_t)[clock now];
+}
+
+NSDate *HttpdnsClockCurrentDate(void) {
+    return [NSDate dateWithTimeIntervalSince1970:HttpdnsClockNow()];
+}
+
+void HttpdnsClockSleep(NSTimeInterval interval) {
+    [HttpdnsClockCurrent() sleepForTimeInterval:interval];
+}
+
+void HttpdnsClockDispatchAfter(NSTimeInterval delay, dispatch_queue_t queue, dispatch_block_t block) {
+    [HttpdnsClockCurrent() dispatchAfter:delay queue:queue block:block];
+}
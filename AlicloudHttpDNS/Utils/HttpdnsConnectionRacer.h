@@ -0,0 +1,68 @@
+//
+//  HttpdnsConnectionRacer.h
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/26.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * 竞速建连的最终结果
+ * @param socketFd 最先建立的连接，阻塞模式，所有权交给调用方；全部失败时为-1
+ * @param ip 胜出的地址，全部失败时为nil
+ */
+typedef void(^HttpdnsConnectionRaceCompletion)(int socketFd, NSString * _Nullable ip);
+
+/**
+ * 单个地址的建连结果，用于反馈到IP排序统计
+ * 被取消的尝试（已有其他地址胜出）不会回调
+ * @param costTime 建连耗时（毫秒），-1表示失败或超时
+ */
+typedef void(^HttpdnsConnectionAttemptHandler)(NSString *ip, NSInteger costTime);
+
+/**
+ * 按RFC 8305（Happy Eyeballs v2）的方式对多个地址竞速建连
+ *
+ * 地址按给定顺序依次发起连接，相邻两次发起之间间隔attemptDelay；
+ * 前一个尝试失败时立即发起下一个。任一连接建立后取消其余尝试
+ */
+@interface HttpdnsConnectionRacer : NSObject
+
+// 相邻两次发起连接的间隔，默认250毫秒，与RFC 8305的推荐值一致
+@property (nonatomic, assign) NSTimeInterval attemptDelay;
+
+// 单个地址的建连超时时间，默认5秒
+@property (nonatomic, assign) NSTimeInterval attemptTimeout;
+
++ (instancetype)sharedInstance;
+
+/**
+ * 按RFC 8305的规则把两个地址族的排序结果交错排列，IPv6优先
+ * @param ipv4s 已排序的IPv4地址
+ * @param ipv6s 已排序的IPv6地址
+ * @param maxPerFamily 每个地址族最多取前几个地址，为0时不限制
+ */
++ (NSArray<NSString *> *)interleavedCandidatesWithIpv4s:(nullable NSArray<NSString *> *)ipv4s
+                                                  ipv6s:(nullable NSArray<NSString *> *)ipv6s
+                                           maxPerFamily:(NSUInteger)maxPerFamily;
+
+/**
+ * 对候选地址竞速建连
+ * @param ips 按优先级排列的候选地址
+ * @param port 端口
+ * @param attemptHandler 每个地址完成后在竞速的内部串行队列上同步回调，不能有耗时操作，可以为空；
+ *        竞速结束前完成的尝试都先于completion回调，结束后才完成的尝试（已建立但被关闭的连接）在completion之后回调
+ * @param completion 竞速结束后在全局队列上回调一次
+ */
+- (void)raceConnectionsToIPs:(NSArray<NSString *> *)ips
+                        port:(int)port
+              attemptHandler:(nullable HttpdnsConnectionAttemptHandler)attemptHandler
+                  completion:(HttpdnsConnectionRaceCompletion)completion;
+
+@end
+
+NS_ASSUME_NONNULL_END
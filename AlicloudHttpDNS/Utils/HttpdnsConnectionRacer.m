@@ -0,0 +1,214 @@
+//
+//  HttpdnsConnectionRacer.m
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/26.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "HttpdnsConnectionRacer.h"
+#import <unistd.h>
+#import "HttpdnsTCPProber.h"
+#import "HttpdnsLog_Internal.h"
+#import "HttpdnsUtil.h"
+
+// RFC 8305推荐的Connection Attempt Delay
+static const NSTimeInterval kHttpdnsConnectionAttemptDelay = 0.25;
+
+static const NSTimeInterval kHttpdnsConnectionAttemptTimeout = 5.0;
+
+// 应用发起的建连与后台探测使用不同的探测器，避免排在大量探测之后
+static const NSUInteger kHttpdnsConnectionRacerMaxConcurrentConnects = 32;
+
+// 一次竞速的状态，只在自己的串行队列上访问
+@interface HttpdnsConnectionRace : NSObject
+
+@property (nonatomic, copy) NSArray<NSString *> *ips;
+@property (nonatomic, assign) int port;
+@property (nonatomic, assign) NSTimeInterval attemptDelay;
+@property (nonatomic, assign) NSTimeInterval attemptTimeout;
+@property (nonatomic, copy) HttpdnsConnectionAttemptHandler attemptHandler;
+@property (nonatomic, copy) HttpdnsConnectionRaceCompletion completion;
+@property (nonatomic, strong) HttpdnsTCPProber *prober;
+@property (nonatomic, strong) dispatch_queue_t queue;
+
+@property (nonatomic, assign) NSUInteger nextIndex;
+@property (nonatomic, assign) NSUInteger pendingCount;
+@property (nonatomic, assign) BOOL finished;
+// 下标为候选地址的位置，值为建连标识
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, NSNumber *> *pendingTokens;
+
+@end
+
+@implementation HttpdnsConnectionRace
+
+- (void)start {
+    dispatch_async(self.queue, ^{
+        [self startNextAttempt];
+    });
+}
+
+- (void)startNextAttempt {
+    if (self.finished || self.nextIndex >= self.ips.count) {
+        return;
+    }
+
+    NSUInteger index = self.nextIndex++;
+    NSString *ip = self.ips[index];
+    self.pendingCount++;
+
+    NSUInteger token = [self.prober connectIP:ip port:self.port timeout:self.attemptTimeout completion:^(int socketFd, NSInteger costTime) {
+        dispatch_async(self.queue, ^{
+            [self attemptAtIndex:index finishedWithSocket:socketFd costTime:costTime];
+        });
+    }];
+    if (token != 0) {
+        self.pendingTokens[@(index)] = @(token);
+    }
+
+    // 到达间隔时还没有新的尝试发起（前一个尝试既没成功也没失败），就发起下一个
+    NSUInteger startedCount = self.nextIndex;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.attemptDelay * NSEC_PER_SEC)), self.queue, ^{
+        if (self.nextIndex == startedCount) {
+            [self startNextAttempt];
+        }
+    });
+}
+
+- (void)attemptAtIndex:(NSUInteger)index finishedWithSocket:(int)socketFd costTime:(NSInteger)costTime {
+    NSString *ip = self.ips[index];
+    BOOL cancelled = self.pendingTokens[@(index)] == nil && self.finished;
+    [self.pendingTokens removeObjectForKey:@(index)];
+    self.pendingCount--;
+
+    // 已有其他地址胜出时被取消的尝试不代表该地址的质量
+    if (!(cancelled && costTime < 0)) {
+        [self reportAttemptOfIP:ip costTime:costTime];
+    }
+
+    if (socketFd >= 0) {
+        if (self.finished) {
+            // 取消前已经建立的连接
+            close(socketFd);
+            return;
+        }
+        [self finishWithSocket:socketFd ip:ip];
+        return;
+    }
+
+    if (self.finished) {
+        return;
+    }
+
+    if (self.nextIndex < self.ips.count) {
+        // 失败后立即尝试下一个地址，不等待间隔
+        [self startNextAttempt];
+    } else if (self.pendingCount == 0) {
+        HttpdnsLogDebug("ConnectionRacer all %lu candidates failed", (unsigned long)self.ips.count);
+        [self finishWithSocket:-1 ip:nil];
+    }
+}
+
+- (void)finishWithSocket:(int)socketFd ip:(NSString *)ip {
+    self.finished = YES;
+
+    NSArray<NSNumber *> *tokens = [self.pendingTokens allValues];
+    [self.pendingTokens removeAllObjects];
+    for (NSNumber *token in tokens) {
+        [self.prober cancelConnect:[token unsignedIntegerValue]];
+    }
+
+    HttpdnsConnectionRaceCompletion completion = self.completion;
+    self.completion = nil;
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        completion(socketFd, ip);
+    });
+}
+
+- (void)reportAttemptOfIP:(NSString *)ip costTime:(NSInteger)costTime {
+    HttpdnsConnectionAttemptHandler attemptHandler = self.attemptHandler;
+    if (!attemptHandler) {
+        return;
+    }
+    // 在串行队列上同步回调，保证先于completion，调用方可以在completion中统一处理本轮的样本
+    attemptHandler(ip, costTime);
+}
+
+@end
+
+
+@interface HttpdnsConnectionRacer ()
+
+@property (nonatomic, strong) HttpdnsTCPProber *prober;
+
+@end
+
+@implementation HttpdnsConnectionRacer
+
++ (instancetype)sharedInstance {
+    static HttpdnsConnectionRacer *instance = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        instance = [[HttpdnsConnectionRacer alloc] init];
+    });
+    return instance;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _attemptDelay = kHttpdnsConnectionAttemptDelay;
+        _attemptTimeout = kHttpdnsConnectionAttemptTimeout;
+        _prober = [[HttpdnsTCPProber alloc] initWithMaxConcurrentProbes:kHttpdnsConnectionRacerMaxConcurrentConnects];
+    }
+    return self;
+}
+
++ (NSArray<NSString *> *)interleavedCandidatesWithIpv4s:(NSArray<NSString *> *)ipv4s
+                                                  ipv6s:(NSArray<NSString *> *)ipv6s
+                                           maxPerFamily:(NSUInteger)maxPerFamily {
+    NSUInteger v4Count = maxPerFamily > 0 ? MIN(ipv4s.count, maxPerFamily) : ipv4s.count;
+    NSUInteger v6Count = maxPerFamily > 0 ? MIN(ipv6s.count, maxPerFamily) : ipv6s.count;
+
+    NSMutableArray<NSString *> *candidates = [NSMutableArray arrayWithCapacity:v4Count + v6Count];
+    for (NSUInteger i = 0; i < MAX(v4Count, v6Count); i++) {
+        if (i < v6Count) {
+            [candidates addObject:ipv6s[i]];
+        }
+        if (i < v4Count) {
+            [candidates addObject:ipv4s[i]];
+        }
+    }
+    return [candidates copy];
+}
+
+- (void)raceConnectionsToIPs:(NSArray<NSString *> *)ips
+                        port:(int)port
+              attemptHandler:(HttpdnsConnectionAttemptHandler)attemptHandler
+                  completion:(HttpdnsConnectionRaceCompletion)completion {
+    if (!completion) {
+        return;
+    }
+
+    if ([HttpdnsUtil isEmptyArray:ips]) {
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            completion(-1, nil);
+        });
+        return;
+    }
+
+    HttpdnsConnectionRace *race = [[HttpdnsConnectionRace alloc] init];
+    race.ips = ips;
+    race.port = port;
+    race.attemptDelay = self.attemptDelay;
+    race.attemptTimeout = self.attemptTimeout;
+    race.attemptHandler = attemptHandler;
+    race.completion = completion;
+    race.prober = self.prober;
+    race.queue = dispatch_queue_create("com.aliyun.httpdns.connectionrace", DISPATCH_QUEUE_SERIAL);
+    race.pendingTokens = [NSMutableDictionary dictionary];
+    // 竞速对象由探测回调和延迟任务持有，全部结束后自然释放
+    [race start];
+}
+
+@end
@@ -0,0 +1,54 @@
+//
+//  HttpdnsHostAccessTracker.h
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "HttpdnsHostAccessRecord.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * 按域名统计指数衰减的访问频率，用于挑选需要自动预解析的热门域名
+ *
+ * 以域名的FNV-1a哈希为键，命中已跟踪域名时只更新已有记录，不创建对象；
+ * 跟踪的域名达到上限后，新域名会淘汰衰减后频率最低的域名
+ */
+@interface HttpdnsHostAccessTracker : NSObject
+
+// 跟踪的域名数量
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+// 上次调用recordsAccessedSince:atTime:之后是否有新的访问
+@property (nonatomic, assign, readonly, getter=isDirty) BOOL dirty;
+
+- (instancetype)initWithHalfLife:(NSTimeInterval)halfLife maxTrackedCount:(NSUInteger)maxTrackedCount;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+- (void)recordAccessForHost:(NSString *)host atTime:(NSTimeInterval)time;
+
+// 用于只有C字符串的快速路径，域名尚未被跟踪时忽略
+- (void)recordAccessForHostHash:(uint64_t)hostHash atTime:(NSTimeInterval)time;
+
+/**
+ * 按衰减后的访问频率从高到低返回域名
+ * @param limit 最多返回的数量
+ * @param since 最近一次访问早于该时刻的域名不返回
+ */
+- (NSArray<NSString *> *)hottestHostsWithLimit:(NSUInteger)limit accessedSince:(NSTimeInterval)since atTime:(NSTimeInterval)time;
+
+// 用于持久化，返回最近一次访问不早于since的记录的拷贝，并清除dirty标记
+- (NSArray<HttpdnsHostAccessRecord *> *)recordsAccessedSince:(NSTimeInterval)since;
+
+// 合并持久化的记录，同一域名把两边的频率衰减到较晚的访问时刻后相加
+- (void)mergeRecords:(NSArray<HttpdnsHostAccessRecord *> *)records;
+
+- (void)removeAllRecords;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,214 @@
+//
+//  HttpdnsHostAccessTracker.m
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "HttpdnsHostAccessTracker.h"
+#import "HttpdnsResolveRecorder.h"
+#import <os/lock.h>
+
+@implementation HttpdnsHostAccessTracker {
+    os_unfair_lock _lock;
+    NSTimeInterval _halfLife;
+    NSUInteger _maxTrackedCount;
+    // 键为域名哈希，值为HttpdnsHostAccessRecord，查找时不需要构造键对象
+    CFMutableDictionaryRef _records;
+    BOOL _dirty;
+}
+
+- (instancetype)initWithHalfLife:(NSTimeInterval)halfLife maxTrackedCount:(NSUInteger)maxTrackedCount {
+    if (self = [super init]) {
+        _lock = OS_UNFAIR_LOCK_INIT;
+        _halfLife = halfLife;
+        _maxTrackedCount = MAX(maxTrackedCount, 1);
+        _records = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    CFRelease(_records);
+}
+
+static inline const void *HttpdnsHostAccessKey(uint64_t hostHash) {
+    return (const void *)(uintptr_t)hostHash;
+}
+
+- (NSUInteger)count {
+    os_unfair_lock_lock(&_lock);
+    NSUInteger count = (NSUInteger)CFDictionaryGetCount(_records);
+    os_unfair_lock_unlock(&_lock);
+    return count;
+}
+
+- (BOOL)isDirty {
+    os_unfair_lock_lock(&_lock);
+    BOOL dirty = _dirty;
+    os_unfair_lock_unlock(&_lock);
+    return dirty;
+}
+
+// 调用方持有锁
+- (void)accessRecord:(HttpdnsHostAccessRecord *)record atTime:(NSTimeInterval)time {
+    record.score = [record scoreAtTime:time halfLife:_halfLife] + 1;
+    record.lastAccessTime = MAX(record.lastAccessTime, time);
+    _dirty = YES;
+}
+
+- (void)recordAccessForHost:(NSString *)host atTime:(NSTimeInterval)time {
+    if (host.length == 0) {
+        return;
+    }
+    const void *key = HttpdnsHostAccessKey(HttpdnsResolveRecordHostHash(host.UTF8String));
+
+    os_unfair_lock_lock(&_lock);
+    HttpdnsHostAccessRecord *record = (__bridge HttpdnsHostAccessRecord *)CFDictionaryGetValue(_records, key);
+    if (record && [record.hostName isEqualToString:host]) {
+        [self accessRecord:record atTime:time];
+        os_unfair_lock_unlock(&_lock);
+        return;
+    }
+    os_unfair_lock_unlock(&_lock);
+
+    // 新域名在锁外构造记录，哈希冲突时新域名覆盖旧域名
+    HttpdnsHostAccessRecord *newRecord = [[HttpdnsHostAccessRecord alloc] initWithHostName:host score:1 lastAccessTime:time];
+    os_unfair_lock_lock(&_lock);
+    record = (__bridge HttpdnsHostAccessRecord *)CFDictionaryGetValue(_records, key);
+    if (record && [record.hostName isEqualToString:host]) {
+        [self accessRecord:record atTime:time];
+    } else {
+        if (!record && (NSUInteger)CFDictionaryGetCount(_records) >= _maxTrackedCount) {
+            [self evictColdestRecordAtTime:time];
+        }
+        CFDictionarySetValue(_records, key, (__bridge const void *)newRecord);
+        _dirty = YES;
+    }
+    os_unfair_lock_unlock(&_lock);
+}
+
+- (void)recordAccessForHostHash:(uint64_t)hostHash atTime:(NSTimeInterval)time {
+    os_unfair_lock_lock(&_lock);
+    HttpdnsHostAccessRecord *record = (__bridge HttpdnsHostAccessRecord *)CFDictionaryGetValue(_records, HttpdnsHostAccessKey(hostHash));
+    if (record) {
+        [self accessRecord:record atTime:time];
+    }
+    os_unfair_lock_unlock(&_lock);
+}
+
+// 调用方持有锁
+- (void)evictColdestRecordAtTime:(NSTimeInterval)time {
+    CFIndex count = CFDictionaryGetCount(_records);
+    if (count == 0) {
+        return;
+    }
+    const void **keys = malloc(sizeof(void *) * count);
+    const void **values = malloc(sizeof(void *) * count);
+    CFDictionaryGetKeysAndValues(_records, keys, values);
+
+    CFIndex coldestIndex = 0;
+    double coldestScore = DBL_MAX;
+    for (CFIndex i = 0; i < count; i++) {
+        double score = [(__bridge HttpdnsHostAccessRecord *)values[i] scoreAtTime:time halfLife:_halfLife];
+        if (score < coldestScore) {
+            coldestScore = score;
+            coldestIndex = i;
+        }
+    }
+    CFDictionaryRemoveValue(_records, keys[coldestIndex]);
+    free(keys);
+    free(values);
+}
+
+- (NSArray<HttpdnsHostAccessRecord *> *)allRecordsLocked {
+    CFIndex count = CFDictionaryGetCount(_records);
+    if (count == 0) {
+        return @[];
+    }
+    const void **values = malloc(sizeof(void *) * count);
+    CFDictionaryGetKeysAndValues(_records, NULL, values);
+    NSArray<HttpdnsHostAccessRecord *> *records = [NSArray arrayWithObjects:(__unsafe_unretained id *)(void *)values count:count];
+    free(values);
+    return records;
+}
+
+- (NSArray<NSString *> *)hottestHostsWithLimit:(NSUInteger)limit accessedSince:(NSTimeInterval)since atTime:(NSTimeInterval)time {
+    if (limit == 0) {
+        return @[];
+    }
+
+    NSMutableArray<HttpdnsHostAccessRecord *> *candidates = [NSMutableArray array];
+    os_unfair_lock_lock(&_lock);
+    for (HttpdnsHostAccessRecord *record in [self allRecordsLocked]) {
+        if (record.lastAccessTime >= since) {
+            [candidates addObject:[record copy]];
+        }
+    }
+    os_unfair_lock_unlock(&_lock);
+
+    NSTimeInterval halfLife = _halfLife;
+    [candidates sortUsingComparator:^NSComparisonResult(HttpdnsHostAccessRecord *lhs, HttpdnsHostAccessRecord *rhs) {
+        double lhsScore = [lhs scoreAtTime:time halfLife:halfLife];
+        double rhsScore = [rhs scoreAtTime:time halfLife:halfLife];
+        if (lhsScore != rhsScore) {
+            return lhsScore > rhsScore ? NSOrderedAscending : NSOrderedDescending;
+        }
+        return [lhs.hostName compare:rhs.hostName];
+    }];
+
+    NSUInteger count = MIN(limit, candidates.count);
+    NSMutableArray<NSString *> *hosts = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [hosts addObject:candidates[i].hostName];
+    }
+    return hosts;
+}
+
+- (NSArray<HttpdnsHostAccessRecord *> *)recordsAccessedSince:(NSTimeInterval)since {
+    NSMutableArray<HttpdnsHostAccessRecord *> *records = [NSMutableArray array];
+    os_unfair_lock_lock(&_lock);
+    for (HttpdnsHostAccessRecord *record in [self allRecordsLocked]) {
+        if (record.lastAccessTime >= since) {
+            [records addObject:[record copy]];
+        }
+    }
+    _dirty = NO;
+    os_unfair_lock_unlock(&_lock);
+    return records;
+}
+
+- (void)mergeRecords:(NSArray<HttpdnsHostAccessRecord *> *)records {
+    os_unfair_lock_lock(&_lock);
+    for (HttpdnsHostAccessRecord *record in records) {
+        if (record.hostName.length == 0) {
+            continue;
+        }
+        const void *key = HttpdnsHostAccessKey(HttpdnsResolveRecordHostHash(record.hostName.UTF8String));
+        HttpdnsHostAccessRecord *existing = (__bridge HttpdnsHostAccessRecord *)CFDictionaryGetValue(_records, key);
+        if (existing && [existing.hostName isEqualToString:record.hostName]) {
+            NSTimeInterval latest = MAX(existing.lastAccessTime, record.lastAccessTime);
+            existing.score = [existing scoreAtTime:latest halfLife:_halfLife] + [record scoreAtTime:latest halfLife:_halfLife];
+            existing.lastAccessTime = latest;
+            continue;
+        }
+        if (existing) {
+            continue;
+        }
+        if ((NSUInteger)CFDictionaryGetCount(_records) >= _maxTrackedCount) {
+            [self evictColdestRecordAtTime:record.lastAccessTime];
+        }
+        CFDictionarySetValue(_records, key, (__bridge const void *)[record copy]);
+    }
+    os_unfair_lock_unlock(&_lock);
+}
+
+- (void)removeAllRecords {
+    os_unfair_lock_lock(&_lock);
+    CFDictionaryRemoveAllValues(_records);
+    _dirty = NO;
+    os_unfair_lock_unlock(&_lock);
+}
+
+@end
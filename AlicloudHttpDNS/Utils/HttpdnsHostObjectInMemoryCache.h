@@ -8,6 +8,7 @@
 
 #import <Foundation/Foundation.h>
 #import "HttpdnsHostObject.h"
+#import "HttpdnsResult.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -23,8 +24,42 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (HttpdnsHostObject *)getHostObjectByCacheKey:(NSString *)key createIfNotExists:(HttpdnsHostObject *(^)(void))objectProducer;
 
+- (BOOL)containsCacheKey:(NSString *)key;
+
+// 不复制缓存对象，判断缓存中是否有包含所需地址族、到currentEpoch仍未过期的结果；持久化缓存加载的结果同样计入
+- (BOOL)containsUnexpiredHostObjectForCacheKey:(NSString *)key queryIpType:(HttpdnsQueryIPType)queryType atTime:(int64_t)currentEpoch;
+
 - (void)updateQualityForCacheKey:(NSString *)key forIp:(NSString *)ip withConnectedRT:(NSInteger)connectedRT;
 
+// 只记录探测样本不排序，一轮探测结束后调用rerankIpsForCacheKey:统一排序
+- (void)recordQualitySampleForCacheKey:(NSString *)key forIp:(NSString *)ip withConnectedRT:(NSInteger)connectedRT;
+
+- (void)rerankIpsForCacheKey:(NSString *)key;
+
+/**
+ * 热路径查询：以C字符串为key，直接把未过期的缓存结果写入sockaddr数组
+ * 查询过程不创建Objective-C对象；缓存不存在、已过期、来自持久化缓存或缺少所需地址族时返回-1，由调用方走完整的解析流程
+ * @return 写入的地址数量，或-1
+ */
+- (NSInteger)copyFreshSockaddrsForCacheKey:(const char *)key
+                               queryIpType:(HttpdnsQueryIPType)queryType
+                                      port:(uint16_t)port
+                                    atTime:(int64_t)currentEpoch
+                                        to:(struct sockaddr_storage *)sockaddrs
+                                  maxCount:(NSUInteger)maxCount;
+
+/**
+ * 热路径查询：为缓存对象构造的结果只构造一次，缓存对象发生任何变化前每次返回它的浅拷贝，与其共用IP数组
+ * 只在缓存未过期、不来自持久化缓存且包含所需地址族时返回，否则返回nil，由调用方走完整的解析流程
+ * @param host 调用方请求的域名，cacheKey与域名不同时结果中的host以此为准
+ * @param builder 缓存未命中时在锁外基于缓存对象的拷贝构造结果，构造期间缓存对象有变化时结果不保存
+ */
+- (nullable HttpdnsResult *)memoizedResultForCacheKey:(NSString *)key
+                                          queryIpType:(HttpdnsQueryIPType)queryType
+                                                 host:(NSString *)host
+                                               atTime:(int64_t)currentEpoch
+                                              builder:(HttpdnsResult * _Nullable (^)(HttpdnsHostObject *object))builder;
+
 - (void)removeHostObjectByCacheKey:(NSString *)key;
 
 - (void)removeAllHostObjects;
@@ -7,31 +7,111 @@
 //
 
 #import "HttpdnsHostObjectInMemoryCache.h"
+#import "HttpdnsResult_Internal.h"
+#import "HttpdnsMetrics.h"
+#import <string.h>
+
+// C字符串key的回调，插入时复制一份，移除时释放
+static const void *HttpdnsCStringKeyRetain(CFAllocatorRef allocator, const void *value) {
+    return strdup((const char *)value);
+}
+
+static void HttpdnsCStringKeyRelease(CFAllocatorRef allocator, const void *value) {
+    free((void *)value);
+}
+
+static Boolean HttpdnsCStringKeyEqual(const void *value1, const void *value2) {
+    return strcmp((const char *)value1, (const char *)value2) == 0;
+}
+
+static CFHashCode HttpdnsCStringKeyHash(const void *value) {
+    CFHashCode hash = 2166136261u;
+    for (const char *cursor = (const char *)value; *cursor; cursor++) {
+        hash ^= (uint8_t)*cursor;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static const CFDictionaryKeyCallBacks kHttpdnsCStringKeyCallBacks = {
+    0,
+    HttpdnsCStringKeyRetain,
+    HttpdnsCStringKeyRelease,
+    NULL,
+    HttpdnsCStringKeyEqual,
+    HttpdnsCStringKeyHash
+};
+
+// 可以不经过完整解析流程直接使用的缓存对象
+// 持久化缓存加载的结果需要走完整流程，以便触发延迟的IP质量探测和后台刷新
+static BOOL HttpdnsIsHostObjectFresh(HttpdnsHostObject *object, HttpdnsQueryIPType queryType, int64_t currentEpoch) {
+    return object
+        && ![object isLoadFromDB]
+        && ![object isIpEmptyUnderQueryIpType:queryType]
+        && ![object isExpiredUnderQueryIpType:queryType atTime:currentEpoch];
+}
 
 @interface HttpdnsHostObjectInMemoryCache ()
 
 @property (nonatomic, strong) NSMutableDictionary<NSString *, HttpdnsHostObject *> *cacheDict;
 @property (nonatomic, strong) NSLock *lock;
 
+// 按cacheKey、查询类型记录已构造的结果，缓存对象有任何变化时整体失效
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSMutableDictionary<NSNumber *, HttpdnsResult *> *> *memoizedResults;
+
 @end
 
-@implementation HttpdnsHostObjectInMemoryCache
+@implementation HttpdnsHostObjectInMemoryCache {
+    // 与cacheDict指向相同对象的索引，供C字符串查询使用，同样只在锁内访问
+    CFMutableDictionaryRef _cStringKeyIndex;
+    // 已构造的结果每失效一次加一，锁外构造的结果只在期间没有失效时保存
+    uint64_t _memoizedGeneration;
+}
 
 - (instancetype)init {
     self = [super init];
     if (self) {
         _cacheDict = [NSMutableDictionary dictionary];
         _lock = [[NSLock alloc] init];
+        _memoizedResults = [NSMutableDictionary dictionary];
+        _cStringKeyIndex = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, &kHttpdnsCStringKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
     }
     return self;
 }
 
+- (void)dealloc {
+    if (_cStringKeyIndex) {
+        CFRelease(_cStringKeyIndex);
+    }
+}
+
 - (void)setHostObject:(HttpdnsHostObject *)object forCacheKey:(NSString *)key {
     [_lock lock];
     _cacheDict[key] = object;
+    [self indexHostObject:object forCacheKey:key];
+    [self invalidateMemoizedResultsForCacheKey:key];
     [_lock unlock];
 }
 
+// 需在锁内调用
+- (void)invalidateMemoizedResultsForCacheKey:(NSString *)key {
+    [_memoizedResults removeObjectForKey:key];
+    _memoizedGeneration++;
+}
+
+// 需在锁内调用
+- (void)indexHostObject:(HttpdnsHostObject *)object forCacheKey:(NSString *)key {
+    const char *cKey = [key UTF8String];
+    if (!cKey) {
+        return;
+    }
+    if (object) {
+        CFDictionarySetValue(_cStringKeyIndex, cKey, (__bridge const void *)object);
+    } else {
+        CFDictionaryRemoveValue(_cStringKeyIndex, cKey);
+    }
+}
+
 - (HttpdnsHostObject *)getHostObjectByCacheKey:(NSString *)key {
     [_lock lock];
     @try {
@@ -49,6 +129,7 @@
         if (!object) {
             object = objectProducer();
             _cacheDict[key] = object;
+            [self indexHostObject:object forCacheKey:key];
         }
         return [object copy];
     } @finally {
@@ -56,25 +137,144 @@
     }
 }
 
+- (BOOL)containsCacheKey:(NSString *)key {
+    [_lock lock];
+    BOOL contains = _cacheDict[key] != nil;
+    [_lock unlock];
+    return contains;
+}
+
+- (BOOL)containsUnexpiredHostObjectForCacheKey:(NSString *)key queryIpType:(HttpdnsQueryIPType)queryType atTime:(int64_t)currentEpoch {
+    [_lock lock];
+    HttpdnsHostObject *object = _cacheDict[key];
+    BOOL contains = object
+        && ![object isIpEmptyUnderQueryIpType:queryType]
+        && ![object isExpiredUnderQueryIpType:queryType atTime:currentEpoch];
+    [_lock unlock];
+    return contains;
+}
+
 - (void)updateQualityForCacheKey:(NSString *)key forIp:(NSString *)ip withConnectedRT:(NSInteger)connectedRT {
     [_lock lock];
     HttpdnsHostObject *object = _cacheDict[key];
     if (object) {
         [object updateConnectedRT:connectedRT forIP:ip];
+        [self invalidateMemoizedResultsForCacheKey:key];
+    }
+    [_lock unlock];
+}
+
+- (void)recordQualitySampleForCacheKey:(NSString *)key forIp:(NSString *)ip withConnectedRT:(NSInteger)connectedRT {
+    [_lock lock];
+    HttpdnsHostObject *object = _cacheDict[key];
+    if (object) {
+        [object recordProbeSample:connectedRT forIP:ip];
+        [self invalidateMemoizedResultsForCacheKey:key];
+    }
+    [_lock unlock];
+}
+
+- (void)rerankIpsForCacheKey:(NSString *)key {
+    [_lock lock];
+    HttpdnsHostObject *object = _cacheDict[key];
+    if (object) {
+        [object rerankIps];
+        [self invalidateMemoizedResultsForCacheKey:key];
+    }
+    [_lock unlock];
+}
+
+- (NSInteger)copyFreshSockaddrsForCacheKey:(const char *)key
+                               queryIpType:(HttpdnsQueryIPType)queryType
+                                      port:(uint16_t)port
+                                    atTime:(int64_t)currentEpoch
+                                        to:(struct sockaddr_storage *)sockaddrs
+                                  maxCount:(NSUInteger)maxCount {
+    if (!key) {
+        return -1;
+    }
+
+    NSInteger count = -1;
+    [_lock lock];
+    HttpdnsHostObject *object = (__bridge HttpdnsHostObject *)CFDictionaryGetValue(_cStringKeyIndex, key);
+    if (HttpdnsIsHostObjectFresh(object, queryType, currentEpoch)) {
+        count = (NSInteger)[object copySockaddrsUnderQueryIpType:queryType port:port to:sockaddrs maxCount:maxCount];
+    }
+    [_lock unlock];
+    return count;
+}
+
+- (HttpdnsResult *)memoizedResultForCacheKey:(NSString *)key
+                                 queryIpType:(HttpdnsQueryIPType)queryType
+                                        host:(NSString *)host
+                                      atTime:(int64_t)currentEpoch
+                                     builder:(HttpdnsResult * _Nullable (^)(HttpdnsHostObject *object))builder {
+    if (!key || !host || !builder) {
+        return nil;
+    }
+
+    [_lock lock];
+    HttpdnsHostObject *object = _cacheDict[key];
+    if (!HttpdnsIsHostObjectFresh(object, queryType, currentEpoch)) {
+        [_lock unlock];
+        return nil;
+    }
+
+    // 缓存的结果只在内部持有，每次返回浅拷贝，调用方可以随意修改
+    HttpdnsResult *result = _memoizedResults[key][@(queryType)];
+    if (result && [result.host isEqualToString:host]) {
+        result = [result shallowCopy];
+        [_lock unlock];
+        return result;
     }
+
+    // 构造结果涉及排序和IP选择，在锁外基于快照进行，避免阻塞其他域名的读取
+    HttpdnsHostObject *snapshot = [object copy];
+    uint64_t generation = _memoizedGeneration;
     [_lock unlock];
+
+    result = builder(snapshot);
+    if (!result) {
+        return nil;
+    }
+    // 结果中的host是调用方请求的域名，sdns场景下可能与缓存对象中的不同
+    result.host = host;
+
+    [_lock lock];
+    // 构造期间缓存对象发生过变化时，结果仍可返回给本次调用，但不再保存
+    if (generation == _memoizedGeneration) {
+        NSMutableDictionary<NSNumber *, HttpdnsResult *> *results = _memoizedResults[key];
+        if (!results) {
+            results = [NSMutableDictionary dictionary];
+            _memoizedResults[key] = results;
+        }
+        results[@(queryType)] = result;
+    }
+    [_lock unlock];
+    return [result shallowCopy];
 }
 
 - (void)removeHostObjectByCacheKey:(NSString *)key {
     [_lock lock];
+    BOOL existed = _cacheDict[key] != nil;
     [_cacheDict removeObjectForKey:key];
+    [self indexHostObject:nil forCacheKey:key];
+    [self invalidateMemoizedResultsForCacheKey:key];
     [_lock unlock];
+    if (existed) {
+        HttpdnsMetricsIncrement(HttpdnsMetricCounterCacheEviction);
+    }
 }
 
 - (void)removeAllHostObjects {
     [_lock lock];
+    NSUInteger removedCount = _cacheDict.count;
     [_cacheDict removeAllObjects];
+    CFDictionaryRemoveAllValues(_cStringKeyIndex);
+    [_memoizedResults removeAllObjects];
+    _memoizedGeneration++;
     [_lock unlock];
+    HttpdnsMetricsAdd(HttpdnsMetricCounterCacheEviction, removedCount);
 }
 
 - (NSInteger)count {
@@ -0,0 +1,62 @@
+//
+//  HttpdnsHostTransitionPredictor.h
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * 从解析请求序列中学习域名之间的先后关系，用于预测接下来会被解析的域名
+ *
+ * 某域名被访问后，transitionWindow内访问的其他域名记为它的后继，每次出现只计一次；
+ * 域名出现次数与后继次数都按指数衰减累计，两者之比作为转移概率。
+ * 统计是有上限的稀疏矩阵：源域名数量和每个源域名的后继数量都有上限，超出时淘汰衰减后次数最低的一项
+ *
+ * 预测出的域名在predictionWindow内被访问计为命中，命中数与预测数计入HttpdnsMetrics
+ */
+@interface HttpdnsHostTransitionPredictor : NSObject
+
+// 统计的源域名数量
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+- (instancetype)initWithHalfLife:(NSTimeInterval)halfLife
+                  maxSourceCount:(NSUInteger)maxSourceCount
+               maxSuccessorCount:(NSUInteger)maxSuccessorCount
+                transitionWindow:(NSTimeInterval)transitionWindow
+                predictionWindow:(NSTimeInterval)predictionWindow;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+- (void)recordAccessForHost:(NSString *)host atTime:(NSTimeInterval)time;
+
+// 用于只有C字符串的快速路径，只更新已统计的域名和已有的后继关系
+- (void)recordAccessForHostHash:(uint64_t)hostHash atTime:(NSTimeInterval)time;
+
+/**
+ * 按转移概率从高到低返回host的后继，已预测且仍在predictionWindow内的域名不返回
+ * @param minProbability 最低转移概率
+ * @param minScore 后继衰减后的最低出现次数，避免偶然出现一次的域名被预测
+ */
+- (NSArray<NSString *> *)likelySuccessorsOfHost:(NSString *)host
+                                          limit:(NSUInteger)limit
+                                 minProbability:(double)minProbability
+                                       minScore:(double)minScore
+                                         atTime:(NSTimeInterval)time;
+
+/**
+ * 标记域名已被预解析，之后predictionWindow内的首次访问计为命中
+ * 已标记且仍在predictionWindow内的域名不重复标记，也不计入预测数
+ * @return 本次新标记的域名，调用方只需预解析这些域名
+ */
+- (NSArray<NSString *> *)markPredictedHosts:(NSArray<NSString *> *)hosts atTime:(NSTimeInterval)time;
+
+- (void)removeAllTransitions;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,394 @@
+//
+//  HttpdnsHostTransitionPredictor.m
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "HttpdnsHostTransitionPredictor.h"
+#import "HttpdnsMetrics.h"
+#import "HttpdnsResolveRecorder.h"
+#import <os/lock.h>
+
+// 用于学习后继关系的最近访问数，同时也是每次出现最多计入的后继数
+#define HTTPDNS_HOST_TRANSITION_RECENT_COUNT 8
+
+typedef struct {
+    uint64_t hostHash;
+    NSTimeInterval time;
+    // 本次出现已经计入过的后继，同一后继在窗口内重复出现只计一次
+    uint64_t creditedHashes[HTTPDNS_HOST_TRANSITION_RECENT_COUNT];
+    NSUInteger creditedCount;
+} HttpdnsHostTransitionRecentAccess;
+
+static inline double HttpdnsHostTransitionDecayedScore(double score, NSTimeInterval lastTime, NSTimeInterval time, NSTimeInterval halfLife) {
+    return score * exp2(-MAX(time - lastTime, 0) / halfLife);
+}
+
+static inline const void *HttpdnsHostTransitionKey(uint64_t hostHash) {
+    return (const void *)(uintptr_t)hostHash;
+}
+
+@interface HttpdnsHostTransitionEdge : NSObject
+
+@property (nonatomic, assign) uint64_t hostHash;
+@property (nonatomic, copy) NSString *hostName;
+@property (nonatomic, assign) double score;
+@property (nonatomic, assign) NSTimeInterval lastTime;
+
+@end
+
+@implementation HttpdnsHostTransitionEdge
+@end
+
+@interface HttpdnsHostTransitionNode : NSObject
+
+@property (nonatomic, copy) NSString *hostName;
+// 作为源域名出现的次数
+@property (nonatomic, assign) double score;
+@property (nonatomic, assign) NSTimeInterval lastTime;
+@property (nonatomic, strong) NSMutableArray<HttpdnsHostTransitionEdge *> *successors;
+
+@end
+
+@implementation HttpdnsHostTransitionNode
+@end
+
+@implementation HttpdnsHostTransitionPredictor {
+    os_unfair_lock _lock;
+    NSTimeInterval _halfLife;
+    NSUInteger _maxSourceCount;
+    NSUInteger _maxSuccessorCount;
+    NSTimeInterval _transitionWindow;
+    NSTimeInterval _predictionWindow;
+    // 键为域名哈希，值为HttpdnsHostTransitionNode
+    CFMutableDictionaryRef _nodes;
+    HttpdnsHostTransitionRecentAccess _recentAccesses[HTTPDNS_HOST_TRANSITION_RECENT_COUNT];
+    NSUInteger _recentAccessCount;
+    // 已预测、尚未被访问的域名哈希到预测时刻
+    NSMutableDictionary<NSNumber *, NSNumber *> *_pendingPredictions;
+    // 上次清理过期预测的时刻，每个predictionWindow最多清理一次
+    NSTimeInterval _lastPendingSweepTime;
+}
+
+- (instancetype)initWithHalfLife:(NSTimeInterval)halfLife
+                  maxSourceCount:(NSUInteger)maxSourceCount
+               maxSuccessorCount:(NSUInteger)maxSuccessorCount
+                transitionWindow:(NSTimeInterval)transitionWindow
+                predictionWindow:(NSTimeInterval)predictionWindow {
+    if (self = [super init]) {
+        _lock = OS_UNFAIR_LOCK_INIT;
+        _halfLife = halfLife > 0 ? halfLife : 1;
+        _maxSourceCount = MAX(maxSourceCount, 1);
+        _maxSuccessorCount = MAX(maxSuccessorCount, 1);
+        _transitionWindow = transitionWindow;
+        _predictionWindow = predictionWindow;
+        _nodes = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+        _pendingPredictions = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    CFRelease(_nodes);
+}
+
+- (NSUInteger)count {
+    os_unfair_lock_lock(&_lock);
+    NSUInteger count = (NSUInteger)CFDictionaryGetCount(_nodes);
+    os_unfair_lock_unlock(&_lock);
+    return count;
+}
+
+- (void)recordAccessForHost:(NSString *)host atTime:(NSTimeInterval)time {
+    if (host.length == 0) {
+        return;
+    }
+    [self recordAccessForHostHash:HttpdnsResolveRecordHostHash(host.UTF8String) hostName:host atTime:time];
+}
+
+- (void)recordAccessForHostHash:(uint64_t)hostHash atTime:(NSTimeInterval)time {
+    [self recordAccessForHostHash:hostHash hostName:nil atTime:time];
+}
+
+// hostName为nil时只更新已有的统计
+- (void)recordAccessForHostHash:(uint64_t)hostHash hostName:(NSString *)hostName atTime:(NSTimeInterval)time {
+    BOOL predictionHit = NO;
+
+    os_unfair_lock_lock(&_lock);
+    if (_pendingPredictions.count > 0) {
+        NSNumber *key = @(hostHash);
+        NSNumber *predictedAt = _pendingPredictions[key];
+        if (predictedAt) {
+            [_pendingPredictions removeObjectForKey:key];
+            predictionHit = time - predictedAt.doubleValue <= _predictionWindow;
+        }
+    }
+
+    [self creditSuccessorHash:hostHash hostName:hostName atTime:time];
+
+    HttpdnsHostTransitionNode *node = (__bridge HttpdnsHostTransitionNode *)CFDictionaryGetValue(_nodes, HttpdnsHostTransitionKey(hostHash));
+    if (node && (!hostName || [node.hostName isEqualToString:hostName])) {
+        node.score = HttpdnsHostTransitionDecayedScore(node.score, node.lastTime, time, _halfLife) + 1;
+        node.lastTime = MAX(node.lastTime, time);
+    } else if (hostName) {
+        // 哈希冲突时新域名覆盖旧域名
+        if (!node && (NSUInteger)CFDictionaryGetCount(_nodes) >= _maxSourceCount) {
+            [self evictColdestNodeAtTime:time];
+        }
+        node = [HttpdnsHostTransitionNode new];
+        node.hostName = hostName;
+        node.score = 1;
+        node.lastTime = time;
+        node.successors = [NSMutableArray array];
+        CFDictionarySetValue(_nodes, HttpdnsHostTransitionKey(hostHash), (__bridge const void *)node);
+    } else {
+        node = nil;
+    }
+
+    if (node) {
+        [self pushRecentAccessForHostHash:hostHash atTime:time];
+    }
+    os_unfair_lock_unlock(&_lock);
+
+    if (predictionHit) {
+        HttpdnsMetricsIncrement(HttpdnsMetricCounterPredictedHit);
+    }
+}
+
+// 调用方持有锁，把本次访问计为窗口内最近访问过的域名的后继
+- (void)creditSuccessorHash:(uint64_t)hostHash hostName:(NSString *)hostName atTime:(NSTimeInterval)time {
+    for (NSUInteger i = 0; i < _recentAccessCount; i++) {
+        HttpdnsHostTransitionRecentAccess *access = &_recentAccesses[i];
+        if (access->hostHash == hostHash || time < access->time || time - access->time > _transitionWindow) {
+            continue;
+        }
+        if (access->creditedCount >= HTTPDNS_HOST_TRANSITION_RECENT_COUNT) {
+            continue;
+        }
+        BOOL credited = NO;
+        for (NSUInteger j = 0; j < access->creditedCount; j++) {
+            if (access->creditedHashes[j] == hostHash) {
+                credited = YES;
+                break;
+            }
+        }
+        if (credited) {
+            continue;
+        }
+
+        HttpdnsHostTransitionNode *source = (__bridge HttpdnsHostTransitionNode *)CFDictionaryGetValue(_nodes, HttpdnsHostTransitionKey(access->hostHash));
+        if (!source) {
+            continue;
+        }
+        HttpdnsHostTransitionEdge *edge = nil;
+        for (HttpdnsHostTransitionEdge *successor in source.successors) {
+            if (successor.hostHash == hostHash) {
+                edge = successor;
+                break;
+            }
+        }
+        if (edge && (!hostName || [edge.hostName isEqualToString:hostName])) {
+            edge.score = HttpdnsHostTransitionDecayedScore(edge.score, edge.lastTime, time, _halfLife) + 1;
+            edge.lastTime = MAX(edge.lastTime, time);
+        } else if (hostName) {
+            if (!edge) {
+                if (source.successors.count >= _maxSuccessorCount) {
+                    [self evictColdestSuccessorOfNode:source atTime:time];
+                }
+                edge = [HttpdnsHostTransitionEdge new];
+                edge.hostHash = hostHash;
+                [source.successors addObject:edge];
+            }
+            edge.hostName = hostName;
+            edge.score = 1;
+            edge.lastTime = time;
+        } else {
+            continue;
+        }
+        access->creditedHashes[access->creditedCount++] = hostHash;
+    }
+}
+
+// 调用方持有锁，同一域名只保留最近一次出现，否则替换最早的一项
+- (void)pushRecentAccessForHostHash:(uint64_t)hostHash atTime:(NSTimeInterval)time {
+    NSUInteger index = _recentAccessCount;
+    for (NSUInteger i = 0; i < _recentAccessCount; i++) {
+        if (_recentAccesses[i].hostHash == hostHash) {
+            index = i;
+            break;
+        }
+    }
+    if (index == HTTPDNS_HOST_TRANSITION_RECENT_COUNT) {
+        index = 0;
+        for (NSUInteger i = 1; i < _recentAccessCount; i++) {
+            if (_recentAccesses[i].time < _recentAccesses[index].time) {
+                index = i;
+            }
+        }
+    } else if (index == _recentAccessCount) {
+        _recentAccessCount++;
+    }
+    _recentAccesses[index].hostHash = hostHash;
+    _recentAccesses[index].time = time;
+    _recentAccesses[index].creditedCount = 0;
+}
+
+// 调用方持有锁
+- (void)evictColdestNodeAtTime:(NSTimeInterval)time {
+    CFIndex count = CFDictionaryGetCount(_nodes);
+    if (count == 0) {
+        return;
+    }
+    const void **keys = malloc(sizeof(void *) * count);
+    const void **values = malloc(sizeof(void *) * count);
+    CFDictionaryGetKeysAndValues(_nodes, keys, values);
+
+    CFIndex coldestIndex = 0;
+    double coldestScore = DBL_MAX;
+    for (CFIndex i = 0; i < count; i++) {
+        HttpdnsHostTransitionNode *node = (__bridge HttpdnsHostTransitionNode *)values[i];
+        double score = HttpdnsHostTransitionDecayedScore(node.score, node.lastTime, time, _halfLife);
+        if (score < coldestScore) {
+            coldestScore = score;
+            coldestIndex = i;
+        }
+    }
+    CFDictionaryRemoveValue(_nodes, keys[coldestIndex]);
+    free(keys);
+    free(values);
+}
+
+// 调用方持有锁
+- (void)evictColdestSuccessorOfNode:(HttpdnsHostTransitionNode *)node atTime:(NSTimeInterval)time {
+    NSUInteger coldestIndex = NSNotFound;
+    double coldestScore = DBL_MAX;
+    for (NSUInteger i = 0; i < node.successors.count; i++) {
+        HttpdnsHostTransitionEdge *edge = node.successors[i];
+        double score = HttpdnsHostTransitionDecayedScore(edge.score, edge.lastTime, time, _halfLife);
+        if (score < coldestScore) {
+            coldestScore = score;
+            coldestIndex = i;
+        }
+    }
+    if (coldestIndex != NSNotFound) {
+        [node.successors removeObjectAtIndex:coldestIndex];
+    }
+}
+
+- (NSArray<NSString *> *)likelySuccessorsOfHost:(NSString *)host
+                                          limit:(NSUInteger)limit
+                                 minProbability:(double)minProbability
+                                       minScore:(double)minScore
+                                         atTime:(NSTimeInterval)time {
+    if (host.length == 0 || limit == 0) {
+        return @[];
+    }
+    uint64_t hostHash = HttpdnsResolveRecordHostHash(host.UTF8String);
+
+    NSMutableArray<NSString *> *hosts = nil;
+    NSMutableArray<NSNumber *> *probabilities = nil;
+    os_unfair_lock_lock(&_lock);
+    HttpdnsHostTransitionNode *node = (__bridge HttpdnsHostTransitionNode *)CFDictionaryGetValue(_nodes, HttpdnsHostTransitionKey(hostHash));
+    if (node && node.successors.count > 0 && [node.hostName isEqualToString:host]) {
+        double sourceScore = HttpdnsHostTransitionDecayedScore(node.score, node.lastTime, time, _halfLife);
+        for (HttpdnsHostTransitionEdge *edge in node.successors) {
+            double score = HttpdnsHostTransitionDecayedScore(edge.score, edge.lastTime, time, _halfLife);
+            double probability = sourceScore > 0 ? MIN(score / sourceScore, 1) : 0;
+            if (score < minScore || probability < minProbability) {
+                continue;
+            }
+            NSNumber *predictedAt = _pendingPredictions.count > 0 ? _pendingPredictions[@(edge.hostHash)] : nil;
+            if (predictedAt && time - predictedAt.doubleValue <= _predictionWindow) {
+                continue;
+            }
+            if (!hosts) {
+                hosts = [NSMutableArray array];
+                probabilities = [NSMutableArray array];
+            }
+            [hosts addObject:edge.hostName];
+            [probabilities addObject:@(probability)];
+        }
+    }
+    os_unfair_lock_unlock(&_lock);
+
+    if (!hosts) {
+        return @[];
+    }
+
+    NSMutableArray<NSNumber *> *order = [NSMutableArray arrayWithCapacity:hosts.count];
+    for (NSUInteger i = 0; i < hosts.count; i++) {
+        [order addObject:@(i)];
+    }
+    [order sortUsingComparator:^NSComparisonResult(NSNumber *lhs, NSNumber *rhs) {
+        double lhsProbability = probabilities[lhs.unsignedIntegerValue].doubleValue;
+        double rhsProbability = probabilities[rhs.unsignedIntegerValue].doubleValue;
+        if (lhsProbability != rhsProbability) {
+            return lhsProbability > rhsProbability ? NSOrderedAscending : NSOrderedDescending;
+        }
+        return [hosts[lhs.unsignedIntegerValue] compare:hosts[rhs.unsignedIntegerValue]];
+    }];
+
+    NSUInteger count = MIN(limit, order.count);
+    NSMutableArray<NSString *> *result = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [result addObject:hosts[order[i].unsignedIntegerValue]];
+    }
+    return result;
+}
+
+- (NSArray<NSString *> *)markPredictedHosts:(NSArray<NSString *> *)hosts atTime:(NSTimeInterval)time {
+    if (hosts.count == 0) {
+        return @[];
+    }
+
+    NSMutableArray<NSString *> *markedHosts = [NSMutableArray arrayWithCapacity:hosts.count];
+    os_unfair_lock_lock(&_lock);
+    // 超过预测窗口仍未被访问的预测不再计入命中，不必每次都遍历
+    if (_pendingPredictions.count > 0 && time - _lastPendingSweepTime > _predictionWindow) {
+        [self sweepExpiredPredictionsAtTime:time];
+    }
+    for (NSString *host in hosts) {
+        NSNumber *key = @(HttpdnsResolveRecordHostHash(host.UTF8String));
+        NSNumber *predictedAt = _pendingPredictions[key];
+        if (predictedAt && time - predictedAt.doubleValue <= _predictionWindow) {
+            continue;
+        }
+        _pendingPredictions[key] = @(time);
+        [markedHosts addObject:host];
+    }
+    os_unfair_lock_unlock(&_lock);
+
+    if (markedHosts.count > 0) {
+        HttpdnsMetricsAdd(HttpdnsMetricCounterPredictedPrefetch, markedHosts.count);
+    }
+    return markedHosts;
+}
+
+// 调用方持有锁
+- (void)sweepExpiredPredictionsAtTime:(NSTimeInterval)time {
+    _lastPendingSweepTime = time;
+    NSMutableArray<NSNumber *> *expiredKeys = nil;
+    for (NSNumber *key in _pendingPredictions) {
+        if (time - _pendingPredictions[key].doubleValue > _predictionWindow) {
+            if (!expiredKeys) {
+                expiredKeys = [NSMutableArray array];
+            }
+            [expiredKeys addObject:key];
+        }
+    }
+    if (expiredKeys) {
+        [_pendingPredictions removeObjectsForKeys:expiredKeys];
+    }
+}
+
+- (void)removeAllTransitions {
+    os_unfair_lock_lock(&_lock);
+    CFDictionaryRemoveAllValues(_nodes);
+    _recentAccessCount = 0;
+    [_pendingPredictions removeAllObjects];
+    os_unfair_lock_unlock(&_lock);
+}
+
+@end
@@ -26,16 +26,28 @@ typedef void(^HttpdnsIPQualityCallback)(NSString *cacheKey, NSString *ip, NSInte
 + (instancetype)sharedInstance;
 
 /**
- * 获取当前等待队列中的任务数量
+ * 获取当前等待队列中尚未开始的检测数量
  */
 - (NSUInteger)pendingTasksCount;
 
+/**
+ * 因复用有效期内的结果或合并到在途探测而省去的探测次数
+ */
+- (NSUInteger)savedProbeCount;
+
+/**
+ * 清空探测结果表，网络切换后调用，之后的检测都会重新探测
+ */
+- (void)removeAllProbeResults;
+
 /**
  * 调度一个IP连接质量检测任务，不会阻塞当前线程
+ * 同一网络下同一(ip, port)的检测会被合并：有效期内直接复用上次结果（失败结果的有效期较短），探测进行中则等待其结果，
+ * 一次测量结果会回调给所有发起检测的缓存键
  * @param cacheKey 缓存键，通常是域名
  * @param ip 要检测的IP地址
  * @param port 连接端口，如果为nil则默认使用80
- * @param callback 检测完成后的回调
+ * @param callback 检测完成后的回调，每次调度都恰好回调一次，参数无效时以-1回调
  */
 - (void)scheduleIPQualityDetection:(NSString *)cacheKey
                                 ip:(NSString *)ip
@@ -58,38 +70,24 @@ typedef void(^HttpdnsIPQualityCallback)(NSString *cacheKey, NSString *ip, NSInte
                 callback:(HttpdnsIPQualityCallback)callback;
 
 /**
- * 建立TCP连接并测量连接时间
- * @param ip 要连接的IP地址
- * @param port 连接端口
- * @return 连接耗时（毫秒），-1表示连接失败
+ * 执行IP连接质量检测，探测真正发起连接时回调started
+ * @param started 探测离开等待队列、发起连接时的回调，在探测器事件循环线程上执行
  * @note 此方法主要用于测试
  */
-- (NSInteger)tcpConnectToIP:(NSString *)ip port:(int)port;
+- (void)executeDetection:(NSString *)cacheKey
+                      ip:(NSString *)ip
+                    port:(nullable NSNumber *)port
+                 started:(nullable dispatch_block_t)started
+                callback:(HttpdnsIPQualityCallback)callback;
 
 /**
- * 添加待处理任务
- * @param cacheKey 缓存键，通常是域名
- * @param ip 要检测的IP地址
+ * 建立TCP连接并测量连接时间，同步等待探测结果
+ * @param ip 要连接的IP地址
  * @param port 连接端口
- * @param callback 检测完成后的回调
- * @note 此方法主要用于测试
- */
-- (void)addPendingTask:(NSString *)cacheKey
-                    ip:(NSString *)ip
-                  port:(nullable NSNumber *)port
-              callback:(HttpdnsIPQualityCallback)callback;
-
-/**
- * 处理待处理任务队列
- * @note 此方法主要用于测试
- */
-- (void)processPendingTasksIfNeeded;
-
-/**
- * 处理所有待处理任务
- * @note 此方法主要用于测试
+ * @return 连接耗时（毫秒），-1表示连接失败
+ * @note 此方法主要用于测试，会阻塞当前线程
  */
-- (void)processPendingTasks;
+- (NSInteger)tcpConnectToIP:(NSString *)ip port:(int)port;
 
 @end
 
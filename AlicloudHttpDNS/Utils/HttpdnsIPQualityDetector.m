@@ -7,40 +7,71 @@
 //
 
 #import "HttpdnsIPQualityDetector.h"
-#import <sys/socket.h>
-#import <netinet/in.h>
-#import <arpa/inet.h>
-#import <netdb.h>
-#import <unistd.h>
-#import <sys/time.h>
-#import <fcntl.h>
-#import <errno.h>
 #import "HttpdnsLog_Internal.h"
-#import "HttpdnsUtil.h"
+#import "HttpdnsReachability.h"
+#import "HttpdnsTCPProber.h"
+#import "HttpdnsMetrics.h"
 
-// 定义任务类，替代之前的结构体，确保正确的内存管理
-@interface HttpdnsDetectionTask : NSObject
+// 同时进行中的探测数量上限，所有探测共用一个事件循环线程，上限主要用于限制占用的socket数量
+static const NSUInteger kHttpdnsIPQualityMaxConcurrentProbes = 128;
+
+// 更长的超时时间不是很有必要，因为建连超过2秒的IP，已经没有优选必要了
+static const NSTimeInterval kHttpdnsIPQualityProbeTimeout = 2.0;
+
+// 探测结果的有效期，有效期内同一(ip, port, 网络)的检测直接复用结果
+static const NSTimeInterval kHttpdnsIPQualityResultFreshness = 300;
+
+// 失败结果的有效期，失败多为瞬时的，不应在整个有效期内把IP排在末尾
+static const NSTimeInterval kHttpdnsIPQualityFailureFreshness = 30;
+
+// 发起连接后超过该时长（探测超时时间加上余量）仍未完成的在途探测视为丢失，允许重新发起
+// 在探测器等待队列中的时间不计入
+static const NSTimeInterval kHttpdnsIPQualityInflightExpiration = 5.0;
+
+// 结果表超过该数量时清理过期条目
+static const NSUInteger kHttpdnsIPQualityResultPruneThreshold = 512;
+
+@interface HttpdnsProbeResult : NSObject
+@property (nonatomic, assign) NSInteger costTime;
+@property (nonatomic, assign) NSTimeInterval measuredAt;
+@end
+
+@implementation HttpdnsProbeResult
+
+- (BOOL)isFreshAt:(NSTimeInterval)now {
+    NSTimeInterval freshness = _costTime < 0 ? kHttpdnsIPQualityFailureFreshness : kHttpdnsIPQualityResultFreshness;
+    return now - _measuredAt < freshness;
+}
+
+@end
+
+// 等待同一个探测结果的检测请求
+@interface HttpdnsProbeWaiter : NSObject
 @property (nonatomic, copy) NSString *cacheKey;
-@property (nonatomic, copy) NSString *ip;
-@property (nonatomic, strong) NSNumber *port;
 @property (nonatomic, copy) HttpdnsIPQualityCallback callback;
 @end
 
-@implementation HttpdnsDetectionTask
+@implementation HttpdnsProbeWaiter
+@end
+
+@interface HttpdnsInflightProbe : NSObject
+// 探测真正发起连接的时间，仍在探测器等待队列中时为0
+@property (nonatomic, assign) NSTimeInterval startedAt;
+@property (nonatomic, strong) NSMutableArray<HttpdnsProbeWaiter *> *waiters;
+@end
+
+@implementation HttpdnsInflightProbe
 @end
 
 @interface HttpdnsIPQualityDetector ()
 
-@property (nonatomic, strong) dispatch_queue_t detectQueue;
-@property (nonatomic, strong) dispatch_semaphore_t concurrencySemaphore;
-@property (nonatomic, strong) NSMutableArray<HttpdnsDetectionTask *> *pendingTasks;
-@property (nonatomic, strong) NSLock *pendingTasksLock;
-@property (nonatomic, assign) BOOL isProcessingPendingTasks;
+@property (nonatomic, strong) HttpdnsTCPProber *prober;
 
-/**
- * 最大并发检测数量，默认为10
- */
-@property (nonatomic, assign) NSUInteger maxConcurrentDetections;
+// 以下属性由stateLock保护，key为"ip|port|网络类型"
+@property (nonatomic, strong) NSLock *stateLock;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, HttpdnsProbeResult *> *probeResults;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, HttpdnsInflightProbe *> *inflightProbes;
+@property (nonatomic, assign) NSUInteger savedProbeCount;
 
 @end
 
@@ -58,12 +89,10 @@
 - (instancetype)init {
     self = [super init];
     if (self) {
-        _detectQueue = dispatch_queue_create("com.aliyun.httpdns.ipqualitydetector", DISPATCH_QUEUE_CONCURRENT);
-        _maxConcurrentDetections = 10;
-        _concurrencySemaphore = dispatch_semaphore_create(_maxConcurrentDetections);
-        _pendingTasks = [NSMutableArray array];
-        _pendingTasksLock = [[NSLock alloc] init];
-        _isProcessingPendingTasks = NO;
+        _prober = [[HttpdnsTCPProber alloc] initWithMaxConcurrentProbes:kHttpdnsIPQualityMaxConcurrentProbes];
+        _stateLock = [[NSLock alloc] init];
+        _probeResults = [NSMutableDictionary dictionary];
+        _inflightProbes = [NSMutableDictionary dictionary];
     }
     return self;
 }
@@ -72,220 +101,152 @@
                                 ip:(NSString *)ip
                               port:(NSNumber *)port
                           callback:(HttpdnsIPQualityCallback)callback {
-    if (!cacheKey || !ip || !callback) {
-        HttpdnsLogDebug("IPQualityDetector invalid parameters for detection: cacheKey=%@, ip=%@", cacheKey, ip);
+    if (!callback) {
         return;
     }
 
-    // 尝试获取信号量，如果获取不到，说明已达到最大并发数
-    if (dispatch_semaphore_wait(_concurrencySemaphore, DISPATCH_TIME_NOW) != 0) {
-        // 将任务加入等待队列
-        [self addPendingTask:cacheKey ip:ip port:port callback:callback];
+    if (!cacheKey || !ip) {
+        // 调用方可能在等待每个检测的回调，参数无效时也要以失败回调
+        HttpdnsLogDebug("IPQualityDetector invalid parameters for detection: cacheKey=%@, ip=%@", cacheKey, ip);
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            callback(cacheKey, ip, -1);
+        });
         return;
     }
 
-    // 获取到信号量，可以执行检测
-    [self executeDetection:cacheKey ip:ip port:port callback:callback];
-}
+    int portValue = port ? [port intValue] : 80;
+    NSString *probeKey = [NSString stringWithFormat:@"%@|%d|%@", ip, portValue,
+                          [[HttpdnsReachability sharedInstance] currentReachabilityString]];
+    NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
 
-- (void)addPendingTask:(NSString *)cacheKey ip:(NSString *)ip port:(NSNumber *)port callback:(HttpdnsIPQualityCallback)callback {
-    // 创建任务对象，ARC会自动管理内存
-    HttpdnsDetectionTask *task = [[HttpdnsDetectionTask alloc] init];
-    task.cacheKey = cacheKey;
-    task.ip = ip;
-    task.port = port;
-    task.callback = callback;
-
-    // 加锁添加任务
-    [_pendingTasksLock lock];
-    [_pendingTasks addObject:task];
-    [_pendingTasksLock unlock];
-
-    // 如果没有正在处理等待队列，则开始处理
-    [self processPendingTasksIfNeeded];
-}
+    HttpdnsProbeWaiter *waiter = [[HttpdnsProbeWaiter alloc] init];
+    waiter.cacheKey = cacheKey;
+    waiter.callback = callback;
 
-- (NSUInteger)pendingTasksCount {
-    [_pendingTasksLock lock];
-    NSUInteger count = _pendingTasks.count;
-    [_pendingTasksLock unlock];
-    return count;
-}
+    [_stateLock lock];
+    // 有效期内的结果直接复用
+    HttpdnsProbeResult *result = _probeResults[probeKey];
+    if (result && [result isFreshAt:now]) {
+        _savedProbeCount++;
+        [_stateLock unlock];
 
-- (void)processPendingTasksIfNeeded {
-    [_pendingTasksLock lock];
-    BOOL shouldProcess = !_isProcessingPendingTasks && _pendingTasks.count > 0;
-    if (shouldProcess) {
-        _isProcessingPendingTasks = YES;
-    }
-    [_pendingTasksLock unlock];
-
-    if (shouldProcess) {
+        NSInteger costTime = result.costTime;
         dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
-            [self processPendingTasks];
+            callback(cacheKey, ip, costTime);
         });
+        return;
     }
-}
 
-- (void)processPendingTasks {
-    while (1) {
-        // 尝试获取信号量
-        if (dispatch_semaphore_wait(_concurrencySemaphore, DISPATCH_TIME_NOW) != 0) {
-            // 无法获取信号量，等待一段时间后重试
-            [NSThread sleepForTimeInterval:0.1];
-            continue;
-        }
+    // 同一IP已有探测在排队或进行中，等待其结果；探测器保证每个探测都会回调，排队中的不会过期
+    HttpdnsInflightProbe *inflight = _inflightProbes[probeKey];
+    if (inflight && (inflight.startedAt == 0 || now - inflight.startedAt < kHttpdnsIPQualityInflightExpiration)) {
+        [inflight.waiters addObject:waiter];
+        _savedProbeCount++;
+        [_stateLock unlock];
+        return;
+    }
 
-        // 获取到信号量，取出一个等待任务
-        HttpdnsDetectionTask *task = nil;
+    inflight = [[HttpdnsInflightProbe alloc] init];
+    inflight.waiters = [NSMutableArray arrayWithObject:waiter];
+    _inflightProbes[probeKey] = inflight;
+    [_stateLock unlock];
+
+    // 达到并发上限时由探测器排队，这里不会阻塞
+    [self executeDetection:cacheKey ip:ip port:@(portValue) started:^{
+        [self->_stateLock lock];
+        inflight.startedAt = [[NSDate date] timeIntervalSince1970];
+        [self->_stateLock unlock];
+    } callback:^(NSString *cacheKey, NSString *ip, NSInteger costTime) {
+        [self completeProbe:probeKey inflight:inflight ip:ip costTime:costTime];
+    }];
+}
 
-        [_pendingTasksLock lock];
-        if (_pendingTasks.count > 0) {
-            task = _pendingTasks.firstObject;
-            [_pendingTasks removeObjectAtIndex:0];
-        } else {
-            // 没有等待任务了，结束处理
-            _isProcessingPendingTasks = NO;
-            [_pendingTasksLock unlock];
-            // 释放多余的信号量
-            dispatch_semaphore_signal(_concurrencySemaphore);
-            break;
-        }
-        [_pendingTasksLock unlock];
+- (void)completeProbe:(NSString *)probeKey inflight:(HttpdnsInflightProbe *)inflight ip:(NSString *)ip costTime:(NSInteger)costTime {
+    HttpdnsProbeResult *result = [[HttpdnsProbeResult alloc] init];
+    result.costTime = costTime;
+    result.measuredAt = [[NSDate date] timeIntervalSince1970];
 
-        // 执行任务
-        [self executeDetection:task.cacheKey ip:task.ip port:task.port callback:task.callback];
+    [_stateLock lock];
+    _probeResults[probeKey] = result;
+    if (_inflightProbes[probeKey] == inflight) {
+        [_inflightProbes removeObjectForKey:probeKey];
+    }
+    NSArray<HttpdnsProbeWaiter *> *waiters = [inflight.waiters copy];
+    [inflight.waiters removeAllObjects];
+    [self pruneExpiredProbeResultsIfNeeded:result.measuredAt];
+    [_stateLock unlock];
+
+    // 一次测量结果分发给所有包含该IP的缓存键
+    for (HttpdnsProbeWaiter *waiter in waiters) {
+        waiter.callback(waiter.cacheKey, ip, costTime);
     }
 }
 
-- (void)executeDetection:(NSString *)cacheKey ip:(NSString *)ip port:(NSNumber *)port callback:(HttpdnsIPQualityCallback)callback {
-    // 创建强引用以确保在异步操作期间对象不会被释放
-    HttpdnsIPQualityCallback strongCallback = [callback copy];
+- (void)pruneExpiredProbeResultsIfNeeded:(NSTimeInterval)now {
+    if (_probeResults.count <= kHttpdnsIPQualityResultPruneThreshold) {
+        return;
+    }
 
-    // 使用后台队列进行检测，避免阻塞主线程
-    dispatch_async(self.detectQueue, ^{
-        NSInteger costTime = [self tcpConnectToIP:ip port:port ? [port intValue] : 80];
+    NSMutableArray<NSString *> *expiredKeys = [NSMutableArray array];
+    [_probeResults enumerateKeysAndObjectsUsingBlock:^(NSString *key, HttpdnsProbeResult *result, BOOL *stop) {
+        if (![result isFreshAt:now]) {
+            [expiredKeys addObject:key];
+        }
+    }];
+    [_probeResults removeObjectsForKeys:expiredKeys];
+}
 
-        // 在后台线程回调结果
-        dispatch_async(dispatch_get_global_queue(0, 0), ^{
-            strongCallback(cacheKey, ip, costTime);
+- (NSUInteger)pendingTasksCount {
+    return [_prober waitingProbeCount];
+}
 
-            // 释放信号量，允许执行下一个任务
-            dispatch_semaphore_signal(self->_concurrencySemaphore);
+- (NSUInteger)savedProbeCount {
+    [_stateLock lock];
+    NSUInteger count = _savedProbeCount;
+    [_stateLock unlock];
+    return count;
+}
 
-            // 检查是否有等待的任务需要处理
-            [self processPendingTasksIfNeeded];
-        });
-    });
+- (void)removeAllProbeResults {
+    [_stateLock lock];
+    [_probeResults removeAllObjects];
+    [_stateLock unlock];
 }
 
-- (NSInteger)tcpConnectToIP:(NSString *)ip port:(int)port {
-    if (!ip || port <= 0) {
-        return -1;
-    }
-    int socketFd;
-    struct sockaddr_in serverAddr;
-    struct sockaddr_in6 serverAddr6;
-    void *serverAddrPtr;
-    socklen_t serverAddrLen;
-    BOOL isIPv6 = [HttpdnsUtil isIPv6Address:ip];
-    BOOL isIpv4 = [HttpdnsUtil isIPv4Address:ip];
-
-    // 创建socket
-    if (isIPv6) {
-        socketFd = socket(AF_INET6, SOCK_STREAM, 0);
-        if (socketFd < 0) {
-            HttpdnsLogDebug("IPQualityDetector failed to create IPv6 socket: %s", strerror(errno));
-            return -1;
-        }
+- (void)executeDetection:(NSString *)cacheKey ip:(NSString *)ip port:(NSNumber *)port callback:(HttpdnsIPQualityCallback)callback {
+    [self executeDetection:cacheKey ip:ip port:port started:nil callback:callback];
+}
 
-        memset(&serverAddr6, 0, sizeof(serverAddr6));
-        serverAddr6.sin6_family = AF_INET6;
-        serverAddr6.sin6_port = htons(port);
-        inet_pton(AF_INET6, [ip UTF8String], &serverAddr6.sin6_addr);
-
-        serverAddrPtr = &serverAddr6;
-        serverAddrLen = sizeof(serverAddr6);
-    } else if (isIpv4) {
-        socketFd = socket(AF_INET, SOCK_STREAM, 0);
-        if (socketFd < 0) {
-            HttpdnsLogDebug("IPQualityDetector failed to create IPv4 socket: %s", strerror(errno));
-            return -1;
+- (void)executeDetection:(NSString *)cacheKey ip:(NSString *)ip port:(NSNumber *)port started:(dispatch_block_t)started callback:(HttpdnsIPQualityCallback)callback {
+    HttpdnsIPQualityCallback strongCallback = [callback copy];
+    [_prober probeIP:ip
+                port:port ? [port intValue] : 80
+             timeout:kHttpdnsIPQualityProbeTimeout
+             started:started
+          completion:^(NSInteger costTime) {
+        HttpdnsMetricsIncrement(HttpdnsMetricCounterProbe);
+        if (costTime < 0) {
+            HttpdnsMetricsIncrement(HttpdnsMetricCounterProbeFailure);
+        } else {
+            HttpdnsMetricsRecordLatency(HttpdnsMetricHistogramProbe, (uint64_t)costTime * 1000);
         }
+        strongCallback(cacheKey, ip, costTime);
+    }];
+}
 
-        memset(&serverAddr, 0, sizeof(serverAddr));
-        serverAddr.sin_family = AF_INET;
-        serverAddr.sin_port = htons(port);
-        inet_pton(AF_INET, [ip UTF8String], &serverAddr.sin_addr);
-
-        serverAddrPtr = &serverAddr;
-        serverAddrLen = sizeof(serverAddr);
-    } else {
+- (NSInteger)tcpConnectToIP:(NSString *)ip port:(int)port {
+    if (!ip || port <= 0) {
         return -1;
     }
 
-    // 设置非阻塞模式
-    int flags = fcntl(socketFd, F_GETFL, 0);
-    fcntl(socketFd, F_SETFL, flags | O_NONBLOCK);
-
-    // 开始计时
-    struct timeval startTime, endTime;
-    gettimeofday(&startTime, NULL);
-
-    // 尝试连接
-    int connectResult = connect(socketFd, serverAddrPtr, serverAddrLen);
-
-    if (connectResult < 0) {
-        if (errno == EINPROGRESS) {
-            // 连接正在进行中，使用select等待
-            fd_set fdSet;
-            struct timeval timeout;
-
-            FD_ZERO(&fdSet);
-            FD_SET(socketFd, &fdSet);
-
-            // 设置超时时间为2秒
-            // 更长的超时时间不是很有必要，因为建连超过2秒的IP，已经没有优选必要了
-            timeout.tv_sec = 2;
-            timeout.tv_usec = 0;
-
-            int selectResult = select(socketFd + 1, NULL, &fdSet, NULL, &timeout);
-
-            if (selectResult <= 0) {
-                // 超时或错误
-                HttpdnsLogDebug("IPQualityDetector connection to %@ timed out or error: %s", ip, strerror(errno));
-                close(socketFd);
-                return -1;
-            } else {
-                // 检查连接是否成功
-                int error;
-                socklen_t errorLen = sizeof(error);
-                if (getsockopt(socketFd, SOL_SOCKET, SO_ERROR, &error, &errorLen) < 0 || error != 0) {
-                    HttpdnsLogDebug("IPQualityDetector connection to %@ failed after select: %s", ip, strerror(error));
-                    close(socketFd);
-                    return -1;
-                }
-            }
-        } else {
-            // 其他错误
-            HttpdnsLogDebug("IPQualityDetector connection to %@ failed: %s", ip, strerror(errno));
-            close(socketFd);
-            return -1;
-        }
-    }
-
-    // 结束计时
-    gettimeofday(&endTime, NULL);
-
-    // 关闭socket
-    close(socketFd);
-
-    // 计算耗时（毫秒）
-    long seconds = endTime.tv_sec - startTime.tv_sec;
-    long microseconds = endTime.tv_usec - startTime.tv_usec;
-    NSInteger costTime = (seconds * 1000) + (microseconds / 1000);
-
-    return costTime;
+    __block NSInteger result = -1;
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    [_prober probeIP:ip port:port timeout:kHttpdnsIPQualityProbeTimeout completion:^(NSInteger costTime) {
+        result = costTime;
+        dispatch_semaphore_signal(semaphore);
+    }];
+    dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+    return result;
 }
 
 @end
@@ -0,0 +1,53 @@
+//
+//  HttpdnsIpSelector.h
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/27.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "HttpdnsResult.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// 表示IP大概率不可达的期望代价取值
+static const double HTTPDNS_IP_SELECTION_UNREACHABLE_COST = -1;
+
+/**
+ * 在排序结果上做负载分散的选择
+ *
+ * 先剔除大概率不可达的IP，以及期望代价超过最优IP若干倍的慢IP，
+ * 再在剩余的IP上按期望代价的倒数加权，做随机选择或一致性哈希（加权rendezvous hashing）
+ */
+@interface HttpdnsIpSelector : NSObject
+
+/**
+ * @param ips 已排序的IP
+ * @param expectedCosts 与ips一一对应的期望代价（毫秒），不可达为HTTPDNS_IP_SELECTION_UNREACHABLE_COST；
+ *                      数量不一致时视为没有质量信息，所有IP同等对待
+ * @param strategy 选择策略
+ * @param hashKey 一致性哈希使用的客户端标识
+ * @return 选中的IP，ips为空时返回nil；全部不可达时返回排序第一的IP
+ */
++ (nullable NSString *)selectFromIps:(NSArray<NSString *> *)ips
+                       expectedCosts:(nullable NSArray<NSNumber *> *)expectedCosts
+                            strategy:(HttpdnsIpSelectionStrategy)strategy
+                             hashKey:(nullable NSString *)hashKey;
+
+/**
+ * 参与选择的IP下标，按原有顺序排列
+ */
++ (NSArray<NSNumber *> *)eligibleIndexesOfExpectedCosts:(NSArray<NSNumber *> *)expectedCosts;
+
+/**
+ * 按给定的随机数做加权选择，便于测试
+ * @param randomValue 取值范围[0, 1)
+ */
++ (nullable NSString *)selectFromIps:(NSArray<NSString *> *)ips
+                       expectedCosts:(nullable NSArray<NSNumber *> *)expectedCosts
+                         randomValue:(double)randomValue;
+
+@end
+
+NS_ASSUME_NONNULL_END
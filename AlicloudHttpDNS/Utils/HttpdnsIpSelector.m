@@ -0,0 +1,141 @@
+//
+//  HttpdnsIpSelector.m
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/27.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "HttpdnsIpSelector.h"
+#import <math.h>
+
+// 期望代价超过最优IP该倍数的IP不参与分散，避免把流量分到明显更慢的节点
+static const double kHttpdnsIpSelectionSlowFactor = 3.0;
+
+// 计算权重时代价的下限，避免本地或极快的IP权重无穷大
+static const double kHttpdnsIpSelectionMinCost = 1.0;
+
+static uint64_t HttpdnsFnv1aHash(NSString *string) {
+    uint64_t hash = 14695981039346656037ULL;
+    const char *bytes = [string UTF8String];
+    for (const char *cursor = bytes; cursor && *cursor; cursor++) {
+        hash ^= (uint8_t)*cursor;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// 把哈希值映射到(0, 1)开区间
+static double HttpdnsUnitIntervalFromHash(uint64_t hash) {
+    return ((double)(hash >> 11) + 0.5) / 9007199254740992.0;
+}
+
+@implementation HttpdnsIpSelector
+
++ (NSString *)selectFromIps:(NSArray<NSString *> *)ips
+              expectedCosts:(NSArray<NSNumber *> *)expectedCosts
+                   strategy:(HttpdnsIpSelectionStrategy)strategy
+                    hashKey:(NSString *)hashKey {
+    if (ips.count == 0) {
+        return nil;
+    }
+
+    switch (strategy) {
+        case HttpdnsIpSelectionStrategyWeightedRandom:
+            return [self selectFromIps:ips expectedCosts:expectedCosts randomValue:arc4random_uniform(UINT32_MAX) / (double)UINT32_MAX];
+        case HttpdnsIpSelectionStrategyConsistentHash:
+            return [self selectFromIps:ips expectedCosts:expectedCosts consistentHashKey:hashKey ?: @""];
+        case HttpdnsIpSelectionStrategyFirst:
+        default:
+            return ips.firstObject;
+    }
+}
+
++ (NSArray<NSNumber *> *)eligibleIndexesOfExpectedCosts:(NSArray<NSNumber *> *)expectedCosts {
+    double bestCost = DBL_MAX;
+    for (NSNumber *cost in expectedCosts) {
+        if ([cost doubleValue] >= 0) {
+            bestCost = MIN(bestCost, MAX([cost doubleValue], kHttpdnsIpSelectionMinCost));
+        }
+    }
+
+    NSMutableArray<NSNumber *> *indexes = [NSMutableArray arrayWithCapacity:expectedCosts.count];
+    if (bestCost == DBL_MAX) {
+        return indexes;
+    }
+
+    [expectedCosts enumerateObjectsUsingBlock:^(NSNumber *cost, NSUInteger idx, BOOL *stop) {
+        double value = [cost doubleValue];
+        if (value >= 0 && value <= bestCost * kHttpdnsIpSelectionSlowFactor) {
+            [indexes addObject:@(idx)];
+        }
+    }];
+    return indexes;
+}
+
++ (NSString *)selectFromIps:(NSArray<NSString *> *)ips
+              expectedCosts:(NSArray<NSNumber *> *)expectedCosts
+                randomValue:(double)randomValue {
+    NSArray<NSNumber *> *costs = [self normalizedCostsForIps:ips expectedCosts:expectedCosts];
+    NSArray<NSNumber *> *indexes = [self eligibleIndexesOfExpectedCosts:costs];
+    if (indexes.count == 0) {
+        return ips.firstObject;
+    }
+
+    double totalWeight = 0;
+    for (NSNumber *index in indexes) {
+        totalWeight += [self weightOfCost:costs[[index unsignedIntegerValue]]];
+    }
+
+    double target = MIN(MAX(randomValue, 0), 1) * totalWeight;
+    for (NSNumber *index in indexes) {
+        target -= [self weightOfCost:costs[[index unsignedIntegerValue]]];
+        if (target < 0) {
+            return ips[[index unsignedIntegerValue]];
+        }
+    }
+    return ips[[indexes.lastObject unsignedIntegerValue]];
+}
+
++ (NSString *)selectFromIps:(NSArray<NSString *> *)ips
+              expectedCosts:(NSArray<NSNumber *> *)expectedCosts
+          consistentHashKey:(NSString *)hashKey {
+    NSArray<NSNumber *> *costs = [self normalizedCostsForIps:ips expectedCosts:expectedCosts];
+    NSArray<NSNumber *> *indexes = [self eligibleIndexesOfExpectedCosts:costs];
+    if (indexes.count == 0) {
+        return ips.firstObject;
+    }
+
+    // 加权rendezvous hashing：IP集合变化时只有落在变化IP上的客户端会迁移
+    NSString *selected = nil;
+    double bestScore = -DBL_MAX;
+    for (NSNumber *index in indexes) {
+        NSString *ip = ips[[index unsignedIntegerValue]];
+        double unit = HttpdnsUnitIntervalFromHash(HttpdnsFnv1aHash([NSString stringWithFormat:@"%@|%@", hashKey, ip]));
+        double score = [self weightOfCost:costs[[index unsignedIntegerValue]]] / -log(unit);
+        if (score > bestScore) {
+            bestScore = score;
+            selected = ip;
+        }
+    }
+    return selected;
+}
+
++ (NSArray<NSNumber *> *)normalizedCostsForIps:(NSArray<NSString *> *)ips expectedCosts:(NSArray<NSNumber *> *)expectedCosts {
+    if (expectedCosts.count == ips.count) {
+        return expectedCosts;
+    }
+
+    // 没有质量信息时所有IP同等对待
+    NSMutableArray<NSNumber *> *costs = [NSMutableArray arrayWithCapacity:ips.count];
+    for (NSUInteger i = 0; i < ips.count; i++) {
+        [costs addObject:@(kHttpdnsIpSelectionMinCost)];
+    }
+    return costs;
+}
+
++ (double)weightOfCost:(NSNumber *)cost {
+    return 1.0 / MAX([cost doubleValue], kHttpdnsIpSelectionMinCost);
+}
+
+@end
@@ -0,0 +1,66 @@
+//
+//  HttpdnsMetrics.h
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class HttpdnsStatistics;
+
+// 进程内的运行计数，各组件在热路径上直接累加，只用原子操作
+typedef NS_ENUM(NSUInteger, HttpdnsMetricCounter) {
+    HttpdnsMetricCounterCacheHit = 0,
+    HttpdnsMetricCounterCacheMiss,
+    HttpdnsMetricCounterStaleServe,
+    HttpdnsMetricCounterCacheEviction,
+    HttpdnsMetricCounterNetworkRequest,
+    HttpdnsMetricCounterNetworkFailure,
+    HttpdnsMetricCounterNetworkRetry,
+    HttpdnsMetricCounterLocalDegradation,
+    HttpdnsMetricCounterConnectionOpen,
+    HttpdnsMetricCounterConnectionReuse,
+    HttpdnsMetricCounterConnectionIdleClose,
+    HttpdnsMetricCounterServerRotation,
+    HttpdnsMetricCounterProbe,
+    HttpdnsMetricCounterProbeFailure,
+    HttpdnsMetricCounterPredictedPrefetch,
+    HttpdnsMetricCounterPredictedHit,
+    HttpdnsMetricCounterCount,
+};
+
+typedef NS_ENUM(NSUInteger, HttpdnsMetricHistogram) {
+    HttpdnsMetricHistogramNetworkRequest = 0,
+    HttpdnsMetricHistogramConnectionOpen,
+    HttpdnsMetricHistogramProbe,
+    HttpdnsMetricHistogramCount,
+};
+
+// 耗时直方图的桶数：小于8微秒的值各占一桶，之后每个2倍区间分8个桶，最后一个桶的上限为2^28-1微秒（约268秒），更大的值也计入最后一个桶
+#define HTTPDNS_METRICS_HISTOGRAM_BUCKET_COUNT 208
+
+// 单调时钟，单位纳秒
+FOUNDATION_EXTERN uint64_t HttpdnsMetricsNow(void);
+
+FOUNDATION_EXTERN void HttpdnsMetricsIncrement(HttpdnsMetricCounter counter);
+
+FOUNDATION_EXTERN void HttpdnsMetricsAdd(HttpdnsMetricCounter counter, uint64_t value);
+
+FOUNDATION_EXTERN uint64_t HttpdnsMetricsCounterValue(HttpdnsMetricCounter counter);
+
+// 记录从startTime（HttpdnsMetricsNow的返回值）到当前时刻的耗时
+FOUNDATION_EXTERN void HttpdnsMetricsRecordLatencySince(HttpdnsMetricHistogram histogram, uint64_t startTime);
+
+FOUNDATION_EXTERN void HttpdnsMetricsRecordLatency(HttpdnsMetricHistogram histogram, uint64_t microseconds);
+
+// 桶内能表示的最大值，单位微秒
+FOUNDATION_EXTERN uint64_t HttpdnsMetricsBucketHighestValue(NSUInteger bucketIndex);
+
+// 按当前计数生成快照，各计数分别原子读取，彼此之间不保证是同一时刻
+FOUNDATION_EXTERN HttpdnsStatistics *HttpdnsMetricsSnapshot(void);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,124 @@
+//
+//  HttpdnsMetrics.m
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "HttpdnsMetrics.h"
+#import "HttpdnsStatistics_Internal.h"
+#import <stdatomic.h>
+#import <time.h>
+
+// 每个2倍区间的分桶数为2^3
+#define HTTPDNS_METRICS_SUB_BUCKET_BITS 3
+#define HTTPDNS_METRICS_SUB_BUCKET_COUNT (1 << HTTPDNS_METRICS_SUB_BUCKET_BITS)
+
+// 计数各占一个缓存行，避免不同线程累加不同计数时互相影响
+typedef struct {
+    atomic_ullong value;
+    char padding[64 - sizeof(atomic_ullong)];
+} HttpdnsMetricSlot;
+
+typedef struct {
+    atomic_ullong buckets[HTTPDNS_METRICS_HISTOGRAM_BUCKET_COUNT];
+    atomic_ullong sum;
+    atomic_ullong max;
+} HttpdnsMetricHistogramStorage;
+
+static HttpdnsMetricSlot sCounters[HttpdnsMetricCounterCount];
+static HttpdnsMetricHistogramStorage sHistograms[HttpdnsMetricHistogramCount];
+
+uint64_t HttpdnsMetricsNow(void) {
+    return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+void HttpdnsMetricsIncrement(HttpdnsMetricCounter counter) {
+    atomic_fetch_add_explicit(&sCounters[counter].value, 1, memory_order_relaxed);
+}
+
+void HttpdnsMetricsAdd(HttpdnsMetricCounter counter, uint64_t value) {
+    atomic_fetch_add_explicit(&sCounters[counter].value, value, memory_order_relaxed);
+}
+
+uint64_t HttpdnsMetricsCounterValue(HttpdnsMetricCounter counter) {
+    return atomic_load_explicit(&sCounters[counter].value, memory_order_relaxed);
+}
+
+static NSUInteger HttpdnsMetricsBucketIndex(uint64_t value) {
+    if (value < HTTPDNS_METRICS_SUB_BUCKET_COUNT) {
+        return (NSUInteger)value;
+    }
+    int highestBit = 63 - __builtin_clzll(value);
+    int shift = highestBit - HTTPDNS_METRICS_SUB_BUCKET_BITS;
+    NSUInteger index = (NSUInteger)(shift + 1) * HTTPDNS_METRICS_SUB_BUCKET_COUNT
+                       + (NSUInteger)((value >> shift) & (HTTPDNS_METRICS_SUB_BUCKET_COUNT - 1));
+    return MIN(index, HTTPDNS_METRICS_HISTOGRAM_BUCKET_COUNT - 1);
+}
+
+uint64_t HttpdnsMetricsBucketHighestValue(NSUInteger bucketIndex) {
+    if (bucketIndex < HTTPDNS_METRICS_SUB_BUCKET_COUNT) {
+        return bucketIndex;
+    }
+    NSUInteger shift = bucketIndex / HTTPDNS_METRICS_SUB_BUCKET_COUNT - 1;
+    uint64_t subBucket = HTTPDNS_METRICS_SUB_BUCKET_COUNT + bucketIndex % HTTPDNS_METRICS_SUB_BUCKET_COUNT;
+    return ((subBucket + 1) << shift) - 1;
+}
+
+void HttpdnsMetricsRecordLatency(HttpdnsMetricHistogram histogram, uint64_t microseconds) {
+    HttpdnsMetricHistogramStorage *storage = &sHistograms[histogram];
+    atomic_fetch_add_explicit(&storage->buckets[HttpdnsMetricsBucketIndex(microseconds)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&storage->sum, microseconds, memory_order_relaxed);
+
+    uint64_t currentMax = atomic_load_explicit(&storage->max, memory_order_relaxed);
+    while (microseconds > currentMax
+           && !atomic_compare_exchange_weak_explicit(&storage->max, &currentMax, microseconds, memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+void HttpdnsMetricsRecordLatencySince(HttpdnsMetricHistogram histogram, uint64_t startTime) {
+    uint64_t now = HttpdnsMetricsNow();
+    HttpdnsMetricsRecordLatency(histogram, now > startTime ? (now - startTime) / NSEC_PER_USEC : 0);
+}
+
+static HttpdnsLatencyHistogram *HttpdnsMetricsHistogramSnapshot(HttpdnsMetricHistogram histogram) {
+    HttpdnsMetricHistogramStorage *storage = &sHistograms[histogram];
+    uint64_t bucketCounts[HTTPDNS_METRICS_HISTOGRAM_BUCKET_COUNT];
+    for (NSUInteger i = 0; i < HTTPDNS_METRICS_HISTOGRAM_BUCKET_COUNT; i++) {
+        bucketCounts[i] = atomic_load_explicit(&storage->buckets[i], memory_order_relaxed);
+    }
+    return [[HttpdnsLatencyHistogram alloc] initWithBucketCounts:bucketCounts
+                                                     bucketCount:HTTPDNS_METRICS_HISTOGRAM_BUCKET_COUNT
+                                               sumInMicroseconds:atomic_load_explicit(&storage->sum, memory_order_relaxed)
+                                               maxInMicroseconds:atomic_load_explicit(&storage->max, memory_order_relaxed)];
+}
+
+HttpdnsStatistics *HttpdnsMetricsSnapshot(void) {
+    HttpdnsStatistics *statistics = [HttpdnsStatistics new];
+    statistics.cacheHitCount = (NSUInteger)HttpdnsMetricsCounterValue(HttpdnsMetricCounterCacheHit);
+    statistics.cacheMissCount = (NSUInteger)HttpdnsMetricsCounterValue(HttpdnsMetricCounterCacheMiss);
+    statistics.staleServeCount = (NSUInteger)HttpdnsMetricsCounterValue(HttpdnsMetricCounterStaleServe);
+    statistics.cacheEvictionCount = (NSUInteger)HttpdnsMetricsCounterValue(HttpdnsMetricCounterCacheEviction);
+
+    statistics.networkRequestCount = (NSUInteger)HttpdnsMetricsCounterValue(HttpdnsMetricCounterNetworkRequest);
+    statistics.networkFailureCount = (NSUInteger)HttpdnsMetricsCounterValue(HttpdnsMetricCounterNetworkFailure);
+    statistics.networkRetryCount = (NSUInteger)HttpdnsMetricsCounterValue(HttpdnsMetricCounterNetworkRetry);
+    statistics.localDegradationCount = (NSUInteger)HttpdnsMetricsCounterValue(HttpdnsMetricCounterLocalDegradation);
+    statistics.networkRequestLatency = HttpdnsMetricsHistogramSnapshot(HttpdnsMetricHistogramNetworkRequest);
+
+    statistics.connectionOpenCount = (NSUInteger)HttpdnsMetricsCounterValue(HttpdnsMetricCounterConnectionOpen);
+    statistics.connectionReuseCount = (NSUInteger)HttpdnsMetricsCounterValue(HttpdnsMetricCounterConnectionReuse);
+    statistics.connectionIdleCloseCount = (NSUInteger)HttpdnsMetricsCounterValue(HttpdnsMetricCounterConnectionIdleClose);
+    statistics.connectionOpenLatency = HttpdnsMetricsHistogramSnapshot(HttpdnsMetricHistogramConnectionOpen);
+
+    statistics.serverRotationCount = (NSUInteger)HttpdnsMetricsCounterValue(HttpdnsMetricCounterServerRotation);
+
+    statistics.probeCount = (NSUInteger)HttpdnsMetricsCounterValue(HttpdnsMetricCounterProbe);
+    statistics.probeFailureCount = (NSUInteger)HttpdnsMetricsCounterValue(HttpdnsMetricCounterProbeFailure);
+    statistics.probeLatency = HttpdnsMetricsHistogramSnapshot(HttpdnsMetricHistogramProbe);
+
+    statistics.predictedPrefetchCount = (NSUInteger)HttpdnsMetricsCounterValue(HttpdnsMetricCounterPredictedPrefetch);
+    statistics.predictedHitCount = (NSUInteger)HttpdnsMetricsCounterValue(HttpdnsMetricCounterPredictedHit);
+    return statistics;
+}
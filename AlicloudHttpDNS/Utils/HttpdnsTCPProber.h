@@ -0,0 +1,107 @@
+//
+//  HttpdnsTCPProber.h
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/24.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * TCP建连探测回调
+ * @param costTime 建连耗时（毫秒），-1表示连接失败或超时
+ */
+typedef void(^HttpdnsTCPProbeCompletion)(NSInteger costTime);
+
+/**
+ * 探测真正发起连接（离开等待队列）时的回调，在事件循环线程上执行，不能有耗时操作
+ */
+typedef void(^HttpdnsTCPProbeStartHandler)(void);
+
+/**
+ * TCP建连回调
+ * @param socketFd 建连成功时为已连接的阻塞模式socket，所有权交给调用方；失败、超时或被取消时为-1
+ * @param costTime 建连耗时（毫秒），-1表示连接失败、超时或被取消
+ */
+typedef void(^HttpdnsTCPConnectCompletion)(int socketFd, NSInteger costTime);
+
+/**
+ * 基于kqueue的TCP建连探测器
+ *
+ * 所有探测在同一个事件循环线程上以非阻塞connect的方式并发执行，每个探测有独立的超时时间。
+ * 同时进行中的探测数量达到上限时，新的探测进入等待队列，有探测完成后按提交顺序启动
+ */
+@interface HttpdnsTCPProber : NSObject
+
+/**
+ * 同时进行中的探测数量上限
+ */
+@property (nonatomic, assign, readonly) NSUInteger maxConcurrentProbes;
+
+/**
+ * 创建探测器并启动事件循环线程
+ * @param maxConcurrentProbes 同时进行中的探测数量上限，为0时按1处理
+ */
+- (instancetype)initWithMaxConcurrentProbes:(NSUInteger)maxConcurrentProbes;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * 提交一个探测，立即返回
+ * @param ip IPv4或IPv6地址
+ * @param port 端口
+ * @param timeout 超时时间（秒），从真正发起连接时开始计算
+ * @param completion 探测完成后在全局队列上回调，每个探测只回调一次
+ */
+- (void)probeIP:(NSString *)ip
+           port:(int)port
+        timeout:(NSTimeInterval)timeout
+     completion:(HttpdnsTCPProbeCompletion)completion;
+
+/**
+ * 提交一个探测，真正发起连接时通过started通知调用方，用于区分排队时间和探测时间
+ * @param started 发起连接时回调，参数无效或探测器已停止时不回调
+ */
+- (void)probeIP:(NSString *)ip
+           port:(int)port
+        timeout:(NSTimeInterval)timeout
+        started:(nullable HttpdnsTCPProbeStartHandler)started
+     completion:(HttpdnsTCPProbeCompletion)completion;
+
+/**
+ * 提交一个建连请求，与探测相同地排队和计时，但建连成功后不关闭socket而是交给调用方
+ * @param completion 完成后在全局队列上回调，每个请求只回调一次
+ * @return 用于取消的标识，参数无效或探测器已停止时返回0
+ */
+- (NSUInteger)connectIP:(NSString *)ip
+                   port:(int)port
+                timeout:(NSTimeInterval)timeout
+             completion:(HttpdnsTCPConnectCompletion)completion;
+
+/**
+ * 取消尚未完成的建连请求，被取消的请求以-1回调；已完成的请求忽略
+ * @param token connectIP:port:timeout:completion:返回的标识
+ */
+- (void)cancelConnect:(NSUInteger)token;
+
+/**
+ * 等待队列中尚未开始的探测数量
+ */
+- (NSUInteger)waitingProbeCount;
+
+/**
+ * 正在进行中的探测数量
+ */
+- (NSUInteger)activeProbeCount;
+
+/**
+ * 停止事件循环，尚未完成的探测以-1回调；停止后提交的探测直接以-1回调
+ */
+- (void)shutdown;
+
+@end
+
+NS_ASSUME_NONNULL_END
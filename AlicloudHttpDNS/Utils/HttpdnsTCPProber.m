@@ -0,0 +1,487 @@
+//
+//  HttpdnsTCPProber.m
+//  AlicloudHttpDNS
+//
+//  Created by xuyecan on 2025/4/24.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "HttpdnsTCPProber.h"
+#import <sys/event.h>
+#import <sys/socket.h>
+#import <netinet/in.h>
+#import <arpa/inet.h>
+#import <unistd.h>
+#import <fcntl.h>
+#import <errno.h>
+#import <time.h>
+#import "HttpdnsLog_Internal.h"
+#import "HttpdnsUtil.h"
+
+// 用于唤醒事件循环的EVFILT_USER标识
+static const uintptr_t kHttpdnsTCPProberWakeupIdent = 0;
+
+// 单次kevent最多取出的事件数量
+static const int kHttpdnsTCPProberEventBatchSize = 64;
+
+@interface HttpdnsTCPProbe : NSObject
+
+@property (nonatomic, copy) NSString *ip;
+@property (nonatomic, assign) int port;
+@property (nonatomic, assign) NSTimeInterval timeout;
+@property (nonatomic, copy) HttpdnsTCPProbeCompletion completion;
+@property (nonatomic, copy) HttpdnsTCPProbeStartHandler started;
+// 不为空时建连成功后把socket交给调用方
+@property (nonatomic, copy) HttpdnsTCPConnectCompletion connectCompletion;
+@property (nonatomic, assign) NSUInteger token;
+@property (nonatomic, assign) int socketFd;
+@property (nonatomic, assign) uint64_t startTime;
+
+@end
+
+@implementation HttpdnsTCPProbe
+@end
+
+@interface HttpdnsTCPProber ()
+
+@property (nonatomic, assign) int kqueueFd;
+@property (nonatomic, strong) NSThread *loopThread;
+
+// 以下属性由stateLock保护
+@property (nonatomic, strong) NSLock *stateLock;
+@property (nonatomic, strong) NSMutableArray<HttpdnsTCPProbe *> *waitingProbes;
+@property (nonatomic, assign) NSUInteger activeCount;
+@property (nonatomic, assign) BOOL stopped;
+@property (nonatomic, assign) NSUInteger nextToken;
+@property (nonatomic, strong) NSMutableIndexSet *cancelledTokens;
+
+// 只在事件循环线程上访问，key为socket描述符
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, HttpdnsTCPProbe *> *activeProbes;
+
+@end
+
+@implementation HttpdnsTCPProber
+
+- (instancetype)initWithMaxConcurrentProbes:(NSUInteger)maxConcurrentProbes {
+    self = [super init];
+    if (self) {
+        _maxConcurrentProbes = MAX(maxConcurrentProbes, 1);
+        _stateLock = [[NSLock alloc] init];
+        _waitingProbes = [NSMutableArray array];
+        _cancelledTokens = [NSMutableIndexSet indexSet];
+        _activeProbes = [NSMutableDictionary dictionary];
+
+        _kqueueFd = kqueue();
+        if (_kqueueFd < 0) {
+            HttpdnsLogDebug("TCPProber failed to create kqueue: %s", strerror(errno));
+            _stopped = YES;
+            return self;
+        }
+
+        struct kevent wakeup;
+        EV_SET(&wakeup, kHttpdnsTCPProberWakeupIdent, EVFILT_USER, EV_ADD | EV_CLEAR, 0, 0, NULL);
+        if (kevent(_kqueueFd, &wakeup, 1, NULL, 0, NULL) < 0) {
+            HttpdnsLogDebug("TCPProber failed to register wakeup event: %s", strerror(errno));
+            close(_kqueueFd);
+            _kqueueFd = -1;
+            _stopped = YES;
+            return self;
+        }
+
+        // 事件循环线程持有探测器，直到调用shutdown
+        _loopThread = [[NSThread alloc] initWithBlock:^{
+            [self runEventLoop];
+        }];
+        _loopThread.name = @"com.aliyun.httpdns.tcpprober";
+        _loopThread.qualityOfService = NSQualityOfServiceUtility;
+        [_loopThread start];
+    }
+    return self;
+}
+
+#pragma mark - Public Methods
+
+- (void)probeIP:(NSString *)ip
+           port:(int)port
+        timeout:(NSTimeInterval)timeout
+     completion:(HttpdnsTCPProbeCompletion)completion {
+    [self probeIP:ip port:port timeout:timeout started:nil completion:completion];
+}
+
+- (void)probeIP:(NSString *)ip
+           port:(int)port
+        timeout:(NSTimeInterval)timeout
+        started:(HttpdnsTCPProbeStartHandler)started
+     completion:(HttpdnsTCPProbeCompletion)completion {
+    if (!completion) {
+        return;
+    }
+
+    HttpdnsTCPProbe *probe = [[HttpdnsTCPProbe alloc] init];
+    probe.started = started;
+    probe.completion = completion;
+    [self enqueueProbe:probe ip:ip port:port timeout:timeout];
+}
+
+- (NSUInteger)connectIP:(NSString *)ip
+                   port:(int)port
+                timeout:(NSTimeInterval)timeout
+             completion:(HttpdnsTCPConnectCompletion)completion {
+    if (!completion) {
+        return 0;
+    }
+
+    HttpdnsTCPProbe *probe = [[HttpdnsTCPProbe alloc] init];
+    probe.connectCompletion = completion;
+    return [self enqueueProbe:probe ip:ip port:port timeout:timeout];
+}
+
+- (NSUInteger)enqueueProbe:(HttpdnsTCPProbe *)probe ip:(NSString *)ip port:(int)port timeout:(NSTimeInterval)timeout {
+    if ([HttpdnsUtil isEmptyString:ip] || port <= 0 || port > UINT16_MAX) {
+        [self deliverProbe:probe socket:-1 costTime:-1];
+        return 0;
+    }
+
+    probe.ip = ip;
+    probe.port = port;
+    probe.timeout = timeout;
+    probe.socketFd = -1;
+
+    [_stateLock lock];
+    BOOL stopped = _stopped;
+    if (!stopped) {
+        probe.token = ++_nextToken;
+        [_waitingProbes addObject:probe];
+    }
+    [_stateLock unlock];
+
+    if (stopped) {
+        [self deliverProbe:probe socket:-1 costTime:-1];
+        return 0;
+    }
+
+    [self wakeupEventLoop];
+    return probe.token;
+}
+
+- (void)cancelConnect:(NSUInteger)token {
+    if (token == 0) {
+        return;
+    }
+
+    HttpdnsTCPProbe *waitingProbe = nil;
+    [_stateLock lock];
+    for (HttpdnsTCPProbe *probe in _waitingProbes) {
+        if (probe.token == token) {
+            waitingProbe = probe;
+            break;
+        }
+    }
+    if (waitingProbe) {
+        [_waitingProbes removeObject:waitingProbe];
+    } else if (!_stopped) {
+        // 可能正在进行中，交给事件循环线程关闭
+        [_cancelledTokens addIndex:token];
+    }
+    [_stateLock unlock];
+
+    if (waitingProbe) {
+        [self deliverProbe:waitingProbe socket:-1 costTime:-1];
+    } else {
+        [self wakeupEventLoop];
+    }
+}
+
+- (NSUInteger)waitingProbeCount {
+    [_stateLock lock];
+    NSUInteger count = _waitingProbes.count;
+    [_stateLock unlock];
+    return count;
+}
+
+- (NSUInteger)activeProbeCount {
+    [_stateLock lock];
+    NSUInteger count = _activeCount;
+    [_stateLock unlock];
+    return count;
+}
+
+- (void)shutdown {
+    [_stateLock lock];
+    BOOL alreadyStopped = _stopped;
+    _stopped = YES;
+    [_stateLock unlock];
+
+    if (!alreadyStopped) {
+        [self wakeupEventLoop];
+    }
+}
+
+#pragma mark - Event Loop
+
+- (void)wakeupEventLoop {
+    struct kevent wakeup;
+    EV_SET(&wakeup, kHttpdnsTCPProberWakeupIdent, EVFILT_USER, 0, NOTE_TRIGGER, 0, NULL);
+    kevent(_kqueueFd, &wakeup, 1, NULL, 0, NULL);
+}
+
+- (void)runEventLoop {
+    struct kevent events[kHttpdnsTCPProberEventBatchSize];
+
+    while (YES) {
+        @autoreleasepool {
+            [_stateLock lock];
+            BOOL stopped = _stopped;
+            [_stateLock unlock];
+            if (stopped) {
+                break;
+            }
+
+            // 处理完上一批事件后再启动新探测，避免同一批事件里复用的描述符被误认
+            [self startWaitingProbes];
+            [self closeCancelledProbes];
+
+            // 每个探测都注册了自己的超时定时器，这里无需计算等待时间
+            int count = kevent(_kqueueFd, NULL, 0, events, kHttpdnsTCPProberEventBatchSize, NULL);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                HttpdnsLogDebug("TCPProber kevent failed: %s", strerror(errno));
+                break;
+            }
+
+            for (int i = 0; i < count; i++) {
+                struct kevent *event = &events[i];
+                int socketFd = (int)event->ident;
+
+                if (event->filter == EVFILT_WRITE) {
+                    [self finishProbeWithSocket:socketFd costTime:[self costTimeOfConnectedSocket:socketFd]];
+                } else if (event->filter == EVFILT_TIMER) {
+                    HttpdnsTCPProbe *probe = _activeProbes[@(socketFd)];
+                    if (probe) {
+                        HttpdnsLogDebug("TCPProber connection to %@ timed out", probe.ip);
+                    }
+                    [self finishProbeWithSocket:socketFd costTime:-1];
+                }
+            }
+        }
+    }
+
+    [self failAllProbes];
+}
+
+- (void)startWaitingProbes {
+    while (YES) {
+        HttpdnsTCPProbe *probe = nil;
+
+        [_stateLock lock];
+        if (_activeCount < _maxConcurrentProbes && _waitingProbes.count > 0) {
+            probe = _waitingProbes.firstObject;
+            [_waitingProbes removeObjectAtIndex:0];
+            _activeCount++;
+        }
+        [_stateLock unlock];
+
+        if (!probe) {
+            return;
+        }
+
+        [self startProbe:probe];
+    }
+}
+
+- (void)closeCancelledProbes {
+    [_stateLock lock];
+    NSIndexSet *cancelledTokens = [_cancelledTokens copy];
+    [_cancelledTokens removeAllIndexes];
+    [_stateLock unlock];
+
+    if (cancelledTokens.count == 0) {
+        return;
+    }
+
+    // 已经完成的请求不在activeProbes中，直接忽略
+    for (NSNumber *socketFd in [_activeProbes allKeys]) {
+        HttpdnsTCPProbe *probe = _activeProbes[socketFd];
+        if ([cancelledTokens containsIndex:probe.token]) {
+            [self finishProbeWithSocket:[socketFd intValue] costTime:-1];
+        }
+    }
+}
+
+- (void)startProbe:(HttpdnsTCPProbe *)probe {
+    if (probe.started) {
+        probe.started();
+        probe.started = nil;
+    }
+
+    struct sockaddr_storage serverAddr;
+    socklen_t serverAddrLen = 0;
+    memset(&serverAddr, 0, sizeof(serverAddr));
+
+    if ([HttpdnsUtil isIPv6Address:probe.ip]) {
+        struct sockaddr_in6 *addr6 = (struct sockaddr_in6 *)&serverAddr;
+        addr6->sin6_family = AF_INET6;
+        addr6->sin6_len = sizeof(struct sockaddr_in6);
+        addr6->sin6_port = htons(probe.port);
+        if (inet_pton(AF_INET6, [probe.ip UTF8String], &addr6->sin6_addr) == 1) {
+            serverAddrLen = sizeof(struct sockaddr_in6);
+        }
+    } else if ([HttpdnsUtil isIPv4Address:probe.ip]) {
+        struct sockaddr_in *addr4 = (struct sockaddr_in *)&serverAddr;
+        addr4->sin_family = AF_INET;
+        addr4->sin_len = sizeof(struct sockaddr_in);
+        addr4->sin_port = htons(probe.port);
+        if (inet_pton(AF_INET, [probe.ip UTF8String], &addr4->sin_addr) == 1) {
+            serverAddrLen = sizeof(struct sockaddr_in);
+        }
+    }
+
+    if (serverAddrLen == 0) {
+        [self completeStartedProbe:probe socket:-1 costTime:-1];
+        return;
+    }
+
+    int socketFd = socket(serverAddr.ss_family, SOCK_STREAM, 0);
+    if (socketFd < 0) {
+        HttpdnsLogDebug("TCPProber failed to create socket: %s", strerror(errno));
+        [self completeStartedProbe:probe socket:-1 costTime:-1];
+        return;
+    }
+
+    int flags = fcntl(socketFd, F_GETFL, 0);
+    fcntl(socketFd, F_SETFL, flags | O_NONBLOCK);
+    int noSigPipe = 1;
+    setsockopt(socketFd, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+
+    probe.socketFd = socketFd;
+    probe.startTime = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+
+    if (connect(socketFd, (struct sockaddr *)&serverAddr, serverAddrLen) == 0) {
+        // 本地地址可能立即完成连接
+        NSInteger costTime = [self elapsedMillisecondsSince:probe.startTime];
+        [self completeStartedProbe:probe socket:[self handOverOrCloseSocket:socketFd ofProbe:probe] costTime:costTime];
+        return;
+    }
+
+    if (errno != EINPROGRESS) {
+        HttpdnsLogDebug("TCPProber connection to %@ failed: %s", probe.ip, strerror(errno));
+        close(socketFd);
+        [self completeStartedProbe:probe socket:-1 costTime:-1];
+        return;
+    }
+
+    // 可写事件表示连接完成，定时器事件表示超时，两者都只触发一次
+    struct kevent changes[2];
+    int64_t timeoutMs = MAX((int64_t)(probe.timeout * 1000), 1);
+    EV_SET(&changes[0], socketFd, EVFILT_WRITE, EV_ADD | EV_ONESHOT, 0, 0, NULL);
+    EV_SET(&changes[1], socketFd, EVFILT_TIMER, EV_ADD | EV_ONESHOT, 0, timeoutMs, NULL);
+    if (kevent(_kqueueFd, changes, 2, NULL, 0, NULL) < 0) {
+        HttpdnsLogDebug("TCPProber failed to register probe events: %s", strerror(errno));
+        close(socketFd);
+        [self completeStartedProbe:probe socket:-1 costTime:-1];
+        return;
+    }
+
+    _activeProbes[@(socketFd)] = probe;
+}
+
+- (NSInteger)costTimeOfConnectedSocket:(int)socketFd {
+    HttpdnsTCPProbe *probe = _activeProbes[@(socketFd)];
+    if (!probe) {
+        return -1;
+    }
+
+    int error = 0;
+    socklen_t errorLen = sizeof(error);
+    if (getsockopt(socketFd, SOL_SOCKET, SO_ERROR, &error, &errorLen) < 0 || error != 0) {
+        HttpdnsLogDebug("TCPProber connection to %@ failed: %s", probe.ip, strerror(error));
+        return -1;
+    }
+
+    return [self elapsedMillisecondsSince:probe.startTime];
+}
+
+- (void)finishProbeWithSocket:(int)socketFd costTime:(NSInteger)costTime {
+    HttpdnsTCPProbe *probe = _activeProbes[@(socketFd)];
+    if (!probe) {
+        // 同一批事件中连接完成和超时同时到达，另一个已处理
+        return;
+    }
+    [_activeProbes removeObjectForKey:@(socketFd)];
+
+    // 关闭描述符会移除可写事件，定时器需要单独删除；已触发的事件删除失败可以忽略
+    struct kevent changes[2];
+    EV_SET(&changes[0], socketFd, EVFILT_WRITE, EV_DELETE, 0, 0, NULL);
+    EV_SET(&changes[1], socketFd, EVFILT_TIMER, EV_DELETE, 0, 0, NULL);
+    for (int i = 0; i < 2; i++) {
+        kevent(_kqueueFd, &changes[i], 1, NULL, 0, NULL);
+    }
+
+    if (costTime < 0) {
+        close(socketFd);
+        [self completeStartedProbe:probe socket:-1 costTime:costTime];
+        return;
+    }
+    [self completeStartedProbe:probe socket:[self handOverOrCloseSocket:socketFd ofProbe:probe] costTime:costTime];
+}
+
+- (int)handOverOrCloseSocket:(int)socketFd ofProbe:(HttpdnsTCPProbe *)probe {
+    if (!probe.connectCompletion) {
+        close(socketFd);
+        return -1;
+    }
+
+    // 交给调用方前恢复为阻塞模式，与普通connect得到的socket行为一致
+    int flags = fcntl(socketFd, F_GETFL, 0);
+    fcntl(socketFd, F_SETFL, flags & ~O_NONBLOCK);
+    return socketFd;
+}
+
+- (void)completeStartedProbe:(HttpdnsTCPProbe *)probe socket:(int)socketFd costTime:(NSInteger)costTime {
+    [_stateLock lock];
+    _activeCount--;
+    [_stateLock unlock];
+
+    [self deliverProbe:probe socket:socketFd costTime:costTime];
+}
+
+- (void)failAllProbes {
+    for (NSNumber *socketFd in [_activeProbes allKeys]) {
+        [self finishProbeWithSocket:[socketFd intValue] costTime:-1];
+    }
+
+    [_stateLock lock];
+    NSArray<HttpdnsTCPProbe *> *waitingProbes = [_waitingProbes copy];
+    [_waitingProbes removeAllObjects];
+    [_stateLock unlock];
+
+    for (HttpdnsTCPProbe *probe in waitingProbes) {
+        [self deliverProbe:probe socket:-1 costTime:-1];
+    }
+
+    int kqueueFd = _kqueueFd;
+    _kqueueFd = -1;
+    close(kqueueFd);
+}
+
+- (void)deliverProbe:(HttpdnsTCPProbe *)probe socket:(int)socketFd costTime:(NSInteger)costTime {
+    HttpdnsTCPProbeCompletion completion = probe.completion;
+    HttpdnsTCPConnectCompletion connectCompletion = probe.connectCompletion;
+    // 回调不在事件循环线程上执行，避免耗时回调阻塞其他探测
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        if (connectCompletion) {
+            connectCompletion(socketFd, costTime);
+        } else {
+            completion(costTime);
+        }
+    });
+}
+
+- (NSInteger)elapsedMillisecondsSince:(uint64_t)startTime {
+    uint64_t now = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    return (NSInteger)((now - startTime) / NSEC_PER_MSEC);
+}
+
+@end
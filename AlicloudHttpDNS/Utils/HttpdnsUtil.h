@@ -59,6 +59,8 @@
 
 + (NSString *)generateSessionID;
 
++ (NSString *)installationID;
+
 + (NSString *)generateUserAgent;
 
 + (NSData *)encryptDataAESCBC:(NSData *)plaintext
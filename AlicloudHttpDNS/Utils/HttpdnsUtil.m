@@ -220,6 +220,16 @@
     return nil;
 }
 
++ (NSString *)randomBase62StringOfLength:(NSUInteger)count {
+    NSString *alphabet = @"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+    NSUInteger length = alphabet.length;
+    NSMutableString *result = [NSMutableString stringWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [result appendFormat:@"%@", [alphabet substringWithRange:NSMakeRange(arc4random_uniform((uint32_t)length), 1)]];
+    }
+    return [result copy];
+}
+
 /**
  生成sessionId
  App打开生命周期只生成一次，不做持久化
@@ -229,19 +239,33 @@
     static NSString *sessionId = nil;
     static dispatch_once_t onceToken;
     dispatch_once(&onceToken, ^{
-        NSString *alphabet = @"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
-        NSUInteger length = alphabet.length;
-        if (![HttpdnsUtil isNotEmptyString:sessionId]) {
-            NSMutableString *mSessionId = [NSMutableString string];
-            for (int i = 0; i < 12; i++) {
-                [mSessionId appendFormat:@"%@", [alphabet substringWithRange:NSMakeRange(arc4random() % length, 1)]];
-            }
-            sessionId = [mSessionId copy];
-        }
+        sessionId = [self randomBase62StringOfLength:12];
     });
     return sessionId;
 }
 
+/**
+ 获取安装标识
+ 首次使用时随机生成并保存到NSUserDefaults，之后跨启动保持不变，卸载重装后重新生成
+ 只在本地使用，不随请求上报
+ */
++ (NSString *)installationID {
+    static NSString *installationId = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSUserDefaults *userDefault = [NSUserDefaults standardUserDefaults];
+        NSString *savedId = [userDefault stringForKey:kAlicloudHttpdnsInstallationIdKey];
+        if ([HttpdnsUtil isNotEmptyString:savedId]) {
+            installationId = savedId;
+            return;
+        }
+
+        installationId = [self randomBase62StringOfLength:16];
+        [userDefault setObject:installationId forKey:kAlicloudHttpdnsInstallationIdKey];
+    });
+    return installationId;
+}
+
 + (NSString *)generateUserAgent {
     UIDevice *device = [UIDevice currentDevice];
     NSString *systemName = [device systemName];
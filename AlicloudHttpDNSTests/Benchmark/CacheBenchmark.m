@@ -0,0 +1,89 @@
+//
+//  CacheBenchmark.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+#import "HttpdnsBenchmarkCase.h"
+#import "HttpdnsRequest_Internal.h"
+#import "HttpdnsService.h"
+#import "HttpdnsService_Internal.h"
+
+static const NSUInteger kCacheBenchmarkOperations = 100000;
+
+@interface CacheBenchmark : HttpdnsBenchmarkCase
+
+@end
+
+@implementation CacheBenchmark
+
++ (void)setUp {
+    [super setUp];
+
+    HttpDnsService *httpdns = [[HttpDnsService alloc] initWithAccountID:100000];
+    [httpdns setLogEnabled:NO];
+}
+
+- (void)setUp {
+    [super setUp];
+
+    self.httpdns = [HttpDnsService sharedInstance];
+    [self.httpdns setReuseExpiredIPEnabled:NO];
+    [self.httpdns cleanAllHostCache];
+    self.currentTimeStamp = [[NSDate date] timeIntervalSince1970];
+
+    [self presetNetworkEnvAsIpv4];
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4HostObject];
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:ipv4OnlyHost cacheKey:ipv4OnlyHost underQueryIpType:HttpdnsQueryIPTypeIpv4];
+}
+
+- (void)tearDown {
+    [self.httpdns cleanAllHostCache];
+    [super tearDown];
+}
+
+- (void)benchmarkCacheHitWithThreads:(NSUInteger)threads {
+    HttpdnsRequestManager *requestManager = self.httpdns.requestManager;
+    NSString *name = [NSString stringWithFormat:@"cache_hit.threads_%lu", (unsigned long)threads];
+    [self benchmark:name threads:threads operations:kCacheBenchmarkOperations block:^(NSUInteger index) {
+        HttpdnsRequest *request = [[HttpdnsRequest alloc] initWithHost:ipv4OnlyHost queryIpType:HttpdnsQueryIPTypeIpv4];
+        request.cacheKey = ipv4OnlyHost;
+        [request becomeNonBlockingRequest];
+        [requestManager resolveHost:request];
+    }];
+}
+
+- (void)testCacheHitSingleThread {
+    [self benchmarkCacheHitWithThreads:1];
+}
+
+- (void)testCacheHitFourThreads {
+    [self benchmarkCacheHitWithThreads:4];
+}
+
+- (void)testCacheHitSixteenThreads {
+    [self benchmarkCacheHitWithThreads:16];
+}
+
+- (void)testResolveHostSyncNonBlocking {
+    HttpDnsService *httpdns = self.httpdns;
+    XCTAssertNotNil([httpdns resolveHostSyncNonBlocking:ipv4OnlyHost byIpType:HttpdnsQueryIPTypeIpv4]);
+
+    [self benchmark:@"resolve_sync_nonblocking.result" operations:kCacheBenchmarkOperations block:^(NSUInteger index) {
+        [httpdns resolveHostSyncNonBlocking:ipv4OnlyHost byIpType:HttpdnsQueryIPTypeIpv4];
+    }];
+}
+
+- (void)testResolveHostSyncNonBlockingToSockaddrs {
+    HttpDnsService *httpdns = self.httpdns;
+    [self benchmark:@"resolve_sync_nonblocking.sockaddr" operations:kCacheBenchmarkOperations block:^(NSUInteger index) {
+        struct sockaddr_storage sockaddrs[4];
+        [httpdns resolveHostSyncNonBlocking:ipv4OnlyHost port:443 byIpType:HttpdnsQueryIPTypeIpv4 sockaddrs:sockaddrs maxCount:4];
+    }];
+}
+
+@end
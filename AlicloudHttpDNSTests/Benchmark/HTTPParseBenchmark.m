@@ -0,0 +1,108 @@
+//
+//  HTTPParseBenchmark.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+#import "HttpdnsBenchmarkCase.h"
+#import "HttpdnsNWHTTPClient.h"
+#import "HttpdnsNWHTTPClient_Internal.h"
+
+static const NSUInteger kHTTPParseBenchmarkOperations = 20000;
+// 模拟网络分片到达时每片的字节数
+static const NSUInteger kHTTPParseFragmentSize = 64;
+
+@interface HTTPParseBenchmark : HttpdnsBenchmarkCase
+
+@property (nonatomic, strong) HttpdnsNWHTTPClient *client;
+@property (nonatomic, copy) NSData *plainResponse;
+@property (nonatomic, copy) NSData *chunkedResponse;
+
+@end
+
+@implementation HTTPParseBenchmark
+
+- (void)setUp {
+    [super setUp];
+
+    self.client = [HttpdnsNWHTTPClient sharedInstance];
+
+    NSString *body = @"{\"code\":\"success\",\"mode\":0,\"data\":{\"answers\":[{\"dn\":\"www.aliyun.com\",\"v4\":{\"ips\":[\"1.1.1.1\",\"2.2.2.2\"],\"ttl\":60}}]}}";
+    NSString *plain = [NSString stringWithFormat:@"HTTP/1.1 200 OK\r\n"
+                       @"Content-Type: application/json\r\n"
+                       @"Content-Length: %lu\r\n"
+                       @"Connection: keep-alive\r\n"
+                       @"Server: Tengine\r\n"
+                       @"\r\n%@", (unsigned long)body.length, body];
+    self.plainResponse = [plain dataUsingEncoding:NSUTF8StringEncoding];
+
+    NSMutableString *chunked = [NSMutableString stringWithString:@"HTTP/1.1 200 OK\r\n"
+                                @"Content-Type: application/json\r\n"
+                                @"Transfer-Encoding: chunked\r\n"
+                                @"Connection: keep-alive\r\n"
+                                @"\r\n"];
+    // 按32字节分块，覆盖多块拼接
+    for (NSUInteger offset = 0; offset < body.length; offset += 32) {
+        NSString *chunk = [body substringWithRange:NSMakeRange(offset, MIN(32, body.length - offset))];
+        [chunked appendFormat:@"%lx\r\n%@\r\n", (unsigned long)chunk.length, chunk];
+    }
+    [chunked appendString:@"0\r\n\r\n"];
+    self.chunkedResponse = [chunked dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+- (void)testParsePlainResponse {
+    HttpdnsNWHTTPClient *client = self.client;
+    NSData *response = self.plainResponse;
+    [self benchmark:@"http_parse.plain" operations:kHTTPParseBenchmarkOperations block:^(NSUInteger index) {
+        NSInteger statusCode = 0;
+        NSData *body = nil;
+        [client parseHTTPResponseData:response statusCode:&statusCode headers:nil body:&body error:nil];
+    }];
+}
+
+- (void)testParseChunkedResponse {
+    HttpdnsNWHTTPClient *client = self.client;
+    NSData *response = self.chunkedResponse;
+    [self benchmark:@"http_parse.chunked" operations:kHTTPParseBenchmarkOperations block:^(NSUInteger index) {
+        NSInteger statusCode = 0;
+        NSData *body = nil;
+        [client parseHTTPResponseData:response statusCode:&statusCode headers:nil body:&body error:nil];
+    }];
+}
+
+- (void)testParseFragmentedResponse {
+    HttpdnsNWHTTPClient *client = self.client;
+    NSData *response = self.chunkedResponse;
+
+    // 与连接收包时的流程一致：每收到一片就尝试解析头部，头部完整后检查分块是否收齐，最后整体解析
+    [self benchmark:@"http_parse.fragmented" operations:kHTTPParseBenchmarkOperations block:^(NSUInteger index) {
+        NSMutableData *buffer = [NSMutableData dataWithCapacity:response.length];
+        NSUInteger headerEndIndex = NSNotFound;
+        BOOL headerParsed = NO;
+        BOOL finished = NO;
+        for (NSUInteger offset = 0; offset < response.length && !finished; offset += kHTTPParseFragmentSize) {
+            NSUInteger length = MIN(kHTTPParseFragmentSize, response.length - offset);
+            [buffer appendBytes:(const uint8_t *)response.bytes + offset length:length];
+            if (!headerParsed) {
+                headerParsed = [client tryParseHTTPHeadersInData:buffer
+                                                  headerEndIndex:&headerEndIndex
+                                                      statusCode:nil
+                                                         headers:nil
+                                                           error:nil] == HttpdnsHTTPHeaderParseResultSuccess;
+            }
+            if (headerParsed) {
+                finished = [client checkChunkedBodyCompletionInData:buffer
+                                                     headerEndIndex:headerEndIndex
+                                                              error:nil] == HttpdnsHTTPChunkParseResultSuccess;
+            }
+        }
+        NSData *body = nil;
+        [client parseHTTPResponseData:buffer statusCode:nil headers:nil body:&body error:nil];
+    }];
+}
+
+@end
@@ -0,0 +1,48 @@
+//
+//  HttpdnsBenchmarkCase.h
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "TestBase.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// 输出文件路径的环境变量，未设置时写到临时目录下的httpdns_benchmark.jsonl
+static NSString *const HttpdnsBenchmarkOutputEnvKey = @"HTTPDNS_BENCHMARK_OUTPUT";
+
+/**
+ * 微基准测试基类
+ *
+ * 每个基准先预热，再跑固定轮数，每轮执行operations次被测代码，按轮统计每次操作的耗时。
+ * 结果以JSON Lines格式追加到输出文件，同时以"[HttpdnsBenchmark] "前缀打印到控制台，
+ * 便于在不同版本之间比较。
+ */
+@interface HttpdnsBenchmarkCase : TestBase
+
+/**
+ * @param name 基准名称，同一名称在不同版本之间应保持不变
+ * @param threads 并发线程数，大于1时每轮的operations在各线程间平分
+ * @param operations 每轮执行的总次数
+ * @param block 被测代码，index为本轮内的操作序号
+ */
+- (void)benchmark:(NSString *)name
+          threads:(NSUInteger)threads
+       operations:(NSUInteger)operations
+            block:(void (^)(NSUInteger index))block;
+
+- (void)benchmark:(NSString *)name
+       operations:(NSUInteger)operations
+            block:(void (^)(NSUInteger index))block;
+
+/**
+ * 输出一条自定义指标的结果，用于压测这类不按固定轮数执行的场景
+ * 会补充sdkVersion、configuration、timestamp等公共字段
+ */
+- (void)reportBenchmark:(NSString *)name metrics:(NSDictionary<NSString *, id> *)metrics;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,124 @@
+//
+//  HttpdnsBenchmarkCase.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "HttpdnsBenchmarkCase.h"
+#import "HttpdnsPublicConstant.h"
+#import <time.h>
+
+static const NSUInteger kHttpdnsBenchmarkWarmupRounds = 2;
+static const NSUInteger kHttpdnsBenchmarkMeasuredRounds = 10;
+
+@implementation HttpdnsBenchmarkCase
+
++ (NSString *)outputPath {
+    NSString *path = [NSProcessInfo processInfo].environment[HttpdnsBenchmarkOutputEnvKey];
+    if (path.length > 0) {
+        return path;
+    }
+    return [NSTemporaryDirectory() stringByAppendingPathComponent:@"httpdns_benchmark.jsonl"];
+}
+
++ (void)appendRecord:(NSDictionary *)record {
+    NSData *json = [NSJSONSerialization dataWithJSONObject:record options:NSJSONWritingSortedKeys error:nil];
+    if (!json) {
+        return;
+    }
+    NSString *line = [[NSString alloc] initWithData:json encoding:NSUTF8StringEncoding];
+    NSLog(@"[HttpdnsBenchmark] %@", line);
+
+    @synchronized (self) {
+        NSString *path = [self outputPath];
+        if (![[NSFileManager defaultManager] fileExistsAtPath:path]) {
+            [[NSFileManager defaultManager] createFileAtPath:path contents:nil attributes:nil];
+        }
+        NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingAtPath:path];
+        [fileHandle seekToEndOfFile];
+        [fileHandle writeData:json];
+        [fileHandle writeData:[@"\n" dataUsingEncoding:NSUTF8StringEncoding]];
+        [fileHandle closeFile];
+    }
+}
+
+- (uint64_t)runRoundWithThreads:(NSUInteger)threads
+                     operations:(NSUInteger)operations
+                          block:(void (^)(NSUInteger index))block {
+    uint64_t startTime = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    if (threads <= 1) {
+        for (NSUInteger i = 0; i < operations; i++) {
+            @autoreleasepool {
+                block(i);
+            }
+        }
+    } else {
+        NSUInteger operationsPerThread = operations / threads;
+        dispatch_apply(threads, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t threadIndex) {
+            NSUInteger base = threadIndex * operationsPerThread;
+            for (NSUInteger i = 0; i < operationsPerThread; i++) {
+                @autoreleasepool {
+                    block(base + i);
+                }
+            }
+        });
+    }
+    return clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - startTime;
+}
+
+- (void)benchmark:(NSString *)name
+          threads:(NSUInteger)threads
+       operations:(NSUInteger)operations
+            block:(void (^)(NSUInteger index))block {
+    threads = MAX(threads, 1);
+    operations = MAX(operations / threads, 1) * threads;
+
+    for (NSUInteger round = 0; round < kHttpdnsBenchmarkWarmupRounds; round++) {
+        [self runRoundWithThreads:threads operations:operations block:block];
+    }
+
+    NSMutableArray<NSNumber *> *nsPerOperation = [NSMutableArray arrayWithCapacity:kHttpdnsBenchmarkMeasuredRounds];
+    for (NSUInteger round = 0; round < kHttpdnsBenchmarkMeasuredRounds; round++) {
+        uint64_t elapsed = [self runRoundWithThreads:threads operations:operations block:block];
+        [nsPerOperation addObject:@((double)elapsed / operations)];
+    }
+    [nsPerOperation sortUsingSelector:@selector(compare:)];
+
+    double median = nsPerOperation[kHttpdnsBenchmarkMeasuredRounds / 2].doubleValue;
+    NSUInteger p90Index = MIN((NSUInteger)ceil(kHttpdnsBenchmarkMeasuredRounds * 0.9), kHttpdnsBenchmarkMeasuredRounds) - 1;
+
+    [self reportBenchmark:name metrics:@{
+        @"threads": @(threads),
+        @"operationsPerRound": @(operations),
+        @"rounds": @(kHttpdnsBenchmarkMeasuredRounds),
+        @"nsPerOpMin": nsPerOperation.firstObject,
+        @"nsPerOpMedian": @(median),
+        @"nsPerOpP90": nsPerOperation[p90Index],
+        @"opsPerSecond": @(median > 0 ? 1e9 / median : 0),
+    }];
+}
+
+- (void)benchmark:(NSString *)name
+       operations:(NSUInteger)operations
+            block:(void (^)(NSUInteger index))block {
+    [self benchmark:name threads:1 operations:operations block:block];
+}
+
+- (void)reportBenchmark:(NSString *)name metrics:(NSDictionary<NSString *, id> *)metrics {
+#if DEBUG
+    NSString *configuration = @"Debug";
+#else
+    NSString *configuration = @"Release";
+#endif
+
+    NSMutableDictionary *record = [metrics mutableCopy];
+    record[@"name"] = name;
+    record[@"sdkVersion"] = HTTPDNS_IOS_SDK_VERSION;
+    record[@"configuration"] = configuration;
+    record[@"timestamp"] = @((int64_t)[[NSDate date] timeIntervalSince1970]);
+    [[self class] appendRecord:record];
+}
+
+@end
@@ -0,0 +1,102 @@
+//
+//  PersistenceBenchmark.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+#import "HttpdnsBenchmarkCase.h"
+#import "HttpdnsDB.h"
+#import "HttpdnsHostObject.h"
+#import "HttpdnsHostRecord.h"
+
+static const NSInteger kBenchmarkAccountId = 999997;
+static const NSUInteger kBenchmarkRecordCount = 200;
+
+@interface PersistenceBenchmark : HttpdnsBenchmarkCase
+
+@property (nonatomic, strong) HttpdnsDB *db;
+@property (nonatomic, copy) NSArray<HttpdnsHostRecord *> *records;
+
+@end
+
+@implementation PersistenceBenchmark
+
+- (void)setUp {
+    [super setUp];
+
+    self.currentTimeStamp = [[NSDate date] timeIntervalSince1970];
+    self.db = [[HttpdnsDB alloc] initWithAccountId:kBenchmarkAccountId];
+    [self.db deleteAll];
+
+    NSMutableArray<HttpdnsHostRecord *> *records = [NSMutableArray arrayWithCapacity:kBenchmarkRecordCount];
+    for (NSUInteger i = 0; i < kBenchmarkRecordCount; i++) {
+        HttpdnsHostObject *hostObject = [self constructSimpleIpv4AndIpv6HostObject];
+        hostObject.hostName = [NSString stringWithFormat:@"host%lu.onlyfortest.com", (unsigned long)i];
+        hostObject.cacheKey = hostObject.hostName;
+        [records addObject:[hostObject toDBRecord]];
+    }
+    self.records = records;
+}
+
+- (void)tearDown {
+    [self.db deleteAll];
+    [super tearDown];
+}
+
+- (void)testUpsert {
+    HttpdnsDB *db = self.db;
+    NSArray<HttpdnsHostRecord *> *records = self.records;
+    [self benchmark:@"db.upsert" operations:kBenchmarkRecordCount block:^(NSUInteger index) {
+        [db createOrUpdate:records[index % records.count]];
+    }];
+}
+
+- (void)testBatchUpsert {
+    HttpdnsDB *db = self.db;
+    NSArray<HttpdnsHostRecord *> *records = self.records;
+    // 每次操作写入整批记录
+    [self benchmark:@"db.upsert_batch_200" operations:20 block:^(NSUInteger index) {
+        [db createOrUpdateBatch:records];
+    }];
+}
+
+- (void)testLoad {
+    HttpdnsDB *db = self.db;
+    NSArray<HttpdnsHostRecord *> *records = self.records;
+    XCTAssertTrue([db createOrUpdateBatch:records]);
+
+    [self benchmark:@"db.select_by_cache_key" operations:kBenchmarkRecordCount block:^(NSUInteger index) {
+        [HttpdnsHostObject fromDBRecord:[db selectByCacheKey:records[index % records.count].cacheKey]];
+    }];
+    [self benchmark:@"db.load_all_200" operations:20 block:^(NSUInteger index) {
+        for (HttpdnsHostRecord *record in [db getAllRecords]) {
+            [HttpdnsHostObject fromDBRecord:record];
+        }
+    }];
+}
+
+- (void)testUpdateConnectedRTSorting {
+    HttpdnsHostObject *hostObject = [HttpdnsHostObject new];
+    hostObject.hostName = ipv4OnlyHost;
+    NSMutableArray<HttpdnsIpObject *> *ipObjects = [NSMutableArray array];
+    NSMutableArray<NSString *> *ips = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 8; i++) {
+        HttpdnsIpObject *ipObject = [HttpdnsIpObject new];
+        NSString *ip = [NSString stringWithFormat:@"10.0.0.%lu", (unsigned long)i + 1];
+        [ipObject setIp:ip];
+        [ipObjects addObject:ipObject];
+        [ips addObject:ip];
+    }
+    hostObject.v4Ips = ipObjects;
+
+    [self benchmark:@"host_object.update_connected_rt" operations:100000 block:^(NSUInteger index) {
+        // 耗时在IP之间轮换，确保每次更新都可能改变排序
+        [hostObject updateConnectedRT:(NSInteger)((index * 37) % 200) forIP:ips[index % ips.count]];
+    }];
+}
+
+@end
@@ -0,0 +1,255 @@
+//
+//  ResolveReplayTest.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+#import "HttpdnsBenchmarkCase.h"
+#import "HttpdnsMetrics.h"
+#import "HttpdnsNWHTTPClient.h"
+#import "HttpdnsRequestManager.h"
+#import "HttpdnsResolveRecorder.h"
+#import "HttpdnsScheduleCenter.h"
+#import "HttpdnsService.h"
+#import "HttpdnsService_Internal.h"
+#import "HttpdnsVirtualClock.h"
+
+// 回放使用的环境变量，只有记录文件必须设置
+static NSString *const kReplayFileEnvKey = @"HTTPDNS_REPLAY_FILE";
+static NSString *const kReplayServerEnvKey = @"HTTPDNS_REPLAY_SERVER";
+static NSString *const kReplaySecretKeyEnvKey = @"HTTPDNS_REPLAY_SECRET_KEY";
+
+static const NSInteger kReplayAccountId = 100001;
+static NSString *const kReplayDefaultServer = @"127.0.0.1:11180";
+static NSString *const kReplayDefaultSecretKey = @"00112233445566778899aabbccddeeff";
+
+// 预解析的热门域名数，不超过SDK管理的域名上限
+static const NSUInteger kReplayPreResolveHostCount = 50;
+
+@interface ResolveReplayTest : HttpdnsBenchmarkCase
+
+@property (nonatomic, copy) NSString *server;
+@property (nonatomic, strong) id mockScheduleCenter;
+
+@end
+
+@implementation ResolveReplayTest
+
+- (void)setUp {
+    [super setUp];
+
+    NSDictionary<NSString *, NSString *> *environment = [NSProcessInfo processInfo].environment;
+    self.server = environment[kReplayServerEnvKey] ?: kReplayDefaultServer;
+
+    self.httpdns = [[HttpDnsService alloc] initWithAccountID:kReplayAccountId
+                                                   secretKey:environment[kReplaySecretKeyEnvKey] ?: kReplayDefaultSecretKey];
+    [self.httpdns setLogEnabled:NO];
+    [self.httpdns setNetworkingTimeoutInterval:5];
+    [self presetNetworkEnvAsIpv4];
+
+    self.mockScheduleCenter = OCMPartialMock(self.httpdns.scheduleCenter);
+    OCMStub([self.mockScheduleCenter currentActiveServiceServerV4Host]).andReturn(self.server);
+}
+
+- (void)tearDown {
+    HttpdnsClockSetCurrent(nil);
+    [self.httpdns setReuseExpiredIPEnabled:NO];
+    [self.httpdns cleanAllHostCache];
+    [self.mockScheduleCenter stopMocking];
+    [super tearDown];
+}
+
+- (BOOL)isServerReachable {
+    NSString *url = [NSString stringWithFormat:@"http://%@/admin/stats", self.server];
+    HttpdnsNWHTTPClientResponse *response = [[HttpdnsNWHTTPClient sharedInstance] performRequestWithURLString:url
+                                                                                                      userAgent:@"ResolveReplayTest"
+                                                                                                        timeout:1
+                                                                                                          error:nil];
+    return response.statusCode == 200;
+}
+
+- (NSData *)loadRecordsFromFile:(NSString *)path {
+    NSData *data = [NSData dataWithContentsOfFile:path];
+    if (data.length < sizeof(HttpdnsResolveRecordFileHeader)) {
+        return nil;
+    }
+
+    HttpdnsResolveRecordFileHeader header;
+    [data getBytes:&header length:sizeof(header)];
+    if (memcmp(header.magic, HTTPDNS_RESOLVE_RECORD_MAGIC, sizeof(header.magic)) != 0
+        || header.version != HTTPDNS_RESOLVE_RECORD_VERSION
+        || header.recordSize != sizeof(HttpdnsResolveRecord)) {
+        return nil;
+    }
+
+    // 记录过程中被中断的文件，末尾可能有不完整的记录
+    NSUInteger recordCount = (data.length - sizeof(header)) / sizeof(HttpdnsResolveRecord);
+    return [data subdataWithRange:NSMakeRange(sizeof(header), recordCount * sizeof(HttpdnsResolveRecord))];
+}
+
+static NSString *HttpdnsReplayHostName(uint64_t hostHash) {
+    // 模拟服务按域名生成结果，哈希相同的记录落到同一个域名上，保留原始的访问分布
+    return [NSString stringWithFormat:@"r%016llx.replay.onlyfortest.com", hostHash];
+}
+
+- (NSArray<NSString *> *)mostFrequentHostsInRecords:(NSData *)records limit:(NSUInteger)limit {
+    NSCountedSet<NSNumber *> *hostHashes = [NSCountedSet set];
+    const HttpdnsResolveRecord *record = records.bytes;
+    NSUInteger recordCount = records.length / sizeof(HttpdnsResolveRecord);
+    for (NSUInteger i = 0; i < recordCount; i++) {
+        [hostHashes addObject:@(record[i].hostHash)];
+    }
+
+    NSArray<NSNumber *> *sortedHostHashes = [hostHashes.allObjects sortedArrayUsingComparator:^NSComparisonResult(NSNumber *lhs, NSNumber *rhs) {
+        NSUInteger lhsCount = [hostHashes countForObject:lhs];
+        NSUInteger rhsCount = [hostHashes countForObject:rhs];
+        if (lhsCount != rhsCount) {
+            return lhsCount > rhsCount ? NSOrderedAscending : NSOrderedDescending;
+        }
+        return [lhs compare:rhs];
+    }];
+
+    NSMutableArray<NSString *> *hosts = [NSMutableArray array];
+    for (NSNumber *hostHash in [sortedHostHashes subarrayWithRange:NSMakeRange(0, MIN(limit, sortedHostHashes.count))]) {
+        [hosts addObject:HttpdnsReplayHostName(hostHash.unsignedLongLongValue)];
+    }
+    return hosts;
+}
+
+static double HttpdnsReplayPercentile(const uint64_t *sortedLatencies, NSUInteger count, double percentile) {
+    if (count == 0) {
+        return 0;
+    }
+    NSUInteger index = MIN((NSUInteger)ceil(percentile / 100.0 * count), count) - 1;
+    return sortedLatencies[index] / 1000.0;
+}
+
+static int HttpdnsReplayCompareLatency(const void *lhs, const void *rhs) {
+    uint64_t left = *(const uint64_t *)lhs;
+    uint64_t right = *(const uint64_t *)rhs;
+    return left < right ? -1 : (left > right ? 1 : 0);
+}
+
+- (void)reportRecordedBaseline:(NSData *)records {
+    const HttpdnsResolveRecord *record = records.bytes;
+    NSUInteger recordCount = records.length / sizeof(HttpdnsResolveRecord);
+    NSUInteger hitCount = 0;
+    uint64_t *latencies = malloc(sizeof(uint64_t) * MAX(recordCount, 1));
+    for (NSUInteger i = 0; i < recordCount; i++) {
+        if (record[i].outcome != HttpdnsResolveRecordOutcomeMiss) {
+            hitCount++;
+        }
+        latencies[i] = record[i].latency;
+    }
+    qsort(latencies, recordCount, sizeof(uint64_t), HttpdnsReplayCompareLatency);
+
+    [self reportBenchmark:@"resolve_replay.recorded" metrics:@{
+        @"events": @(recordCount),
+        @"durationSeconds": @(recordCount > 0 ? record[recordCount - 1].timestamp / 1000.0 : 0),
+        @"hitRatio": @(recordCount > 0 ? (double)hitCount / recordCount : 0),
+        @"p50Ms": @(HttpdnsReplayPercentile(latencies, recordCount, 50)),
+        @"p99Ms": @(HttpdnsReplayPercentile(latencies, recordCount, 99)),
+        @"p999Ms": @(HttpdnsReplayPercentile(latencies, recordCount, 99.9)),
+    }];
+    free(latencies);
+}
+
+// 按记录的相对时间在虚拟时钟上依次发起解析，TTL过期等计时逻辑与线上一致，网络请求真实发往模拟服务
+- (void)replayRecords:(NSData *)records configuration:(NSString *)configuration setup:(void (^)(void))setup {
+    [self.httpdns cleanAllHostCache];
+    HttpdnsVirtualClock *clock = [HttpdnsVirtualClock new];
+    [clock install];
+    NSTimeInterval startTime = clock.now;
+    if (setup) {
+        setup();
+    }
+
+    HttpdnsStatistics *before = [self.httpdns statisticsSnapshot];
+    const HttpdnsResolveRecord *record = records.bytes;
+    NSUInteger recordCount = records.length / sizeof(HttpdnsResolveRecord);
+    uint64_t *latencies = malloc(sizeof(uint64_t) * MAX(recordCount, 1));
+    NSUInteger answeredCount = 0;
+    uint64_t wallClockStartTime = HttpdnsMetricsNow();
+
+    for (NSUInteger i = 0; i < recordCount; i++) {
+        @autoreleasepool {
+            [clock advanceTo:startTime + record[i].timestamp / 1000.0];
+
+            NSString *host = HttpdnsReplayHostName(record[i].hostHash);
+            HttpdnsQueryIPType queryIpType = record[i].queryIpType;
+            uint64_t requestStartTime = HttpdnsMetricsNow();
+            HttpdnsResult *result = (record[i].flags & HttpdnsResolveRecordFlagBlocking)
+                ? [self.httpdns resolveHostSync:host byIpType:queryIpType]
+                : [self.httpdns resolveHostSyncNonBlocking:host byIpType:queryIpType];
+            latencies[i] = (HttpdnsMetricsNow() - requestStartTime) / NSEC_PER_USEC;
+            if (result) {
+                answeredCount++;
+            }
+
+            // 异步解析完成后再推进时钟，保证回放结果与线程调度无关
+            [self.httpdns.requestManager waitForAsyncResolveTasks];
+        }
+    }
+
+    double elapsedSeconds = (double)(HttpdnsMetricsNow() - wallClockStartTime) / NSEC_PER_SEC;
+    HttpdnsStatistics *after = [self.httpdns statisticsSnapshot];
+    [clock uninstall];
+    qsort(latencies, recordCount, sizeof(uint64_t), HttpdnsReplayCompareLatency);
+
+    NSUInteger hitCount = (after.cacheHitCount - before.cacheHitCount) + (after.staleServeCount - before.staleServeCount);
+    NSUInteger lookupCount = hitCount + (after.cacheMissCount - before.cacheMissCount);
+    NSString *name = [NSString stringWithFormat:@"resolve_replay.%@", configuration];
+    [self reportBenchmark:name metrics:@{
+        @"events": @(recordCount),
+        @"wallClockSeconds": @(elapsedSeconds),
+        @"networkRequests": @(after.networkRequestCount - before.networkRequestCount),
+        @"networkFailures": @(after.networkFailureCount - before.networkFailureCount),
+        @"hitRatio": @(lookupCount > 0 ? (double)hitCount / lookupCount : 0),
+        @"answerRatio": @(recordCount > 0 ? (double)answeredCount / recordCount : 0),
+        @"p50Ms": @(HttpdnsReplayPercentile(latencies, recordCount, 50)),
+        @"p99Ms": @(HttpdnsReplayPercentile(latencies, recordCount, 99)),
+        @"p999Ms": @(HttpdnsReplayPercentile(latencies, recordCount, 99.9)),
+        @"maxMs": @(recordCount > 0 ? latencies[recordCount - 1] / 1000.0 : 0),
+    }];
+    free(latencies);
+}
+
+- (void)testReplayRecordedTraffic {
+    NSString *path = [NSProcessInfo processInfo].environment[kReplayFileEnvKey];
+    if (path.length == 0) {
+        XCTSkip(@"未设置%@，先在App中通过startRecordingResolveEventsToPath:error:采集记录", kReplayFileEnvKey);
+    }
+    if (![self isServerReachable]) {
+        XCTSkip(@"模拟服务未启动，先运行 Network/mock_httpdns_server.py");
+    }
+
+    NSData *records = [self loadRecordsFromFile:path];
+    XCTAssertNotNil(records, @"记录文件格式不正确: %@", path);
+    if (!records) {
+        return;
+    }
+    [self reportRecordedBaseline:records];
+
+    [self replayRecords:records configuration:@"baseline" setup:^{
+        [self.httpdns setReuseExpiredIPEnabled:NO];
+    }];
+
+    // 过期结果先返回再异步刷新，相当于提前刷新
+    [self replayRecords:records configuration:@"reuse_expired_ip" setup:^{
+        [self.httpdns setReuseExpiredIPEnabled:YES];
+    }];
+
+    // 启动时按批预解析记录中最热门的域名
+    NSArray<NSString *> *hotHosts = [self mostFrequentHostsInRecords:records limit:kReplayPreResolveHostCount];
+    [self replayRecords:records configuration:@"pre_resolve_hot_hosts" setup:^{
+        [self.httpdns setReuseExpiredIPEnabled:NO];
+        [self.httpdns.requestManager preResolveHosts:hotHosts queryType:HttpdnsQueryIPTypeIpv4];
+        [self.httpdns.requestManager waitForAsyncResolveTasks];
+    }];
+}
+
+@end
@@ -0,0 +1,103 @@
+//
+//  ResolveResponseBenchmark.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+#import "HttpdnsBenchmarkCase.h"
+#import "HttpdnsRemoteResolver.h"
+#import "HttpdnsUtil.h"
+
+static const NSUInteger kResolveResponseBenchmarkOperations = 20000;
+static NSString *const kBenchmarkAesKey = @"0123456789abcdef0123456789abcdef";
+static NSString *const kBenchmarkSecretKey = @"benchmark-secret-key";
+
+@interface HttpdnsRemoteResolver (ResolveResponseBenchmark)
+
+- (NSArray<HttpdnsHostObject *> *)parseHttpdnsResponse:(NSDictionary *)json withQueryIpType:(HttpdnsQueryIPType)queryIpType;
+
+- (NSString *)calculateSignatureForParams:(NSDictionary *)params withSecretKey:(NSString *)secretKey;
+
+@end
+
+@interface ResolveResponseBenchmark : HttpdnsBenchmarkCase
+
+@end
+
+@implementation ResolveResponseBenchmark
+
++ (void)setUp {
+    [super setUp];
+
+    HttpDnsService *httpdns = [[HttpDnsService alloc] initWithAccountID:100000];
+    [httpdns setLogEnabled:NO];
+}
+
+// 与/v2/d的响应格式一致，包含批量解析时的多个answer
+- (NSData *)v2ResponseBodyWithAnswerCount:(NSUInteger)answerCount {
+    NSMutableArray *answers = [NSMutableArray arrayWithCapacity:answerCount];
+    for (NSUInteger i = 0; i < answerCount; i++) {
+        [answers addObject:@{
+            @"dn": [NSString stringWithFormat:@"host%lu.onlyfortest.com", (unsigned long)i],
+            @"v4": @{@"ips": @[@"1.1.1.1", @"2.2.2.2", @"3.3.3.3"], @"ttl": @60},
+            @"v6": @{@"ips": @[@"2001:4860:4860::8888", @"2001:4860:4860::8844"], @"ttl": @60},
+            @"data": @{@"cip": @"42.120.74.100"},
+        }];
+    }
+    NSDictionary *json = @{@"code": @"success", @"mode": @0, @"data": @{@"answers": answers}};
+    return [NSJSONSerialization dataWithJSONObject:json options:0 error:nil];
+}
+
+- (void)benchmarkJSONParseWithAnswerCount:(NSUInteger)answerCount {
+    HttpdnsRemoteResolver *resolver = [HttpdnsRemoteResolver new];
+    NSData *body = [self v2ResponseBodyWithAnswerCount:answerCount];
+    NSString *name = [NSString stringWithFormat:@"v2d_json_parse.answers_%lu", (unsigned long)answerCount];
+    [self benchmark:name operations:kResolveResponseBenchmarkOperations / answerCount block:^(NSUInteger index) {
+        NSDictionary *json = [NSJSONSerialization JSONObjectWithData:body options:kNilOptions error:nil];
+        [resolver parseHttpdnsResponse:json withQueryIpType:HttpdnsQueryIPTypeBoth];
+    }];
+}
+
+- (void)testJSONParseSingleAnswer {
+    [self benchmarkJSONParseWithAnswerCount:1];
+}
+
+- (void)testJSONParseBatchAnswers {
+    [self benchmarkJSONParseWithAnswerCount:5];
+}
+
+- (void)testSign {
+    HttpdnsRemoteResolver *resolver = [HttpdnsRemoteResolver new];
+    NSDictionary *params = @{
+        @"dn": @"www.aliyun.com",
+        @"q": @"4,6",
+        @"sid": @"benchmarksession",
+        @"exp": @"1745900000",
+    };
+    [self benchmark:@"sign.hmac_sha256" operations:kResolveResponseBenchmarkOperations block:^(NSUInteger index) {
+        [resolver calculateSignatureForParams:params withSecretKey:kBenchmarkSecretKey];
+    }];
+}
+
+- (void)testEncrypt {
+    NSData *key = [HttpdnsUtil dataFromHexString:kBenchmarkAesKey];
+    NSData *plaintext = [@"{\"dn\":\"www.aliyun.com\",\"q\":\"4,6\",\"sdns-a\":\"b\"}" dataUsingEncoding:NSUTF8StringEncoding];
+    [self benchmark:@"crypto.aes_cbc_encrypt" operations:kResolveResponseBenchmarkOperations block:^(NSUInteger index) {
+        [HttpdnsUtil encryptDataAESCBC:plaintext withKey:key error:nil];
+    }];
+}
+
+- (void)testDecrypt {
+    NSData *key = [HttpdnsUtil dataFromHexString:kBenchmarkAesKey];
+    NSData *ciphertext = [HttpdnsUtil encryptDataAESCBC:[self v2ResponseBodyWithAnswerCount:1] withKey:key error:nil];
+    XCTAssertNotNil(ciphertext);
+    [self benchmark:@"crypto.aes_cbc_decrypt" operations:kResolveResponseBenchmarkOperations block:^(NSUInteger index) {
+        [HttpdnsUtil decryptDataAESCBC:ciphertext withKey:key error:nil];
+    }];
+}
+
+@end
@@ -0,0 +1,184 @@
+//
+//  ResolverLoadTest.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+#import "HttpdnsBenchmarkCase.h"
+#import "HttpdnsNWHTTPClient.h"
+#import "HttpdnsRemoteResolver.h"
+#import "HttpdnsRequest_Internal.h"
+#import "HttpdnsScheduleCenter.h"
+#import "HttpdnsService.h"
+#import "HttpdnsService_Internal.h"
+#import <time.h>
+
+// 压测使用的环境变量，均可不设置
+static NSString *const kLoadTestServerEnvKey = @"HTTPDNS_LOADTEST_SERVER";
+static NSString *const kLoadTestClientsEnvKey = @"HTTPDNS_LOADTEST_CLIENTS";
+static NSString *const kLoadTestDurationEnvKey = @"HTTPDNS_LOADTEST_DURATION";
+static NSString *const kLoadTestSecretKeyEnvKey = @"HTTPDNS_LOADTEST_SECRET_KEY";
+static NSString *const kLoadTestAesKeyEnvKey = @"HTTPDNS_LOADTEST_AES_KEY";
+
+static const NSInteger kLoadTestAccountId = 100001;
+static NSString *const kLoadTestDefaultServer = @"127.0.0.1:11180";
+static NSString *const kLoadTestDefaultSecretKey = @"00112233445566778899aabbccddeeff";
+
+@interface ResolverLoadTest : HttpdnsBenchmarkCase
+
+@property (nonatomic, copy) NSString *server;
+@property (nonatomic, strong) id mockScheduleCenter;
+
+@end
+
+@implementation ResolverLoadTest
+
+- (void)setUp {
+    [super setUp];
+
+    NSDictionary<NSString *, NSString *> *environment = [NSProcessInfo processInfo].environment;
+    self.server = environment[kLoadTestServerEnvKey] ?: kLoadTestDefaultServer;
+    NSString *secretKey = environment[kLoadTestSecretKeyEnvKey] ?: kLoadTestDefaultSecretKey;
+
+    self.httpdns = [[HttpDnsService alloc] initWithAccountID:kLoadTestAccountId
+                                                   secretKey:secretKey
+                                                aesSecretKey:environment[kLoadTestAesKeyEnvKey]];
+    [self.httpdns setLogEnabled:NO];
+    [self.httpdns setNetworkingTimeoutInterval:5];
+    [self presetNetworkEnvAsIpv4];
+
+    // 所有解析请求都指向本地模拟服务
+    self.mockScheduleCenter = OCMPartialMock(self.httpdns.scheduleCenter);
+    OCMStub([self.mockScheduleCenter currentActiveServiceServerV4Host]).andReturn(self.server);
+}
+
+- (void)tearDown {
+    [self.mockScheduleCenter stopMocking];
+    [super tearDown];
+}
+
+- (BOOL)isServerReachable {
+    NSString *url = [NSString stringWithFormat:@"http://%@/admin/stats", self.server];
+    HttpdnsNWHTTPClientResponse *response = [[HttpdnsNWHTTPClient sharedInstance] performRequestWithURLString:url
+                                                                                                      userAgent:@"ResolverLoadTest"
+                                                                                                        timeout:1
+                                                                                                          error:nil];
+    return response.statusCode == 200;
+}
+
+- (NSArray<NSNumber *> *)clientCounts {
+    NSString *value = [NSProcessInfo processInfo].environment[kLoadTestClientsEnvKey] ?: @"1,8,32";
+    NSMutableArray<NSNumber *> *counts = [NSMutableArray array];
+    for (NSString *component in [value componentsSeparatedByString:@","]) {
+        if (component.integerValue > 0) {
+            [counts addObject:@(component.integerValue)];
+        }
+    }
+    return counts;
+}
+
+static double HttpdnsLoadTestPercentile(const uint64_t *sortedLatencies, NSUInteger count, double percentile) {
+    if (count == 0) {
+        return 0;
+    }
+    NSUInteger index = MIN((NSUInteger)ceil(percentile / 100.0 * count), count) - 1;
+    return sortedLatencies[index] / 1000.0;
+}
+
+static int HttpdnsLoadTestCompareLatency(const void *lhs, const void *rhs) {
+    uint64_t left = *(const uint64_t *)lhs;
+    uint64_t right = *(const uint64_t *)rhs;
+    return left < right ? -1 : (left > right ? 1 : 0);
+}
+
+- (void)runLoadWithClients:(NSUInteger)clients duration:(NSTimeInterval)duration {
+    NSMutableArray<NSMutableData *> *latenciesPerClient = [NSMutableArray arrayWithCapacity:clients];
+    NSMutableArray<NSNumber *> *errorsPerClient = [NSMutableArray arrayWithCapacity:clients];
+    for (NSUInteger i = 0; i < clients; i++) {
+        [latenciesPerClient addObject:[NSMutableData data]];
+        [errorsPerClient addObject:@0];
+    }
+
+    uint64_t startTime = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    uint64_t deadline = startTime + (uint64_t)(duration * NSEC_PER_SEC);
+    dispatch_group_t group = dispatch_group_create();
+
+    // 每个客户端独占一个线程，避免GCD线程池上限影响并发度
+    for (NSUInteger clientIndex = 0; clientIndex < clients; clientIndex++) {
+        dispatch_group_enter(group);
+        NSMutableData *latencies = latenciesPerClient[clientIndex];
+        NSThread *thread = [[NSThread alloc] initWithBlock:^{
+            NSUInteger errorCount = 0;
+            NSUInteger sequence = 0;
+            while (clock_gettime_nsec_np(CLOCK_UPTIME_RAW) < deadline) {
+                @autoreleasepool {
+                    // 每次解析不同的域名，服务端按域名生成结果，客户端不会命中缓存
+                    NSString *host = [NSString stringWithFormat:@"load-%lu-%lu.onlyfortest.com", (unsigned long)clientIndex, (unsigned long)sequence++];
+                    HttpdnsRequest *request = [[HttpdnsRequest alloc] initWithHost:host queryIpType:HttpdnsQueryIPTypeBoth];
+                    request.accountId = kLoadTestAccountId;
+
+                    uint64_t requestStartTime = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+                    NSError *error = nil;
+                    NSArray<HttpdnsHostObject *> *result = [[HttpdnsRemoteResolver new] resolve:request error:&error];
+                    uint64_t latency = (clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - requestStartTime) / NSEC_PER_USEC;
+
+                    if (error || result.count == 0) {
+                        errorCount++;
+                    } else {
+                        [latencies appendBytes:&latency length:sizeof(latency)];
+                    }
+                }
+            }
+            @synchronized (errorsPerClient) {
+                errorsPerClient[clientIndex] = @(errorCount);
+            }
+            dispatch_group_leave(group);
+        }];
+        [thread start];
+    }
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+    double elapsedSeconds = (double)(clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - startTime) / NSEC_PER_SEC;
+
+    NSMutableData *allLatencies = [NSMutableData data];
+    NSUInteger errorCount = 0;
+    for (NSUInteger i = 0; i < clients; i++) {
+        [allLatencies appendData:latenciesPerClient[i]];
+        errorCount += errorsPerClient[i].unsignedIntegerValue;
+    }
+    NSUInteger successCount = allLatencies.length / sizeof(uint64_t);
+    uint64_t *sortedLatencies = allLatencies.mutableBytes;
+    qsort(sortedLatencies, successCount, sizeof(uint64_t), HttpdnsLoadTestCompareLatency);
+
+    NSString *name = [NSString stringWithFormat:@"resolver_load.clients_%lu", (unsigned long)clients];
+    [self reportBenchmark:name metrics:@{
+        @"clients": @(clients),
+        @"durationSeconds": @(elapsedSeconds),
+        @"requests": @(successCount + errorCount),
+        @"errors": @(errorCount),
+        @"throughputPerSecond": @(successCount / elapsedSeconds),
+        @"p50Ms": @(HttpdnsLoadTestPercentile(sortedLatencies, successCount, 50)),
+        @"p99Ms": @(HttpdnsLoadTestPercentile(sortedLatencies, successCount, 99)),
+        @"p999Ms": @(HttpdnsLoadTestPercentile(sortedLatencies, successCount, 99.9)),
+        @"maxMs": @(successCount > 0 ? sortedLatencies[successCount - 1] / 1000.0 : 0),
+    }];
+
+    XCTAssertGreaterThan(successCount, 0, @"%@ 没有成功的解析", name);
+}
+
+- (void)testResolverScaling {
+    if (![self isServerReachable]) {
+        XCTSkip(@"模拟服务未启动，先运行 Network/mock_httpdns_server.py");
+    }
+
+    NSString *durationValue = [NSProcessInfo processInfo].environment[kLoadTestDurationEnvKey];
+    NSTimeInterval duration = durationValue.doubleValue > 0 ? durationValue.doubleValue : 10;
+    for (NSNumber *clients in [self clientCounts]) {
+        [self runLoadWithClients:clients.unsignedIntegerValue duration:duration];
+    }
+}
+
+@end
@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+"""
+比较两次微基准测试的结果
+
+输入为 HttpdnsBenchmarkCase 输出的 JSON Lines 文件，同名基准取各自最后一条记录，
+微基准按 nsPerOpMedian、压测按 p99Ms 计算变化比例，超过阈值时视为回归并以非零状态码退出。
+
+使用方法:
+    python3 compare_benchmark.py baseline.jsonl current.jsonl [--threshold 0.10]
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    results = {}
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line:
+                continue
+            record = json.loads(line)
+            results[record["name"]] = record
+    return results
+
+
+def metric_of(record):
+    return record["nsPerOpMedian"] if "nsPerOpMedian" in record else record["p99Ms"]
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.10, help="允许的耗时增长比例")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+
+    regressions = []
+    print("%-40s %14s %14s %9s" % ("name", "baseline", "current", "change"))
+    for name in sorted(set(baseline) | set(current)):
+        if name not in baseline or name not in current:
+            print("%-40s %s" % (name, "only in " + ("current" if name in current else "baseline")))
+            continue
+        before = metric_of(baseline[name])
+        after = metric_of(current[name])
+        change = (after - before) / before if before > 0 else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions.append(name)
+        print("%-40s %14.1f %14.1f %+8.1f%%%s" % (name, before, after, change * 100, flag))
+
+    if regressions:
+        print("\n%d regression(s) over %.0f%%" % (len(regressions), args.threshold * 100))
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
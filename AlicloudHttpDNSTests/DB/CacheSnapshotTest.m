@@ -0,0 +1,184 @@
+//
+//  CacheSnapshotTest.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/22.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "../Testbase/TestBase.h"
+#import "HttpdnsCacheSnapshot.h"
+#import "HttpdnsDB.h"
+#import "HttpdnsHostRecord.h"
+#import "HttpdnsPersistenceUtils.h"
+
+static const NSInteger kSnapshotTestAccountId = 999997;
+static const NSInteger kSnapshotBenchmarkRecordCount = 1000;
+
+@interface CacheSnapshotTest : TestBase
+
+@property (nonatomic, copy) NSString *snapshotPath;
+
+@end
+
+@implementation CacheSnapshotTest
+
+- (void)setUp {
+    [super setUp];
+
+    self.snapshotPath = [[HttpdnsPersistenceUtils httpdnsDataDirectory] stringByAppendingPathComponent:@"cache_snapshot_test.snapshot"];
+    [[NSFileManager defaultManager] removeItemAtPath:self.snapshotPath error:nil];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:self.snapshotPath error:nil];
+
+    [super tearDown];
+}
+
+- (void)testRebuildAndLookup {
+    HttpdnsCacheSnapshot *snapshot = [[HttpdnsCacheSnapshot alloc] initWithPath:self.snapshotPath];
+    XCTAssertEqual(snapshot.recordCount, 0, @"Missing file should map as an empty snapshot");
+
+    XCTAssertTrue([snapshot rebuildWithRecords:[self createRecords:100]]);
+    XCTAssertEqual(snapshot.recordCount, 100);
+
+    HttpdnsHostRecord *record = [snapshot recordForCacheKey:@"snapshot42.example.com"];
+    XCTAssertNotNil(record);
+    XCTAssertEqualObjects(record.hostName, @"snapshot42.example.com");
+    XCTAssertEqualObjects(record.clientIp, @"192.168.1.1");
+    XCTAssertEqualObjects(record.v4ips, (@[@"10.0.0.42", @"10.0.1.42"]));
+    XCTAssertEqualObjects(record.v6ips, (@[@"2001:db8::2a"]));
+    XCTAssertEqual(record.v4ttl, 300);
+    XCTAssertEqual(record.v4LookupTime, 1042);
+    XCTAssertEqual(record.v6ttl, 600);
+    XCTAssertEqual(record.v6LookupTime, 2042);
+    XCTAssertEqualObjects(record.extra, @"extra42");
+
+    XCTAssertNil([snapshot recordForCacheKey:@"absent.example.com"]);
+}
+
+- (void)testSnapshotSurvivesReopen {
+    HttpdnsCacheSnapshot *snapshot = [[HttpdnsCacheSnapshot alloc] initWithPath:self.snapshotPath];
+    [snapshot rebuildWithRecords:[self createRecords:10]];
+
+    HttpdnsCacheSnapshot *reopened = [[HttpdnsCacheSnapshot alloc] initWithPath:self.snapshotPath];
+    XCTAssertEqual(reopened.recordCount, 10);
+    XCTAssertNotNil([reopened recordForCacheKey:@"snapshot3.example.com"]);
+}
+
+- (void)testRemovedKeysAreMasked {
+    HttpdnsCacheSnapshot *snapshot = [[HttpdnsCacheSnapshot alloc] initWithPath:self.snapshotPath];
+    [snapshot rebuildWithRecords:[self createRecords:10]];
+
+    [snapshot removeRecordForCacheKey:@"snapshot3.example.com"];
+    XCTAssertNil([snapshot recordForCacheKey:@"snapshot3.example.com"]);
+    XCTAssertNotNil([snapshot recordForCacheKey:@"snapshot4.example.com"]);
+
+    [snapshot removeAllRecords];
+    XCTAssertEqual(snapshot.recordCount, 0);
+    XCTAssertNil([snapshot recordForCacheKey:@"snapshot4.example.com"]);
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:self.snapshotPath]);
+}
+
+- (void)testCorruptedFileIsIgnored {
+    HttpdnsCacheSnapshot *snapshot = [[HttpdnsCacheSnapshot alloc] initWithPath:self.snapshotPath];
+    [snapshot rebuildWithRecords:[self createRecords:10]];
+
+    // 截断文件，长度与文件头记录的不一致
+    NSData *data = [NSData dataWithContentsOfFile:self.snapshotPath];
+    [[data subdataWithRange:NSMakeRange(0, data.length / 2)] writeToFile:self.snapshotPath atomically:YES];
+
+    HttpdnsCacheSnapshot *corrupted = [[HttpdnsCacheSnapshot alloc] initWithPath:self.snapshotPath];
+    XCTAssertEqual(corrupted.recordCount, 0);
+    XCTAssertNil([corrupted recordForCacheKey:@"snapshot3.example.com"]);
+}
+
+- (void)testInvalidAndExcessIpsAreDropped {
+    NSMutableArray<NSString *> *v4ips = [NSMutableArray array];
+    for (NSInteger i = 0; i < 12; i++) {
+        [v4ips addObject:[NSString stringWithFormat:@"10.0.0.%ld", (long)i]];
+    }
+    [v4ips insertObject:@"not-an-ip" atIndex:0];
+
+    HttpdnsHostRecord *record = [[HttpdnsHostRecord alloc] initWithId:0
+                                                             cacheKey:@"many.example.com"
+                                                             hostName:@"many.example.com"
+                                                             createAt:nil
+                                                             modifyAt:nil
+                                                             clientIp:nil
+                                                                v4ips:v4ips
+                                                                v4ttl:60
+                                                         v4LookupTime:1
+                                                                v6ips:@[]
+                                                                v6ttl:0
+                                                         v6LookupTime:0
+                                                                extra:nil];
+
+    HttpdnsCacheSnapshot *snapshot = [[HttpdnsCacheSnapshot alloc] initWithPath:self.snapshotPath];
+    [snapshot rebuildWithRecords:@[record]];
+
+    HttpdnsHostRecord *fetched = [snapshot recordForCacheKey:@"many.example.com"];
+    XCTAssertEqual(fetched.v4ips.count, 8, @"Each family keeps at most 8 addresses");
+    XCTAssertEqualObjects(fetched.v4ips.firstObject, @"10.0.0.0");
+    XCTAssertNil(fetched.clientIp);
+    XCTAssertNil(fetched.extra);
+}
+
+#pragma mark - Performance Tests
+
+// 冷启动命中：映射快照后查询一条记录
+- (void)testPerformanceColdStartHitFromSnapshot {
+    HttpdnsCacheSnapshot *snapshot = [[HttpdnsCacheSnapshot alloc] initWithPath:self.snapshotPath];
+    [snapshot rebuildWithRecords:[self createRecords:kSnapshotBenchmarkRecordCount]];
+
+    [self measureBlock:^{
+        HttpdnsCacheSnapshot *coldSnapshot = [[HttpdnsCacheSnapshot alloc] initWithPath:self.snapshotPath];
+        HttpdnsHostRecord *record = [coldSnapshot recordForCacheKey:@"snapshot500.example.com"];
+        XCTAssertNotNil(record);
+    }];
+}
+
+// 对照组：打开数据库后查询同一条记录
+- (void)testPerformanceColdStartHitFromDB {
+    HttpdnsDB *db = [[HttpdnsDB alloc] initWithAccountId:kSnapshotTestAccountId];
+    [db deleteAll];
+    [db createOrUpdateBatch:[self createRecords:kSnapshotBenchmarkRecordCount]];
+    db = nil;
+
+    [self measureBlock:^{
+        HttpdnsDB *coldDB = [[HttpdnsDB alloc] initWithAccountId:kSnapshotTestAccountId];
+        HttpdnsHostRecord *record = [coldDB selectByCacheKey:@"snapshot500.example.com"];
+        XCTAssertNotNil(record);
+    }];
+
+    [[[HttpdnsDB alloc] initWithAccountId:kSnapshotTestAccountId] deleteAll];
+}
+
+#pragma mark - Helper Methods
+
+- (NSArray<HttpdnsHostRecord *> *)createRecords:(NSInteger)count {
+    NSMutableArray<HttpdnsHostRecord *> *records = [NSMutableArray arrayWithCapacity:count];
+    for (NSInteger i = 0; i < count; i++) {
+        NSString *host = [NSString stringWithFormat:@"snapshot%ld.example.com", (long)i];
+        HttpdnsHostRecord *record = [[HttpdnsHostRecord alloc] initWithId:0
+                                                                 cacheKey:host
+                                                                 hostName:host
+                                                                 createAt:[NSDate date]
+                                                                 modifyAt:[NSDate date]
+                                                                 clientIp:@"192.168.1.1"
+                                                                    v4ips:@[[NSString stringWithFormat:@"10.0.%ld.%ld", (long)(i / 256), (long)(i % 256)],
+                                                                            [NSString stringWithFormat:@"10.0.%ld.%ld", (long)(i / 256 + 1), (long)(i % 256)]]
+                                                                    v4ttl:300
+                                                             v4LookupTime:1000 + i
+                                                                    v6ips:@[[NSString stringWithFormat:@"2001:db8::%lx", (long)i]]
+                                                                    v6ttl:600
+                                                             v6LookupTime:2000 + i
+                                                                    extra:[NSString stringWithFormat:@"extra%ld", (long)i]];
+        [records addObject:record];
+    }
+    return records;
+}
+
+@end
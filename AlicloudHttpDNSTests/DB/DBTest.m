@@ -7,9 +7,12 @@
 //
 
 #import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
 #import "../Testbase/TestBase.h"
 #import "HttpdnsDB.h"
 #import "HttpdnsHostRecord.h"
+#import "HttpdnsPersistenceUtils.h"
+#import <sqlite3.h>
 
 @interface DBTest : TestBase
 
@@ -456,8 +459,330 @@
     }
 }
 
+#pragma mark - Batch & Write-Behind Tests
+
+- (void)testCreateOrUpdateBatch {
+    NSMutableArray<HttpdnsHostRecord *> *records = [NSMutableArray array];
+    for (NSInteger i = 0; i < 20; i++) {
+        NSString *hostname = [NSString stringWithFormat:@"batch%ld.example.com", (long)i];
+        NSString *cacheKey = [NSString stringWithFormat:@"batch_cache_key_%ld", (long)i];
+        [records addObject:[self createTestRecordWithHostname:hostname cacheKey:cacheKey]];
+    }
+
+    XCTAssertTrue([self.db createOrUpdateBatch:records], @"Batch upsert should succeed");
+    XCTAssertEqual([self.db getAllRecords].count, 20, @"All batch records should be persisted");
+
+    HttpdnsHostRecord *fetchedRecord = [self.db selectByCacheKey:@"batch_cache_key_7"];
+    XCTAssertEqualObjects(fetchedRecord.hostName, @"batch7.example.com", @"Hostname should match");
+}
+
+- (void)testUpsertPreservesIdAndCreateAt {
+    HttpdnsHostRecord *record = [self createTestRecordWithHostname:@"upsert.example.com" cacheKey:@"upsert_cache_key"];
+    XCTAssertTrue([self.db createOrUpdate:record]);
+    HttpdnsHostRecord *originalRecord = [self.db selectByCacheKey:@"upsert_cache_key"];
+
+    [NSThread sleepForTimeInterval:0.05];
+
+    XCTAssertTrue([self.db createOrUpdateBatch:@[record]]);
+    HttpdnsHostRecord *updatedRecord = [self.db selectByCacheKey:@"upsert_cache_key"];
+
+    XCTAssertEqual(updatedRecord.id, originalRecord.id, @"Upsert should keep the original row id");
+    XCTAssertEqualWithAccuracy([updatedRecord.createAt timeIntervalSince1970],
+                               [originalRecord.createAt timeIntervalSince1970],
+                               0.001,
+                               @"createAt should not change on upsert");
+    XCTAssertTrue([updatedRecord.modifyAt timeIntervalSinceDate:originalRecord.modifyAt] > 0,
+                  @"modifyAt should be updated to a later time");
+}
+
+- (void)testWriteBehindCoalescesUpdatesPerCacheKey {
+    for (NSInteger i = 0; i < 10; i++) {
+        HttpdnsHostRecord *record = [[HttpdnsHostRecord alloc] initWithId:1
+                                                                 cacheKey:@"coalesce_cache_key"
+                                                                 hostName:@"coalesce.example.com"
+                                                                 createAt:[NSDate date]
+                                                                 modifyAt:[NSDate date]
+                                                                 clientIp:@"192.168.1.1"
+                                                                    v4ips:@[[NSString stringWithFormat:@"10.0.0.%ld", (long)i]]
+                                                                    v4ttl:300
+                                                             v4LookupTime:1000 + i
+                                                                    v6ips:@[]
+                                                                    v6ttl:0
+                                                             v6LookupTime:0
+                                                                    extra:@""];
+        [self.db enqueueCreateOrUpdate:record];
+    }
+    [self.db enqueueCreateOrUpdate:[self createTestRecordWithHostname:@"other.example.com" cacheKey:@"other_cache_key"]];
+
+    XCTAssertEqual([self.db pendingWriteCount], 2, @"Updates for the same cacheKey should be coalesced");
+
+    [self.db flushPendingWrites];
+    XCTAssertEqual([self.db pendingWriteCount], 0, @"Flush should drain pending writes");
+
+    HttpdnsHostRecord *fetchedRecord = [self.db selectByCacheKey:@"coalesce_cache_key"];
+    XCTAssertEqualObjects(fetchedRecord.v4ips.firstObject, @"10.0.0.9", @"The last enqueued update should win");
+    XCTAssertEqual(fetchedRecord.v4LookupTime, 1009);
+}
+
+- (void)testWriteBehindFlushesAfterDelay {
+    [self.db enqueueCreateOrUpdate:[self createTestRecordWithHostname:@"delay.example.com" cacheKey:@"delay_cache_key"]];
+
+    [NSThread sleepForTimeInterval:1.0];
+
+    XCTAssertEqual([self.db pendingWriteCount], 0, @"Pending writes should be flushed by the timer");
+    XCTAssertNotNil([self.db selectByCacheKey:@"delay_cache_key"]);
+}
+
+- (void)testWriteBehindVisibleToReadsAndDeletes {
+    [self.db enqueueCreateOrUpdate:[self createTestRecordWithHostname:@"visible.example.com" cacheKey:@"visible_cache_key"]];
+    XCTAssertNotNil([self.db selectByCacheKey:@"visible_cache_key"], @"Reads should see pending writes");
+
+    [self.db enqueueCreateOrUpdate:[self createTestRecordWithHostname:@"visible.example.com" cacheKey:@"visible_cache_key"]];
+    XCTAssertTrue([self.db deleteByCacheKey:@"visible_cache_key"]);
+
+    [self.db flushPendingWrites];
+    XCTAssertNil([self.db selectByCacheKey:@"visible_cache_key"], @"Deleted record should not be resurrected by pending write");
+}
+
+- (void)testWriteBehindFlushOnEnterBackground {
+    [self.db enqueueCreateOrUpdate:[self createTestRecordWithHostname:@"bg.example.com" cacheKey:@"bg_cache_key"]];
+
+    [[NSNotificationCenter defaultCenter] postNotificationName:UIApplicationDidEnterBackgroundNotification object:nil];
+
+    // 进入后台时异步落盘，排在其后的队列操作能看到落盘结果
+    XCTAssertEqual([self.db pendingWriteCount], 0, @"Entering background should flush pending writes");
+}
+
+- (void)testWriteBehindFlushOnTerminate {
+    [self.db enqueueCreateOrUpdate:[self createTestRecordWithHostname:@"terminate.example.com" cacheKey:@"terminate_cache_key"]];
+
+    [[NSNotificationCenter defaultCenter] postNotificationName:UIApplicationWillTerminateNotification object:nil];
+
+    XCTAssertEqual([self.db pendingWriteCount], 0, @"Terminating should flush pending writes synchronously");
+}
+
+#pragma mark - Expiry Cleanup Tests
+
+- (void)testCleanRecordAlreadyExpired {
+    // v4和v6都过期
+    [self.db createOrUpdate:[self createRecordWithCacheKey:@"both_expired" v4ExpireAt:100 v6ExpireAt:200]];
+    // 仅v4过期
+    [self.db createOrUpdate:[self createRecordWithCacheKey:@"v4_expired" v4ExpireAt:100 v6ExpireAt:2000]];
+    // 仅v6过期
+    [self.db createOrUpdate:[self createRecordWithCacheKey:@"v6_expired" v4ExpireAt:2000 v6ExpireAt:100]];
+    // 都未过期
+    [self.db createOrUpdate:[self createRecordWithCacheKey:@"none_expired" v4ExpireAt:2000 v6ExpireAt:2000]];
+
+    NSInteger cleaned = [self.db cleanRecordAlreadExpiredAt:1000];
+    XCTAssertEqual(cleaned, 3, @"One deleted and two updated records should be counted");
+
+    XCTAssertNil([self.db selectByCacheKey:@"both_expired"], @"Fully expired record should be deleted");
+
+    HttpdnsHostRecord *v4Expired = [self.db selectByCacheKey:@"v4_expired"];
+    XCTAssertEqual(v4Expired.v4ips.count, 0, @"Expired IPv4 addresses should be cleared");
+    XCTAssertEqual(v4Expired.v6ips.count, 1, @"Valid IPv6 addresses should be kept");
+
+    HttpdnsHostRecord *v6Expired = [self.db selectByCacheKey:@"v6_expired"];
+    XCTAssertEqual(v6Expired.v4ips.count, 2, @"Valid IPv4 addresses should be kept");
+    XCTAssertEqual(v6Expired.v6ips.count, 0, @"Expired IPv6 addresses should be cleared");
+
+    HttpdnsHostRecord *noneExpired = [self.db selectByCacheKey:@"none_expired"];
+    XCTAssertEqual(noneExpired.v4ips.count, 2);
+    XCTAssertEqual(noneExpired.v6ips.count, 1);
+}
+
+- (void)testMigrateLegacyTableAddsExpireColumns {
+    NSInteger legacyAccountId = 999998;
+    NSString *dbPath = [[HttpdnsPersistenceUtils httpdnsDataDirectory]
+                        stringByAppendingPathComponent:[NSString stringWithFormat:@"%ld_v20250406.db", (long)legacyAccountId]];
+    [[NSFileManager defaultManager] removeItemAtPath:dbPath error:nil];
+
+    // 按旧版本表结构写入一条v4已过期、v6未过期的记录
+    sqlite3 *legacyDb = NULL;
+    XCTAssertEqual(sqlite3_open([dbPath UTF8String], &legacyDb), SQLITE_OK);
+    const char *legacySql =
+        "CREATE TABLE httpdns_cache_table (id INTEGER PRIMARY KEY AUTOINCREMENT, cache_key TEXT UNIQUE NOT NULL, "
+        "host_name TEXT NOT NULL, create_at REAL, modify_at REAL, client_ip TEXT, v4_ips TEXT, v4_ttl INTEGER, "
+        "v4_lookup_time INTEGER, v6_ips TEXT, v6_ttl INTEGER, v6_lookup_time INTEGER, extra TEXT);"
+        "INSERT INTO httpdns_cache_table (cache_key, host_name, v4_ips, v4_ttl, v4_lookup_time, v6_ips, v6_ttl, v6_lookup_time) "
+        "VALUES ('legacy_cache_key', 'legacy.example.com', '1.1.1.1', 60, 40, '2001:db8::1', 60, 1940);";
+    XCTAssertEqual(sqlite3_exec(legacyDb, legacySql, NULL, NULL, NULL), SQLITE_OK);
+    sqlite3_close(legacyDb);
+
+    HttpdnsDB *migratedDb = [[HttpdnsDB alloc] initWithAccountId:legacyAccountId];
+    XCTAssertNotNil(migratedDb, @"Legacy database should be migrated on open");
+
+    XCTAssertEqual([migratedDb cleanRecordAlreadExpiredAt:1000], 1, @"Backfilled expire columns should drive cleanup");
+    HttpdnsHostRecord *record = [migratedDb selectByCacheKey:@"legacy_cache_key"];
+    XCTAssertEqual(record.v4ips.count, 0);
+    XCTAssertEqualObjects(record.v6ips.firstObject, @"2001:db8::1");
+
+    [migratedDb deleteAll];
+}
+
+- (void)testIpBlobRoundTripKeepsConnectedRT {
+    HttpdnsIpQuality *probed = [[HttpdnsIpQuality alloc] initWithEwmaRT:12.5 rtVariance:4 failureRate:0.25 sampleCount:7];
+    HttpdnsIpQuality *unprobed = [[HttpdnsIpQuality alloc] init];
+    HttpdnsIpQuality *unreachable = [HttpdnsIpQuality qualityWithConnectedRT:-1];
+    HttpdnsHostRecord *record = [[HttpdnsHostRecord alloc] initWithId:0
+                                                             cacheKey:@"blob_cache_key"
+                                                             hostName:@"blob.example.com"
+                                                             createAt:nil
+                                                             modifyAt:nil
+                                                             clientIp:nil
+                                                                v4ips:@[@"10.0.0.1", @"10.0.0.2", @"10.0.0.3"]
+                                                        v4IpQualities:@[probed, unprobed, unreachable]
+                                                                v4ttl:60
+                                                         v4LookupTime:1000
+                                                                v6ips:@[@"2001:db8::1"]
+                                                        v6IpQualities:@[[HttpdnsIpQuality qualityWithConnectedRT:35]]
+                                                                v6ttl:60
+                                                         v6LookupTime:1000
+                                                                extra:nil];
+    XCTAssertTrue([self.db createOrUpdate:record]);
+
+    HttpdnsHostRecord *fetched = [self.db selectByCacheKey:@"blob_cache_key"];
+    XCTAssertEqualObjects(fetched.v4ips, (@[@"10.0.0.1", @"10.0.0.2", @"10.0.0.3"]));
+    XCTAssertEqualObjects(fetched.v4ConnectedRTs, (@[@13, @(NSIntegerMax), @(-1)]));
+    XCTAssertEqualObjects(fetched.v6ips, (@[@"2001:db8::1"]));
+    XCTAssertEqualObjects(fetched.v6ConnectedRTs, (@[@35]));
+
+    // 多次探测的统计完整保留
+    HttpdnsIpQuality *fetchedQuality = fetched.v4IpQualities.firstObject;
+    XCTAssertEqualWithAccuracy(fetchedQuality.ewmaRT, 12.5, 0.001);
+    XCTAssertEqualWithAccuracy(fetchedQuality.rtVariance, 4, 0.001);
+    XCTAssertEqualWithAccuracy(fetchedQuality.failureRate, 0.25, 0.001);
+    XCTAssertEqual(fetchedQuality.sampleCount, 7);
+    XCTAssertEqual(fetched.v4IpQualities[2].sampleCount, 1);
+    XCTAssertEqualWithAccuracy(fetched.v4IpQualities[2].failureRate, 1, 0.001);
+
+    // 库中只存打包后的地址，不再写文本列
+    NSString *dbPath = [[HttpdnsPersistenceUtils httpdnsDataDirectory]
+                        stringByAppendingPathComponent:[NSString stringWithFormat:@"%ld_v20250406.db", (long)self.testAccountId]];
+    sqlite3 *rawDb = NULL;
+    XCTAssertEqual(sqlite3_open([dbPath UTF8String], &rawDb), SQLITE_OK);
+    sqlite3_stmt *stmt = NULL;
+    XCTAssertEqual(sqlite3_prepare_v2(rawDb, "SELECT v4_ips, length(v4_ip_blob), length(v6_ip_blob) FROM httpdns_cache_table WHERE cache_key = 'blob_cache_key'", -1, &stmt, NULL), SQLITE_OK);
+    XCTAssertEqual(sqlite3_step(stmt), SQLITE_ROW);
+    XCTAssertEqual(sqlite3_column_type(stmt, 0), SQLITE_NULL);
+    XCTAssertEqual(sqlite3_column_int(stmt, 1), 2 + 3 * (4 + 16));
+    XCTAssertEqual(sqlite3_column_int(stmt, 2), 2 + 1 * (16 + 16));
+    sqlite3_finalize(stmt);
+    sqlite3_close(rawDb);
+}
+
+- (void)testMigrateLegacyTextIpsToBlob {
+    NSInteger legacyAccountId = 999998;
+    NSString *dbPath = [[HttpdnsPersistenceUtils httpdnsDataDirectory]
+                        stringByAppendingPathComponent:[NSString stringWithFormat:@"%ld_v20250406.db", (long)legacyAccountId]];
+    [[NSFileManager defaultManager] removeItemAtPath:dbPath error:nil];
+
+    sqlite3 *legacyDb = NULL;
+    XCTAssertEqual(sqlite3_open([dbPath UTF8String], &legacyDb), SQLITE_OK);
+    const char *legacySql =
+        "CREATE TABLE httpdns_cache_table (id INTEGER PRIMARY KEY AUTOINCREMENT, cache_key TEXT UNIQUE NOT NULL, "
+        "host_name TEXT NOT NULL, create_at REAL, modify_at REAL, client_ip TEXT, v4_ips TEXT, v4_ttl INTEGER, "
+        "v4_lookup_time INTEGER, v6_ips TEXT, v6_ttl INTEGER, v6_lookup_time INTEGER, extra TEXT);"
+        "INSERT INTO httpdns_cache_table (cache_key, host_name, v4_ips, v4_ttl, v4_lookup_time, v6_ips, v6_ttl, v6_lookup_time) "
+        "VALUES ('legacy_cache_key', 'legacy.example.com', '1.1.1.1,2.2.2.2', 60, 40, '2001:db8::1', 60, 40);";
+    XCTAssertEqual(sqlite3_exec(legacyDb, legacySql, NULL, NULL, NULL), SQLITE_OK);
+    sqlite3_close(legacyDb);
+
+    HttpdnsDB *migratedDb = [[HttpdnsDB alloc] initWithAccountId:legacyAccountId];
+    XCTAssertNotNil(migratedDb);
+
+    HttpdnsHostRecord *record = [migratedDb selectByCacheKey:@"legacy_cache_key"];
+    XCTAssertEqualObjects(record.v4ips, (@[@"1.1.1.1", @"2.2.2.2"]));
+    XCTAssertEqualObjects(record.v6ips, (@[@"2001:db8::1"]));
+    XCTAssertEqualObjects(record.v4ConnectedRTs, (@[@(NSIntegerMax), @(NSIntegerMax)]), @"Legacy rows carry no probe results");
+    migratedDb = nil;
+
+    // 迁移后文本列被清空
+    XCTAssertEqual(sqlite3_open([dbPath UTF8String], &legacyDb), SQLITE_OK);
+    sqlite3_stmt *stmt = NULL;
+    XCTAssertEqual(sqlite3_prepare_v2(legacyDb, "SELECT count(*) FROM httpdns_cache_table WHERE v4_ips IS NOT NULL OR v6_ips IS NOT NULL", -1, &stmt, NULL), SQLITE_OK);
+    XCTAssertEqual(sqlite3_step(stmt), SQLITE_ROW);
+    XCTAssertEqual(sqlite3_column_int(stmt, 0), 0);
+    sqlite3_finalize(stmt);
+    sqlite3_close(legacyDb);
+
+    [[[HttpdnsDB alloc] initWithAccountId:legacyAccountId] deleteAll];
+}
+
+// 模拟启动时对10k条记录做过期清理的耗时
+- (void)testPerformanceStartupCleanupWith10kRecords {
+    NSMutableArray<HttpdnsHostRecord *> *records = [NSMutableArray arrayWithCapacity:10000];
+    for (NSInteger i = 0; i < 10000; i++) {
+        NSString *cacheKey = [NSString stringWithFormat:@"startup_cache_key_%ld", (long)i];
+        // 三分之一全部过期，三分之一仅v4过期，其余未过期
+        int64_t v4ExpireAt = (i % 3 == 2) ? 2000 : 100;
+        int64_t v6ExpireAt = (i % 3 == 0) ? 100 : 2000;
+        [records addObject:[self createRecordWithCacheKey:cacheKey v4ExpireAt:v4ExpireAt v6ExpireAt:v6ExpireAt]];
+    }
+
+    [self measureMetrics:[[self class] defaultPerformanceMetrics] automaticallyStartMeasuring:NO forBlock:^{
+        [self.db deleteAll];
+        [self.db createOrUpdateBatch:records];
+
+        [self startMeasuring];
+        [self.db cleanRecordAlreadExpiredAt:1000];
+        [self stopMeasuring];
+    }];
+}
+
+#pragma mark - Performance Tests
+
+// 逐条同步写入，作为对比基准
+- (void)testPerformancePerRecordCreateOrUpdate {
+    NSArray<HttpdnsHostRecord *> *records = [self createPerformanceRecords:200];
+    [self measureBlock:^{
+        for (HttpdnsHostRecord *record in records) {
+            [self.db createOrUpdate:record];
+        }
+    }];
+}
+
+// 延迟合并写入，最终在一个事务中落盘
+- (void)testPerformanceWriteBehindBatch {
+    NSArray<HttpdnsHostRecord *> *records = [self createPerformanceRecords:200];
+    [self measureBlock:^{
+        for (HttpdnsHostRecord *record in records) {
+            [self.db enqueueCreateOrUpdate:record];
+        }
+        [self.db flushPendingWrites];
+    }];
+}
+
 #pragma mark - Helper Methods
 
+- (HttpdnsHostRecord *)createRecordWithCacheKey:(NSString *)cacheKey
+                                     v4ExpireAt:(int64_t)v4ExpireAt
+                                     v6ExpireAt:(int64_t)v6ExpireAt {
+    return [[HttpdnsHostRecord alloc] initWithId:1
+                                        cacheKey:cacheKey
+                                        hostName:@"expire.example.com"
+                                        createAt:[NSDate date]
+                                        modifyAt:[NSDate date]
+                                        clientIp:@"192.168.1.1"
+                                           v4ips:@[@"192.168.1.2", @"192.168.1.3"]
+                                           v4ttl:60
+                                    v4LookupTime:v4ExpireAt - 60
+                                           v6ips:@[@"2001:db8::1"]
+                                           v6ttl:60
+                                    v6LookupTime:v6ExpireAt - 60
+                                           extra:@""];
+}
+
+- (NSArray<HttpdnsHostRecord *> *)createPerformanceRecords:(NSInteger)count {
+    NSMutableArray<HttpdnsHostRecord *> *records = [NSMutableArray arrayWithCapacity:count];
+    for (NSInteger i = 0; i < count; i++) {
+        NSString *hostname = [NSString stringWithFormat:@"perf%ld.example.com", (long)i];
+        NSString *cacheKey = [NSString stringWithFormat:@"perf_cache_key_%ld", (long)i];
+        [records addObject:[self createTestRecordWithHostname:hostname cacheKey:cacheKey]];
+    }
+    return records;
+}
+
 - (HttpdnsHostRecord *)createTestRecordWithHostname:(NSString *)hostname cacheKey:(NSString *)cacheKey {
     return [[HttpdnsHostRecord alloc] initWithId:1
                                         cacheKey:cacheKey
@@ -0,0 +1,193 @@
+//
+//  AsyncLogTest.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+#import "TestBase.h"
+#import "HttpdnsLog_Internal.h"
+#import "HttpdnsLogBuffer.h"
+
+static NSString *const logMarker = @"ASYNC-LOG-TEST";
+
+// 记录被拷贝次数的可变对象
+@interface AsyncLogCopyCountingObject : NSObject <NSCopying>
+
+@property (nonatomic, copy) NSString *state;
+@property (nonatomic, assign) NSUInteger copyCount;
+
+@end
+
+@implementation AsyncLogCopyCountingObject
+
+- (id)copyWithZone:(NSZone *)zone {
+    self.copyCount++;
+    AsyncLogCopyCountingObject *copy = [[AsyncLogCopyCountingObject alloc] init];
+    copy.state = self.state;
+    return copy;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"state=%@", self.state];
+}
+
+@end
+
+@interface AsyncLogTest : TestBase
+
+@property (nonatomic, strong) NSMutableArray<NSString *> *receivedLogs;
+@property (nonatomic, assign) NSUInteger batchCount;
+
+@end
+
+@implementation AsyncLogTest
+
+- (void)setUp {
+    [super setUp];
+
+    self.receivedLogs = [NSMutableArray array];
+    self.batchCount = 0;
+    [HttpdnsLog disableLog];
+    [HttpdnsLog setLogHandler:self];
+    HttpdnsLogBufferFlush();
+    @synchronized (self) {
+        [self.receivedLogs removeAllObjects];
+        self.batchCount = 0;
+    }
+}
+
+- (void)tearDown {
+    [HttpdnsLog unsetLogHandler];
+    [super tearDown];
+}
+
+- (void)log:(NSString *)logStr {
+    [self logBatch:@[logStr]];
+}
+
+- (void)logBatch:(NSArray<NSString *> *)logStrs {
+    @synchronized (self) {
+        self.batchCount++;
+        for (NSString *logStr in logStrs) {
+            // 只收集本测试写入的日志，忽略SDK其他线程的输出
+            if ([logStr containsString:logMarker]) {
+                [self.receivedLogs addObject:logStr];
+            }
+        }
+    }
+}
+
+- (NSArray<NSString *> *)flushAndCollect {
+    HttpdnsLogBufferFlush();
+    @synchronized (self) {
+        return [self.receivedLogs copy];
+    }
+}
+
+- (void)testRecordIsFormattedOnDrain {
+    HttpdnsLogDebug("%@ int: %d, long: %ld, ulong: %lu, llong: %lld, hex: %x, float: %.2f, cstr: %s, obj: %@, nil: %@, percent: %%",
+                    logMarker, -1, 2L, 3UL, 4LL, 255, 1.5, "hello", @[@1], nil);
+
+    NSArray<NSString *> *logs = [self flushAndCollect];
+    XCTAssertEqual(logs.count, 1);
+    NSString *expected = [NSString stringWithFormat:@"%@ int: -1, long: 2, ulong: 3, llong: 4, hex: ff, float: 1.50, cstr: hello, obj: %@, nil: (null), percent: %%",
+                          logMarker, [@[@1] description]];
+    XCTAssertTrue([logs.firstObject hasSuffix:expected], @"%@", logs.firstObject);
+    XCTAssertTrue([logs.firstObject hasPrefix:@"["], @"日志以线程号开头");
+}
+
+- (void)testArgumentsAreSnapshottedWhenWritten {
+    char buffer[16];
+    strlcpy(buffer, "before", sizeof(buffer));
+    NSMutableString *mutableString = [NSMutableString stringWithString:@"before"];
+
+    HttpdnsLogDebug("%@ %s %@", logMarker, buffer, mutableString);
+    strlcpy(buffer, "after", sizeof(buffer));
+    [mutableString setString:@"after"];
+
+    NSArray<NSString *> *logs = [self flushAndCollect];
+    XCTAssertEqual(logs.count, 1);
+    XCTAssertTrue([logs.firstObject hasSuffix:@"ASYNC-LOG-TEST before before"], @"%@", logs.firstObject);
+}
+
+- (void)testModelObjectsAreDescribedInsteadOfCopied {
+    AsyncLogCopyCountingObject *object = [[AsyncLogCopyCountingObject alloc] init];
+    object.state = @"before";
+
+    HttpdnsLogDebug("%@ %@", logMarker, object);
+    object.state = @"after";
+
+    NSArray<NSString *> *logs = [self flushAndCollect];
+    XCTAssertEqual(logs.count, 1);
+    XCTAssertTrue([logs.firstObject hasSuffix:@"ASYNC-LOG-TEST state=before"], @"%@", logs.firstObject);
+    XCTAssertEqual(object.copyCount, 0, @"自定义对象只取描述，不做拷贝");
+}
+
+- (void)testTooManyArgumentsFallBackToEagerFormatting {
+    HttpdnsLogDebug("%@ %d %d %d %d %d %d %d %d %d", logMarker, 1, 2, 3, 4, 5, 6, 7, 8, 9);
+    HttpdnsLogDebug("%@ %*d", logMarker, 4, 7);
+
+    NSArray<NSString *> *logs = [self flushAndCollect];
+    XCTAssertEqual(logs.count, 2);
+    XCTAssertTrue([logs[0] hasSuffix:@"ASYNC-LOG-TEST 1 2 3 4 5 6 7 8 9"], @"%@", logs[0]);
+    XCTAssertTrue([logs[1] hasSuffix:@"ASYNC-LOG-TEST    7"], @"%@", logs[1]);
+}
+
+- (void)testRecordsAreDeliveredInBatches {
+    for (int i = 0; i < 20; i++) {
+        HttpdnsLogDebug("%@ %d", logMarker, i);
+    }
+
+    NSArray<NSString *> *logs = [self flushAndCollect];
+    XCTAssertEqual(logs.count, 20);
+    XCTAssertTrue([logs.lastObject hasSuffix:@"ASYNC-LOG-TEST 19"]);
+    @synchronized (self) {
+        XCTAssertLessThan(self.batchCount, 20, @"同一批日志应合并回调");
+    }
+}
+
+- (void)testArgumentsAreNotEvaluatedWhenInactive {
+    [HttpdnsLog unsetLogHandler];
+
+    __block int evaluatedCount = 0;
+    NSString *(^argument)(void) = ^NSString *{
+        evaluatedCount++;
+        return logMarker;
+    };
+    HttpdnsLogDebug("%@", argument());
+    XCTAssertEqual(evaluatedCount, 0);
+
+    [HttpdnsLog setLogHandler:self];
+    HttpdnsLogDebug("%@", argument());
+    XCTAssertEqual(evaluatedCount, 1);
+    XCTAssertEqual([self flushAndCollect].count, 1);
+}
+
+- (void)testFullBufferDropsRecords {
+    NSUInteger droppedCount = HttpdnsLogBufferDroppedCount();
+
+    // 写入量超过缓冲区容量，处理不过来的记录被丢弃并计数
+    for (int i = 0; i < 3000; i++) {
+        HttpdnsLogDebug("%@ %d", logMarker, i);
+    }
+    NSArray<NSString *> *logs = [self flushAndCollect];
+
+    NSUInteger newlyDropped = HttpdnsLogBufferDroppedCount() - droppedCount;
+    XCTAssertLessThanOrEqual(logs.count, 3000);
+    XCTAssertGreaterThanOrEqual(logs.count + newlyDropped, 3000);
+}
+
+- (void)testWritePerformance {
+    [self measureBlock:^{
+        for (int i = 0; i < 1000; i++) {
+            HttpdnsLogDebug("%@ host: %@, ttl: %lld", logMarker, ipv4OnlyHost, (long long)i);
+        }
+        HttpdnsLogBufferFlush();
+    }];
+}
+
+@end
@@ -0,0 +1,242 @@
+//
+//  HostObjectPackedAddressTest.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/28.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+#import <malloc/malloc.h>
+#import <arpa/inet.h>
+#import "HttpdnsHostObject.h"
+#import "HttpdnsHostRecord.h"
+
+static const NSUInteger kBenchmarkHostCount = 1000;
+
+// 改动前IP对象的布局，作为内存对比的基准
+@interface HostObjectStringLayoutIp : NSObject
+
+@property (nonatomic, copy) NSString *ip;
+@property (nonatomic, assign) NSInteger connectedRT;
+@property (nonatomic, strong) HttpdnsIpQuality *quality;
+
+@end
+
+@implementation HostObjectStringLayoutIp
+@end
+
+@interface HostObjectPackedAddressTest : XCTestCase
+
+@end
+
+@implementation HostObjectPackedAddressTest
+
+- (HttpdnsIpObject *)ipObjectWithIp:(NSString *)ip {
+    HttpdnsIpObject *ipObject = [HttpdnsIpObject new];
+    ipObject.ip = ip;
+    return ipObject;
+}
+
+- (HttpdnsHostObject *)hostObjectWithIndex:(NSUInteger)index {
+    HttpdnsHostObject *hostObject = [HttpdnsHostObject new];
+    hostObject.hostName = [NSString stringWithFormat:@"host%lu.example.com", (unsigned long)index];
+    NSMutableArray *v4Ips = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 4; i++) {
+        [v4Ips addObject:[self ipObjectWithIp:[NSString stringWithFormat:@"10.%lu.%lu.%lu", (unsigned long)(index >> 8), (unsigned long)(index & 0xff), (unsigned long)i]]];
+    }
+    NSMutableArray *v6Ips = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 2; i++) {
+        [v6Ips addObject:[self ipObjectWithIp:[NSString stringWithFormat:@"2001:db8::%lx:%lx", (unsigned long)index, (unsigned long)i]]];
+    }
+    hostObject.v4Ips = v4Ips;
+    hostObject.v6Ips = v6Ips;
+    return hostObject;
+}
+
+// IP对象自身占用的堆内存，未探测过的IP共用默认统计，不计入
+- (NSUInteger)retainedBytesOfIpObject:(HttpdnsIpObject *)ipObject {
+    NSUInteger bytes = malloc_size((__bridge const void *)ipObject);
+    if (ipObject.quality != [HttpdnsIpObject new].quality) {
+        bytes += malloc_size((__bridge const void *)ipObject.quality);
+    }
+    return bytes;
+}
+
+- (NSUInteger)retainedBytesOfIpObjects:(HttpdnsHostObject *)hostObject {
+    NSUInteger bytes = 0;
+    for (HttpdnsIpObject *ipObject in [[hostObject getV4Ips] arrayByAddingObjectsFromArray:[hostObject getV6Ips]]) {
+        bytes += [self retainedBytesOfIpObject:ipObject];
+    }
+    return bytes;
+}
+
+// 缓存读取拷贝、构造结果、打印日志、落盘，几乎每个IP都会被格式化成字符串
+- (void)exerciseRealisticAccessPath:(HttpdnsHostObject *)hostObject {
+    @autoreleasepool {
+        HttpdnsHostObject *copied = [hostObject copy];
+        [copied getV4IpStrings];
+        [copied getV6IpStrings];
+        [hostObject getV4IpStrings];
+        [hostObject getV6IpStrings];
+        for (HttpdnsIpObject *ipObject in [[hostObject getV4Ips] arrayByAddingObjectsFromArray:[hostObject getV6Ips]]) {
+            [ipObject description];
+            [ipObject getIpString];
+        }
+        [hostObject toDBRecord];
+    }
+}
+
+- (void)testAddressRoundTripAndFamily {
+    HttpdnsIpObject *v4 = [self ipObjectWithIp:@"192.168.1.1"];
+    XCTAssertEqual(v4.family, AF_INET);
+    XCTAssertFalse([v4 isIPv6]);
+    XCTAssertEqualObjects(v4.ip, @"192.168.1.1");
+
+    // 字符串由二进制地址生成，IPv6地址为规范形式
+    HttpdnsIpObject *v6 = [self ipObjectWithIp:@"2001:DB8:0:0:0:0:0:1"];
+    XCTAssertEqual(v6.family, AF_INET6);
+    XCTAssertTrue([v6 isIPv6]);
+    XCTAssertEqualObjects(v6.ip, @"2001:db8::1");
+}
+
+- (void)testUnparseableAddressIsKept {
+    HttpdnsIpObject *ipObject = [self ipObjectWithIp:@"not-an-ip"];
+    XCTAssertEqual(ipObject.family, AF_UNSPEC);
+    XCTAssertFalse([ipObject isIPv6]);
+    XCTAssertEqualObjects(ipObject.ip, @"not-an-ip");
+
+    ipObject.ip = nil;
+    XCTAssertNil(ipObject.ip);
+}
+
+- (void)testCopyAndCodingKeepAddress {
+    HttpdnsIpObject *ipObject = [self ipObjectWithIp:@"2001:db8::2"];
+    HttpdnsIpObject *copied = [ipObject copy];
+    XCTAssertEqual(copied.family, AF_INET6);
+    XCTAssertEqualObjects(copied.ip, @"2001:db8::2");
+
+    NSData *data = [NSKeyedArchiver archivedDataWithRootObject:ipObject requiringSecureCoding:NO error:nil];
+    NSKeyedUnarchiver *unarchiver = [[NSKeyedUnarchiver alloc] initForReadingFromData:data error:nil];
+    unarchiver.requiresSecureCoding = NO;
+    HttpdnsIpObject *decoded = [unarchiver decodeObjectForKey:NSKeyedArchiveRootObjectKey];
+    XCTAssertEqual(decoded.family, AF_INET6);
+    XCTAssertEqualObjects(decoded.ip, @"2001:db8::2");
+}
+
+- (void)testProbeSampleMatchesEquivalentIpv6Notation {
+    HttpdnsHostObject *hostObject = [HttpdnsHostObject new];
+    hostObject.v6Ips = @[[self ipObjectWithIp:@"2001:db8::1"], [self ipObjectWithIp:@"2001:db8::2"]];
+
+    // 不同写法的同一地址按二进制比较能匹配上
+    [hostObject updateConnectedRT:10 forIP:@"2001:0db8:0000:0000:0000:0000:0000:0002"];
+    XCTAssertEqualObjects([hostObject getV6IpStrings], (@[@"2001:db8::2", @"2001:db8::1"]));
+    XCTAssertEqual([hostObject getV6Ips].firstObject.connectedRT, 10);
+}
+
+- (void)testIpStringsCacheInvalidatedOnRerank {
+    HttpdnsHostObject *hostObject = [HttpdnsHostObject new];
+    hostObject.v4Ips = @[[self ipObjectWithIp:@"1.1.1.1"], [self ipObjectWithIp:@"2.2.2.2"]];
+
+    NSArray *strings = [hostObject getV4IpStrings];
+    XCTAssertEqualObjects(strings, (@[@"1.1.1.1", @"2.2.2.2"]));
+    XCTAssertTrue([hostObject getV4IpStrings] == strings, @"未变化时应复用缓存的数组");
+
+    [hostObject updateConnectedRT:-1 forIP:@"1.1.1.1"];
+    XCTAssertEqualObjects([hostObject getV4IpStrings], (@[@"2.2.2.2", @"1.1.1.1"]));
+
+    HttpdnsHostObject *copied = [hostObject copy];
+    XCTAssertEqualObjects([copied getV4IpStrings], (@[@"2.2.2.2", @"1.1.1.1"]));
+}
+
+- (void)testAccessPathDoesNotRetainStrings {
+    HttpdnsHostObject *hostObject = [self hostObjectWithIndex:7];
+    NSUInteger before = [self retainedBytesOfIpObjects:hostObject];
+
+    [self exerciseRealisticAccessPath:hostObject];
+
+    XCTAssertEqual([self retainedBytesOfIpObjects:hostObject], before, @"读取字符串后IP对象不应额外持有内存");
+
+    // 缓存读取返回的拷贝共用已生成的字符串数组
+    NSArray *strings = [hostObject getV6IpStrings];
+    XCTAssertTrue([[hostObject copy] getV6IpStrings] == strings);
+
+    char buffer[INET6_ADDRSTRLEN];
+    XCTAssertTrue([[hostObject getV6Ips].firstObject getIpCString:buffer length:sizeof(buffer)]);
+    XCTAssertEqualObjects([NSString stringWithUTF8String:buffer], strings.firstObject);
+}
+
+- (void)testMemoryOfThousandHostsAgainstStringLayout {
+    // 1000个域名，每个4个IPv4、2个IPv6，按日志、构造结果、落盘的访问路径读取过字符串后，
+    // 与改动前“IP对象持有NSString”的布局比较每个IP实际占用的堆内存
+    NSMutableArray<HttpdnsHostObject *> *hostObjects = [NSMutableArray arrayWithCapacity:kBenchmarkHostCount];
+    NSMutableArray<HostObjectStringLayoutIp *> *baselineIps = [NSMutableArray array];
+    for (NSUInteger i = 0; i < kBenchmarkHostCount; i++) {
+        HttpdnsHostObject *hostObject = [self hostObjectWithIndex:i];
+        [hostObjects addObject:hostObject];
+        for (HttpdnsIpObject *ipObject in [[hostObject getV4Ips] arrayByAddingObjectsFromArray:[hostObject getV6Ips]]) {
+            HostObjectStringLayoutIp *baseline = [HostObjectStringLayoutIp new];
+            baseline.ip = [ipObject getIpString];
+            // 改动前每个IP对象创建时都分配统计
+            baseline.quality = [[HttpdnsIpQuality alloc] init];
+            [baselineIps addObject:baseline];
+        }
+    }
+
+    NSUInteger packedV4Bytes = 0, packedV6Bytes = 0, baselineV4Bytes = 0, baselineV6Bytes = 0;
+    for (HttpdnsHostObject *hostObject in hostObjects) {
+        [self exerciseRealisticAccessPath:hostObject];
+        for (HttpdnsIpObject *ipObject in [hostObject getV4Ips]) {
+            packedV4Bytes += [self retainedBytesOfIpObject:ipObject];
+        }
+        for (HttpdnsIpObject *ipObject in [hostObject getV6Ips]) {
+            packedV6Bytes += [self retainedBytesOfIpObject:ipObject];
+        }
+    }
+    for (HostObjectStringLayoutIp *baseline in baselineIps) {
+        // 短的IPv4字符串通常是tagged pointer，malloc_size为0
+        NSUInteger bytes = malloc_size((__bridge const void *)baseline) + malloc_size((__bridge const void *)baseline.ip)
+            + malloc_size((__bridge const void *)baseline.quality);
+        if ([baseline.ip containsString:@":"]) {
+            baselineV6Bytes += bytes;
+        } else {
+            baselineV4Bytes += bytes;
+        }
+    }
+
+    XCTAssertLessThan(packedV4Bytes, baselineV4Bytes, @"未探测的IPv4地址不再各自持有统计");
+    XCTAssertLessThan(packedV6Bytes, baselineV6Bytes, @"IPv6地址不再额外持有字符串和统计");
+}
+
+- (void)testUnprobedIpSharesDefaultQuality {
+    HttpdnsIpObject *ipObject = [self ipObjectWithIp:@"192.168.1.1"];
+    HttpdnsIpObject *copied = [ipObject copy];
+    XCTAssertTrue(copied.quality == ipObject.quality, @"拷贝未探测的IP不分配统计");
+    XCTAssertEqual(ipObject.quality.sampleCount, 0);
+
+    [copied addProbeSample:20];
+    XCTAssertTrue(copied.quality != ipObject.quality);
+    XCTAssertEqual(copied.quality.sampleCount, 1);
+    XCTAssertEqual(ipObject.quality.sampleCount, 0, @"记录样本不能修改共用的默认统计");
+
+    HttpdnsIpObject *copiedAgain = [copied copy];
+    XCTAssertTrue(copiedAgain.quality != copied.quality);
+    XCTAssertEqual(copiedAgain.quality.sampleCount, 1);
+}
+
+- (void)testRecordProbeSamplePerformance {
+    NSMutableArray<HttpdnsHostObject *> *hostObjects = [NSMutableArray arrayWithCapacity:kBenchmarkHostCount];
+    for (NSUInteger i = 0; i < kBenchmarkHostCount; i++) {
+        [hostObjects addObject:[self hostObjectWithIndex:i]];
+    }
+
+    [self measureBlock:^{
+        for (HttpdnsHostObject *hostObject in hostObjects) {
+            [hostObject recordProbeSample:20 forIP:[hostObject getV4Ips].lastObject.ip];
+            [hostObject recordProbeSample:30 forIP:[hostObject getV6Ips].lastObject.ip];
+        }
+    }];
+}
+
+@end
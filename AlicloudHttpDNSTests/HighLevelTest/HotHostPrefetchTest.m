@@ -0,0 +1,216 @@
+//
+//  HotHostPrefetchTest.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+#import <OCMock/OCMock.h>
+#import "TestBase.h"
+#import "HttpdnsDB.h"
+#import "HttpdnsHostAccessTracker.h"
+#import "HttpdnsHostObject.h"
+#import "HttpdnsRequestManager.h"
+#import "HttpdnsResolveRecorder.h"
+#import "HttpdnsService_Internal.h"
+#import "HttpdnsVirtualClock.h"
+
+@interface HotHostPrefetchTest : TestBase
+
+@end
+
+@implementation HotHostPrefetchTest
+
++ (void)setUp {
+    [super setUp];
+
+    HttpDnsService *httpdns = [[HttpDnsService alloc] initWithAccountID:100000];
+    [httpdns setLogEnabled:YES];
+}
+
+- (void)setUp {
+    [super setUp];
+
+    self.httpdns = [HttpDnsService sharedInstance];
+    [self.httpdns setReuseExpiredIPEnabled:NO];
+    [self.httpdns cleanAllHostCache];
+    self.currentTimeStamp = [[NSDate date] timeIntervalSince1970];
+}
+
+- (void)tearDown {
+    [self.httpdns setHotHostPrefetchEnabled:NO maxHostCount:0];
+    [self.httpdns cleanAllHostCache];
+    [super tearDown];
+}
+
+#pragma mark - Tracker
+
+- (void)testDecayedScoreOrdering {
+    HttpdnsHostAccessTracker *tracker = [[HttpdnsHostAccessTracker alloc] initWithHalfLife:100 maxTrackedCount:10];
+    for (int i = 0; i < 4; i++) {
+        [tracker recordAccessForHost:@"old.onlyfortest.com" atTime:1000];
+    }
+    for (int i = 0; i < 3; i++) {
+        [tracker recordAccessForHost:@"new.onlyfortest.com" atTime:1200];
+    }
+
+    // 经过两个半衰期，4次访问衰减为1，低于最近的3次
+    NSArray *hosts = [tracker hottestHostsWithLimit:10 accessedSince:0 atTime:1200];
+    XCTAssertEqualObjects(hosts, (@[@"new.onlyfortest.com", @"old.onlyfortest.com"]));
+
+    hosts = [tracker hottestHostsWithLimit:1 accessedSince:0 atTime:1200];
+    XCTAssertEqualObjects(hosts, @[@"new.onlyfortest.com"]);
+
+    // 最近没有访问的域名不返回
+    hosts = [tracker hottestHostsWithLimit:10 accessedSince:1100 atTime:1200];
+    XCTAssertEqualObjects(hosts, @[@"new.onlyfortest.com"]);
+}
+
+- (void)testHostHashOnlyUpdatesTrackedHost {
+    HttpdnsHostAccessTracker *tracker = [[HttpdnsHostAccessTracker alloc] initWithHalfLife:100 maxTrackedCount:10];
+    NSString *host = @"hash.onlyfortest.com";
+
+    [tracker recordAccessForHostHash:HttpdnsResolveRecordHostHash(host.UTF8String) atTime:1000];
+    XCTAssertEqual(tracker.count, 0);
+    XCTAssertFalse(tracker.isDirty);
+
+    [tracker recordAccessForHost:host atTime:1000];
+    [tracker recordAccessForHostHash:HttpdnsResolveRecordHostHash(host.UTF8String) atTime:1000];
+    XCTAssertEqual(tracker.count, 1);
+    XCTAssertTrue(tracker.isDirty);
+
+    NSArray<HttpdnsHostAccessRecord *> *records = [tracker recordsAccessedSince:0];
+    XCTAssertEqual(records.count, 1);
+    XCTAssertEqualObjects(records.firstObject.hostName, host);
+    XCTAssertEqualWithAccuracy(records.firstObject.score, 2, 0.0001);
+    XCTAssertFalse(tracker.isDirty);
+}
+
+- (void)testColdestHostIsEvictedWhenFull {
+    HttpdnsHostAccessTracker *tracker = [[HttpdnsHostAccessTracker alloc] initWithHalfLife:100 maxTrackedCount:2];
+    for (int i = 0; i < 3; i++) {
+        [tracker recordAccessForHost:@"a.onlyfortest.com" atTime:1000];
+    }
+    [tracker recordAccessForHost:@"b.onlyfortest.com" atTime:1000];
+    [tracker recordAccessForHost:@"c.onlyfortest.com" atTime:1000];
+
+    XCTAssertEqual(tracker.count, 2);
+    NSArray *hosts = [tracker hottestHostsWithLimit:10 accessedSince:0 atTime:1000];
+    XCTAssertEqualObjects(hosts, (@[@"a.onlyfortest.com", @"c.onlyfortest.com"]));
+}
+
+- (void)testMergePersistedRecords {
+    HttpdnsHostAccessTracker *tracker = [[HttpdnsHostAccessTracker alloc] initWithHalfLife:100 maxTrackedCount:10];
+    [tracker recordAccessForHost:@"a.onlyfortest.com" atTime:1100];
+
+    HttpdnsHostAccessRecord *persisted = [[HttpdnsHostAccessRecord alloc] initWithHostName:@"a.onlyfortest.com" score:4 lastAccessTime:1000];
+    HttpdnsHostAccessRecord *other = [[HttpdnsHostAccessRecord alloc] initWithHostName:@"b.onlyfortest.com" score:1 lastAccessTime:1000];
+    [tracker mergeRecords:@[persisted, other]];
+
+    XCTAssertEqual(tracker.count, 2);
+    NSArray<HttpdnsHostAccessRecord *> *records = [tracker recordsAccessedSince:1050];
+    XCTAssertEqual(records.count, 1);
+    // 持久化的4次访问衰减一个半衰期后为2，加上本次运行的1次
+    XCTAssertEqualObjects(records.firstObject.hostName, @"a.onlyfortest.com");
+    XCTAssertEqualWithAccuracy(records.firstObject.score, 3, 0.0001);
+    XCTAssertEqualWithAccuracy(records.firstObject.lastAccessTime, 1100, 0.0001);
+}
+
+#pragma mark - Request manager
+
+- (void)presetHost:(NSString *)host {
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4HostObject];
+    hostObject.hostName = host;
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:host cacheKey:host underQueryIpType:HttpdnsQueryIPTypeIpv4];
+}
+
+- (void)testHotHostsFollowResolveFrequency {
+    [self presetNetworkEnvAsIpv4];
+
+    HttpdnsRequestManager *requestManager = self.httpdns.requestManager;
+    id mockManager = OCMPartialMock(requestManager);
+    NSMutableArray<NSArray *> *prefetchedHosts = [NSMutableArray array];
+    OCMStub([mockManager preResolveHosts:[OCMArg any] queryType:HttpdnsQueryIPTypeAuto]).andDo(^(NSInvocation *invocation) {
+        __unsafe_unretained NSArray *hosts = nil;
+        [invocation getArgument:&hosts atIndex:2];
+        @synchronized (prefetchedHosts) {
+            [prefetchedHosts addObject:hosts];
+        }
+    });
+
+    HttpdnsVirtualClock *clock = [[HttpdnsVirtualClock alloc] initWithStartTime:self.currentTimeStamp];
+    [clock install];
+
+    NSString *hotHost = @"hot.prefetch.onlyfortest.com";
+    NSString *coldHost = @"cold.prefetch.onlyfortest.com";
+    NSString *staleHost = @"stale.prefetch.onlyfortest.com";
+    [self presetHost:hotHost];
+    [self presetHost:coldHost];
+    [self presetHost:staleHost];
+
+    [self.httpdns setHotHostPrefetchEnabled:YES maxHostCount:100];
+    [requestManager waitForInitialization];
+
+    for (int i = 0; i < 5; i++) {
+        [self.httpdns resolveHostSyncNonBlocking:staleHost byIpType:HttpdnsQueryIPTypeIpv4];
+    }
+    // 超过统计窗口没有访问的域名不再预解析
+    [clock advanceBy:4 * 24 * 3600];
+    [self presetHost:hotHost];
+    [self presetHost:coldHost];
+    for (int i = 0; i < 3; i++) {
+        XCTAssertNotNil([self.httpdns resolveHostSyncNonBlocking:hotHost byIpType:HttpdnsQueryIPTypeIpv4]);
+    }
+    XCTAssertNotNil([self.httpdns resolveHostSyncNonBlocking:coldHost byIpType:HttpdnsQueryIPTypeIpv4]);
+
+    NSArray<NSString *> *hotHosts = [requestManager hotHostsForPrefetch];
+    XCTAssertFalse([hotHosts containsObject:staleHost]);
+    NSUInteger hotIndex = [hotHosts indexOfObject:hotHost];
+    NSUInteger coldIndex = [hotHosts indexOfObject:coldHost];
+    XCTAssertNotEqual(hotIndex, NSNotFound);
+    XCTAssertNotEqual(coldIndex, NSNotFound);
+    XCTAssertLessThan(hotIndex, coldIndex);
+
+    // 持久化后由新的数据库连接读出
+    [requestManager syncPersistHostAccessRecords];
+    HttpdnsDB *db = [[HttpdnsDB alloc] initWithAccountId:100000];
+    NSMutableSet<NSString *> *persistedHosts = [NSMutableSet set];
+    for (HttpdnsHostAccessRecord *record in [db getAllHostAccessRecords]) {
+        [persistedHosts addObject:record.hostName];
+    }
+    XCTAssertTrue([persistedHosts containsObject:hotHost]);
+    XCTAssertTrue([persistedHosts containsObject:coldHost]);
+    XCTAssertFalse([persistedHosts containsObject:staleHost]);
+
+    [clock uninstall];
+    [mockManager stopMocking];
+}
+
+- (void)testSdnsRequestIsNotTracked {
+    [self presetNetworkEnvAsIpv4];
+    [self.httpdns setHotHostPrefetchEnabled:YES maxHostCount:100];
+
+    NSString *host = @"sdns.prefetch.onlyfortest.com";
+    NSString *cacheKey = [NSString stringWithFormat:@"%@_sdns", host];
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4HostObject];
+    hostObject.hostName = host;
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:host cacheKey:cacheKey underQueryIpType:HttpdnsQueryIPTypeIpv4];
+
+    [self.httpdns resolveHostSyncNonBlocking:host byIpType:HttpdnsQueryIPTypeIpv4 withSdnsParams:@{} sdnsCacheKey:cacheKey];
+    XCTAssertFalse([[self.httpdns.requestManager hotHostsForPrefetch] containsObject:host]);
+}
+
+- (void)testSdnsRequestWithoutCacheKeyIsNotTracked {
+    [self presetNetworkEnvAsIpv4];
+    [self.httpdns setHotHostPrefetchEnabled:YES maxHostCount:100];
+
+    // 未指定cacheKey时以域名为cacheKey，但结果依赖SDNS参数，同样不统计
+    NSString *host = @"sdns.nokey.prefetch.onlyfortest.com";
+    [self.httpdns resolveHostSyncNonBlocking:host byIpType:HttpdnsQueryIPTypeIpv4 withSdnsParams:@{@"sdns-region": @"test"} sdnsCacheKey:nil];
+    XCTAssertFalse([[self.httpdns.requestManager hotHostsForPrefetch] containsObject:host]);
+}
+
+@end
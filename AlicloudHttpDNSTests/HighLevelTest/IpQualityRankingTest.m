@@ -0,0 +1,162 @@
+//
+//  IpQualityRankingTest.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/25.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+#import "HttpdnsHostObject.h"
+#import "HttpdnsIpQuality.h"
+
+@interface IpQualityRankingTest : XCTestCase
+
+@end
+
+@implementation IpQualityRankingTest
+
+- (HttpdnsHostObject *)hostObjectWithV4Ips:(NSArray<NSString *> *)ips {
+    HttpdnsHostObject *hostObject = [[HttpdnsHostObject alloc] init];
+    hostObject.cacheKey = @"ranking.example.com";
+    hostObject.hostName = @"ranking.example.com";
+    NSMutableArray<HttpdnsIpObject *> *ipObjects = [NSMutableArray array];
+    for (NSString *ip in ips) {
+        HttpdnsIpObject *ipObject = [[HttpdnsIpObject alloc] init];
+        ipObject.ip = ip;
+        [ipObjects addObject:ipObject];
+    }
+    [hostObject setV4Ips:ipObjects];
+    return hostObject;
+}
+
+- (NSArray<NSString *> *)v4IpStringsOf:(HttpdnsHostObject *)hostObject {
+    return [hostObject getV4IpStrings];
+}
+
+#pragma mark - HttpdnsIpQuality
+
+- (void)testQualityStartsUnknown {
+    HttpdnsIpQuality *quality = [[HttpdnsIpQuality alloc] init];
+    XCTAssertEqual(quality.sampleCount, 0);
+    XCTAssertEqual([quality connectedRT], NSIntegerMax);
+    XCTAssertEqualWithAccuracy([quality expectedCost], 1000, 0.001);
+}
+
+- (void)testQualityAccumulatesSamples {
+    HttpdnsIpQuality *quality = [[HttpdnsIpQuality alloc] init];
+    [quality addSample:100];
+    XCTAssertEqualWithAccuracy(quality.ewmaRT, 100, 0.001, @"第一个样本直接作为初始值");
+    XCTAssertEqualWithAccuracy(quality.rtVariance, 0, 0.001);
+
+    [quality addSample:200];
+    XCTAssertEqualWithAccuracy(quality.ewmaRT, 130, 0.001);
+    XCTAssertGreaterThan(quality.rtVariance, 0, @"耗时有波动时方差大于0");
+    XCTAssertEqual(quality.sampleCount, 2);
+    XCTAssertEqual([quality connectedRT], 130);
+
+    [quality addSample:-1];
+    XCTAssertEqualWithAccuracy(quality.failureRate, 0.3, 0.001);
+    XCTAssertEqualWithAccuracy(quality.ewmaRT, 130, 0.001, @"失败样本不影响耗时统计");
+}
+
+- (void)testQualityWithConnectedRTCompatibility {
+    XCTAssertEqual([[HttpdnsIpQuality qualityWithConnectedRT:NSIntegerMax] sampleCount], 0);
+    XCTAssertEqual([[HttpdnsIpQuality qualityWithConnectedRT:-1] connectedRT], -1);
+    XCTAssertEqual([[HttpdnsIpQuality qualityWithConnectedRT:42] connectedRT], 42);
+}
+
+- (void)testQualityCodingAndCopy {
+    HttpdnsIpQuality *quality = [[HttpdnsIpQuality alloc] init];
+    [quality addSample:80];
+    [quality addSample:-1];
+
+    NSData *data = [NSKeyedArchiver archivedDataWithRootObject:quality requiringSecureCoding:NO error:nil];
+    HttpdnsIpQuality *decoded = [NSKeyedUnarchiver unarchiveObjectWithData:data];
+    XCTAssertEqualWithAccuracy(decoded.ewmaRT, quality.ewmaRT, 0.001);
+    XCTAssertEqualWithAccuracy(decoded.failureRate, quality.failureRate, 0.001);
+    XCTAssertEqual(decoded.sampleCount, quality.sampleCount);
+
+    HttpdnsIpQuality *copied = [quality copy];
+    [copied addSample:10];
+    XCTAssertEqual(quality.sampleCount, 2, @"拷贝后的修改不影响原对象");
+}
+
+#pragma mark - 排序
+
+- (void)testSingleOutlierDoesNotReorder {
+    HttpdnsHostObject *hostObject = [self hostObjectWithV4Ips:@[@"1.1.1.1", @"2.2.2.2"]];
+    for (int i = 0; i < 5; i++) {
+        [hostObject recordProbeSample:20 forIP:@"1.1.1.1"];
+        [hostObject recordProbeSample:100 forIP:@"2.2.2.2"];
+    }
+    [hostObject rerankIps];
+    XCTAssertEqualObjects([self v4IpStringsOf:hostObject], (@[@"1.1.1.1", @"2.2.2.2"]));
+
+    // 一次偶然的慢样本不应让长期更快的IP掉到后面
+    [hostObject recordProbeSample:90 forIP:@"1.1.1.1"];
+    [hostObject recordProbeSample:95 forIP:@"2.2.2.2"];
+    [hostObject rerankIps];
+    XCTAssertEqualObjects([self v4IpStringsOf:hostObject], (@[@"1.1.1.1", @"2.2.2.2"]));
+}
+
+- (void)testFlakyIpRanksBehindStableIp {
+    HttpdnsHostObject *hostObject = [self hostObjectWithV4Ips:@[@"1.1.1.1", @"2.2.2.2"]];
+    // 1.1.1.1更快但经常失败
+    NSArray<NSNumber *> *flakySamples = @[@10, @(-1), @12, @(-1), @11];
+    for (NSNumber *sample in flakySamples) {
+        [hostObject recordProbeSample:[sample integerValue] forIP:@"1.1.1.1"];
+        [hostObject recordProbeSample:80 forIP:@"2.2.2.2"];
+    }
+    [hostObject rerankIps];
+    XCTAssertEqualObjects([self v4IpStringsOf:hostObject], (@[@"2.2.2.2", @"1.1.1.1"]));
+}
+
+- (void)testUnreachableLastAndUnprobedInMiddle {
+    HttpdnsHostObject *hostObject = [self hostObjectWithV4Ips:@[@"1.1.1.1", @"2.2.2.2", @"3.3.3.3"]];
+    [hostObject recordProbeSample:-1 forIP:@"1.1.1.1"];
+    [hostObject recordProbeSample:30 forIP:@"3.3.3.3"];
+    [hostObject rerankIps];
+    XCTAssertEqualObjects([self v4IpStringsOf:hostObject], (@[@"3.3.3.3", @"2.2.2.2", @"1.1.1.1"]));
+    XCTAssertEqual([hostObject getV4Ips].lastObject.connectedRT, -1);
+    XCTAssertEqual([hostObject getV4Ips][1].connectedRT, NSIntegerMax);
+}
+
+- (void)testRecordWithoutRerankKeepsOrder {
+    HttpdnsHostObject *hostObject = [self hostObjectWithV4Ips:@[@"1.1.1.1", @"2.2.2.2"]];
+    [hostObject recordProbeSample:-1 forIP:@"1.1.1.1"];
+    XCTAssertEqualObjects([self v4IpStringsOf:hostObject], (@[@"1.1.1.1", @"2.2.2.2"]), @"只记录样本时不排序");
+
+    [hostObject updateConnectedRT:-1 forIP:@"1.1.1.1"];
+    XCTAssertEqualObjects([self v4IpStringsOf:hostObject], (@[@"2.2.2.2", @"1.1.1.1"]), @"updateConnectedRT立即排序");
+}
+
+- (void)testInheritIpQualityFromPreviousResult {
+    HttpdnsHostObject *previous = [self hostObjectWithV4Ips:@[@"1.1.1.1", @"2.2.2.2"]];
+    [previous recordProbeSample:-1 forIP:@"1.1.1.1"];
+    [previous recordProbeSample:25 forIP:@"2.2.2.2"];
+
+    // 新结果保留了2.2.2.2和1.1.1.1，新增了3.3.3.3
+    HttpdnsHostObject *current = [self hostObjectWithV4Ips:@[@"1.1.1.1", @"3.3.3.3", @"2.2.2.2"]];
+    [current inheritIpQualityFrom:previous];
+
+    XCTAssertEqualObjects([self v4IpStringsOf:current], (@[@"2.2.2.2", @"3.3.3.3", @"1.1.1.1"]));
+    XCTAssertEqual([current getV4Ips].firstObject.quality.sampleCount, 1);
+
+    // 继承的是拷贝，之后的样本互不影响
+    [current recordProbeSample:30 forIP:@"2.2.2.2"];
+    XCTAssertEqual([previous getV4Ips][1].quality.sampleCount, 1);
+}
+
+- (void)testCopyDeepCopiesQuality {
+    HttpdnsHostObject *hostObject = [self hostObjectWithV4Ips:@[@"1.1.1.1"]];
+    [hostObject recordProbeSample:40 forIP:@"1.1.1.1"];
+
+    HttpdnsHostObject *copied = [hostObject copy];
+    [copied recordProbeSample:-1 forIP:@"1.1.1.1"];
+    XCTAssertEqual([hostObject getV4Ips].firstObject.quality.sampleCount, 1);
+    XCTAssertEqual([copied getV4Ips].firstObject.quality.sampleCount, 2);
+}
+
+@end
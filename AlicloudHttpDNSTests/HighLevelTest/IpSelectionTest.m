@@ -0,0 +1,129 @@
+//
+//  IpSelectionTest.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/27.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+#import "HttpdnsResult.h"
+#import "HttpdnsResult_Internal.h"
+#import "HttpdnsIpSelector.h"
+#import "HttpdnsUtil.h"
+
+@interface IpSelectionTest : XCTestCase
+
+@end
+
+@implementation IpSelectionTest
+
+- (void)testEligibleIndexesExcludeUnreachableAndSlow {
+    NSArray *costs = @[@(-1), @20, @50, @200, @1000];
+    XCTAssertEqualObjects([HttpdnsIpSelector eligibleIndexesOfExpectedCosts:costs], (@[@1, @2]));
+
+    // 全部不可达时没有可选IP
+    XCTAssertEqual([HttpdnsIpSelector eligibleIndexesOfExpectedCosts:@[@(-1), @(-1)]].count, 0);
+}
+
+- (void)testFirstStrategyKeepsRankedOrder {
+    NSString *ip = [HttpdnsIpSelector selectFromIps:@[@"1.1.1.1", @"2.2.2.2"]
+                                      expectedCosts:@[@(-1), @20]
+                                           strategy:HttpdnsIpSelectionStrategyFirst
+                                            hashKey:nil];
+    XCTAssertEqualObjects(ip, @"1.1.1.1");
+}
+
+- (void)testWeightedRandomFavorsFasterIps {
+    NSArray *ips = @[@"1.1.1.1", @"2.2.2.2", @"3.3.3.3"];
+    NSArray *costs = @[@10, @30, @(-1)];
+
+    // 权重为1/10和1/30，前75%落在更快的IP上
+    XCTAssertEqualObjects([HttpdnsIpSelector selectFromIps:ips expectedCosts:costs randomValue:0.0], @"1.1.1.1");
+    XCTAssertEqualObjects([HttpdnsIpSelector selectFromIps:ips expectedCosts:costs randomValue:0.74], @"1.1.1.1");
+    XCTAssertEqualObjects([HttpdnsIpSelector selectFromIps:ips expectedCosts:costs randomValue:0.76], @"2.2.2.2");
+    XCTAssertEqualObjects([HttpdnsIpSelector selectFromIps:ips expectedCosts:costs randomValue:0.999], @"2.2.2.2");
+
+    NSMutableDictionary<NSString *, NSNumber *> *counts = [NSMutableDictionary dictionary];
+    for (int i = 0; i < 4000; i++) {
+        NSString *ip = [HttpdnsIpSelector selectFromIps:ips expectedCosts:costs strategy:HttpdnsIpSelectionStrategyWeightedRandom hashKey:nil];
+        counts[ip] = @([counts[ip] integerValue] + 1);
+    }
+    XCTAssertNil(counts[@"3.3.3.3"], @"不可达的IP不应被选中");
+    XCTAssertGreaterThan([counts[@"1.1.1.1"] integerValue], 2600);
+    XCTAssertGreaterThan([counts[@"2.2.2.2"] integerValue], 600);
+}
+
+- (void)testConsistentHashIsStablePerClientAndSpreadsAcrossClients {
+    NSArray *ips = @[@"1.1.1.1", @"2.2.2.2", @"3.3.3.3", @"4.4.4.4"];
+    NSArray *costs = @[@20, @22, @25, @21];
+
+    NSString *first = [HttpdnsIpSelector selectFromIps:ips expectedCosts:costs strategy:HttpdnsIpSelectionStrategyConsistentHash hashKey:@"client-a"];
+    for (int i = 0; i < 10; i++) {
+        XCTAssertEqualObjects([HttpdnsIpSelector selectFromIps:ips expectedCosts:costs strategy:HttpdnsIpSelectionStrategyConsistentHash hashKey:@"client-a"], first);
+    }
+
+    NSMutableSet<NSString *> *selected = [NSMutableSet set];
+    for (int i = 0; i < 200; i++) {
+        NSString *key = [NSString stringWithFormat:@"client-%d", i];
+        [selected addObject:[HttpdnsIpSelector selectFromIps:ips expectedCosts:costs strategy:HttpdnsIpSelectionStrategyConsistentHash hashKey:key]];
+    }
+    XCTAssertEqual(selected.count, ips.count, @"不同客户端应分散到所有质量相近的IP上");
+}
+
+- (void)testConsistentHashOnlyMovesClientsOfRemovedIp {
+    NSArray *ips = @[@"1.1.1.1", @"2.2.2.2", @"3.3.3.3", @"4.4.4.4"];
+    NSArray *costs = @[@20, @20, @20, @20];
+    NSArray *degradedCosts = @[@20, @20, @(-1), @20];
+
+    for (int i = 0; i < 200; i++) {
+        NSString *key = [NSString stringWithFormat:@"client-%d", i];
+        NSString *before = [HttpdnsIpSelector selectFromIps:ips expectedCosts:costs strategy:HttpdnsIpSelectionStrategyConsistentHash hashKey:key];
+        NSString *after = [HttpdnsIpSelector selectFromIps:ips expectedCosts:degradedCosts strategy:HttpdnsIpSelectionStrategyConsistentHash hashKey:key];
+        XCTAssertNotEqualObjects(after, @"3.3.3.3");
+        if (![before isEqualToString:@"3.3.3.3"]) {
+            XCTAssertEqualObjects(before, after, @"其他IP上的客户端不应迁移");
+        }
+    }
+}
+
+- (void)testAllUnreachableFallsBackToFirst {
+    NSString *ip = [HttpdnsIpSelector selectFromIps:@[@"1.1.1.1", @"2.2.2.2"]
+                                      expectedCosts:@[@(-1), @(-1)]
+                                           strategy:HttpdnsIpSelectionStrategyWeightedRandom
+                                            hashKey:nil];
+    XCTAssertEqualObjects(ip, @"1.1.1.1");
+}
+
+- (void)testResultSelectionWithoutQualityInfo {
+    HttpdnsResult *result = [HttpdnsResult new];
+    result.ips = @[@"1.1.1.1", @"2.2.2.2"];
+    result.selectionHashKey = @"client-a";
+
+    // 没有质量信息时所有IP同等参与
+    XCTAssertTrue([result.ips containsObject:[result selectIpv4AddressWithStrategy:HttpdnsIpSelectionStrategyWeightedRandom]]);
+    XCTAssertTrue([result.ips containsObject:[result selectIpv4AddressWithStrategy:HttpdnsIpSelectionStrategyConsistentHash]]);
+    XCTAssertNil([result selectIpv6AddressWithStrategy:HttpdnsIpSelectionStrategyConsistentHash]);
+}
+
+- (void)testResultSelectionSkipsUnreachableIpv6 {
+    HttpdnsResult *result = [HttpdnsResult new];
+    result.ipv6s = @[@"2001:db8::1", @"2001:db8::2"];
+    result.v6ExpectedCosts = @[@(-1), @40];
+    for (int i = 0; i < 20; i++) {
+        result.selectionHashKey = [NSString stringWithFormat:@"client-%d", i];
+        XCTAssertEqualObjects([result selectIpv6AddressWithStrategy:HttpdnsIpSelectionStrategyConsistentHash], @"2001:db8::2");
+    }
+}
+
+- (void)testInstallationIdIsPersistedAndIndependentOfSession {
+    // 一致性哈希使用的客户端标识保存在本地，下次启动读到的是同一个值
+    NSString *installationId = [HttpdnsUtil installationID];
+    XCTAssertEqual(installationId.length, 16);
+    XCTAssertEqualObjects([[NSUserDefaults standardUserDefaults] stringForKey:@"HttpdnsInstallationId"], installationId);
+    XCTAssertEqualObjects([HttpdnsUtil installationID], installationId);
+    XCTAssertNotEqualObjects(installationId, [HttpdnsUtil generateSessionID]);
+}
+
+@end
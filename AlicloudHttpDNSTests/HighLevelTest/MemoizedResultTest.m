@@ -0,0 +1,175 @@
+//
+//  MemoizedResultTest.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+#import "TestBase.h"
+#import "HttpdnsHostObject.h"
+#import "HttpdnsService.h"
+#import "HttpdnsService_Internal.h"
+#import "HttpdnsResult_Internal.h"
+
+@interface MemoizedResultTest : TestBase
+
+@end
+
+@implementation MemoizedResultTest
+
++ (void)setUp {
+    [super setUp];
+
+    HttpDnsService *httpdns = [[HttpDnsService alloc] initWithAccountID:100000];
+    [httpdns setLogEnabled:YES];
+}
+
+- (void)setUp {
+    [super setUp];
+
+    self.httpdns = [HttpDnsService sharedInstance];
+    [self.httpdns setReuseExpiredIPEnabled:NO];
+    self.currentTimeStamp = [[NSDate date] timeIntervalSince1970];
+}
+
+- (void)testCacheHitReusesBuiltResultUntilEntryChanges {
+    [self presetNetworkEnvAsIpv4AndIpv6];
+    [self.httpdns cleanAllHostCache];
+
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4AndIpv6HostObject];
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:ipv4AndIpv6Host cacheKey:ipv4AndIpv6Host underQueryIpType:HttpdnsQueryIPTypeBoth];
+
+    HttpdnsResult *result1 = [self.httpdns resolveHostSyncNonBlocking:ipv4AndIpv6Host byIpType:HttpdnsQueryIPTypeBoth];
+    HttpdnsResult *result2 = [self.httpdns resolveHostSyncNonBlocking:ipv4AndIpv6Host byIpType:HttpdnsQueryIPTypeBoth];
+    XCTAssertNotNil(result1);
+    XCTAssertTrue(result1 != result2, @"每次命中返回独立的浅拷贝");
+    XCTAssertTrue(result1.ips == result2.ips && result1.v4ExpectedCosts == result2.v4ExpectedCosts, @"缓存未变化时应复用已构造的数组");
+    XCTAssertEqual(result1.ips.count, 2);
+    XCTAssertEqual(result1.ipv6s.count, 2);
+    XCTAssertEqual(result1.ttl, 60);
+    XCTAssertEqual(result1.lastUpdatedTimeInterval, (int64_t)self.currentTimeStamp);
+
+    // 不同的查询类型各自缓存
+    HttpdnsResult *v4Result = [self.httpdns resolveHostSyncNonBlocking:ipv4AndIpv6Host byIpType:HttpdnsQueryIPTypeIpv4];
+    XCTAssertTrue(v4Result.v4ExpectedCosts != result1.v4ExpectedCosts);
+    XCTAssertEqual(v4Result.ipv6s.count, 0);
+    XCTAssertTrue([self.httpdns resolveHostSyncNonBlocking:ipv4AndIpv6Host byIpType:HttpdnsQueryIPTypeIpv4].v4ExpectedCosts == v4Result.v4ExpectedCosts);
+
+    // 缓存更新后重新构造
+    HttpdnsHostObject *updatedHostObject = [self constructSimpleIpv4AndIpv6HostObject];
+    updatedHostObject.v4ttl = 120;
+    [self.httpdns.requestManager mergeLookupResultToManager:updatedHostObject host:ipv4AndIpv6Host cacheKey:ipv4AndIpv6Host underQueryIpType:HttpdnsQueryIPTypeBoth];
+
+    HttpdnsResult *result3 = [self.httpdns resolveHostSyncNonBlocking:ipv4AndIpv6Host byIpType:HttpdnsQueryIPTypeBoth];
+    XCTAssertTrue(result3.v4ExpectedCosts != result1.v4ExpectedCosts);
+    XCTAssertEqual(result3.ttl, 120);
+
+    // 建连反馈改变排序统计后也重新构造
+    [self.httpdns.requestManager reportConnectionCost:-1 forIp:ipv41 cacheKey:ipv4AndIpv6Host];
+    [self.httpdns.requestManager commitConnectionCostsForCacheKey:ipv4AndIpv6Host];
+    HttpdnsResult *result4 = [self.httpdns resolveHostSyncNonBlocking:ipv4AndIpv6Host byIpType:HttpdnsQueryIPTypeBoth];
+    XCTAssertTrue(result4.v4ExpectedCosts != result3.v4ExpectedCosts);
+    XCTAssertEqualObjects(result4.ips.lastObject, ipv41);
+}
+
+- (void)testModifyingReturnedResultDoesNotAffectCache {
+    [self presetNetworkEnvAsIpv4];
+    [self.httpdns cleanAllHostCache];
+
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4HostObject];
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:ipv4OnlyHost cacheKey:ipv4OnlyHost underQueryIpType:HttpdnsQueryIPTypeIpv4];
+
+    HttpdnsResult *result = [self.httpdns resolveHostSyncNonBlocking:ipv4OnlyHost byIpType:HttpdnsQueryIPTypeIpv4];
+    XCTAssertTrue([result isKindOfClass:[HttpdnsResult class]]);
+    result.ips = @[@"9.9.9.9"];
+    result.ttl = 1;
+    // 调用方对自己拿到的结果的修改生效
+    XCTAssertEqualObjects(result.ips, @[@"9.9.9.9"]);
+    XCTAssertEqual(result.ttl, 1);
+
+    HttpdnsResult *again = [self.httpdns resolveHostSyncNonBlocking:ipv4OnlyHost byIpType:HttpdnsQueryIPTypeIpv4];
+    XCTAssertEqual(again.ips.count, 2);
+    XCTAssertFalse([again.ips containsObject:@"9.9.9.9"]);
+    XCTAssertEqual(again.ttl, 60);
+}
+
+- (void)testResultHostFollowsRequestedHost {
+    [self presetNetworkEnvAsIpv4];
+    [self.httpdns cleanAllHostCache];
+
+    NSString *sharedCacheKey = @"shared.cache.key";
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4HostObject];
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:ipv4OnlyHost cacheKey:sharedCacheKey underQueryIpType:HttpdnsQueryIPTypeIpv4];
+
+    HttpdnsResult *result1 = [self.httpdns resolveHostSyncNonBlocking:ipv4OnlyHost byIpType:HttpdnsQueryIPTypeIpv4 withSdnsParams:@{} sdnsCacheKey:sharedCacheKey];
+    XCTAssertEqualObjects(result1.host, ipv4OnlyHost);
+
+    HttpdnsResult *result2 = [self.httpdns resolveHostSyncNonBlocking:ipv4AndIpv6Host byIpType:HttpdnsQueryIPTypeIpv4 withSdnsParams:@{} sdnsCacheKey:sharedCacheKey];
+    XCTAssertEqualObjects(result2.host, ipv4AndIpv6Host);
+    XCTAssertEqualObjects(result2.ips, result1.ips);
+}
+
+- (void)testExpiredEntryIsNotMemoized {
+    [self presetNetworkEnvAsIpv4];
+    [self.httpdns cleanAllHostCache];
+
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4HostObject];
+    hostObject.lastIPv4LookupTime = self.currentTimeStamp - 3600;
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:ipv4OnlyHost cacheKey:ipv4OnlyHost underQueryIpType:HttpdnsQueryIPTypeIpv4];
+
+    HttpdnsRequest *request = [[HttpdnsRequest alloc] initWithHost:ipv4OnlyHost queryIpType:HttpdnsQueryIPTypeIpv4];
+    request.cacheKey = ipv4OnlyHost;
+    HttpdnsResult *result = [self.httpdns.requestManager memoizedResultForRequest:request builder:^HttpdnsResult *(HttpdnsHostObject *object) {
+        XCTFail(@"过期的缓存不应构造结果");
+        return nil;
+    }];
+    XCTAssertNil(result);
+}
+
+- (void)testResultBuiltDuringInvalidationIsNotMemoized {
+    [self presetNetworkEnvAsIpv4];
+    [self.httpdns cleanAllHostCache];
+
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4HostObject];
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:ipv4OnlyHost cacheKey:ipv4OnlyHost underQueryIpType:HttpdnsQueryIPTypeIpv4];
+
+    HttpdnsRequest *request = [[HttpdnsRequest alloc] initWithHost:ipv4OnlyHost queryIpType:HttpdnsQueryIPTypeIpv4];
+    request.cacheKey = ipv4OnlyHost;
+    __block NSUInteger buildCount = 0;
+    HttpdnsResult * (^builder)(HttpdnsHostObject *) = ^HttpdnsResult *(HttpdnsHostObject *object) {
+        buildCount++;
+        if (buildCount == 1) {
+            // 构造在锁外进行，期间缓存可以被更新
+            [self.httpdns.requestManager mergeLookupResultToManager:[self constructSimpleIpv4HostObject] host:ipv4OnlyHost cacheKey:ipv4OnlyHost underQueryIpType:HttpdnsQueryIPTypeIpv4];
+        }
+        HttpdnsResult *result = [HttpdnsResult new];
+        result.ips = [object getV4IpStrings];
+        return result;
+    };
+
+    XCTAssertNotNil([self.httpdns.requestManager memoizedResultForRequest:request builder:builder]);
+    XCTAssertNotNil([self.httpdns.requestManager memoizedResultForRequest:request builder:builder]);
+    XCTAssertEqual(buildCount, 2, @"构造期间缓存发生变化，结果不应被保存");
+
+    XCTAssertNotNil([self.httpdns.requestManager memoizedResultForRequest:request builder:builder]);
+    XCTAssertEqual(buildCount, 2);
+}
+
+- (void)testMemoizedLookupPerformance {
+    [self presetNetworkEnvAsIpv4AndIpv6];
+    [self.httpdns cleanAllHostCache];
+
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4AndIpv6HostObject];
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:ipv4AndIpv6Host cacheKey:ipv4AndIpv6Host underQueryIpType:HttpdnsQueryIPTypeBoth];
+
+    [self measureBlock:^{
+        for (int i = 0; i < 10000; i++) {
+            [self.httpdns resolveHostSyncNonBlocking:ipv4AndIpv6Host byIpType:HttpdnsQueryIPTypeBoth];
+        }
+    }];
+}
+
+@end
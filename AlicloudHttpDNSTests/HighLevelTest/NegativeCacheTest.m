@@ -0,0 +1,176 @@
+//
+//  NegativeCacheTest.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+#import "TestBase.h"
+#import "HttpdnsHostObject.h"
+#import "HttpdnsHostRecord.h"
+#import "HttpdnsDB.h"
+#import "HttpdnsInternalConstant.h"
+#import "HttpdnsService.h"
+#import "HttpdnsService_Internal.h"
+
+static NSString *const noRecordHost = @"no-record.onlyfortest.com";
+
+@interface HttpdnsRequestManager (NegativeCacheTest)
+
+- (BOOL)isResolvingBackedOffForCacheKey:(NSString *)cacheKey;
+
+@end
+
+@interface NegativeCacheTest : TestBase
+
+@end
+
+@implementation NegativeCacheTest
+
++ (void)setUp {
+    [super setUp];
+
+    HttpDnsService *httpdns = [[HttpDnsService alloc] initWithAccountID:100000];
+    [httpdns setLogEnabled:YES];
+}
+
+- (void)setUp {
+    [super setUp];
+
+    self.httpdns = [HttpDnsService sharedInstance];
+    [self.httpdns setReuseExpiredIPEnabled:NO];
+    [self.httpdns setDegradeToLocalDNSEnabled:NO];
+    [self.httpdns setNegativeCacheTTL:HTTPDNS_DEFAULT_NEGATIVE_CACHE_TTL];
+    [self.httpdns cleanAllHostCache];
+    self.currentTimeStamp = [[NSDate date] timeIntervalSince1970];
+}
+
+- (void)tearDown {
+    [self.httpdns setNegativeCacheTTL:HTTPDNS_DEFAULT_NEGATIVE_CACHE_TTL];
+    [self.httpdns cleanAllHostCache];
+    [super tearDown];
+}
+
+- (HttpdnsHostObject *)constructEmptyHostObject {
+    HttpdnsHostObject *hostObject = [HttpdnsHostObject new];
+    hostObject.hostName = noRecordHost;
+    hostObject.v4Ips = @[];
+    hostObject.v6Ips = @[];
+    return hostObject;
+}
+
+- (void)testNoRecordFamilyUsesNegativeTTL {
+    [self.httpdns setNegativeCacheTTL:120];
+
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4HostObject];
+    HttpdnsHostObject *merged = [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:ipv4OnlyHost cacheKey:ipv4OnlyHost underQueryIpType:HttpdnsQueryIPTypeBoth];
+
+    XCTAssertTrue(merged.hasNoIpv6Record);
+    XCTAssertEqual(merged.v6ttl, 120);
+    int64_t lookupTime = merged.lastIPv6LookupTime;
+    XCTAssertFalse([merged isExpiredUnderQueryIpType:HttpdnsQueryIPTypeBoth atTime:lookupTime + 119]);
+    XCTAssertTrue([merged isExpiredUnderQueryIpType:HttpdnsQueryIPTypeBoth atTime:lookupTime + 120], @"负缓存过期后需要重新请求");
+    XCTAssertEqual([merged staleQueryIpTypeUnderQueryIpType:HttpdnsQueryIPTypeBoth], 0);
+}
+
+- (void)testNoRecordReplacesPreviousIps {
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4AndIpv6HostObject];
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:ipv4AndIpv6Host cacheKey:ipv4AndIpv6Host underQueryIpType:HttpdnsQueryIPTypeBoth];
+
+    // 再次解析双栈时ipv6已经没有记录
+    HttpdnsHostObject *v4Result = [self constructSimpleIpv4HostObject];
+    v4Result.hostName = ipv4AndIpv6Host;
+    HttpdnsHostObject *merged = [self.httpdns.requestManager mergeLookupResultToManager:v4Result host:ipv4AndIpv6Host cacheKey:ipv4AndIpv6Host underQueryIpType:HttpdnsQueryIPTypeBoth];
+
+    XCTAssertTrue(merged.hasNoIpv6Record);
+    XCTAssertEqual([merged getV6Ips].count, 0);
+    XCTAssertEqual([merged getV4Ips].count, 2);
+
+    // 之后又解析到ipv6记录时清除标记
+    HttpdnsHostObject *merged2 = [self.httpdns.requestManager mergeLookupResultToManager:[self constructSimpleIpv4AndIpv6HostObject] host:ipv4AndIpv6Host cacheKey:ipv4AndIpv6Host underQueryIpType:HttpdnsQueryIPTypeBoth];
+    XCTAssertFalse(merged2.hasNoIpv6Record);
+    XCTAssertEqual([merged2 getV6Ips].count, 2);
+    XCTAssertEqual(merged2.v6ttl, 60);
+}
+
+- (void)testHostWithoutAnyRecordIsServedFromNegativeCache {
+    [self presetNetworkEnvAsIpv4AndIpv6];
+
+    [self.httpdns.requestManager mergeLookupResultToManager:[self constructEmptyHostObject] host:noRecordHost cacheKey:noRecordHost underQueryIpType:HttpdnsQueryIPTypeBoth];
+
+    NSUInteger hitCount = [self.httpdns.requestManager negativeCacheHitCount];
+    [self shouldNotHaveCallNetworkRequestWhenResolving:^{
+        XCTAssertNil([self.httpdns resolveHostSyncNonBlocking:noRecordHost byIpType:HttpdnsQueryIPTypeBoth]);
+        XCTAssertNil([self.httpdns resolveHostSyncNonBlocking:noRecordHost byIpType:HttpdnsQueryIPTypeIpv4]);
+    }];
+    XCTAssertEqual([self.httpdns.requestManager negativeCacheHitCount], hitCount + 2);
+
+    struct sockaddr_storage sockaddrs[4];
+    XCTAssertEqual([self.httpdns resolveHostSyncNonBlocking:noRecordHost port:80 byIpType:HttpdnsQueryIPTypeBoth sockaddrs:sockaddrs maxCount:4], 0);
+}
+
+- (void)testFailedHostIsBackedOff {
+    [self presetNetworkEnvAsIpv4];
+
+    HttpdnsRequest *request = [[HttpdnsRequest alloc] initWithHost:noRecordHost queryIpType:HttpdnsQueryIPTypeIpv4];
+    request.cacheKey = noRecordHost;
+
+    // 重试次数已用完且不降级，直接记为一次失败
+    XCTAssertNil([self.httpdns.requestManager executeRequest:request retryCount:HTTPDNS_MAX_REQUEST_RETRY_TIME + 1]);
+    XCTAssertTrue([self.httpdns.requestManager isResolvingBackedOffForCacheKey:noRecordHost]);
+
+    NSUInteger backoffCount = [self.httpdns.requestManager failureBackoffHitCount];
+    [self shouldNotHaveCallNetworkRequestWhenResolving:^{
+        XCTAssertNil([self.httpdns resolveHostSyncNonBlocking:noRecordHost byIpType:HttpdnsQueryIPTypeIpv4]);
+    }];
+    XCTAssertEqual([self.httpdns.requestManager failureBackoffHitCount], backoffCount + 1);
+
+    // 拿到结果后退避状态清除
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4HostObject];
+    hostObject.hostName = noRecordHost;
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:noRecordHost cacheKey:noRecordHost underQueryIpType:HttpdnsQueryIPTypeIpv4];
+    XCTAssertFalse([self.httpdns.requestManager isResolvingBackedOffForCacheKey:noRecordHost]);
+}
+
+- (void)testZeroNegativeTTLDisablesBackoff {
+    [self.httpdns setNegativeCacheTTL:0];
+
+    HttpdnsRequest *request = [[HttpdnsRequest alloc] initWithHost:noRecordHost queryIpType:HttpdnsQueryIPTypeIpv4];
+    request.cacheKey = noRecordHost;
+    [self.httpdns.requestManager executeRequest:request retryCount:HTTPDNS_MAX_REQUEST_RETRY_TIME + 1];
+    XCTAssertFalse([self.httpdns.requestManager isResolvingBackedOffForCacheKey:noRecordHost]);
+
+    HttpdnsHostObject *merged = [self.httpdns.requestManager mergeLookupResultToManager:[self constructSimpleIpv4HostObject] host:ipv4OnlyHost cacheKey:ipv4OnlyHost underQueryIpType:HttpdnsQueryIPTypeBoth];
+    XCTAssertTrue([merged isExpiredUnderQueryIpType:HttpdnsQueryIPTypeIpv6], @"负缓存时长为0时没有记录的结论立即过期");
+}
+
+- (void)testNegativeEntryIsPersisted {
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4HostObject];
+    hostObject.cacheKey = ipv4OnlyHost;
+    [hostObject markNoRecordUnderQueryIpType:HttpdnsQueryIPTypeIpv6 ttl:300 atTime:self.currentTimeStamp];
+
+    HttpdnsDB *db = [[HttpdnsDB alloc] initWithAccountId:999998];
+    [db deleteAll];
+    XCTAssertTrue([db createOrUpdate:[hostObject toDBRecord]]);
+
+    HttpdnsHostObject *restored = [HttpdnsHostObject fromDBRecord:[db selectByCacheKey:ipv4OnlyHost]];
+    XCTAssertTrue(restored.hasNoIpv6Record);
+    XCTAssertFalse(restored.hasNoIpv4Record);
+    XCTAssertEqual([restored getV4Ips].count, 2);
+    XCTAssertEqual(restored.v6ttl, 300);
+    XCTAssertFalse([restored isIpEmptyUnderQueryIpType:HttpdnsQueryIPTypeIpv6]);
+    XCTAssertFalse([restored isExpiredUnderQueryIpType:HttpdnsQueryIPTypeBoth]);
+
+    // 已过期的负缓存不再恢复
+    [hostObject markNoRecordUnderQueryIpType:HttpdnsQueryIPTypeIpv6 ttl:300 atTime:self.currentTimeStamp - 600];
+    XCTAssertTrue([db createOrUpdate:[hostObject toDBRecord]]);
+    restored = [HttpdnsHostObject fromDBRecord:[db selectByCacheKey:ipv4OnlyHost]];
+    XCTAssertFalse(restored.hasNoIpv6Record);
+
+    [db deleteAll];
+}
+
+@end
@@ -0,0 +1,136 @@
+//
+//  PartialRefreshTest.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+#import "TestBase.h"
+#import "HttpdnsHostObject.h"
+#import "HttpdnsRequest_Internal.h"
+#import "HttpdnsService.h"
+#import "HttpdnsService_Internal.h"
+
+@interface PartialRefreshTest : TestBase
+
+@end
+
+@implementation PartialRefreshTest
+
++ (void)setUp {
+    [super setUp];
+
+    HttpDnsService *httpdns = [[HttpDnsService alloc] initWithAccountID:100000];
+    [httpdns setLogEnabled:YES];
+}
+
+- (void)setUp {
+    [super setUp];
+
+    self.httpdns = [HttpDnsService sharedInstance];
+    [self.httpdns setReuseExpiredIPEnabled:NO];
+    self.currentTimeStamp = [[NSDate date] timeIntervalSince1970];
+}
+
+- (void)testStaleQueryIpTypeOnlyContainsExpiredFamilies {
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4AndIpv6HostObject];
+    XCTAssertEqual([hostObject staleQueryIpTypeUnderQueryIpType:HttpdnsQueryIPTypeBoth], 0);
+
+    hostObject.lastIPv6LookupTime = self.currentTimeStamp - 3600;
+    XCTAssertEqual([hostObject staleQueryIpTypeUnderQueryIpType:HttpdnsQueryIPTypeBoth], HttpdnsQueryIPTypeIpv6);
+    XCTAssertEqual([hostObject staleQueryIpTypeUnderQueryIpType:HttpdnsQueryIPTypeIpv4], 0);
+
+    hostObject.lastIPv4LookupTime = self.currentTimeStamp - 3600;
+    XCTAssertEqual([hostObject staleQueryIpTypeUnderQueryIpType:HttpdnsQueryIPTypeBoth], HttpdnsQueryIPTypeBoth);
+
+    // 已确认没有ipv6记录时，负缓存有效期内不再请求ipv6
+    [hostObject markNoRecordUnderQueryIpType:HttpdnsQueryIPTypeIpv6 ttl:60 atTime:self.currentTimeStamp];
+    XCTAssertEqual([hostObject staleQueryIpTypeUnderQueryIpType:HttpdnsQueryIPTypeBoth], HttpdnsQueryIPTypeIpv4);
+
+    // 没有IP的地址族需要请求
+    HttpdnsHostObject *ipv4Only = [self constructSimpleIpv4HostObject];
+    XCTAssertEqual([ipv4Only staleQueryIpTypeUnderQueryIpType:HttpdnsQueryIPTypeBoth], HttpdnsQueryIPTypeIpv6);
+}
+
+- (void)testNarrowedRequestKeepsOtherParameters {
+    HttpdnsRequest *request = [[HttpdnsRequest alloc] initWithHost:ipv4AndIpv6Host
+                                                       queryIpType:HttpdnsQueryIPTypeBoth
+                                                        sdnsParams:@{@"a": @"b"}
+                                                          cacheKey:@"key"
+                                                    resolveTimeout:3];
+    request.accountId = 100000;
+    [request becomeBlockingRequest];
+
+    HttpdnsRequest *narrowed = [request requestNarrowedToQueryIpType:HttpdnsQueryIPTypeIpv6];
+    XCTAssertEqual(narrowed.queryIpType, HttpdnsQueryIPTypeIpv6);
+    XCTAssertEqual(request.queryIpType, HttpdnsQueryIPTypeBoth);
+    XCTAssertEqualObjects(narrowed.host, ipv4AndIpv6Host);
+    XCTAssertEqualObjects(narrowed.sdnsParams, (@{@"a": @"b"}));
+    XCTAssertEqualObjects(narrowed.cacheKey, @"key");
+    XCTAssertEqual(narrowed.resolveTimeoutInSecond, 3);
+    XCTAssertEqual(narrowed.accountId, 100000);
+    XCTAssertTrue(narrowed.isBlockingRequest);
+}
+
+- (void)testMergingOneFamilyKeepsTheOtherHalf {
+    [self.httpdns cleanAllHostCache];
+
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4AndIpv6HostObject];
+    hostObject.lastIPv6LookupTime = self.currentTimeStamp - 3600;
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:ipv4AndIpv6Host cacheKey:ipv4AndIpv6Host underQueryIpType:HttpdnsQueryIPTypeBoth];
+
+    // 只带回ipv6的结果
+    HttpdnsHostObject *v6Result = [self constructSimpleIpv6HostObject];
+    v6Result.hostName = ipv4AndIpv6Host;
+    v6Result.v6ttl = 300;
+    HttpdnsHostObject *merged = [self.httpdns.requestManager mergeLookupResultToManager:v6Result host:ipv4AndIpv6Host cacheKey:ipv4AndIpv6Host underQueryIpType:HttpdnsQueryIPTypeIpv6];
+
+    XCTAssertEqual([merged getV4Ips].count, 2, @"未请求的ipv4结果应保留");
+    XCTAssertEqual(merged.v4ttl, 60);
+    XCTAssertEqual(merged.lastIPv4LookupTime, (int64_t)self.currentTimeStamp);
+    XCTAssertEqual(merged.v6ttl, 300);
+    XCTAssertEqual([merged staleQueryIpTypeUnderQueryIpType:HttpdnsQueryIPTypeBoth], 0);
+}
+
+- (void)testMergingOneFamilyKeepsNoRecordFlagOfTheOther {
+    [self.httpdns cleanAllHostCache];
+
+    // ipv6确认没有记录
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4HostObject];
+    hostObject.hostName = ipv4AndIpv6Host;
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:ipv4AndIpv6Host cacheKey:ipv4AndIpv6Host underQueryIpType:HttpdnsQueryIPTypeBoth];
+
+    HttpdnsHostObject *v4Result = [self constructSimpleIpv4HostObject];
+    v4Result.hostName = ipv4AndIpv6Host;
+    HttpdnsHostObject *merged = [self.httpdns.requestManager mergeLookupResultToManager:v4Result host:ipv4AndIpv6Host cacheKey:ipv4AndIpv6Host underQueryIpType:HttpdnsQueryIPTypeIpv4];
+
+    XCTAssertTrue(merged.hasNoIpv6Record, @"只请求ipv4时不应清除ipv6的无记录标记");
+    XCTAssertFalse(merged.hasNoIpv4Record);
+}
+
+- (void)testExpiredHalfIsRefreshedAlone {
+    [self presetNetworkEnvAsIpv4AndIpv6];
+    [self.httpdns cleanAllHostCache];
+
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4AndIpv6HostObject];
+    hostObject.lastIPv6LookupTime = self.currentTimeStamp - 3600;
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:ipv4AndIpv6Host cacheKey:ipv4AndIpv6Host underQueryIpType:HttpdnsQueryIPTypeBoth];
+
+    HttpdnsRequestManager *mockRequestManager = OCMPartialMock(self.httpdns.requestManager);
+    XCTestExpectation *expectation = [self expectationWithDescription:@"partial refresh"];
+    OCMStub([mockRequestManager executeRequest:[OCMArg checkWithBlock:^BOOL(HttpdnsRequest *request) {
+        return request.queryIpType == HttpdnsQueryIPTypeIpv6;
+    }] retryCount:0]).andDo(^(NSInvocation *invocation) {
+        [expectation fulfill];
+    }).andReturn(nil);
+
+    [self.httpdns resolveHostSyncNonBlocking:ipv4AndIpv6Host byIpType:HttpdnsQueryIPTypeBoth];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    [mockRequestManager stopMocking];
+}
+
+@end
@@ -0,0 +1,173 @@
+//
+//  PersistentCacheLazyLoadTest.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/20.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "TestBase.h"
+#import "HttpdnsDB.h"
+#import "HttpdnsHostRecord.h"
+#import "HttpdnsInternalConstant.h"
+
+static const NSInteger kLazyLoadTestAccountId = 100001;
+static const NSInteger kLazyLoadTestRecordCount = 30;
+
+@interface PersistentCacheLazyLoadTest : TestBase
+
+@property (nonatomic, strong) HttpdnsDB *db;
+
+@end
+
+@implementation PersistentCacheLazyLoadTest
+
+- (void)setUp {
+    [super setUp];
+
+    self.httpdns = [[HttpDnsService alloc] initWithAccountID:kLazyLoadTestAccountId];
+    [self.httpdns setReuseExpiredIPEnabled:NO];
+    [self.httpdns.requestManager setPersistentCacheIpEnabled:YES];
+    // 只清理内存，数据库由下面的连接同步清理，避免与异步删除产生竞争
+    [self.httpdns.requestManager cleanAllHostMemoryCache];
+
+    self.db = [[HttpdnsDB alloc] initWithAccountId:kLazyLoadTestAccountId];
+    [self.db deleteAll];
+
+    NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
+    for (NSInteger i = 0; i < kLazyLoadTestRecordCount; i++) {
+        NSString *host = [NSString stringWithFormat:@"lazy%ld.example.com", (long)i];
+        HttpdnsHostRecord *record = [[HttpdnsHostRecord alloc] initWithId:0
+                                                                 cacheKey:host
+                                                                 hostName:host
+                                                                 createAt:[NSDate date]
+                                                                 modifyAt:[NSDate date]
+                                                                 clientIp:@"192.168.1.1"
+                                                                    v4ips:@[ipv41, ipv42]
+                                                                    v4ttl:600
+                                                             v4LookupTime:(int64_t)now
+                                                                    v6ips:@[]
+                                                                    v6ttl:0
+                                                             v6LookupTime:0
+                                                                    extra:@""];
+        // 逐条写入，保证每条记录的更新时间不同
+        [self.db createOrUpdate:record];
+    }
+}
+
+- (void)tearDown {
+    [self.db deleteAll];
+    // 用空数据库重建快照，避免影响后续用例
+    [self.httpdns.requestManager syncRebuildCacheSnapshot];
+    [self.httpdns.requestManager cleanAllHostMemoryCache];
+    self.db = nil;
+
+    [super tearDown];
+}
+
+- (void)testStartupOnlyPreloadsRecentRecords {
+    [self.httpdns.requestManager syncLoadCacheFromDbToMemory];
+
+    XCTAssertEqual([self.httpdns.requestManager memoryCacheCount], HTTPDNS_PERSISTENT_CACHE_PRELOAD_COUNT,
+                   @"Only the most recently modified records should be loaded at startup");
+}
+
+- (void)testMemoryMissFallsThroughToDB {
+    [self.httpdns.requestManager syncLoadCacheFromDbToMemory];
+
+    // 最早写入的记录不在预加载范围内
+    HttpdnsResult *result = [self.httpdns resolveHostSync:@"lazy0.example.com" byIpType:HttpdnsQueryIPTypeIpv4];
+    XCTAssertNotNil(result, @"A memory miss should be served from the persisted record");
+    XCTAssertEqualObjects(result.ips.firstObject, ipv41);
+    XCTAssertEqual([self.httpdns.requestManager memoryCacheCount], HTTPDNS_PERSISTENT_CACHE_PRELOAD_COUNT + 1,
+                   @"The on-demand record should now be cached in memory");
+}
+
+- (void)testNonBlockingMissLoadsFromDBInBackground {
+    [self.httpdns.requestManager syncLoadCacheFromDbToMemory];
+
+    // 非阻塞接口不在调用线程读数据库，本次按未命中返回
+    XCTAssertNil([self.httpdns resolveHostSyncNonBlocking:@"lazy0.example.com" byIpType:HttpdnsQueryIPTypeIpv4]);
+
+    [self.httpdns.requestManager waitForPersistentCacheTasks];
+    HttpdnsResult *result = [self.httpdns resolveHostSyncNonBlocking:@"lazy0.example.com" byIpType:HttpdnsQueryIPTypeIpv4];
+    XCTAssertNotNil(result, @"The record loaded in background should serve later lookups");
+    XCTAssertEqualObjects(result.ips.firstObject, ipv41);
+}
+
+- (void)testUnknownHostDoesNotHitDB {
+    [self.httpdns.requestManager syncLoadCacheFromDbToMemory];
+
+    HttpdnsResult *result = [self.httpdns resolveHostSyncNonBlocking:@"not.persisted.example.com" byIpType:HttpdnsQueryIPTypeIpv4];
+    XCTAssertNil(result, @"Hosts absent from the persisted index should go straight to the network path");
+}
+
+- (void)testColdStartHitServedFromSnapshot {
+    [self.httpdns.requestManager syncRebuildCacheSnapshot];
+    [self.httpdns.requestManager cleanAllHostMemoryCache];
+
+    // 不加载数据库索引，模拟启动时数据库尚未加载完成
+    HttpdnsResult *result = [self.httpdns resolveHostSyncNonBlocking:@"lazy5.example.com" byIpType:HttpdnsQueryIPTypeIpv4];
+    XCTAssertNotNil(result, @"Cold start lookups should be served from the mapped snapshot");
+    XCTAssertEqualObjects(result.ips.firstObject, ipv41);
+}
+
+- (void)testCleanedHostIsNotReloadedFromSnapshot {
+    [self.httpdns.requestManager syncRebuildCacheSnapshot];
+    [self.httpdns.requestManager cleanAllHostMemoryCache];
+
+    [self.httpdns.requestManager cleanMemoryAndPersistentCacheOfHostArray:@[@"lazy5.example.com"]];
+
+    HttpdnsResult *result = [self.httpdns resolveHostSyncNonBlocking:@"lazy5.example.com" byIpType:HttpdnsQueryIPTypeIpv4];
+    XCTAssertNil(result, @"A cleaned host must not be revived from the snapshot");
+}
+
+- (void)testCleanedHostIsNotReloadedFromDB {
+    [self.httpdns.requestManager syncLoadCacheFromDbToMemory];
+
+    [self.httpdns.requestManager cleanMemoryAndPersistentCacheOfHostArray:@[@"lazy0.example.com"]];
+
+    HttpdnsResult *result = [self.httpdns resolveHostSyncNonBlocking:@"lazy0.example.com" byIpType:HttpdnsQueryIPTypeIpv4];
+    XCTAssertNil(result, @"A cleaned host must not be revived from the persisted index");
+}
+
+- (void)testEvictedHostIsNotReloadedFromSnapshot {
+    [self.httpdns.requestManager syncRebuildCacheSnapshot];
+    [self.httpdns.requestManager cleanAllHostMemoryCache];
+
+    XCTAssertNotNil([self.httpdns resolveHostSyncNonBlocking:@"lazy5.example.com" byIpType:HttpdnsQueryIPTypeIpv4]);
+
+    // 模拟网络切换后从内存移除，快照中的旧结果不能再被加载回来
+    [self.httpdns.requestManager cleanAllHostMemoryCache];
+    HttpdnsResult *result = [self.httpdns resolveHostSyncNonBlocking:@"lazy5.example.com" byIpType:HttpdnsQueryIPTypeIpv4];
+    XCTAssertNil(result, @"Each snapshot record should be loaded at most once");
+}
+
+- (void)testLongExpiredSnapshotRecordIsDiscarded {
+    NSString *host = @"expired.lazy.example.com";
+    int64_t lookupTime = (int64_t)[[NSDate date] timeIntervalSince1970] - 3 * 24 * 3600;
+    HttpdnsHostRecord *record = [[HttpdnsHostRecord alloc] initWithId:0
+                                                             cacheKey:host
+                                                             hostName:host
+                                                             createAt:[NSDate date]
+                                                             modifyAt:[NSDate date]
+                                                             clientIp:@"192.168.1.1"
+                                                                v4ips:@[ipv41]
+                                                                v4ttl:600
+                                                         v4LookupTime:lookupTime
+                                                                v6ips:@[]
+                                                                v6ttl:0
+                                                         v6LookupTime:0
+                                                                extra:@""];
+    [self.db createOrUpdate:record];
+    [self.httpdns.requestManager syncRebuildCacheSnapshot];
+    [self.httpdns.requestManager cleanAllHostMemoryCache];
+    [self.httpdns setReuseExpiredIPEnabled:YES];
+
+    HttpdnsResult *result = [self.httpdns resolveHostSyncNonBlocking:host byIpType:HttpdnsQueryIPTypeIpv4];
+    [self.httpdns setReuseExpiredIPEnabled:NO];
+    XCTAssertNil(result, @"Snapshot records expired beyond the discard threshold should not be served");
+}
+
+@end
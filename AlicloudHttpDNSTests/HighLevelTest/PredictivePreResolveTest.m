@@ -0,0 +1,273 @@
+//
+//  PredictivePreResolveTest.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+#import <OCMock/OCMock.h>
+#import "TestBase.h"
+#import "HttpdnsHostObject.h"
+#import "HttpdnsHostTransitionPredictor.h"
+#import "HttpdnsMetrics.h"
+#import "HttpdnsRequestManager.h"
+#import "HttpdnsRequest_Internal.h"
+#import "HttpdnsService_Internal.h"
+#import "HttpdnsVirtualClock.h"
+
+static NSString *const kApiHost = @"api.predict.onlyfortest.com";
+static NSString *const kImgHost = @"img.predict.onlyfortest.com";
+static NSString *const kCdnHost = @"cdn.predict.onlyfortest.com";
+
+@interface PredictivePreResolveTest : TestBase
+
+@property (nonatomic, strong) HttpdnsVirtualClock *clock;
+
+@end
+
+@implementation PredictivePreResolveTest
+
++ (void)setUp {
+    [super setUp];
+
+    HttpDnsService *httpdns = [[HttpDnsService alloc] initWithAccountID:100000];
+    [httpdns setLogEnabled:YES];
+}
+
+- (void)setUp {
+    [super setUp];
+
+    self.httpdns = [HttpDnsService sharedInstance];
+    [self.httpdns setReuseExpiredIPEnabled:NO];
+    [self.httpdns cleanAllHostCache];
+    self.currentTimeStamp = [[NSDate date] timeIntervalSince1970];
+}
+
+- (void)tearDown {
+    [self.clock uninstall];
+    self.clock = nil;
+    [self.httpdns setPredictivePreResolveEnabled:NO];
+    [self.httpdns cleanAllHostCache];
+    [super tearDown];
+}
+
+- (HttpdnsHostTransitionPredictor *)createPredictor {
+    return [[HttpdnsHostTransitionPredictor alloc] initWithHalfLife:1000
+                                                     maxSourceCount:8
+                                                  maxSuccessorCount:4
+                                                   transitionWindow:1
+                                                   predictionWindow:30];
+}
+
+- (void)recordHosts:(NSArray<NSString *> *)hosts startingAt:(NSTimeInterval)time predictor:(HttpdnsHostTransitionPredictor *)predictor {
+    for (NSString *host in hosts) {
+        [predictor recordAccessForHost:host atTime:time];
+        time += 0.2;
+    }
+}
+
+#pragma mark - Predictor
+
+- (void)testSuccessorsWithinWindowAreLearned {
+    HttpdnsHostTransitionPredictor *predictor = [self createPredictor];
+    for (int i = 0; i < 2; i++) {
+        [self recordHosts:@[kApiHost, kImgHost, kCdnHost] startingAt:100 + i * 100 predictor:predictor];
+        // 超出窗口的访问不记为后继
+        [predictor recordAccessForHost:@"late.predict.onlyfortest.com" atTime:105 + i * 100];
+    }
+
+    NSArray *successors = [predictor likelySuccessorsOfHost:kApiHost limit:4 minProbability:0.5 minScore:2 atTime:201];
+    XCTAssertEqualObjects([NSSet setWithArray:successors], ([NSSet setWithArray:@[kImgHost, kCdnHost]]));
+
+    successors = [predictor likelySuccessorsOfHost:kApiHost limit:1 minProbability:0.5 minScore:2 atTime:201];
+    XCTAssertEqual(successors.count, 1);
+
+    // 只出现过一次的先后关系不预测
+    successors = [predictor likelySuccessorsOfHost:kApiHost limit:4 minProbability:0.5 minScore:3 atTime:201];
+    XCTAssertEqual(successors.count, 0);
+}
+
+- (void)testRepeatedSuccessorIsCountedOncePerOccurrence {
+    HttpdnsHostTransitionPredictor *predictor = [self createPredictor];
+    [self recordHosts:@[kApiHost, kImgHost, kImgHost, kImgHost] startingAt:100 predictor:predictor];
+    XCTAssertEqual([predictor likelySuccessorsOfHost:kApiHost limit:4 minProbability:0 minScore:1.5 atTime:101].count, 0);
+
+    [self recordHosts:@[kApiHost, kImgHost] startingAt:200 predictor:predictor];
+    XCTAssertEqualObjects([predictor likelySuccessorsOfHost:kApiHost limit:4 minProbability:0.9 minScore:1.5 atTime:201], @[kImgHost]);
+}
+
+- (void)testUnlikelySuccessorIsNotPredicted {
+    HttpdnsHostTransitionPredictor *predictor = [self createPredictor];
+    for (int i = 0; i < 5; i++) {
+        NSArray *hosts = i < 2 ? @[kApiHost, kImgHost] : @[kApiHost];
+        [self recordHosts:hosts startingAt:100 + i * 10 predictor:predictor];
+    }
+
+    // 5次中只有2次紧随其后
+    XCTAssertEqual([predictor likelySuccessorsOfHost:kApiHost limit:4 minProbability:0.5 minScore:1.5 atTime:150].count, 0);
+    XCTAssertEqualObjects([predictor likelySuccessorsOfHost:kApiHost limit:4 minProbability:0.3 minScore:1.5 atTime:150], @[kImgHost]);
+}
+
+- (void)testPredictionHitIsCountedWithinWindow {
+    HttpdnsHostTransitionPredictor *predictor = [self createPredictor];
+    for (int i = 0; i < 2; i++) {
+        [self recordHosts:@[kApiHost, kImgHost] startingAt:100 + i * 100 predictor:predictor];
+    }
+
+    uint64_t prefetchCount = HttpdnsMetricsCounterValue(HttpdnsMetricCounterPredictedPrefetch);
+    uint64_t hitCount = HttpdnsMetricsCounterValue(HttpdnsMetricCounterPredictedHit);
+
+    XCTAssertEqualObjects([predictor markPredictedHosts:@[kImgHost, kCdnHost] atTime:300], (@[kImgHost, kCdnHost]));
+    XCTAssertEqual(HttpdnsMetricsCounterValue(HttpdnsMetricCounterPredictedPrefetch) - prefetchCount, 2);
+
+    // 预测有效期内不重复预测，也不重复计数
+    XCTAssertEqual([predictor likelySuccessorsOfHost:kApiHost limit:4 minProbability:0.5 minScore:1.5 atTime:301].count, 0);
+    XCTAssertEqual([predictor markPredictedHosts:@[kImgHost, kCdnHost] atTime:301].count, 0);
+    XCTAssertEqual(HttpdnsMetricsCounterValue(HttpdnsMetricCounterPredictedPrefetch) - prefetchCount, 2);
+
+    [predictor recordAccessForHost:kImgHost atTime:305];
+    [predictor recordAccessForHost:kImgHost atTime:306];
+    // 超出预测窗口的访问不算命中
+    [predictor recordAccessForHost:kCdnHost atTime:340];
+    XCTAssertEqual(HttpdnsMetricsCounterValue(HttpdnsMetricCounterPredictedHit) - hitCount, 1);
+}
+
+- (void)testSourceCountIsBounded {
+    HttpdnsHostTransitionPredictor *predictor = [[HttpdnsHostTransitionPredictor alloc] initWithHalfLife:1000
+                                                                                         maxSourceCount:2
+                                                                                      maxSuccessorCount:4
+                                                                                       transitionWindow:1
+                                                                                       predictionWindow:30];
+    [self recordHosts:@[kApiHost, kImgHost] startingAt:100 predictor:predictor];
+    [self recordHosts:@[kApiHost, kImgHost] startingAt:200 predictor:predictor];
+    [predictor recordAccessForHost:kApiHost atTime:250];
+    // 新域名淘汰出现次数最少的源域名，已学到的后继关系不受影响
+    [predictor recordAccessForHost:kCdnHost atTime:300];
+
+    XCTAssertEqual(predictor.count, 2);
+    XCTAssertEqualObjects([predictor likelySuccessorsOfHost:kApiHost limit:4 minProbability:0.5 minScore:1.5 atTime:300], @[kImgHost]);
+}
+
+#pragma mark - Request manager
+
+- (void)presetHost:(NSString *)host {
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4HostObject];
+    hostObject.hostName = host;
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:host cacheKey:host underQueryIpType:HttpdnsQueryIPTypeIpv4];
+}
+
+- (void)trainApiFollowedByImgAndCdn {
+    [self presetNetworkEnvAsIpv4];
+    [self presetHost:kApiHost];
+    [self presetHost:kImgHost];
+    [self presetHost:kCdnHost];
+
+    self.clock = [[HttpdnsVirtualClock alloc] initWithStartTime:self.currentTimeStamp];
+    [self.clock install];
+    [self.httpdns setPredictivePreResolveEnabled:YES];
+
+    for (int i = 0; i < 2; i++) {
+        for (NSString *host in @[kApiHost, kImgHost, kCdnHost]) {
+            XCTAssertNotNil([self.httpdns resolveHostSyncNonBlocking:host byIpType:HttpdnsQueryIPTypeIpv4]);
+            [self.clock advanceBy:0.1];
+        }
+        [self.clock advanceBy:5];
+    }
+}
+
+- (void)testPredictedHostsArePrefetchedOnCacheHit {
+    [self trainApiFollowedByImgAndCdn];
+    [self.httpdns.requestManager cleanMemoryAndPersistentCacheOfHostArray:@[kImgHost, kCdnHost]];
+
+    id mockManager = OCMPartialMock(self.httpdns.requestManager);
+    NSMutableArray<NSArray *> *prefetchedHosts = [NSMutableArray array];
+    OCMStub([mockManager preResolveHosts:[OCMArg any] queryType:HttpdnsQueryIPTypeIpv4]).andDo(^(NSInvocation *invocation) {
+        __unsafe_unretained NSArray *hosts = nil;
+        [invocation getArgument:&hosts atIndex:2];
+        if (hosts) {
+            [prefetchedHosts addObject:hosts];
+        }
+    });
+
+    uint64_t prefetchCount = HttpdnsMetricsCounterValue(HttpdnsMetricCounterPredictedPrefetch);
+    uint64_t hitCount = HttpdnsMetricsCounterValue(HttpdnsMetricCounterPredictedHit);
+
+    XCTAssertNotNil([self.httpdns resolveHostSyncNonBlocking:kApiHost byIpType:HttpdnsQueryIPTypeIpv4]);
+    // 缓存命中时预测在后台队列上进行
+    [self.httpdns.requestManager waitForAsyncResolveTasks];
+    XCTAssertEqual(prefetchedHosts.count, 1);
+    XCTAssertEqualObjects([NSSet setWithArray:prefetchedHosts.firstObject], ([NSSet setWithArray:@[kImgHost, kCdnHost]]));
+
+    // 预解析的结果到达后，随后的解析计为命中
+    [self presetHost:kCdnHost];
+    [self.clock advanceBy:0.1];
+    XCTAssertNotNil([self.httpdns resolveHostSyncNonBlocking:kCdnHost byIpType:HttpdnsQueryIPTypeIpv4]);
+
+    HttpdnsStatistics *statistics = [self.httpdns statisticsSnapshot];
+    XCTAssertEqual(HttpdnsMetricsCounterValue(HttpdnsMetricCounterPredictedPrefetch) - prefetchCount, 2);
+    XCTAssertEqual(HttpdnsMetricsCounterValue(HttpdnsMetricCounterPredictedHit) - hitCount, 1);
+    XCTAssertGreaterThan(statistics.predictedHitRate, 0);
+
+    [mockManager stopMocking];
+}
+
+- (void)testPredictedHostsJoinMissingHostRequest {
+    [self trainApiFollowedByImgAndCdn];
+    [self.httpdns.requestManager cleanMemoryAndPersistentCacheOfHostArray:@[kApiHost, kImgHost, kCdnHost]];
+
+    id mockManager = OCMPartialMock(self.httpdns.requestManager);
+    __block HttpdnsRequest *resolvingRequest = nil;
+    OCMStub([mockManager executeRequest:[OCMArg any] retryCount:0]).andDo(^(NSInvocation *invocation) {
+        __unsafe_unretained HttpdnsRequest *request = nil;
+        [invocation getArgument:&request atIndex:2];
+        resolvingRequest = request;
+        __unsafe_unretained HttpdnsHostObject *result = nil;
+        [invocation setReturnValue:&result];
+    });
+    OCMReject([mockManager preResolveHosts:[OCMArg isNotNil] queryType:HttpdnsQueryIPTypeIpv4]);
+
+    XCTAssertNil([self.httpdns resolveHostSyncNonBlocking:kApiHost byIpType:HttpdnsQueryIPTypeIpv4]);
+    [self.httpdns.requestManager waitForAsyncResolveTasks];
+
+    // 预测的域名与缺失的域名在同一个请求中解析
+    XCTAssertNotNil(resolvingRequest);
+    XCTAssertEqualObjects(resolvingRequest.host, kApiHost);
+    XCTAssertEqualObjects([NSSet setWithArray:resolvingRequest.predictedHosts], ([NSSet setWithArray:@[kImgHost, kCdnHost]]));
+    XCTAssertTrue([[resolvingRequest resolvingHostsString] hasPrefix:[kApiHost stringByAppendingString:@","]]);
+
+    OCMVerifyAll(mockManager);
+    [mockManager stopMocking];
+}
+
+- (void)testSdnsRequestWithoutCacheKeyIsNotPredicted {
+    [self trainApiFollowedByImgAndCdn];
+    [self.httpdns.requestManager cleanMemoryAndPersistentCacheOfHostArray:@[kApiHost, kImgHost, kCdnHost]];
+
+    id mockManager = OCMPartialMock(self.httpdns.requestManager);
+    __block HttpdnsRequest *resolvingRequest = nil;
+    OCMStub([mockManager executeRequest:[OCMArg any] retryCount:0]).andDo(^(NSInvocation *invocation) {
+        __unsafe_unretained HttpdnsRequest *request = nil;
+        [invocation getArgument:&request atIndex:2];
+        resolvingRequest = request;
+        __unsafe_unretained HttpdnsHostObject *result = nil;
+        [invocation setReturnValue:&result];
+    });
+    OCMReject([mockManager preResolveHosts:[OCMArg isNotNil] queryType:HttpdnsQueryIPTypeIpv4]);
+
+    // cacheKey默认为域名，但SDNS参数会随请求发给所有域名，结果不能写入这些域名的普通缓存
+    XCTAssertNil([self.httpdns resolveHostSyncNonBlocking:kApiHost byIpType:HttpdnsQueryIPTypeIpv4 withSdnsParams:@{@"sdns-region": @"test"} sdnsCacheKey:nil]);
+    [self.httpdns.requestManager waitForAsyncResolveTasks];
+
+    XCTAssertNotNil(resolvingRequest);
+    XCTAssertEqualObjects(resolvingRequest.cacheKey, kApiHost);
+    XCTAssertEqual(resolvingRequest.predictedHosts.count, 0);
+    XCTAssertEqualObjects([resolvingRequest resolvingHostsString], kApiHost);
+
+    OCMVerifyAll(mockManager);
+    [mockManager stopMocking];
+}
+
+@end
@@ -0,0 +1,136 @@
+//
+//  ResolveRecorderTest.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+#import "TestBase.h"
+#import "HttpdnsHostObject.h"
+#import "HttpdnsMetrics.h"
+#import "HttpdnsRequestManager.h"
+#import "HttpdnsResolveRecorder.h"
+#import "HttpdnsService_Internal.h"
+
+@interface ResolveRecorderTest : TestBase
+
+@property (nonatomic, copy) NSString *recordPath;
+
+@end
+
+@implementation ResolveRecorderTest
+
++ (void)setUp {
+    [super setUp];
+
+    HttpDnsService *httpdns = [[HttpDnsService alloc] initWithAccountID:100000];
+    [httpdns setLogEnabled:YES];
+}
+
+- (void)setUp {
+    [super setUp];
+
+    self.httpdns = [HttpDnsService sharedInstance];
+    [self.httpdns setReuseExpiredIPEnabled:NO];
+    [self.httpdns cleanAllHostCache];
+    self.currentTimeStamp = [[NSDate date] timeIntervalSince1970];
+    self.recordPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"resolve_record_%@.bin", [NSUUID UUID].UUIDString]];
+}
+
+- (void)tearDown {
+    [self.httpdns stopRecordingResolveEvents];
+    [self.httpdns cleanAllHostCache];
+    [[NSFileManager defaultManager] removeItemAtPath:self.recordPath error:nil];
+    [super tearDown];
+}
+
+- (NSData *)recordsInFile:(NSString *)path {
+    NSData *data = [NSData dataWithContentsOfFile:path];
+    XCTAssertGreaterThanOrEqual(data.length, sizeof(HttpdnsResolveRecordFileHeader));
+
+    HttpdnsResolveRecordFileHeader header;
+    [data getBytes:&header length:sizeof(header)];
+    XCTAssertEqual(memcmp(header.magic, HTTPDNS_RESOLVE_RECORD_MAGIC, sizeof(header.magic)), 0);
+    XCTAssertEqual(header.version, HTTPDNS_RESOLVE_RECORD_VERSION);
+    XCTAssertEqual(header.recordSize, sizeof(HttpdnsResolveRecord));
+    XCTAssertEqualWithAccuracy(header.startTime, [[NSDate date] timeIntervalSince1970], 60);
+
+    NSData *records = [data subdataWithRange:NSMakeRange(sizeof(header), data.length - sizeof(header))];
+    XCTAssertEqual(records.length % sizeof(HttpdnsResolveRecord), 0);
+    return records;
+}
+
+- (void)testResolveEventsAreRecorded {
+    [self presetNetworkEnvAsIpv4];
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4HostObject];
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:ipv4OnlyHost cacheKey:ipv4OnlyHost underQueryIpType:HttpdnsQueryIPTypeIpv4];
+
+    NSError *error = nil;
+    XCTAssertTrue([self.httpdns startRecordingResolveEventsToPath:self.recordPath error:&error]);
+    XCTAssertNil(error);
+
+    NSString *missingHost = @"record.miss.onlyfortest.com";
+    [self shouldNotHaveCallNetworkRequestWhenResolving:^{
+        XCTAssertNotNil([self.httpdns resolveHostSyncNonBlocking:ipv4OnlyHost byIpType:HttpdnsQueryIPTypeIpv4]);
+    }];
+    [self shouldHaveCalledRequestWhenResolving:^{
+        XCTAssertNil([self.httpdns resolveHostSyncNonBlocking:missingHost byIpType:HttpdnsQueryIPTypeIpv4]);
+        [self.httpdns.requestManager waitForAsyncResolveTasks];
+    }];
+    [self.httpdns stopRecordingResolveEvents];
+
+    // 停止之后的解析不再记录
+    [self.httpdns resolveHostSyncNonBlocking:ipv4OnlyHost byIpType:HttpdnsQueryIPTypeIpv4];
+
+    NSData *records = [self recordsInFile:self.recordPath];
+    XCTAssertEqual(records.length / sizeof(HttpdnsResolveRecord), 2);
+    const HttpdnsResolveRecord *record = records.bytes;
+
+    XCTAssertEqual(record[0].hostHash, HttpdnsResolveRecordHostHash(ipv4OnlyHost.UTF8String));
+    XCTAssertEqual(record[0].queryIpType, HttpdnsQueryIPTypeIpv4);
+    XCTAssertEqual(record[0].outcome, HttpdnsResolveRecordOutcomeHit);
+    XCTAssertEqual(record[0].flags, HttpdnsResolveRecordFlagAnswered | HttpdnsResolveRecordFlagFastPath);
+
+    XCTAssertEqual(record[1].hostHash, HttpdnsResolveRecordHostHash(missingHost.UTF8String));
+    XCTAssertEqual(record[1].outcome, HttpdnsResolveRecordOutcomeMiss);
+    XCTAssertEqual(record[1].flags, 0);
+    XCTAssertGreaterThanOrEqual(record[1].timestamp, record[0].timestamp);
+}
+
+- (void)testRecordsAreFlushedInBatches {
+    HttpdnsResolveRecorder *recorder = [[HttpdnsResolveRecorder alloc] initWithPath:self.recordPath error:nil];
+    XCTAssertNotNil(recorder);
+
+    // 超过一批的数量，验证攒批写入和关闭时写出剩余记录
+    NSUInteger recordCount = 1000;
+    dispatch_apply(recordCount, dispatch_get_global_queue(0, 0), ^(size_t i) {
+        [recorder recordHostHash:i
+                     queryIpType:HttpdnsQueryIPTypeIpv4
+                         outcome:HttpdnsResolveRecordOutcomeHit
+                           flags:HttpdnsResolveRecordFlagAnswered
+                       startTime:HttpdnsMetricsNow()];
+    });
+    XCTAssertEqual(recorder.recordCount, recordCount);
+    [recorder close];
+
+    NSData *records = [self recordsInFile:self.recordPath];
+    XCTAssertEqual(records.length / sizeof(HttpdnsResolveRecord), recordCount);
+
+    NSMutableIndexSet *hostHashes = [NSMutableIndexSet indexSet];
+    const HttpdnsResolveRecord *record = records.bytes;
+    for (NSUInteger i = 0; i < recordCount; i++) {
+        [hostHashes addIndex:(NSUInteger)record[i].hostHash];
+    }
+    XCTAssertEqual(hostHashes.count, recordCount);
+}
+
+- (void)testUnwritablePathFails {
+    NSError *error = nil;
+    XCTAssertFalse([self.httpdns startRecordingResolveEventsToPath:@"/nonexistent-directory/record.bin" error:&error]);
+    XCTAssertNotNil(error);
+}
+
+@end
@@ -0,0 +1,145 @@
+//
+//  ResolveTraceTest.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+#import "TestBase.h"
+#import "HttpdnsHostObject.h"
+#import "HttpdnsRemoteResolver.h"
+#import "HttpdnsRequest_Internal.h"
+#import "HttpdnsResolveTrace_Internal.h"
+#import "HttpdnsService.h"
+#import "HttpdnsService_Internal.h"
+
+@interface ResolveTraceTest : TestBase
+
+@end
+
+@implementation ResolveTraceTest
+
++ (void)setUp {
+    [super setUp];
+
+    HttpDnsService *httpdns = [[HttpDnsService alloc] initWithAccountID:100000];
+    [httpdns setLogEnabled:YES];
+}
+
+- (void)setUp {
+    [super setUp];
+
+    self.httpdns = [HttpDnsService sharedInstance];
+    [self.httpdns setReuseExpiredIPEnabled:NO];
+    [self.httpdns cleanAllHostCache];
+    self.currentTimeStamp = [[NSDate date] timeIntervalSince1970];
+}
+
+- (void)tearDown {
+    [self.httpdns setResolveTraceSampleRate:0 handler:nil];
+    [self.httpdns cleanAllHostCache];
+    [super tearDown];
+}
+
+- (HttpdnsRequest *)blockingRequestForHost:(NSString *)host queryIpType:(HttpdnsQueryIPType)queryIpType {
+    HttpdnsRequest *request = [[HttpdnsRequest alloc] initWithHost:host queryIpType:queryIpType];
+    request.cacheKey = host;
+    request.resolveTimeoutInSecond = 5;
+    [request becomeBlockingRequest];
+    return request;
+}
+
+- (void)testCacheHitIsTraced {
+    [self presetNetworkEnvAsIpv4];
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4HostObject];
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:ipv4OnlyHost cacheKey:ipv4OnlyHost underQueryIpType:HttpdnsQueryIPTypeIpv4];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"trace delivered"];
+    __block HttpdnsResolveTrace *receivedTrace = nil;
+    [self.httpdns setResolveTraceSampleRate:1 handler:^(HttpdnsResolveTrace *trace) {
+        receivedTrace = trace;
+        [expectation fulfill];
+    }];
+
+    [self.httpdns.requestManager resolveHost:[self blockingRequestForHost:ipv4OnlyHost queryIpType:HttpdnsQueryIPTypeIpv4]];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertEqualObjects(receivedTrace.host, ipv4OnlyHost);
+    XCTAssertEqual(receivedTrace.queryIpType, HttpdnsQueryIPTypeIpv4);
+    XCTAssertTrue(receivedTrace.cacheHit);
+    XCTAssertEqual(receivedTrace.spans.count, 1);
+    XCTAssertEqual(receivedTrace.spans.firstObject.phase, HttpdnsResolveTracePhaseCacheLookup);
+    XCTAssertGreaterThanOrEqual(receivedTrace.endTime, receivedTrace.spans.firstObject.endTime);
+    XCTAssertGreaterThanOrEqual(receivedTrace.spans.firstObject.startTime, receivedTrace.startTime);
+}
+
+- (void)testNetworkResolveIsTracedByPhase {
+    [self presetNetworkEnvAsIpv4];
+
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4HostObject];
+    HttpdnsRemoteResolver *resolver = [HttpdnsRemoteResolver new];
+    id mockResolver = OCMPartialMock(resolver);
+    OCMStub([mockResolver resolve:[OCMArg any] error:(NSError * __autoreleasing *)[OCMArg anyPointer]]).andReturn(@[hostObject]);
+    id mockResolverClass = OCMClassMock([HttpdnsRemoteResolver class]);
+    OCMStub([mockResolverClass new]).andReturn(mockResolver);
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"trace delivered"];
+    __block HttpdnsResolveTrace *receivedTrace = nil;
+    [self.httpdns setResolveTraceSampleRate:1 handler:^(HttpdnsResolveTrace *trace) {
+        receivedTrace = trace;
+        [expectation fulfill];
+    }];
+
+    HttpdnsHostObject *result = [self.httpdns.requestManager resolveHost:[self blockingRequestForHost:ipv4OnlyHost queryIpType:HttpdnsQueryIPTypeIpv4]];
+    XCTAssertEqual([result getV4Ips].count, 2);
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertFalse(receivedTrace.cacheHit);
+    NSMutableArray<NSNumber *> *phases = [NSMutableArray array];
+    for (HttpdnsResolveTraceSpan *span in receivedTrace.spans) {
+        [phases addObject:@(span.phase)];
+    }
+    XCTAssertEqualObjects(phases.firstObject, @(HttpdnsResolveTracePhaseCacheLookup));
+    XCTAssertTrue([phases containsObject:@(HttpdnsResolveTracePhaseLockWait)]);
+    XCTAssertTrue([phases containsObject:@(HttpdnsResolveTracePhaseMerge)]);
+    XCTAssertLessThanOrEqual([receivedTrace totalDurationOfPhase:HttpdnsResolveTracePhaseMerge], receivedTrace.duration);
+
+    [mockResolverClass stopMocking];
+    [mockResolver stopMocking];
+}
+
+- (void)testZeroSampleRateDisablesTracing {
+    [self presetNetworkEnvAsIpv4];
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4HostObject];
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:ipv4OnlyHost cacheKey:ipv4OnlyHost underQueryIpType:HttpdnsQueryIPTypeIpv4];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"no trace"];
+    expectation.inverted = YES;
+    [self.httpdns setResolveTraceSampleRate:0 handler:^(HttpdnsResolveTrace *trace) {
+        [expectation fulfill];
+    }];
+
+    [self.httpdns.requestManager resolveHost:[self blockingRequestForHost:ipv4OnlyHost queryIpType:HttpdnsQueryIPTypeIpv4]];
+    [self waitForExpectationsWithTimeout:0.5 handler:nil];
+}
+
+- (void)testSpansAreOrderedByStartTime {
+    HttpdnsRequest *request = [self blockingRequestForHost:ipv4OnlyHost queryIpType:HttpdnsQueryIPTypeIpv4];
+    HttpdnsResolveTrace *trace = [[HttpdnsResolveTrace alloc] initWithRequest:request];
+
+    uint64_t outerStartTime = HttpdnsResolveTraceNow();
+    uint64_t innerStartTime = outerStartTime + 1;
+    [trace addSpanWithPhase:HttpdnsResolveTracePhasePersist startTime:innerStartTime];
+    [trace addSpanWithPhase:HttpdnsResolveTracePhaseMerge startTime:outerStartTime];
+    [trace finish];
+
+    XCTAssertEqual(trace.spans.count, 2);
+    XCTAssertEqual(trace.spans[0].phase, HttpdnsResolveTracePhaseMerge, @"外层阶段先开始，排在前面");
+    XCTAssertEqual(trace.spans[1].phase, HttpdnsResolveTracePhasePersist);
+    XCTAssertEqual([trace totalDurationOfPhase:HttpdnsResolveTracePhaseDecrypt], 0);
+}
+
+@end
@@ -0,0 +1,143 @@
+//
+//  SockaddrResolveTest.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/28.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+#import <arpa/inet.h>
+#import "TestBase.h"
+#import "HttpdnsHostObject.h"
+#import "HttpdnsService.h"
+#import "HttpdnsService_Internal.h"
+#import "HttpdnsSockaddr.h"
+
+static NSString *HttpdnsTestStringOfSockaddr(const struct sockaddr_storage *storage) {
+    char buffer[INET6_ADDRSTRLEN] = {0};
+    if (storage->ss_family == AF_INET6) {
+        inet_ntop(AF_INET6, &((const struct sockaddr_in6 *)storage)->sin6_addr, buffer, sizeof(buffer));
+    } else if (storage->ss_family == AF_INET) {
+        inet_ntop(AF_INET, &((const struct sockaddr_in *)storage)->sin_addr, buffer, sizeof(buffer));
+    }
+    return [NSString stringWithUTF8String:buffer];
+}
+
+static uint16_t HttpdnsTestPortOfSockaddr(const struct sockaddr_storage *storage) {
+    if (storage->ss_family == AF_INET6) {
+        return ntohs(((const struct sockaddr_in6 *)storage)->sin6_port);
+    }
+    return ntohs(((const struct sockaddr_in *)storage)->sin_port);
+}
+
+@interface SockaddrResolveTest : TestBase
+
+@end
+
+@implementation SockaddrResolveTest
+
++ (void)setUp {
+    [super setUp];
+
+    HttpDnsService *httpdns = [[HttpDnsService alloc] initWithAccountID:100000];
+    [httpdns setLogEnabled:YES];
+}
+
+- (void)setUp {
+    [super setUp];
+
+    self.httpdns = [HttpDnsService sharedInstance];
+    self.currentTimeStamp = [[NSDate date] timeIntervalSince1970];
+}
+
+- (void)testHostObjectInterleavesFamiliesWithIpv6First {
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4AndIpv6HostObject];
+
+    struct sockaddr_storage sockaddrs[8];
+    NSUInteger count = [hostObject copySockaddrsUnderQueryIpType:HttpdnsQueryIPTypeBoth port:443 to:sockaddrs maxCount:8];
+    XCTAssertEqual(count, 4);
+    XCTAssertEqualObjects(HttpdnsTestStringOfSockaddr(&sockaddrs[0]), ipv61);
+    XCTAssertEqualObjects(HttpdnsTestStringOfSockaddr(&sockaddrs[1]), ipv41);
+    XCTAssertEqualObjects(HttpdnsTestStringOfSockaddr(&sockaddrs[2]), ipv62);
+    XCTAssertEqualObjects(HttpdnsTestStringOfSockaddr(&sockaddrs[3]), ipv42);
+    for (NSUInteger i = 0; i < count; i++) {
+        XCTAssertEqual(HttpdnsTestPortOfSockaddr(&sockaddrs[i]), 443);
+    }
+    XCTAssertEqual(sockaddrs[0].ss_len, sizeof(struct sockaddr_in6));
+    XCTAssertEqual(sockaddrs[1].ss_len, sizeof(struct sockaddr_in));
+
+    // 容量不足时按交错顺序截断
+    count = [hostObject copySockaddrsUnderQueryIpType:HttpdnsQueryIPTypeBoth port:80 to:sockaddrs maxCount:3];
+    XCTAssertEqual(count, 3);
+    XCTAssertEqualObjects(HttpdnsTestStringOfSockaddr(&sockaddrs[2]), ipv62);
+
+    count = [hostObject copySockaddrsUnderQueryIpType:HttpdnsQueryIPTypeIpv4 port:80 to:sockaddrs maxCount:8];
+    XCTAssertEqual(count, 2);
+    XCTAssertEqual(sockaddrs[0].ss_family, AF_INET);
+}
+
+- (void)testResolveSockaddrsFromCache {
+    [self presetNetworkEnvAsIpv4AndIpv6];
+    [self.httpdns cleanAllHostCache];
+
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4AndIpv6HostObject];
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:ipv4AndIpv6Host cacheKey:ipv4AndIpv6Host underQueryIpType:HttpdnsQueryIPTypeBoth];
+
+    struct sockaddr_storage sockaddrs[8];
+    NSInteger count = [self.httpdns resolveHostSyncNonBlocking:ipv4AndIpv6Host port:8080 byIpType:HttpdnsQueryIPTypeBoth sockaddrs:sockaddrs maxCount:8];
+    XCTAssertEqual(count, 4);
+    XCTAssertEqual(sockaddrs[0].ss_family, AF_INET6);
+    XCTAssertEqual(sockaddrs[1].ss_family, AF_INET);
+
+    // 与字符串接口返回的结果一致
+    HttpdnsResult *result = [self.httpdns resolveHostSyncNonBlocking:ipv4AndIpv6Host byIpType:HttpdnsQueryIPTypeBoth];
+    XCTAssertEqualObjects(HttpdnsTestStringOfSockaddr(&sockaddrs[0]), result.ipv6s[0]);
+    XCTAssertEqualObjects(HttpdnsTestStringOfSockaddr(&sockaddrs[1]), result.ips[0]);
+    XCTAssertEqual(HttpdnsTestPortOfSockaddr(&sockaddrs[3]), 8080);
+
+    int cCount = HttpdnsResolveSockaddrsNonBlocking([ipv4AndIpv6Host UTF8String], 8080, HTTPDNS_SOCKADDR_QUERY_IPV6, sockaddrs, 8);
+    XCTAssertEqual(cCount, 2);
+    XCTAssertEqual(sockaddrs[0].ss_family, AF_INET6);
+    XCTAssertEqual(sockaddrs[1].ss_family, AF_INET6);
+}
+
+- (void)testResolveSockaddrsMissAndExpired {
+    [self presetNetworkEnvAsIpv4];
+    [self.httpdns setReuseExpiredIPEnabled:NO];
+    [self.httpdns cleanAllHostCache];
+
+    struct sockaddr_storage sockaddrs[4];
+    // 缓存未命中时不等待解析
+    NSInteger count = [self.httpdns resolveHostSyncNonBlocking:ipv4OnlyHost port:80 byIpType:HttpdnsQueryIPTypeIpv4 sockaddrs:sockaddrs maxCount:4];
+    XCTAssertEqual(count, 0);
+
+    // 过期的结果不走快速路径，未开启复用过期结果时同样返回0
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4HostObject];
+    hostObject.lastIPv4LookupTime = self.currentTimeStamp - 3600;
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:ipv4OnlyHost cacheKey:ipv4OnlyHost underQueryIpType:HttpdnsQueryIPTypeIpv4];
+    count = [self.httpdns resolveHostSyncNonBlocking:ipv4OnlyHost port:80 byIpType:HttpdnsQueryIPTypeIpv4 sockaddrs:sockaddrs maxCount:4];
+    XCTAssertEqual(count, 0);
+
+    XCTAssertEqual(HttpdnsResolveSockaddrsNonBlocking(NULL, 80, HTTPDNS_SOCKADDR_QUERY_IPV4, sockaddrs, 4), 0);
+    XCTAssertEqual(HttpdnsResolveSockaddrsNonBlocking([ipv4OnlyHost UTF8String], 80, HTTPDNS_SOCKADDR_QUERY_IPV4, sockaddrs, 0), 0);
+}
+
+- (void)testCachedSockaddrLookupPerformance {
+    [self presetNetworkEnvAsIpv4AndIpv6];
+    [self.httpdns cleanAllHostCache];
+
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4AndIpv6HostObject];
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:ipv4AndIpv6Host cacheKey:ipv4AndIpv6Host underQueryIpType:HttpdnsQueryIPTypeBoth];
+
+    const char *host = [ipv4AndIpv6Host UTF8String];
+    [self measureBlock:^{
+        struct sockaddr_storage sockaddrs[4];
+        for (int i = 0; i < 10000; i++) {
+            HttpdnsResolveSockaddrsNonBlocking(host, 443, HTTPDNS_SOCKADDR_QUERY_BOTH, sockaddrs, 4);
+        }
+    }];
+}
+
+@end
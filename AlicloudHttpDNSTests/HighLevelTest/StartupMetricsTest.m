@@ -0,0 +1,139 @@
+//
+//  StartupMetricsTest.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+#import <OCMock/OCMock.h>
+#import "TestBase.h"
+#import "HttpdnsRequestManager.h"
+#import "HttpdnsService_Internal.h"
+#import "HttpdnsStartupMetrics.h"
+
+@interface StartupMetricsTest : TestBase
+
+@end
+
+@implementation StartupMetricsTest
+
++ (void)setUp {
+    [super setUp];
+
+    HttpDnsService *httpdns = [[HttpDnsService alloc] initWithAccountID:100000];
+    [httpdns setLogEnabled:YES];
+}
+
+- (void)testSynchronousInitializationRecordsAllPhases {
+    HttpdnsStartupMetrics *metrics = [[HttpDnsService sharedInstance] startupMetrics];
+    XCTAssertFalse(metrics.deferredInitialization);
+    XCTAssertTrue(metrics.completed);
+    XCTAssertTrue([[HttpDnsService sharedInstance].requestManager isInitialized]);
+
+    XCTAssertGreaterThan(metrics.databaseOpenDurationInMilliseconds, 0);
+    XCTAssertGreaterThan(metrics.reachabilityStartDurationInMilliseconds, 0);
+    XCTAssertGreaterThan(metrics.scheduleConfigLoadDurationInMilliseconds, 0);
+    // 同步初始化时所有阶段都在调用线程上完成
+    XCTAssertGreaterThanOrEqual(metrics.callerThreadDurationInMilliseconds,
+                                metrics.requestManagerCreationDurationInMilliseconds + metrics.databaseOpenDurationInMilliseconds);
+}
+
+- (void)testDeferredInitializationCompletesInBackground {
+    HttpDnsService *httpdns = [[HttpDnsService alloc] initWithAccountID:100010
+                                                              secretKey:@"00112233445566778899aabbccddeeff"
+                                                           aesSecretKey:nil
+                                                 deferredInitialization:YES];
+    XCTAssertNotNil(httpdns.requestManager);
+    XCTAssertNotNil(httpdns.scheduleCenter);
+
+    HttpdnsStartupMetrics *metrics = [httpdns startupMetrics];
+    XCTAssertTrue(metrics.deferredInitialization);
+    XCTAssertGreaterThan(metrics.callerThreadDurationInMilliseconds, 0);
+
+    // 初始化完成前提交的任务排在初始化之后执行
+    XCTestExpectation *expectation = [self expectationWithDescription:@"performAfterInitialization"];
+    __block BOOL initializedWhenPerformed = NO;
+    [httpdns.requestManager performAfterInitialization:^{
+        initializedWhenPerformed = [httpdns.requestManager isInitialized];
+        [expectation fulfill];
+    }];
+    [self waitForExpectations:@[expectation] timeout:5];
+    XCTAssertTrue(initializedWhenPerformed);
+
+    [httpdns.requestManager waitForInitialization];
+    metrics = [httpdns startupMetrics];
+    XCTAssertTrue(metrics.completed);
+    XCTAssertGreaterThan(metrics.databaseOpenDurationInMilliseconds, 0);
+    XCTAssertGreaterThan(metrics.scheduleConfigLoadDurationInMilliseconds, 0);
+    XCTAssertGreaterThanOrEqual(metrics.totalDurationInMilliseconds, metrics.callerThreadDurationInMilliseconds);
+    XCTAssertNotNil([httpdns.scheduleCenter currentActiveServiceServerV4Host]);
+}
+
+- (void)testInitializationWaitIsBoundedByTimeout {
+    HttpdnsRequestManager *requestManager = [[HttpdnsRequestManager alloc] initWithAccountId:100011 ownerService:nil];
+    dispatch_semaphore_t release = dispatch_semaphore_create(0);
+    [requestManager performInitialization:^{
+        dispatch_semaphore_wait(release, dispatch_time(DISPATCH_TIME_NOW, 5 * NSEC_PER_SEC));
+    } deferred:YES];
+
+    // 初始化卡住时，等待在超时后返回而不是一直阻塞
+    NSTimeInterval start = [[NSDate date] timeIntervalSince1970];
+    XCTAssertFalse([requestManager waitForInitializationWithTimeout:0.2]);
+    XCTAssertLessThan([[NSDate date] timeIntervalSince1970] - start, 1);
+
+    dispatch_semaphore_signal(release);
+    XCTAssertTrue([requestManager waitForInitializationWithTimeout:5]);
+}
+
+- (void)testSlowInitializationDoesNotExtendResolveTimeout {
+    [self presetNetworkEnvAsIpv4];
+    HttpDnsService *httpdns = [HttpDnsService sharedInstance];
+    [httpdns cleanAllHostCache];
+
+    NSTimeInterval timeout = 1;
+    id mockManager = OCMPartialMock(httpdns.requestManager);
+    // 模拟初始化在超时时间快用完时才完成
+    OCMStub([mockManager isInitialized]).andReturn(NO);
+    OCMStub([mockManager waitForInitializationWithTimeout:timeout]).andDo(^(NSInvocation *invocation) {
+        [NSThread sleepForTimeInterval:timeout * 0.8];
+        BOOL initialized = YES;
+        [invocation setReturnValue:&initialized];
+    });
+    // 网络请求比剩余的超时更慢
+    OCMStub([mockManager executeRequest:[OCMArg any] retryCount:0]).andDo(^(NSInvocation *invocation) {
+        [NSThread sleepForTimeInterval:timeout * 2];
+        __unsafe_unretained HttpdnsHostObject *result = nil;
+        [invocation setReturnValue:&result];
+    });
+
+    HttpdnsRequest *request = [[HttpdnsRequest alloc] initWithHost:@"slowinit.onlyfortest.com" queryIpType:HttpdnsQueryIPTypeIpv4];
+    request.resolveTimeoutInSecond = timeout;
+
+    // 主线程上的同步解析会降级为非阻塞解析，需在后台线程调用
+    XCTestExpectation *expectation = [self expectationWithDescription:@"resolveHostSync"];
+    __block NSTimeInterval elapsed = 0;
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        [httpdns resolveHostSync:request];
+        elapsed = CFAbsoluteTimeGetCurrent() - start;
+        [expectation fulfill];
+    });
+    [self waitForExpectations:@[expectation] timeout:timeout * 4];
+
+    XCTAssertLessThanOrEqual(elapsed, timeout + 0.2, @"等待初始化的时间应从解析超时中扣除");
+
+    [httpdns.requestManager waitForAsyncResolveTasks];
+    [mockManager stopMocking];
+}
+
+- (void)testMetricsSnapshotIsImmutable {
+    HttpdnsStartupMetrics *first = [[HttpDnsService sharedInstance] startupMetrics];
+    HttpdnsStartupMetrics *second = [[HttpDnsService sharedInstance] startupMetrics];
+    XCTAssertNotEqual(first, second);
+    XCTAssertEqual(first.totalDurationInMilliseconds, second.totalDurationInMilliseconds);
+}
+
+@end
@@ -0,0 +1,133 @@
+//
+//  StatisticsTest.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+#import "TestBase.h"
+#import "HttpdnsHostObject.h"
+#import "HttpdnsRemoteResolver.h"
+#import "HttpdnsRequest_Internal.h"
+#import "HttpdnsMetrics.h"
+#import "HttpdnsStatistics_Internal.h"
+#import "HttpdnsService.h"
+#import "HttpdnsService_Internal.h"
+
+@interface StatisticsTest : TestBase
+
+@end
+
+@implementation StatisticsTest
+
++ (void)setUp {
+    [super setUp];
+
+    HttpDnsService *httpdns = [[HttpDnsService alloc] initWithAccountID:100000];
+    [httpdns setLogEnabled:YES];
+}
+
+- (void)setUp {
+    [super setUp];
+
+    self.httpdns = [HttpDnsService sharedInstance];
+    [self.httpdns setReuseExpiredIPEnabled:NO];
+    [self.httpdns cleanAllHostCache];
+    self.currentTimeStamp = [[NSDate date] timeIntervalSince1970];
+}
+
+- (void)tearDown {
+    [self.httpdns cleanAllHostCache];
+    [super tearDown];
+}
+
+- (HttpdnsRequest *)blockingRequestForHost:(NSString *)host {
+    HttpdnsRequest *request = [[HttpdnsRequest alloc] initWithHost:host queryIpType:HttpdnsQueryIPTypeIpv4];
+    request.cacheKey = host;
+    request.resolveTimeoutInSecond = 5;
+    [request becomeBlockingRequest];
+    return request;
+}
+
+- (void)testHistogramPercentiles {
+    uint64_t bucketCounts[HTTPDNS_METRICS_HISTOGRAM_BUCKET_COUNT] = {0};
+    // 90个5微秒的样本落在第5个桶，10个1000微秒的样本落在[960, 1023]所在的第63个桶
+    bucketCounts[5] = 90;
+    bucketCounts[63] = 10;
+    HttpdnsLatencyHistogram *histogram = [[HttpdnsLatencyHistogram alloc] initWithBucketCounts:bucketCounts
+                                                                                   bucketCount:HTTPDNS_METRICS_HISTOGRAM_BUCKET_COUNT
+                                                                             sumInMicroseconds:90 * 5 + 10 * 1000
+                                                                             maxInMicroseconds:1000];
+
+    XCTAssertEqual(histogram.count, 100);
+    XCTAssertEqualWithAccuracy(histogram.meanInMilliseconds, 0.1045, 0.0001);
+    XCTAssertEqualWithAccuracy([histogram valueInMillisecondsAtPercentile:50], 0.005, 0.0001);
+    XCTAssertEqualWithAccuracy([histogram valueInMillisecondsAtPercentile:90], 0.005, 0.0001);
+    XCTAssertEqualWithAccuracy([histogram valueInMillisecondsAtPercentile:95], 1.0, 0.0001, @"桶上界不超过实际最大值");
+    XCTAssertEqualWithAccuracy(histogram.maxInMilliseconds, 1.0, 0.0001);
+    XCTAssertEqual(HttpdnsMetricsBucketHighestValue(63), 1023);
+}
+
+- (void)testBucketUpperBoundsAreIncreasing {
+    for (NSUInteger i = 1; i < HTTPDNS_METRICS_HISTOGRAM_BUCKET_COUNT; i++) {
+        XCTAssertGreaterThan(HttpdnsMetricsBucketHighestValue(i), HttpdnsMetricsBucketHighestValue(i - 1));
+    }
+}
+
+- (void)testRecordedLatencyAppearsInSnapshot {
+    NSUInteger probeCount = [self.httpdns statisticsSnapshot].probeLatency.count;
+    HttpdnsMetricsRecordLatency(HttpdnsMetricHistogramProbe, 2000);
+
+    HttpdnsLatencyHistogram *probeLatency = [self.httpdns statisticsSnapshot].probeLatency;
+    XCTAssertEqual(probeLatency.count, probeCount + 1);
+    XCTAssertGreaterThanOrEqual(probeLatency.maxInMilliseconds, 2.0);
+}
+
+- (void)testCacheHitAndEvictionAreCounted {
+    [self presetNetworkEnvAsIpv4];
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4HostObject];
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:ipv4OnlyHost cacheKey:ipv4OnlyHost underQueryIpType:HttpdnsQueryIPTypeIpv4];
+
+    HttpdnsStatistics *before = [self.httpdns statisticsSnapshot];
+    [self shouldNotHaveCallNetworkRequestWhenResolving:^{
+        XCTAssertNotNil([self.httpdns.requestManager resolveHost:[self blockingRequestForHost:ipv4OnlyHost]]);
+    }];
+    HttpdnsStatistics *afterHit = [self.httpdns statisticsSnapshot];
+    XCTAssertEqual(afterHit.cacheHitCount, before.cacheHitCount + 1);
+    XCTAssertEqual(afterHit.cacheMissCount, before.cacheMissCount);
+
+    [self.httpdns cleanAllHostCache];
+    XCTAssertGreaterThanOrEqual([self.httpdns statisticsSnapshot].cacheEvictionCount, afterHit.cacheEvictionCount + 1);
+}
+
+- (void)testCacheMissIsCounted {
+    [self presetNetworkEnvAsIpv4];
+
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4HostObject];
+    HttpdnsRemoteResolver *resolver = [HttpdnsRemoteResolver new];
+    id mockResolver = OCMPartialMock(resolver);
+    OCMStub([mockResolver resolve:[OCMArg any] error:(NSError * __autoreleasing *)[OCMArg anyPointer]]).andReturn(@[hostObject]);
+    id mockResolverClass = OCMClassMock([HttpdnsRemoteResolver class]);
+    OCMStub([mockResolverClass new]).andReturn(mockResolver);
+
+    HttpdnsStatistics *before = [self.httpdns statisticsSnapshot];
+    XCTAssertNotNil([self.httpdns.requestManager resolveHost:[self blockingRequestForHost:ipv4OnlyHost]]);
+    HttpdnsStatistics *after = [self.httpdns statisticsSnapshot];
+    XCTAssertEqual(after.cacheMissCount, before.cacheMissCount + 1);
+
+    [mockResolverClass stopMocking];
+    [mockResolver stopMocking];
+}
+
+- (void)testSnapshotPerformance {
+    [self measureBlock:^{
+        for (int i = 0; i < 1000; i++) {
+            [self.httpdns statisticsSnapshot];
+        }
+    }];
+}
+
+@end
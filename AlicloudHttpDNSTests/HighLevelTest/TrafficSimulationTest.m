@@ -0,0 +1,196 @@
+//
+//  TrafficSimulationTest.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+#import "TestBase.h"
+#import "HttpdnsHostObject.h"
+#import "HttpdnsReachability.h"
+#import "HttpdnsRemoteResolver.h"
+#import "HttpdnsRequestManager.h"
+#import "HttpdnsScheduleCenter.h"
+#import "HttpdnsService_Internal.h"
+#import "HttpdnsTrafficSimulation.h"
+#import "HttpdnsVirtualClock.h"
+
+@interface TrafficSimulationTest : TestBase
+
+@end
+
+@implementation TrafficSimulationTest
+
++ (void)setUp {
+    [super setUp];
+
+    HttpDnsService *httpdns = [[HttpDnsService alloc] initWithAccountID:100000];
+    [httpdns setLogEnabled:NO];
+}
+
+- (void)setUp {
+    [super setUp];
+
+    self.httpdns = [HttpDnsService sharedInstance];
+    [self.httpdns setReuseExpiredIPEnabled:NO];
+    [self.httpdns setPreResolveAfterNetworkChanged:NO];
+    [self.httpdns cleanAllHostCache];
+    [self presetNetworkEnvAsIpv4];
+}
+
+- (void)tearDown {
+    HttpdnsClockSetCurrent(nil);
+    [self.httpdns setReuseExpiredIPEnabled:NO];
+    [self.httpdns setPreResolveAfterNetworkChanged:NO];
+    [self.httpdns cleanAllHostCache];
+    [super tearDown];
+}
+
+- (HttpdnsTrafficSimulation *)simulation {
+    HttpdnsTrafficSimulation *simulation = [[HttpdnsTrafficSimulation alloc] initWithService:self.httpdns];
+    simulation.duration = 3 * 3600;
+    simulation.requestsPerSecond = 10;
+    simulation.hostCount = 200;
+    return simulation;
+}
+
+- (void)testTTLExpiryFollowsVirtualClock {
+    HttpdnsVirtualClock *clock = [HttpdnsVirtualClock new];
+    [clock install];
+
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4HostObject];
+    hostObject.lastIPv4LookupTime = clock.now;
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:ipv4OnlyHost cacheKey:ipv4OnlyHost underQueryIpType:HttpdnsQueryIPTypeIpv4];
+
+    [clock advanceBy:59];
+    [self shouldNotHaveCallNetworkRequestWhenResolving:^{
+        XCTAssertNotNil([self.httpdns resolveHostSyncNonBlocking:ipv4OnlyHost byIpType:HttpdnsQueryIPTypeIpv4]);
+    }];
+
+    // 60秒的TTL在虚拟时间里到期，不需要真实等待
+    [clock advanceBy:1];
+    [self shouldHaveCalledRequestWhenResolving:^{
+        XCTAssertNil([self.httpdns resolveHostSyncNonBlocking:ipv4OnlyHost byIpType:HttpdnsQueryIPTypeIpv4]);
+        [self.httpdns.requestManager waitForAsyncResolveTasks];
+    }];
+
+    [clock uninstall];
+}
+
+- (void)testNetworkChangeDelaysRunOnVirtualClock {
+    HttpdnsVirtualClock *clock = [HttpdnsVirtualClock new];
+    [clock install];
+
+    HttpdnsHostObject *hostObject = [self constructSimpleIpv4HostObject];
+    hostObject.lastIPv4LookupTime = clock.now;
+    [self.httpdns.requestManager mergeLookupResultToManager:hostObject host:ipv4OnlyHost cacheKey:ipv4OnlyHost underQueryIpType:HttpdnsQueryIPTypeIpv4];
+
+    id mockScheduleCenter = OCMPartialMock(self.httpdns.scheduleCenter);
+    __block NSUInteger scheduleUpdateCount = 0;
+    OCMStub([mockScheduleCenter asyncUpdateRegionScheduleConfig]).andDo(^(NSInvocation *invocation) {
+        scheduleUpdateCount++;
+    });
+
+    // 距离上次处理网络变化已超过5秒，本次事件会被处理
+    [clock advanceBy:10];
+    [[NSNotificationCenter defaultCenter] postNotificationName:kHttpdnsReachabilityChangedNotification
+                                                        object:[HttpdnsReachability sharedInstance]];
+    XCTAssertGreaterThanOrEqual(clock.pendingTaskCount, 3);
+
+    [clock advanceBy:2.5];
+    XCTAssertGreaterThanOrEqual(scheduleUpdateCount, 1, @"2秒后更新调度");
+    XCTAssertNotNil([self.httpdns resolveHostSyncNonBlocking:ipv4OnlyHost byIpType:HttpdnsQueryIPTypeIpv4], @"3秒后才清理缓存");
+
+    [clock advanceBy:1];
+    [self shouldHaveCalledRequestWhenResolving:^{
+        XCTAssertNil([self.httpdns resolveHostSyncNonBlocking:ipv4OnlyHost byIpType:HttpdnsQueryIPTypeIpv4]);
+        [self.httpdns.requestManager waitForAsyncResolveTasks];
+    }];
+
+    [mockScheduleCenter stopMocking];
+    [clock uninstall];
+}
+
+- (void)testSteadyTrafficWithTTLChurn {
+    HttpdnsTrafficSimulation *simulation = [self simulation];
+    HttpdnsTrafficSimulationReport *report = [simulation run];
+    NSLog(@"[TrafficSimulation] steady: %@", report);
+
+    XCTAssertEqual(report.simulatedSeconds, simulation.duration);
+    XCTAssertEqual(report.requestCount, (NSUInteger)simulation.duration * simulation.requestsPerSecond);
+    XCTAssertEqual(report.cacheHitCount + report.staleServeCount + report.cacheMissCount, report.requestCount);
+    XCTAssertEqual(report.answeredCount, report.cacheHitCount + report.staleServeCount);
+    XCTAssertEqual(report.serverFailureCount, 0);
+    // 每个域名每个TTL周期最多请求一次，热门域名绝大多数请求命中缓存
+    XCTAssertLessThanOrEqual(report.serverRequestCount, report.cacheMissCount);
+    XCTAssertGreaterThan(report.cacheHitRate, 0.8);
+}
+
+- (void)testReuseExpiredIpRidesThroughServerOutage {
+    HttpdnsTrafficSimulation *strictSimulation = [self simulation];
+    [strictSimulation addServerOutageFrom:3600 duration:1800];
+    HttpdnsTrafficSimulationReport *strictReport = [strictSimulation run];
+    NSLog(@"[TrafficSimulation] outage: %@", strictReport);
+
+    [self.httpdns cleanAllHostCache];
+    [self.httpdns setReuseExpiredIPEnabled:YES];
+    HttpdnsTrafficSimulation *reuseSimulation = [self simulation];
+    [reuseSimulation addServerOutageFrom:3600 duration:1800];
+    HttpdnsTrafficSimulationReport *reuseReport = [reuseSimulation run];
+    NSLog(@"[TrafficSimulation] outage with expired ip reused: %@", reuseReport);
+
+    XCTAssertGreaterThan(strictReport.serverFailureCount, 0);
+    XCTAssertGreaterThan(reuseReport.serverFailureCount, 0);
+    XCTAssertGreaterThan(reuseReport.staleServeCount, 0);
+    XCTAssertGreaterThan(reuseReport.answerRate, strictReport.answerRate);
+    // 故障期间失败退避生效，请求量不会随访问量成倍放大
+    XCTAssertLessThan(strictReport.serverFailureCount, strictReport.requestCount / 10);
+}
+
+- (void)testNetworkFlapsFlushCache {
+    HttpdnsTrafficSimulationReport *stableReport = [[self simulation] run];
+
+    [self.httpdns cleanAllHostCache];
+    HttpdnsTrafficSimulation *flappingSimulation = [self simulation];
+    flappingSimulation.networkFlapInterval = 600;
+    HttpdnsTrafficSimulationReport *flappingReport = [flappingSimulation run];
+    NSLog(@"[TrafficSimulation] flapping: %@", flappingReport);
+
+    NSUInteger expectedFlapCount = (NSUInteger)((flappingSimulation.duration - 1) / flappingSimulation.networkFlapInterval);
+    XCTAssertEqual(flappingReport.networkFlapCount, expectedFlapCount);
+    XCTAssertGreaterThanOrEqual(flappingReport.scheduleUpdateCount, flappingReport.networkFlapCount);
+    XCTAssertLessThan(flappingReport.cacheHitRate, stableReport.cacheHitRate);
+
+    // 开启网络切换后预解析，被清理的域名提前解析回来
+    [self.httpdns cleanAllHostCache];
+    [self.httpdns setPreResolveAfterNetworkChanged:YES];
+    HttpdnsTrafficSimulation *preResolveSimulation = [self simulation];
+    preResolveSimulation.networkFlapInterval = 600;
+    HttpdnsTrafficSimulationReport *preResolveReport = [preResolveSimulation run];
+    NSLog(@"[TrafficSimulation] flapping with pre resolve: %@", preResolveReport);
+
+    XCTAssertGreaterThan(preResolveReport.serverResolvedHostCount, preResolveReport.serverRequestCount);
+    XCTAssertGreaterThan(preResolveReport.cacheHitRate, flappingReport.cacheHitRate);
+}
+
+- (void)testSameSeedProducesSameReport {
+    NSMutableArray<NSDictionary *> *results = [NSMutableArray array];
+    for (int i = 0; i < 2; i++) {
+        [self.httpdns cleanAllHostCache];
+        HttpdnsTrafficSimulation *simulation = [self simulation];
+        simulation.duration = 3600;
+        simulation.seed = 42;
+        simulation.networkFlapInterval = 300;
+        [simulation addServerOutageFrom:1200 duration:600];
+
+        NSMutableDictionary *result = [[[simulation run] dictionaryRepresentation] mutableCopy];
+        [result removeObjectForKey:@"wallClockSeconds"];
+        [results addObject:result];
+    }
+    XCTAssertEqualObjects(results[0], results[1]);
+}
+
+@end
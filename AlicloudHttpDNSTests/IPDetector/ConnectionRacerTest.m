@@ -0,0 +1,207 @@
+//
+//  ConnectionRacerTest.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/26.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+#import <sys/socket.h>
+#import <netinet/in.h>
+#import <unistd.h>
+#import "HttpdnsConnectionRacer.h"
+#import "HttpdnsTCPProber.h"
+#import "IpDetectorTestHelper.h"
+
+@interface ConnectionRacerTest : XCTestCase
+
+@property (nonatomic, strong) HttpdnsConnectionRacer *racer;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *attempts;
+@property (nonatomic, strong) NSLock *lock;
+
+@end
+
+@implementation ConnectionRacerTest
+
+- (void)setUp {
+    [super setUp];
+    self.racer = [[HttpdnsConnectionRacer alloc] init];
+    self.racer.attemptDelay = 0.1;
+    self.racer.attemptTimeout = 2.0;
+    self.attempts = [NSMutableDictionary dictionary];
+    self.lock = [[NSLock alloc] init];
+}
+
+- (HttpdnsConnectionAttemptHandler)recordingAttemptHandler {
+    return ^(NSString *ip, NSInteger costTime) {
+        [self.lock lock];
+        self.attempts[ip] = @(costTime);
+        [self.lock unlock];
+    };
+}
+
+- (NSDictionary<NSString *, NSNumber *> *)recordedAttempts {
+    [self.lock lock];
+    NSDictionary *attempts = [self.attempts copy];
+    [self.lock unlock];
+    return attempts;
+}
+
+- (void)testInterleavedCandidatesPreferIPv6 {
+    NSArray *candidates = [HttpdnsConnectionRacer interleavedCandidatesWithIpv4s:@[@"1.1.1.1", @"2.2.2.2", @"3.3.3.3"]
+                                                                           ipv6s:@[@"2001:db8::1"]
+                                                                    maxPerFamily:2];
+    XCTAssertEqualObjects(candidates, (@[@"2001:db8::1", @"1.1.1.1", @"2.2.2.2"]));
+
+    candidates = [HttpdnsConnectionRacer interleavedCandidatesWithIpv4s:@[@"1.1.1.1"] ipv6s:nil maxPerFamily:0];
+    XCTAssertEqualObjects(candidates, (@[@"1.1.1.1"]));
+}
+
+- (void)testFailedAttemptStartsNextImmediately {
+    int port = 0;
+    int listenFd = [IpDetectorTestHelper openLocalListenerWithBacklog:16 port:&port];
+    XCTAssertGreaterThanOrEqual(listenFd, 0);
+
+    // ::1上没有监听，连接会立即被拒绝
+    self.racer.attemptDelay = 1.0;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"race"];
+    NSDate *start = [NSDate date];
+    [self.racer raceConnectionsToIPs:@[@"::1", @"127.0.0.1"]
+                                port:port
+                      attemptHandler:[self recordingAttemptHandler]
+                          completion:^(int socketFd, NSString *ip) {
+        XCTAssertGreaterThanOrEqual(socketFd, 0);
+        XCTAssertEqualObjects(ip, @"127.0.0.1");
+        XCTAssertLessThan([[NSDate date] timeIntervalSinceDate:start], 0.5, @"失败后不应等待尝试间隔");
+        // 竞速结束前完成的尝试先于completion回调
+        XCTAssertEqual([self recordedAttempts].count, 2);
+        close(socketFd);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    NSDictionary *attempts = [self recordedAttempts];
+    XCTAssertEqualObjects(attempts[@"::1"], @(-1), @"失败的尝试应反馈到排序统计");
+    XCTAssertGreaterThanOrEqual([attempts[@"127.0.0.1"] integerValue], 0);
+
+    close(listenFd);
+}
+
+- (void)testStalledAttemptIsOvertakenAfterDelay {
+    int port = 0;
+    NSArray<NSNumber *> *sockets = [IpDetectorTestHelper openBlackholedListenerWithPort:&port];
+    int v6ListenFd = [IpDetectorTestHelper openLocalIPv6ListenerOnPort:port];
+    XCTAssertGreaterThanOrEqual(v6ListenFd, 0);
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"race"];
+    NSDate *start = [NSDate date];
+    [self.racer raceConnectionsToIPs:@[@"127.0.0.1", @"::1"]
+                                port:port
+                      attemptHandler:[self recordingAttemptHandler]
+                          completion:^(int socketFd, NSString *ip) {
+        NSTimeInterval elapsed = [[NSDate date] timeIntervalSinceDate:start];
+        XCTAssertGreaterThanOrEqual(socketFd, 0);
+        XCTAssertEqualObjects(ip, @"::1");
+        XCTAssertGreaterThanOrEqual(elapsed, 0.09, @"第二个地址应在尝试间隔之后才发起");
+        XCTAssertLessThan(elapsed, 1.0, @"不应等到第一个地址超时");
+
+        struct sockaddr_storage peer;
+        socklen_t peerLen = sizeof(peer);
+        XCTAssertEqual(getpeername(socketFd, (struct sockaddr *)&peer, &peerLen), 0, @"返回的socket应处于已连接状态");
+        XCTAssertEqual(peer.ss_family, AF_INET6);
+        close(socketFd);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    // 被取消的尝试不代表地址质量，不应反馈
+    [NSThread sleepForTimeInterval:0.2];
+    NSDictionary *attempts = [self recordedAttempts];
+    XCTAssertNil(attempts[@"127.0.0.1"]);
+    XCTAssertNotNil(attempts[@"::1"]);
+
+    close(v6ListenFd);
+    [IpDetectorTestHelper closeSockets:sockets];
+}
+
+- (void)testAllCandidatesFail {
+    int port = [IpDetectorTestHelper unusedLocalPort];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"race"];
+    [self.racer raceConnectionsToIPs:@[@"127.0.0.1", @"::1", @"not-an-ip"]
+                                port:port
+                      attemptHandler:[self recordingAttemptHandler]
+                          completion:^(int socketFd, NSString *ip) {
+        XCTAssertEqual(socketFd, -1);
+        XCTAssertNil(ip);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    [NSThread sleepForTimeInterval:0.05];
+    XCTAssertEqual([self recordedAttempts].count, 3);
+}
+
+- (void)testEmptyCandidates {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"race"];
+    [self.racer raceConnectionsToIPs:@[] port:80 attemptHandler:nil completion:^(int socketFd, NSString *ip) {
+        XCTAssertEqual(socketFd, -1);
+        XCTAssertNil(ip);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:2.0 handler:nil];
+}
+
+#pragma mark - HttpdnsTCPProber建连
+
+- (void)testProberConnectHandsOverSocket {
+    HttpdnsTCPProber *prober = [[HttpdnsTCPProber alloc] initWithMaxConcurrentProbes:4];
+    int port = 0;
+    int listenFd = [IpDetectorTestHelper openLocalListenerWithBacklog:16 port:&port];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"connect"];
+    NSUInteger token = [prober connectIP:@"127.0.0.1" port:port timeout:2.0 completion:^(int socketFd, NSInteger costTime) {
+        XCTAssertGreaterThanOrEqual(socketFd, 0);
+        XCTAssertGreaterThanOrEqual(costTime, 0);
+        XCTAssertEqual(write(socketFd, "x", 1), 1, @"交出的socket应可以直接使用");
+        close(socketFd);
+        [expectation fulfill];
+    }];
+    XCTAssertGreaterThan(token, 0);
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    [prober shutdown];
+    close(listenFd);
+}
+
+- (void)testProberCancelConnect {
+    HttpdnsTCPProber *prober = [[HttpdnsTCPProber alloc] initWithMaxConcurrentProbes:1];
+    int port = 0;
+    NSArray<NSNumber *> *sockets = [IpDetectorTestHelper openBlackholedListenerWithPort:&port];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"connect"];
+    expectation.expectedFulfillmentCount = 2;
+    NSDate *start = [NSDate date];
+    HttpdnsTCPConnectCompletion completion = ^(int socketFd, NSInteger costTime) {
+        XCTAssertEqual(socketFd, -1);
+        XCTAssertEqual(costTime, -1);
+        XCTAssertLessThan([[NSDate date] timeIntervalSinceDate:start], 1.0, @"取消后应立即回调");
+        [expectation fulfill];
+    };
+    // 第一个进行中，第二个在等待队列中
+    NSUInteger activeToken = [prober connectIP:@"127.0.0.1" port:port timeout:10.0 completion:completion];
+    NSUInteger waitingToken = [prober connectIP:@"127.0.0.1" port:port timeout:10.0 completion:completion];
+    [NSThread sleepForTimeInterval:0.05];
+
+    [prober cancelConnect:waitingToken];
+    [prober cancelConnect:activeToken];
+    [self waitForExpectationsWithTimeout:2.0 handler:nil];
+    XCTAssertEqual([prober activeProbeCount], 0);
+
+    [prober shutdown];
+    [IpDetectorTestHelper closeSockets:sockets];
+}
+
+@end
@@ -8,7 +8,9 @@
 
 #import <Foundation/Foundation.h>
 #import "../Testbase/TestBase.h"
+#import <unistd.h>
 #import "HttpdnsIPQualityDetector.h"
+#import "IpDetectorTestHelper.h"
 
 @interface IpDetectorTest : TestBase
 
@@ -18,7 +20,8 @@
 
 - (void)setUp {
     [super setUp];
-    // 使用默认配置，不修改maxConcurrentDetections
+    // 使用默认配置，清空上个用例留下的探测结果
+    [[HttpdnsIPQualityDetector sharedInstance] removeAllProbeResults];
 }
 
 - (void)tearDown {
@@ -88,6 +91,7 @@
     OCMExpect([detectorMock executeDetection:@"example.com"
                                           ip:@"1.2.3.4"
                                         port:[NSNumber numberWithInt:80]
+                                     started:[OCMArg any]
                                     callback:[OCMArg any]]);
 
     // 执行测试
@@ -114,19 +118,28 @@
     OCMReject([detectorMock executeDetection:[OCMArg any]
                                           ip:[OCMArg any]
                                         port:[OCMArg any]
+                                     started:[OCMArg any]
                                     callback:[OCMArg any]]);
 
+    // 参数无效时仍以-1回调，调用方按回调计数的等待不会挂起
+    XCTestExpectation *expectation = [self expectationWithDescription:@"无效参数应以失败回调"];
+    expectation.expectedFulfillmentCount = 2;
+    HttpdnsIPQualityCallback failureCallback = ^(NSString *cacheKey, NSString *ip, NSInteger costTime) {
+        XCTAssertEqual(costTime, -1);
+        [expectation fulfill];
+    };
+
     // 测试nil cacheKey
     [detectorMock scheduleIPQualityDetection:nil
                                           ip:@"1.2.3.4"
                                         port:[NSNumber numberWithInt:80]
-                                    callback:^(NSString *cacheKey, NSString *ip, NSInteger costTime) {}];
+                                    callback:failureCallback];
 
     // 测试nil IP
     [detectorMock scheduleIPQualityDetection:@"example.com"
                                           ip:nil
                                         port:[NSNumber numberWithInt:80]
-                                    callback:^(NSString *cacheKey, NSString *ip, NSInteger costTime) {}];
+                                    callback:failureCallback];
 
     // 测试nil callback
     [detectorMock scheduleIPQualityDetection:@"example.com"
@@ -134,6 +147,8 @@
                                         port:[NSNumber numberWithInt:80]
                                     callback:nil];
 
+    [self waitForExpectationsWithTimeout:2.0 handler:nil];
+
     // 验证期望
     OCMVerifyAll(detectorMock);
 
@@ -141,202 +156,192 @@
     [detectorMock stopMocking];
 }
 
-- (void)testConcurrencyLimitReached {
-    // 测试达到并发限制时的行为
+- (void)testPendingTasksCountReflectsProberWaitQueue {
+    // 等待队列由探测器维护，提交后很快被事件循环取走
     HttpdnsIPQualityDetector *detector = [HttpdnsIPQualityDetector sharedInstance];
-    id detectorMock = OCMPartialMock(detector);
 
-    // 由于无法直接模拟dispatch_semaphore_wait，我们采用另一种方式测试并发限制
-    // 模拟scheduleIPQualityDetection内部实现，当调用时直接执行addPendingTask
-    OCMStub([detectorMock scheduleIPQualityDetection:[OCMArg any]
-                                                  ip:[OCMArg any]
-                                                port:[OCMArg any]
-                                            callback:[OCMArg any]]).andDo(^(NSInvocation *invocation) {
-        // 提取参数
-        NSString *cacheKey;
-        NSString *ip;
-        NSNumber *port;
-        HttpdnsIPQualityCallback callback;
-
-        [invocation getArgument:&cacheKey atIndex:2];
-        [invocation getArgument:&ip atIndex:3];
-        [invocation getArgument:&port atIndex:4];
-        [invocation getArgument:&callback atIndex:5];
-
-        // 直接调用addPendingTask，模拟并发限制已达到的情况
-        [detector addPendingTask:cacheKey ip:ip port:port callback:callback];
-    });
-
-    // 设置期望：验证addPendingTask被调用，而executeDetection不被调用
-    // 使用同一个mock对象，避免创建多个mock
-    OCMExpect([detectorMock addPendingTask:@"example.com"
-                                        ip:@"1.2.3.4"
-                                      port:[NSNumber numberWithInt:80]
-                                  callback:[OCMArg any]]);
+    XCTestExpectation *expectation = [self expectationWithDescription:@"检测回调应被执行"];
+    [detector scheduleIPQualityDetection:@"example.com"
+                                      ip:@"127.0.0.1"
+                                    port:@([IpDetectorTestHelper unusedLocalPort])
+                                callback:^(NSString *cacheKey, NSString *ip, NSInteger costTime) {
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
 
-    OCMReject([detectorMock executeDetection:[OCMArg any]
-                                          ip:[OCMArg any]
-                                        port:[OCMArg any]
-                                    callback:[OCMArg any]]);
+    XCTAssertEqual([detector pendingTasksCount], 0, @"处理后待处理任务数量应为0");
+}
 
-    // 执行测试
-    [detectorMock scheduleIPQualityDetection:@"example.com"
-                                          ip:@"1.2.3.4"
-                                        port:[NSNumber numberWithInt:80]
-                                    callback:^(NSString *cacheKey, NSString *ip, NSInteger costTime) {}];
+#pragma mark - 探测合并测试
 
-    // 验证期望
-    OCMVerifyAll(detectorMock);
+- (void)testConcurrentDetectionsShareOneProbe {
+    // 多个缓存键同时检测同一IP，只发起一次探测，结果分发给所有缓存键
+    HttpdnsIPQualityDetector *detector = [HttpdnsIPQualityDetector sharedInstance];
+    int port = 0;
+    int listenFd = [IpDetectorTestHelper openLocalListenerWithBacklog:16 port:&port];
+    NSUInteger savedBefore = [detector savedProbeCount];
+
+    NSArray<NSString *> *cacheKeys = @[@"a.example.com", @"b.example.com", @"sdns_c.example.com"];
+    NSMutableSet<NSString *> *calledBackKeys = [NSMutableSet set];
+    NSLock *lock = [[NSLock alloc] init];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"所有缓存键都应收到回调"];
+    expectation.expectedFulfillmentCount = cacheKeys.count;
+
+    for (NSString *key in cacheKeys) {
+        [detector scheduleIPQualityDetection:key
+                                          ip:@"127.0.0.1"
+                                        port:@(port)
+                                    callback:^(NSString *cacheKey, NSString *ip, NSInteger costTime) {
+            XCTAssertGreaterThanOrEqual(costTime, 0);
+            [lock lock];
+            [calledBackKeys addObject:cacheKey];
+            [lock unlock];
+            [expectation fulfill];
+        }];
+    }
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
 
-    // 停止模拟
-    [detectorMock stopMocking];
+    XCTAssertEqualObjects(calledBackKeys, [NSSet setWithArray:cacheKeys]);
+    XCTAssertEqual([detector savedProbeCount] - savedBefore, cacheKeys.count - 1, @"后两次检测应合并到在途探测");
+
+    close(listenFd);
 }
 
-- (void)testAddPendingTask {
-    // 测试添加待处理任务
+- (void)testFreshResultIsReused {
     HttpdnsIPQualityDetector *detector = [HttpdnsIPQualityDetector sharedInstance];
-    id detectorMock = OCMPartialMock(detector);
-
-    // 模拟processPendingTasksIfNeeded方法，避免实际处理任务
-    OCMStub([detectorMock processPendingTasksIfNeeded]);
+    int port = [IpDetectorTestHelper unusedLocalPort];
 
-    // 记录初始待处理任务数量
-    NSUInteger initialCount = [detector pendingTasksCount];
+    XCTestExpectation *first = [self expectationWithDescription:@"first"];
+    [detector scheduleIPQualityDetection:@"a.example.com" ip:@"127.0.0.1" port:@(port) callback:^(NSString *cacheKey, NSString *ip, NSInteger costTime) {
+        [first fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
 
-    // 添加一个待处理任务
-    [detectorMock addPendingTask:@"example.com"
-                              ip:@"1.2.3.4"
-                            port:[NSNumber numberWithInt:80]
-                        callback:^(NSString *cacheKey, NSString *ip, NSInteger costTime) {}];
+    NSUInteger savedBefore = [detector savedProbeCount];
+    id detectorMock = OCMPartialMock(detector);
+    OCMReject([detectorMock executeDetection:[OCMArg any] ip:[OCMArg any] port:[OCMArg any] started:[OCMArg any] callback:[OCMArg any]]);
 
-    // 验证待处理任务数量增加
-    XCTAssertEqual([detector pendingTasksCount], initialCount + 1, @"添加任务后待处理任务数量应增加1");
+    XCTestExpectation *second = [self expectationWithDescription:@"second"];
+    [detectorMock scheduleIPQualityDetection:@"b.example.com" ip:@"127.0.0.1" port:@(port) callback:^(NSString *cacheKey, NSString *ip, NSInteger costTime) {
+        XCTAssertEqualObjects(cacheKey, @"b.example.com");
+        XCTAssertEqual(costTime, -1, @"应复用上次的失败结果");
+        [second fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
 
-    // 停止模拟
+    XCTAssertEqual([detector savedProbeCount] - savedBefore, 1);
+    OCMVerifyAll(detectorMock);
     [detectorMock stopMocking];
 }
 
-- (void)testPendingTasksProcessing {
-    // 测试待处理任务的处理
+- (void)testRemoveAllProbeResultsForcesNewProbe {
     HttpdnsIPQualityDetector *detector = [HttpdnsIPQualityDetector sharedInstance];
-    id detectorMock = OCMPartialMock(detector);
-
-    // 模拟executeDetection方法，避免实际执行检测
-    OCMStub([detectorMock executeDetection:[OCMArg any]
-                                        ip:[OCMArg any]
-                                      port:[OCMArg any]
-                                  callback:[OCMArg any]]);
+    int port = [IpDetectorTestHelper unusedLocalPort];
 
-    // 添加一个待处理任务
-    [detectorMock addPendingTask:@"example.com"
-                              ip:@"1.2.3.4"
-                            port:[NSNumber numberWithInt:80]
-                        callback:^(NSString *cacheKey, NSString *ip, NSInteger costTime) {}];
+    XCTestExpectation *first = [self expectationWithDescription:@"first"];
+    [detector scheduleIPQualityDetection:@"a.example.com" ip:@"127.0.0.1" port:@(port) callback:^(NSString *cacheKey, NSString *ip, NSInteger costTime) {
+        [first fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
 
-    // 手动触发处理待处理任务
-    [detectorMock processPendingTasksIfNeeded];
+    // 模拟网络切换
+    [detector removeAllProbeResults];
 
-    // 给处理任务一些时间
-    [NSThread sleepForTimeInterval:0.1];
+    id detectorMock = OCMPartialMock(detector);
+    OCMExpect([detectorMock executeDetection:@"a.example.com" ip:@"127.0.0.1" port:@(port) started:[OCMArg any] callback:[OCMArg any]]).andForwardToRealObject();
 
-    // 验证待处理任务已被处理
-    XCTAssertEqual([detector pendingTasksCount], 0, @"处理后待处理任务数量应为0");
+    XCTestExpectation *second = [self expectationWithDescription:@"second"];
+    [detectorMock scheduleIPQualityDetection:@"a.example.com" ip:@"127.0.0.1" port:@(port) callback:^(NSString *cacheKey, NSString *ip, NSInteger costTime) {
+        [second fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
 
-    // 停止模拟
+    OCMVerifyAll(detectorMock);
     [detectorMock stopMocking];
 }
 
 #pragma mark - 异步回调测试
 
 - (void)testExecuteDetection {
-    // 测试执行检测并回调
+    // 测试对本地监听端口执行检测并回调
     HttpdnsIPQualityDetector *detector = [HttpdnsIPQualityDetector sharedInstance];
-    id detectorMock = OCMPartialMock(detector);
-
-    // 模拟tcpConnectToIP方法返回固定值
-    OCMStub([detectorMock tcpConnectToIP:@"1.2.3.4" port:80]).andReturn(100);
+    int port = 0;
+    int listenFd = [IpDetectorTestHelper openLocalListenerWithBacklog:16 port:&port];
 
-    // 创建期望
     XCTestExpectation *expectation = [self expectationWithDescription:@"回调应被执行"];
 
-    // 执行测试
-    [detectorMock executeDetection:@"example.com"
-                               ip:@"1.2.3.4"
-                             port:[NSNumber numberWithInt:80]
-                         callback:^(NSString *cacheKey, NSString *ip, NSInteger costTime) {
+    [detector executeDetection:@"example.com"
+                            ip:@"127.0.0.1"
+                          port:@(port)
+                      callback:^(NSString *cacheKey, NSString *ip, NSInteger costTime) {
         // 验证回调参数
         XCTAssertEqualObjects(cacheKey, @"example.com", @"回调中的cacheKey应正确");
-        XCTAssertEqualObjects(ip, @"1.2.3.4", @"回调中的IP应正确");
-        XCTAssertEqual(costTime, 100, @"回调中的耗时应正确");
+        XCTAssertEqualObjects(ip, @"127.0.0.1", @"回调中的IP应正确");
+        XCTAssertGreaterThanOrEqual(costTime, 0, @"连接成功时耗时应不小于0");
 
         [expectation fulfill];
     }];
 
-    // 等待异步操作完成
     [self waitForExpectationsWithTimeout:5.0 handler:nil];
 
-    // 停止模拟
-    [detectorMock stopMocking];
+    close(listenFd);
 }
 
 - (void)testExecuteDetectionWithFailure {
     // 测试执行检测失败的情况
     HttpdnsIPQualityDetector *detector = [HttpdnsIPQualityDetector sharedInstance];
-    id detectorMock = OCMPartialMock(detector);
-
-    // 模拟tcpConnectToIP方法返回失败
-    OCMStub([detectorMock tcpConnectToIP:@"1.2.3.4" port:80]).andReturn(-1);
 
-    // 创建期望
     XCTestExpectation *expectation = [self expectationWithDescription:@"失败回调应被执行"];
 
-    // 执行测试
-    [detectorMock executeDetection:@"example.com"
-                               ip:@"1.2.3.4"
-                             port:[NSNumber numberWithInt:80]
-                         callback:^(NSString *cacheKey, NSString *ip, NSInteger costTime) {
-        // 验证回调参数
+    [detector executeDetection:@"example.com"
+                            ip:@"127.0.0.1"
+                          port:@([IpDetectorTestHelper unusedLocalPort])
+                      callback:^(NSString *cacheKey, NSString *ip, NSInteger costTime) {
         XCTAssertEqualObjects(cacheKey, @"example.com", @"回调中的cacheKey应正确");
-        XCTAssertEqualObjects(ip, @"1.2.3.4", @"回调中的IP应正确");
+        XCTAssertEqualObjects(ip, @"127.0.0.1", @"回调中的IP应正确");
         XCTAssertEqual(costTime, -1, @"连接失败时回调中的耗时应为-1");
 
         [expectation fulfill];
     }];
 
-    // 等待异步操作完成
     [self waitForExpectationsWithTimeout:5.0 handler:nil];
+}
 
-    // 停止模拟
-    [detectorMock stopMocking];
+- (void)testExecuteDetectionOnBlackholedPort {
+    // 黑洞端口在2秒超时后回调失败，期间不占用其他线程
+    HttpdnsIPQualityDetector *detector = [HttpdnsIPQualityDetector sharedInstance];
+    int port = 0;
+    NSArray<NSNumber *> *sockets = [IpDetectorTestHelper openBlackholedListenerWithPort:&port];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"超时回调应被执行"];
+
+    [detector executeDetection:@"example.com"
+                            ip:@"127.0.0.1"
+                          port:@(port)
+                      callback:^(NSString *cacheKey, NSString *ip, NSInteger costTime) {
+        XCTAssertEqual(costTime, -1, @"超时时回调中的耗时应为-1");
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    [IpDetectorTestHelper closeSockets:sockets];
 }
 
 - (void)testExecuteDetectionWithNilPort {
-    // 测试执行检测时端口为nil的情况
+    // 测试执行检测时端口为nil的情况，默认使用80端口
     HttpdnsIPQualityDetector *detector = [HttpdnsIPQualityDetector sharedInstance];
-    id detectorMock = OCMPartialMock(detector);
 
-    // 模拟tcpConnectToIP方法，验证使用默认端口80
-    OCMExpect([detectorMock tcpConnectToIP:@"1.2.3.4" port:80]).andReturn(100);
-
-    // 创建期望
     XCTestExpectation *expectation = [self expectationWithDescription:@"默认端口回调应被执行"];
 
-    // 执行测试，不指定端口
-    [detectorMock executeDetection:@"example.com"
-                               ip:@"1.2.3.4"
-                             port:nil
-                         callback:^(NSString *cacheKey, NSString *ip, NSInteger costTime) {
+    [detector executeDetection:@"example.com"
+                            ip:@"127.0.0.1"
+                          port:nil
+                      callback:^(NSString *cacheKey, NSString *ip, NSInteger costTime) {
         [expectation fulfill];
     }];
 
-    // 等待异步操作完成
     [self waitForExpectationsWithTimeout:5.0 handler:nil];
-
-    // 验证期望
-    OCMVerifyAll(detectorMock);
-
-    // 停止模拟
-    [detectorMock stopMocking];
 }
 
 #pragma mark - 内存管理测试
@@ -344,37 +349,26 @@
 - (void)testMemoryManagementInAsyncOperations {
     // 测试异步操作中的内存管理
     HttpdnsIPQualityDetector *detector = [HttpdnsIPQualityDetector sharedInstance];
-    id detectorMock = OCMPartialMock(detector);
+    int port = 0;
+    NSArray<NSNumber *> *sockets = [IpDetectorTestHelper openBlackholedListenerWithPort:&port];
 
     // 创建可能在异步操作中被释放的对象
-    __block NSString *tempCacheKey = [@"example.com" copy];
-    __block NSString *tempIP = [@"1.2.3.4" copy];
+    __block NSString *tempCacheKey = [NSString stringWithFormat:@"%@.com", @"example"];
+    __block NSString *tempIP = [NSString stringWithFormat:@"127.0.0.%d", 1];
 
     // 创建弱引用以检测对象是否被释放
     __weak NSString *weakCacheKey = tempCacheKey;
     __weak NSString *weakIP = tempIP;
 
-    // 模拟tcpConnectToIP方法，延迟返回以模拟网络延迟
-    OCMStub([detectorMock tcpConnectToIP:[OCMArg any] port:80]).andDo(^(NSInvocation *invocation) {
-        // 延迟执行，给GC一个机会
-        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.5 * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
-            // 设置返回值
-            NSInteger result = 100;
-            [invocation setReturnValue:&result];
-        });
-    });
-
-    // 创建期望
     XCTestExpectation *expectation = [self expectationWithDescription:@"内存管理回调应被执行"];
 
-    // 执行测试
-    [detectorMock executeDetection:tempCacheKey
-                               ip:tempIP
-                             port:[NSNumber numberWithInt:80]
-                         callback:^(NSString *cacheKey, NSString *ip, NSInteger costTime) {
+    [detector executeDetection:tempCacheKey
+                            ip:tempIP
+                          port:@(port)
+                      callback:^(NSString *cacheKey, NSString *ip, NSInteger costTime) {
         // 验证对象在回调时仍然有效
         XCTAssertEqualObjects(cacheKey, @"example.com", @"回调中的cacheKey应正确");
-        XCTAssertEqualObjects(ip, @"1.2.3.4", @"回调中的IP应正确");
+        XCTAssertEqualObjects(ip, @"127.0.0.1", @"回调中的IP应正确");
 
         [expectation fulfill];
     }];
@@ -383,20 +377,17 @@
     tempCacheKey = nil;
     tempIP = nil;
 
-    // 强制GC（注意：在ARC下这不一定会立即触发）
     @autoreleasepool {
         // 触发自动释放池
     }
 
-    // 验证对象没有被释放（应该被executeDetection方法内部强引用）
+    // 验证对象没有被释放（探测进行中由回调持有）
     XCTAssertNotNil(weakCacheKey, @"cacheKey不应被释放");
     XCTAssertNotNil(weakIP, @"IP不应被释放");
 
-    // 等待异步操作完成
     [self waitForExpectationsWithTimeout:5.0 handler:nil];
 
-    // 停止模拟
-    [detectorMock stopMocking];
+    [IpDetectorTestHelper closeSockets:sockets];
 }
 
 @end
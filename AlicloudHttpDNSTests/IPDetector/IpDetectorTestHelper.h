@@ -0,0 +1,32 @@
+//
+//  IpDetectorTestHelper.h
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/24.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface IpDetectorTestHelper : NSObject
+
+// 在127.0.0.1的随机端口上监听，返回监听socket，端口通过port返回；失败返回-1
++ (int)openLocalListenerWithBacklog:(int)backlog port:(int *)port;
+
+// 在::1的指定端口上监听，用于在同一端口上构造不同地址族的竞速对象；失败返回-1
++ (int)openLocalIPv6ListenerOnPort:(int)port;
+
+// 获取一个当前没有监听的本地端口，连接该端口会被拒绝
++ (int)unusedLocalPort;
+
+// 构造一个黑洞端口：监听但从不accept，并用非阻塞连接占满backlog，之后的SYN会被丢弃
+// 返回的socket数组包含监听socket和占位连接，测试结束后需要关闭
++ (NSArray<NSNumber *> *)openBlackholedListenerWithPort:(int *)port;
+
++ (void)closeSockets:(NSArray<NSNumber *> *)sockets;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,127 @@
+//
+//  IpDetectorTestHelper.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/24.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "IpDetectorTestHelper.h"
+#import <sys/socket.h>
+#import <netinet/in.h>
+#import <arpa/inet.h>
+#import <unistd.h>
+#import <fcntl.h>
+
+// 占满backlog所需的占位连接数量，BSD的队列上限约为backlog的1.5倍
+static const NSInteger kBlackholeFillerConnectionCount = 8;
+
+@implementation IpDetectorTestHelper
+
++ (int)openLocalListenerWithBacklog:(int)backlog port:(int *)port {
+    int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        return -1;
+    }
+
+    int reuse = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_len = sizeof(addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = 0;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listenFd, backlog) < 0) {
+        close(listenFd);
+        return -1;
+    }
+
+    socklen_t addrLen = sizeof(addr);
+    getsockname(listenFd, (struct sockaddr *)&addr, &addrLen);
+    if (port) {
+        *port = ntohs(addr.sin_port);
+    }
+    return listenFd;
+}
+
++ (int)openLocalIPv6ListenerOnPort:(int)port {
+    int listenFd = socket(AF_INET6, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        return -1;
+    }
+
+    int reuse = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    int v6Only = 1;
+    setsockopt(listenFd, IPPROTO_IPV6, IPV6_V6ONLY, &v6Only, sizeof(v6Only));
+
+    struct sockaddr_in6 addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin6_len = sizeof(addr);
+    addr.sin6_family = AF_INET6;
+    addr.sin6_port = htons(port);
+    addr.sin6_addr = in6addr_loopback;
+
+    if (bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listenFd, 16) < 0) {
+        close(listenFd);
+        return -1;
+    }
+    return listenFd;
+}
+
++ (int)unusedLocalPort {
+    int port = 0;
+    int listenFd = [self openLocalListenerWithBacklog:1 port:&port];
+    if (listenFd >= 0) {
+        close(listenFd);
+    }
+    return port;
+}
+
++ (NSArray<NSNumber *> *)openBlackholedListenerWithPort:(int *)port {
+    NSMutableArray<NSNumber *> *sockets = [NSMutableArray array];
+
+    int listenPort = 0;
+    int listenFd = [self openLocalListenerWithBacklog:0 port:&listenPort];
+    if (listenFd < 0) {
+        return sockets;
+    }
+    [sockets addObject:@(listenFd)];
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_len = sizeof(addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(listenPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    for (NSInteger i = 0; i < kBlackholeFillerConnectionCount; i++) {
+        int fillerFd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fillerFd < 0) {
+            break;
+        }
+        int flags = fcntl(fillerFd, F_GETFL, 0);
+        fcntl(fillerFd, F_SETFL, flags | O_NONBLOCK);
+        connect(fillerFd, (struct sockaddr *)&addr, sizeof(addr));
+        [sockets addObject:@(fillerFd)];
+    }
+
+    // 等待占位连接进入队列
+    [NSThread sleepForTimeInterval:0.1];
+
+    if (port) {
+        *port = listenPort;
+    }
+    return sockets;
+}
+
++ (void)closeSockets:(NSArray<NSNumber *> *)sockets {
+    for (NSNumber *socketFd in sockets) {
+        close([socketFd intValue]);
+    }
+}
+
+@end
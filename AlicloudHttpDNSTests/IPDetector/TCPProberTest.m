@@ -0,0 +1,230 @@
+//
+//  TCPProberTest.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/24.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+#import <unistd.h>
+#import "HttpdnsTCPProber.h"
+#import "IpDetectorTestHelper.h"
+
+@interface TCPProberTest : XCTestCase
+
+@property (nonatomic, strong) HttpdnsTCPProber *prober;
+
+@end
+
+@implementation TCPProberTest
+
+- (void)setUp {
+    [super setUp];
+    self.prober = [[HttpdnsTCPProber alloc] initWithMaxConcurrentProbes:64];
+}
+
+- (void)tearDown {
+    [self.prober shutdown];
+    self.prober = nil;
+    [super tearDown];
+}
+
+- (void)testProbeLocalListener {
+    int port = 0;
+    int listenFd = [IpDetectorTestHelper openLocalListenerWithBacklog:16 port:&port];
+    XCTAssertGreaterThanOrEqual(listenFd, 0);
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"probe"];
+    [self.prober probeIP:@"127.0.0.1" port:port timeout:2.0 completion:^(NSInteger costTime) {
+        XCTAssertGreaterThanOrEqual(costTime, 0, @"本地监听端口应连接成功");
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    close(listenFd);
+}
+
+- (void)testProbeRefusedPort {
+    int port = [IpDetectorTestHelper unusedLocalPort];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"probe"];
+    NSDate *start = [NSDate date];
+    [self.prober probeIP:@"127.0.0.1" port:port timeout:2.0 completion:^(NSInteger costTime) {
+        XCTAssertEqual(costTime, -1, @"没有监听的端口应连接失败");
+        XCTAssertLessThan([[NSDate date] timeIntervalSinceDate:start], 1.0, @"被拒绝的连接不应等到超时");
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+}
+
+- (void)testProbeBlackholedPortTimesOut {
+    int port = 0;
+    NSArray<NSNumber *> *sockets = [IpDetectorTestHelper openBlackholedListenerWithPort:&port];
+    XCTAssertGreaterThan(sockets.count, 0);
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"probe"];
+    NSDate *start = [NSDate date];
+    [self.prober probeIP:@"127.0.0.1" port:port timeout:0.3 completion:^(NSInteger costTime) {
+        XCTAssertEqual(costTime, -1, @"黑洞端口应以超时失败");
+        XCTAssertLessThan([[NSDate date] timeIntervalSinceDate:start], 1.5, @"超时应由探测自身的截止时间决定");
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    [IpDetectorTestHelper closeSockets:sockets];
+}
+
+- (void)testPerProbeDeadlinesAreIndependent {
+    int blackholePort = 0;
+    NSArray<NSNumber *> *sockets = [IpDetectorTestHelper openBlackholedListenerWithPort:&blackholePort];
+    int port = 0;
+    int listenFd = [IpDetectorTestHelper openLocalListenerWithBacklog:16 port:&port];
+
+    // 慢探测不应拖慢同时进行的快探测
+    XCTestExpectation *slow = [self expectationWithDescription:@"slow"];
+    XCTestExpectation *fast = [self expectationWithDescription:@"fast"];
+    __block NSDate *fastDoneAt = nil;
+    __block NSDate *slowDoneAt = nil;
+
+    [self.prober probeIP:@"127.0.0.1" port:blackholePort timeout:1.0 completion:^(NSInteger costTime) {
+        slowDoneAt = [NSDate date];
+        [slow fulfill];
+    }];
+    [self.prober probeIP:@"127.0.0.1" port:port timeout:1.0 completion:^(NSInteger costTime) {
+        XCTAssertGreaterThanOrEqual(costTime, 0);
+        fastDoneAt = [NSDate date];
+        [fast fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertEqual([fastDoneAt compare:slowDoneAt], NSOrderedAscending);
+
+    close(listenFd);
+    [IpDetectorTestHelper closeSockets:sockets];
+}
+
+- (void)testHundredsOfConcurrentProbes {
+    int port = 0;
+    int listenFd = [IpDetectorTestHelper openLocalListenerWithBacklog:1024 port:&port];
+
+    NSInteger probeCount = 300;
+    __block NSInteger succeeded = 0;
+    NSLock *lock = [[NSLock alloc] init];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"probes"];
+    expectation.expectedFulfillmentCount = probeCount;
+
+    for (NSInteger i = 0; i < probeCount; i++) {
+        [self.prober probeIP:@"127.0.0.1" port:port timeout:2.0 completion:^(NSInteger costTime) {
+            [lock lock];
+            if (costTime >= 0) {
+                succeeded++;
+            }
+            [lock unlock];
+            [expectation fulfill];
+        }];
+    }
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+
+    XCTAssertEqual(succeeded, probeCount);
+    XCTAssertEqual([self.prober activeProbeCount], 0);
+    XCTAssertEqual([self.prober waitingProbeCount], 0);
+
+    close(listenFd);
+}
+
+- (void)testWaitQueueWhenConcurrencyLimitReached {
+    HttpdnsTCPProber *prober = [[HttpdnsTCPProber alloc] initWithMaxConcurrentProbes:2];
+    int port = 0;
+    NSArray<NSNumber *> *sockets = [IpDetectorTestHelper openBlackholedListenerWithPort:&port];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"probes"];
+    expectation.expectedFulfillmentCount = 6;
+    for (NSInteger i = 0; i < 6; i++) {
+        [prober probeIP:@"127.0.0.1" port:port timeout:0.2 completion:^(NSInteger costTime) {
+            [expectation fulfill];
+        }];
+    }
+
+    // 给事件循环一点时间启动前两个探测
+    [NSThread sleepForTimeInterval:0.05];
+    XCTAssertLessThanOrEqual([prober activeProbeCount], 2);
+    XCTAssertGreaterThan([prober waitingProbeCount], 0);
+
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+    XCTAssertEqual([prober waitingProbeCount], 0);
+
+    [prober shutdown];
+    [IpDetectorTestHelper closeSockets:sockets];
+}
+
+- (void)testStartHandlerFiresWhenQueuedProbeLeavesWaitQueue {
+    HttpdnsTCPProber *prober = [[HttpdnsTCPProber alloc] initWithMaxConcurrentProbes:1];
+    int port = 0;
+    NSArray<NSNumber *> *sockets = [IpDetectorTestHelper openBlackholedListenerWithPort:&port];
+
+    __block NSDate *firstFinishedAt = nil;
+    __block NSDate *secondStartedAt = nil;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"probes"];
+    expectation.expectedFulfillmentCount = 2;
+    [prober probeIP:@"127.0.0.1" port:port timeout:0.3 started:nil completion:^(NSInteger costTime) {
+        firstFinishedAt = [NSDate date];
+        [expectation fulfill];
+    }];
+    [prober probeIP:@"127.0.0.1" port:port timeout:0.3 started:^{
+        secondStartedAt = [NSDate date];
+    } completion:^(NSInteger costTime) {
+        [expectation fulfill];
+    }];
+
+    [NSThread sleepForTimeInterval:0.1];
+    XCTAssertNil(secondStartedAt, @"排队中的探测不应回调started");
+
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+    XCTAssertNotNil(secondStartedAt);
+    XCTAssertGreaterThanOrEqual([secondStartedAt timeIntervalSinceDate:firstFinishedAt], -0.05, @"前一个探测结束后才发起连接");
+
+    [prober shutdown];
+    [IpDetectorTestHelper closeSockets:sockets];
+}
+
+- (void)testInvalidParametersFailImmediately {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"probes"];
+    expectation.expectedFulfillmentCount = 3;
+    HttpdnsTCPProbeCompletion completion = ^(NSInteger costTime) {
+        XCTAssertEqual(costTime, -1);
+        [expectation fulfill];
+    };
+
+    [self.prober probeIP:@"not-an-ip" port:80 timeout:1.0 completion:completion];
+    [self.prober probeIP:@"127.0.0.1" port:0 timeout:1.0 completion:completion];
+    [self.prober probeIP:@"127.0.0.1" port:70000 timeout:1.0 completion:completion];
+    [self waitForExpectationsWithTimeout:2.0 handler:nil];
+}
+
+- (void)testShutdownFailsOutstandingProbes {
+    int port = 0;
+    NSArray<NSNumber *> *sockets = [IpDetectorTestHelper openBlackholedListenerWithPort:&port];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"probes"];
+    expectation.expectedFulfillmentCount = 2;
+    [self.prober probeIP:@"127.0.0.1" port:port timeout:10.0 completion:^(NSInteger costTime) {
+        XCTAssertEqual(costTime, -1);
+        [expectation fulfill];
+    }];
+
+    [NSThread sleepForTimeInterval:0.05];
+    [self.prober shutdown];
+
+    // 停止后提交的探测直接失败
+    [self.prober probeIP:@"127.0.0.1" port:port timeout:10.0 completion:^(NSInteger costTime) {
+        XCTAssertEqual(costTime, -1);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:2.0 handler:nil];
+
+    [IpDetectorTestHelper closeSockets:sockets];
+}
+
+@end
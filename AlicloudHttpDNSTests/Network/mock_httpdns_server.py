@@ -0,0 +1,399 @@
+#!/usr/bin/env python3
+"""
+HTTPDNS 服务端模拟器，用于压测 SDK 的解析链路
+
+在本地模拟 /v2/d 解析接口和 /{account_id}/ss 调度接口，响应格式与线上服务一致，
+并且可以注入延迟分布、错误率、连接重置和慢速发送（slow-loris），
+配合 Benchmark/ResolverLoadTest 在不访问线上服务的情况下评估 SDK 的并发扩展性。
+
+使用方法:
+    python3 mock_httpdns_server.py [--latency lognormal:8,0.5] [--error-rate 0.01] ...
+
+端口配置:
+    - HTTP:  127.0.0.1:11180
+    - HTTPS: 127.0.0.1:11543 (自签名证书，与 mock_server.py 共用 server.pem)
+
+延迟分布 (单位毫秒):
+    fixed:MS               固定延迟
+    uniform:LO,HI          均匀分布
+    normal:MEAN,STD        正态分布，负值截断为0
+    lognormal:MEDIAN,SIGMA 对数正态分布，适合模拟长尾
+    exp:MEAN               指数分布
+
+运行时调整:
+    GET  /admin/stats      返回请求计数
+    POST /admin/config     以 JSON 覆盖部分配置，键名与命令行参数一致（下划线形式）
+    POST /admin/reset      清空计数
+
+注意:
+    - 配置了 --secret-key 时校验签名和过期时间，签名错误返回 403
+    - m=1 的请求需要 --aes-key 才能解密，响应同样以 AES-CBC 加密返回；
+      优先使用 cryptography 库，未安装时退化为调用 openssl 命令行，吞吐会明显下降
+"""
+
+import argparse
+import base64
+import hashlib
+import hmac
+import json
+import math
+import os
+import random
+import signal
+import socket
+import ssl
+import struct
+import subprocess
+import sys
+import threading
+import time
+from http.server import BaseHTTPRequestHandler
+from threading import Thread
+from urllib.parse import urlparse, parse_qs
+
+from mock_server import ThreadedHTTPServer, create_self_signed_cert
+
+try:
+    from cryptography.hazmat.primitives import padding
+    from cryptography.hazmat.primitives.ciphers import Cipher, algorithms, modes
+    HAS_CRYPTOGRAPHY = True
+except ImportError:
+    HAS_CRYPTOGRAPHY = False
+
+
+# 不参与签名的参数，与 HttpdnsRemoteResolver appendAdditionalParams 一致
+UNSIGNED_PARAMS = {'s', 'sid', 'net', 'sdk', 'bssid'}
+
+
+class LatencyDistribution:
+    """按配置串采样延迟，单位毫秒"""
+
+    def __init__(self, spec):
+        self.spec = spec or 'fixed:0'
+        kind, _, args = self.spec.partition(':')
+        self.kind = kind
+        self.args = [float(a) for a in args.split(',') if a]
+        samplers = {
+            'fixed': lambda: self.args[0],
+            'uniform': lambda: random.uniform(self.args[0], self.args[1]),
+            'normal': lambda: random.gauss(self.args[0], self.args[1]),
+            'lognormal': lambda: random.lognormvariate(math.log(self.args[0]), self.args[1]),
+            'exp': lambda: random.expovariate(1.0 / self.args[0]) if self.args[0] > 0 else 0,
+        }
+        if kind not in samplers:
+            raise ValueError(f'unsupported latency distribution: {self.spec}')
+        self._sampler = samplers[kind]
+        self._sampler()
+
+    def sample_seconds(self):
+        return max(self._sampler(), 0.0) / 1000.0
+
+
+class ServerState:
+    """可在运行时调整的配置和计数，所有处理线程共享"""
+
+    def __init__(self, args):
+        self.lock = threading.Lock()
+        self.config = {}
+        self.apply({
+            'account_id': args.account_id,
+            'secret_key': args.secret_key,
+            'aes_key': args.aes_key,
+            'latency': args.latency,
+            'error_rate': args.error_rate,
+            'reset_rate': args.reset_rate,
+            'slowloris_rate': args.slowloris_rate,
+            'slowloris_interval_ms': args.slowloris_interval_ms,
+            'ttl': args.ttl,
+            'ips_per_host': args.ips_per_host,
+            'advertise': args.advertise,
+        })
+        self.reset_stats()
+
+    def apply(self, updates):
+        with self.lock:
+            merged = dict(self.config)
+            merged.update(updates)
+            # 先解析再替换，配置串非法时保留原配置
+            latency = LatencyDistribution(merged['latency'])
+            self.config = merged
+            self.latency = latency
+
+    def snapshot(self):
+        with self.lock:
+            return dict(self.config), self.latency
+
+    def reset_stats(self):
+        with self.lock:
+            self.stats = {
+                'resolve_requests': 0,
+                'resolved_hosts': 0,
+                'schedule_requests': 0,
+                'injected_errors': 0,
+                'injected_resets': 0,
+                'injected_slowloris': 0,
+                'signature_failures': 0,
+                'decrypt_failures': 0,
+            }
+
+    def count(self, key, value=1):
+        with self.lock:
+            self.stats[key] += value
+
+    def stats_snapshot(self):
+        with self.lock:
+            return dict(self.stats)
+
+
+def aes_cbc_encrypt(key, plaintext):
+    iv = os.urandom(16)
+    if HAS_CRYPTOGRAPHY:
+        padder = padding.PKCS7(128).padder()
+        padded = padder.update(plaintext) + padder.finalize()
+        encryptor = Cipher(algorithms.AES(key), modes.CBC(iv)).encryptor()
+        return iv + encryptor.update(padded) + encryptor.finalize()
+    output = subprocess.run(['openssl', 'enc', '-aes-128-cbc', '-K', key.hex(), '-iv', iv.hex()],
+                            input=plaintext, capture_output=True, check=True).stdout
+    return iv + output
+
+
+def aes_cbc_decrypt(key, data):
+    iv, ciphertext = data[:16], data[16:]
+    if HAS_CRYPTOGRAPHY:
+        decryptor = Cipher(algorithms.AES(key), modes.CBC(iv)).decryptor()
+        padded = decryptor.update(ciphertext) + decryptor.finalize()
+        unpadder = padding.PKCS7(128).unpadder()
+        return unpadder.update(padded) + unpadder.finalize()
+    return subprocess.run(['openssl', 'enc', '-d', '-aes-128-cbc', '-K', key.hex(), '-iv', iv.hex()],
+                          input=ciphertext, capture_output=True, check=True).stdout
+
+
+def sign(params, secret_key):
+    content = '&'.join(f'{k}={params[k]}' for k in sorted(params))
+    return hmac.new(bytes.fromhex(secret_key), content.encode(), hashlib.sha256).hexdigest()
+
+
+def build_answer(host, query_types, config):
+    """按域名哈希生成稳定的IP，同一个域名每次解析结果一致"""
+    digest = hashlib.md5(host.encode()).digest()
+    count = max(int(config['ips_per_host']), 1)
+    ttl = int(config['ttl'])
+    answer = {'dn': host, 'data': {'cip': '127.0.0.1'}}
+    if '4' in query_types:
+        answer['v4'] = {'ips': [f'10.{digest[0]}.{digest[1]}.{i + 1}' for i in range(count)], 'ttl': ttl}
+    if '6' in query_types:
+        prefix = struct.unpack('>H', digest[2:4])[0]
+        answer['v6'] = {'ips': [f'2001:db8::{prefix:x}:{i + 1:x}' for i in range(count)], 'ttl': ttl}
+    return answer
+
+
+class MockHttpdnsHandler(BaseHTTPRequestHandler):
+    """/v2/d 与调度接口的处理器"""
+
+    protocol_version = 'HTTP/1.1'
+    state = None
+
+    def log_message(self, format, *args):
+        # 压测时逐条打印日志会成为瓶颈
+        pass
+
+    def do_GET(self):
+        parsed = urlparse(self.path)
+        query = {k: v[0] for k, v in parse_qs(parsed.query, keep_blank_values=True).items()}
+        if parsed.path == '/v2/d':
+            self._handle_resolve(query)
+        elif parsed.path.endswith('/ss'):
+            self._handle_schedule()
+        elif parsed.path == '/admin/stats':
+            self._send_json(200, self.state.stats_snapshot())
+        else:
+            self._send_json(404, {'code': 'NotFound'})
+
+    def do_POST(self):
+        parsed = urlparse(self.path)
+        length = int(self.headers.get('Content-Length', 0))
+        body = self.rfile.read(length) if length > 0 else b''
+        if parsed.path == '/admin/config':
+            try:
+                self.state.apply(json.loads(body or b'{}'))
+            except (ValueError, KeyError, IndexError) as e:
+                self._send_json(400, {'code': 'InvalidConfig', 'message': str(e)})
+                return
+            self._send_json(200, self.state.snapshot()[0])
+        elif parsed.path == '/admin/reset':
+            self.state.reset_stats()
+            self._send_json(200, {})
+        else:
+            self._send_json(404, {'code': 'NotFound'})
+
+    def _handle_schedule(self):
+        self.state.count('schedule_requests')
+        config, latency = self.state.snapshot()
+        time.sleep(latency.sample_seconds())
+        advertise = config['advertise'] or f'127.0.0.1:{self.server.server_address[1]}'
+        self._send_json(200, {'service_ip': [advertise], 'service_ipv6': []})
+
+    def _handle_resolve(self, query):
+        self.state.count('resolve_requests')
+        config, latency = self.state.snapshot()
+
+        roll = random.random()
+        if roll < config['reset_rate']:
+            self.state.count('injected_resets')
+            self._reset_connection()
+            return
+        roll -= config['reset_rate']
+        if roll < config['error_rate']:
+            self.state.count('injected_errors')
+            self._send_json(503, {'code': 'ServiceUnavailable'})
+            return
+        roll -= config['error_rate']
+        slowloris = roll < config['slowloris_rate']
+
+        time.sleep(latency.sample_seconds())
+
+        status, error_code = self._verify(query, config)
+        if status != 200:
+            self._send_json(status, {'code': error_code})
+            return
+
+        mode = query.get('m', '0')
+        if mode == '1':
+            try:
+                params = json.loads(aes_cbc_decrypt(bytes.fromhex(config['aes_key']), bytes.fromhex(query['enc'])))
+            except Exception:
+                self.state.count('decrypt_failures')
+                self._send_json(400, {'code': 'InvalidEncryptedParams'})
+                return
+        else:
+            params = query
+
+        hosts = [h for h in params.get('dn', '').split(',') if h]
+        query_types = params.get('q', '4')
+        self.state.count('resolved_hosts', len(hosts))
+        data = {'answers': [build_answer(host, query_types, config) for host in hosts]}
+
+        if mode == '1':
+            encrypted = aes_cbc_encrypt(bytes.fromhex(config['aes_key']), json.dumps(data).encode())
+            payload = {'code': 'success', 'mode': 1, 'data': base64.b64encode(encrypted).decode()}
+        else:
+            payload = {'code': 'success', 'mode': 0, 'data': data}
+
+        if slowloris:
+            self.state.count('injected_slowloris')
+            self._send_json_slowly(payload, config['slowloris_interval_ms'] / 1000.0)
+        else:
+            self._send_json(200, payload)
+
+    def _verify(self, query, config):
+        if config['account_id'] and query.get('id') != str(config['account_id']):
+            return 403, 'InvalidAccount'
+        if not config['secret_key']:
+            return 200, None
+        try:
+            if int(query.get('exp', '0')) < int(time.time()):
+                self.state.count('signature_failures')
+                return 403, 'SignatureExpired'
+        except ValueError:
+            return 400, 'InvalidExp'
+        signed = {k: v for k, v in query.items() if k not in UNSIGNED_PARAMS}
+        if not hmac.compare_digest(sign(signed, config['secret_key']), query.get('s', '')):
+            self.state.count('signature_failures')
+            return 403, 'InvalidSignature'
+        return 200, None
+
+    def _reset_connection(self):
+        # SO_LINGER为0时close会直接发送RST
+        self.connection.setsockopt(socket.SOL_SOCKET, socket.SO_LINGER, struct.pack('ii', 1, 0))
+        self.close_connection = True
+        try:
+            self.connection.close()
+        except OSError:
+            pass
+
+    def _send_json(self, status_code, data):
+        body = json.dumps(data).encode()
+        self.send_response(status_code)
+        self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def _send_json_slowly(self, data, interval):
+        """先发完整的头部，再逐字节发送响应体"""
+        body = json.dumps(data).encode()
+        self.send_response(200)
+        self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(body)))
+        self.end_headers()
+        self.wfile.flush()
+        try:
+            for i in range(len(body)):
+                self.wfile.write(body[i:i + 1])
+                self.wfile.flush()
+                time.sleep(interval)
+        except (BrokenPipeError, ConnectionResetError):
+            # 客户端超时后主动断开属于预期行为
+            self.close_connection = True
+
+
+def serve(server, description):
+    print(f'✓ {description}')
+    server.serve_forever()
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='HTTPDNS 服务端模拟器')
+    parser.add_argument('--port', type=int, default=11180, help='HTTP 端口')
+    parser.add_argument('--https-port', type=int, default=11543, help='HTTPS 端口，0 表示不启动')
+    parser.add_argument('--account-id', type=int, default=0, help='校验请求中的 id，0 表示不校验')
+    parser.add_argument('--secret-key', default='', help='签名密钥（十六进制），为空时不校验签名')
+    parser.add_argument('--aes-key', default='', help='AES 密钥（十六进制），用于 m=1 的加密请求')
+    parser.add_argument('--latency', default='fixed:0', help='服务端处理延迟分布，见文件头说明')
+    parser.add_argument('--error-rate', type=float, default=0.0, help='返回 503 的比例')
+    parser.add_argument('--reset-rate', type=float, default=0.0, help='读取请求后直接重置连接的比例')
+    parser.add_argument('--slowloris-rate', type=float, default=0.0, help='逐字节慢速发送响应体的比例')
+    parser.add_argument('--slowloris-interval-ms', type=float, default=100.0, help='慢速发送时每个字节的间隔')
+    parser.add_argument('--ttl', type=int, default=60, help='解析结果的 TTL')
+    parser.add_argument('--ips-per-host', type=int, default=2, help='每个地址族返回的 IP 个数')
+    parser.add_argument('--advertise', default='', help='调度接口下发的服务地址，默认为本机 HTTP 端口')
+    return parser.parse_args()
+
+
+def main():
+    args = parse_args()
+    signal.signal(signal.SIGINT, lambda sig, frame: sys.exit(0))
+
+    if args.aes_key and not HAS_CRYPTOGRAPHY:
+        print('! 未安装 cryptography，加解密将调用 openssl 命令行', file=sys.stderr)
+
+    MockHttpdnsHandler.state = ServerState(args)
+
+    threads = []
+    http_server = ThreadedHTTPServer(('127.0.0.1', args.port), MockHttpdnsHandler)
+    threads.append(Thread(target=serve, args=(http_server, f'HTTP 服务器运行在 http://127.0.0.1:{args.port}'), daemon=True))
+
+    if args.https_port:
+        script_dir = os.path.dirname(os.path.abspath(__file__))
+        cert_file = os.path.join(script_dir, 'server.pem')
+        create_self_signed_cert(cert_file)
+        https_server = ThreadedHTTPServer(('127.0.0.1', args.https_port), MockHttpdnsHandler)
+        context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        context.load_cert_chain(cert_file)
+        https_server.socket = context.wrap_socket(https_server.socket, server_side=True)
+        threads.append(Thread(target=serve, args=(https_server, f'HTTPS 服务器运行在 https://127.0.0.1:{args.https_port} (自签名证书)'), daemon=True))
+
+    for thread in threads:
+        thread.start()
+
+    print(f'  latency={args.latency} error_rate={args.error_rate} reset_rate={args.reset_rate} '
+          f'slowloris_rate={args.slowloris_rate} signature={"on" if args.secret_key else "off"}')
+    try:
+        for thread in threads:
+            thread.join()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main()
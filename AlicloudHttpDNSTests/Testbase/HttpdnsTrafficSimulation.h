@@ -0,0 +1,81 @@
+//
+//  HttpdnsTrafficSimulation.h
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "HttpdnsRequest.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class HttpDnsService;
+
+@interface HttpdnsTrafficSimulationReport : NSObject
+
+@property (nonatomic, assign) NSTimeInterval simulatedSeconds;
+@property (nonatomic, assign) NSTimeInterval wallClockSeconds;
+
+// 应用发起的解析次数，以及其中拿到结果的次数
+@property (nonatomic, assign) NSUInteger requestCount;
+@property (nonatomic, assign) NSUInteger answeredCount;
+
+// 按SDK统计计数的增量，缓存命中不含复用过期结果
+@property (nonatomic, assign) NSUInteger cacheHitCount;
+@property (nonatomic, assign) NSUInteger staleServeCount;
+@property (nonatomic, assign) NSUInteger cacheMissCount;
+
+// 模拟服务端收到的解析请求数、其中失败的次数，以及一次请求中包含的域名总数
+@property (nonatomic, assign) NSUInteger serverRequestCount;
+@property (nonatomic, assign) NSUInteger serverFailureCount;
+@property (nonatomic, assign) NSUInteger serverResolvedHostCount;
+
+@property (nonatomic, assign) NSUInteger networkFlapCount;
+@property (nonatomic, assign) NSUInteger scheduleUpdateCount;
+
+// 命中缓存（含复用过期结果）的比例
+@property (nonatomic, assign, readonly) double cacheHitRate;
+
+@property (nonatomic, assign, readonly) double answerRate;
+
+- (NSDictionary<NSString *, NSNumber *> *)dictionaryRepresentation;
+
+@end
+
+// 在虚拟时钟上回放按秒生成的解析流量，数小时的TTL更替、网络切换和服务端故障几秒内跑完
+// 服务端由桩替换，相同的参数和种子得到相同的报告
+@interface HttpdnsTrafficSimulation : NSObject
+
+// 随机数种子，决定访问的域名序列和服务端下发的TTL
+@property (nonatomic, assign) uint64_t seed;
+
+@property (nonatomic, assign) NSTimeInterval duration;
+
+@property (nonatomic, assign) NSUInteger requestsPerSecond;
+
+// 域名按Zipf分布访问，排名第k的域名权重为1/k^zipfExponent
+@property (nonatomic, assign) NSUInteger hostCount;
+@property (nonatomic, assign) double zipfExponent;
+
+// 服务端每次应答在[minTTL, maxTTL]中随机取TTL，同时更换IP
+@property (nonatomic, assign) int64_t minTTL;
+@property (nonatomic, assign) int64_t maxTTL;
+
+@property (nonatomic, assign) HttpdnsQueryIPType queryIpType;
+
+// 每隔多少秒发出一次网络变化通知，为0时不切换网络
+@property (nonatomic, assign) NSTimeInterval networkFlapInterval;
+
+- (instancetype)initWithService:(HttpDnsService *)service;
+
+// 从模拟开始后start秒起，服务端在duration秒内对所有解析请求报错
+- (void)addServerOutageFrom:(NSTimeInterval)start duration:(NSTimeInterval)duration;
+
+// 模拟期间替换SDK的时钟和服务端，结束后恢复
+- (HttpdnsTrafficSimulationReport *)run;
+
+@end
+
+NS_ASSUME_NONNULL_END
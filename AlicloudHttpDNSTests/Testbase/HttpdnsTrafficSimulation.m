@@ -0,0 +1,288 @@
+//
+//  HttpdnsTrafficSimulation.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "HttpdnsTrafficSimulation.h"
+#import <OCMock/OCMock.h>
+#import "HttpdnsVirtualClock.h"
+#import "HttpdnsHostObject.h"
+#import "HttpdnsMetrics.h"
+#import "HttpdnsReachability.h"
+#import "HttpdnsRemoteResolver.h"
+#import "HttpdnsRequestManager.h"
+#import "HttpdnsScheduleCenter.h"
+#import "HttpdnsService.h"
+#import "HttpdnsService_Internal.h"
+
+// splitmix64，相同种子产生相同序列
+static uint64_t HttpdnsSimulationNextRandom(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static double HttpdnsSimulationNextUniform(uint64_t *state) {
+    return (HttpdnsSimulationNextRandom(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+@implementation HttpdnsTrafficSimulationReport
+
+- (double)cacheHitRate {
+    NSUInteger lookupCount = self.cacheHitCount + self.staleServeCount + self.cacheMissCount;
+    return lookupCount > 0 ? (double)(self.cacheHitCount + self.staleServeCount) / lookupCount : 0;
+}
+
+- (double)answerRate {
+    return self.requestCount > 0 ? (double)self.answeredCount / self.requestCount : 0;
+}
+
+- (NSDictionary<NSString *, NSNumber *> *)dictionaryRepresentation {
+    return @{
+        @"simulatedSeconds": @(self.simulatedSeconds),
+        @"wallClockSeconds": @(self.wallClockSeconds),
+        @"requests": @(self.requestCount),
+        @"answered": @(self.answeredCount),
+        @"cacheHits": @(self.cacheHitCount),
+        @"staleServes": @(self.staleServeCount),
+        @"cacheMisses": @(self.cacheMissCount),
+        @"serverRequests": @(self.serverRequestCount),
+        @"serverFailures": @(self.serverFailureCount),
+        @"serverResolvedHosts": @(self.serverResolvedHostCount),
+        @"networkFlaps": @(self.networkFlapCount),
+        @"scheduleUpdates": @(self.scheduleUpdateCount),
+        @"cacheHitRate": @(self.cacheHitRate),
+        @"answerRate": @(self.answerRate),
+    };
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"simulated %.0fs in %.2fs, requests: %lu, answered: %.2f%%, hit rate: %.2f%% (hit: %lu, stale: %lu, miss: %lu), server requests: %lu (failed: %lu), flaps: %lu",
+            self.simulatedSeconds, self.wallClockSeconds, (unsigned long)self.requestCount, self.answerRate * 100,
+            self.cacheHitRate * 100, (unsigned long)self.cacheHitCount, (unsigned long)self.staleServeCount, (unsigned long)self.cacheMissCount,
+            (unsigned long)self.serverRequestCount, (unsigned long)self.serverFailureCount, (unsigned long)self.networkFlapCount];
+}
+
+@end
+
+// 替代真实服务端的解析器，故障期间报错，否则按域名生成结果
+@interface HttpdnsSimulatedResolver : HttpdnsRemoteResolver
+
+@property (nonatomic, assign) BOOL serverAvailable;
+@property (nonatomic, assign) uint64_t randomState;
+@property (nonatomic, assign) int64_t minTTL;
+@property (nonatomic, assign) int64_t maxTTL;
+@property (nonatomic, assign) NSUInteger requestCount;
+@property (nonatomic, assign) NSUInteger failureCount;
+@property (nonatomic, assign) NSUInteger resolvedHostCount;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *generations;
+
+@end
+
+@implementation HttpdnsSimulatedResolver
+
+- (NSArray<HttpdnsHostObject *> *)resolve:(HttpdnsRequest *)request error:(NSError **)error {
+    @synchronized (self) {
+        self.requestCount++;
+        if (!self.serverAvailable) {
+            self.failureCount++;
+            if (error) {
+                *error = [NSError errorWithDomain:@"HttpdnsTrafficSimulation" code:503 userInfo:nil];
+            }
+            return nil;
+        }
+
+        NSMutableArray<HttpdnsHostObject *> *hostObjects = [NSMutableArray array];
+        // 预解析时一次请求包含多个域名
+        for (NSString *host in [request.host componentsSeparatedByString:@","]) {
+            [hostObjects addObject:[self hostObjectForHost:host queryIpType:request.queryIpType]];
+        }
+        self.resolvedHostCount += hostObjects.count;
+        return hostObjects;
+    }
+}
+
+- (HttpdnsHostObject *)hostObjectForHost:(NSString *)host queryIpType:(HttpdnsQueryIPType)queryIpType {
+    uint64_t randomState = self.randomState;
+    int64_t ttl = self.minTTL + (int64_t)(HttpdnsSimulationNextRandom(&randomState) % (uint64_t)(self.maxTTL - self.minTTL + 1));
+    self.randomState = randomState;
+
+    // 每次应答都换一组IP，模拟服务端调度的变化
+    NSUInteger generation = self.generations[host].unsignedIntegerValue + 1;
+    self.generations[host] = @(generation);
+    NSUInteger hostHash = host.hash;
+
+    HttpdnsHostObject *hostObject = [HttpdnsHostObject new];
+    hostObject.hostName = host;
+    int64_t now = HttpdnsClockCurrentEpoch();
+    if (queryIpType == HttpdnsQueryIPTypeAuto || (queryIpType & HttpdnsQueryIPTypeIpv4)) {
+        HttpdnsIpObject *ipObject = [HttpdnsIpObject new];
+        ipObject.ip = [NSString stringWithFormat:@"10.%lu.%lu.%lu", (unsigned long)(hostHash % 256), (unsigned long)(generation / 256 % 256), (unsigned long)(generation % 256)];
+        hostObject.v4Ips = @[ipObject];
+        hostObject.v4ttl = ttl;
+        hostObject.lastIPv4LookupTime = now;
+    }
+    if (queryIpType & HttpdnsQueryIPTypeIpv6) {
+        HttpdnsIpObject *ipObject = [HttpdnsIpObject new];
+        ipObject.ip = [NSString stringWithFormat:@"fd00::%lx:%lx", (unsigned long)(hostHash % 0x10000), (unsigned long)(generation % 0x10000)];
+        hostObject.v6Ips = @[ipObject];
+        hostObject.v6ttl = ttl;
+        hostObject.lastIPv6LookupTime = now;
+    }
+    return hostObject;
+}
+
+@end
+
+@interface HttpdnsTrafficSimulation ()
+
+@property (nonatomic, strong) HttpDnsService *service;
+@property (nonatomic, strong) NSMutableArray<NSValue *> *outages;
+
+@end
+
+@implementation HttpdnsTrafficSimulation
+
+- (instancetype)initWithService:(HttpDnsService *)service {
+    if (self = [super init]) {
+        _service = service;
+        _outages = [NSMutableArray array];
+        _seed = 1;
+        _duration = 3600;
+        _requestsPerSecond = 10;
+        _hostCount = 200;
+        _zipfExponent = 1.0;
+        _minTTL = 60;
+        _maxTTL = 600;
+        _queryIpType = HttpdnsQueryIPTypeIpv4;
+    }
+    return self;
+}
+
+- (void)addServerOutageFrom:(NSTimeInterval)start duration:(NSTimeInterval)duration {
+    [self.outages addObject:[NSValue valueWithRange:NSMakeRange((NSUInteger)start, (NSUInteger)duration)]];
+}
+
+- (BOOL)isServerOutageAt:(NSTimeInterval)elapsed {
+    for (NSValue *outage in self.outages) {
+        if (NSLocationInRange((NSUInteger)elapsed, outage.rangeValue)) {
+            return YES;
+        }
+    }
+    return NO;
+}
+
+- (NSArray<NSNumber *> *)cumulativeHostWeights {
+    NSMutableArray<NSNumber *> *weights = [NSMutableArray arrayWithCapacity:self.hostCount];
+    double total = 0;
+    for (NSUInteger rank = 1; rank <= self.hostCount; rank++) {
+        total += 1.0 / pow(rank, self.zipfExponent);
+        [weights addObject:@(total)];
+    }
+    NSMutableArray<NSNumber *> *cumulativeWeights = [NSMutableArray arrayWithCapacity:self.hostCount];
+    for (NSNumber *weight in weights) {
+        [cumulativeWeights addObject:@(weight.doubleValue / total)];
+    }
+    return cumulativeWeights;
+}
+
+- (HttpdnsTrafficSimulationReport *)run {
+    HttpdnsTrafficSimulationReport *report = [HttpdnsTrafficSimulationReport new];
+    HttpdnsRequestManager *requestManager = self.service.requestManager;
+    uint64_t randomState = self.seed;
+
+    NSMutableArray<NSString *> *hosts = [NSMutableArray arrayWithCapacity:self.hostCount];
+    for (NSUInteger i = 0; i < self.hostCount; i++) {
+        [hosts addObject:[NSString stringWithFormat:@"sim-%lu.onlyfortest.com", (unsigned long)i]];
+    }
+    NSArray<NSNumber *> *cumulativeWeights = [self cumulativeHostWeights];
+
+    HttpdnsVirtualClock *clock = [HttpdnsVirtualClock new];
+    HttpdnsSimulatedResolver *resolver = [HttpdnsSimulatedResolver new];
+    resolver.randomState = HttpdnsSimulationNextRandom(&randomState);
+    resolver.minTTL = self.minTTL;
+    resolver.maxTTL = MAX(self.maxTTL, self.minTTL);
+    resolver.generations = [NSMutableDictionary dictionary];
+    resolver.serverAvailable = YES;
+
+    id mockResolverClass = OCMClassMock([HttpdnsRemoteResolver class]);
+    OCMStub([mockResolverClass new]).andReturn(resolver);
+
+    // 网络切换后会更新调度配置，这里只计数，不发出真实请求
+    id mockScheduleCenter = OCMPartialMock(self.service.scheduleCenter);
+    OCMStub([mockScheduleCenter asyncUpdateRegionScheduleConfig]).andDo(^(NSInvocation *invocation) {
+        @synchronized (report) {
+            report.scheduleUpdateCount++;
+        }
+    });
+
+    uint64_t hitCount = HttpdnsMetricsCounterValue(HttpdnsMetricCounterCacheHit);
+    uint64_t staleServeCount = HttpdnsMetricsCounterValue(HttpdnsMetricCounterStaleServe);
+    uint64_t missCount = HttpdnsMetricsCounterValue(HttpdnsMetricCounterCacheMiss);
+
+    [clock install];
+    NSTimeInterval startTime = clock.now;
+    uint64_t wallClockStartTime = HttpdnsMetricsNow();
+
+    for (NSUInteger second = 0; second < (NSUInteger)self.duration; second++) {
+        @autoreleasepool {
+            @synchronized (resolver) {
+                resolver.serverAvailable = ![self isServerOutageAt:second];
+            }
+
+            if (self.networkFlapInterval > 0 && second > 0 && fmod(second, self.networkFlapInterval) == 0) {
+                report.networkFlapCount++;
+                [[NSNotificationCenter defaultCenter] postNotificationName:kHttpdnsReachabilityChangedNotification
+                                                                    object:[HttpdnsReachability sharedInstance]];
+            }
+
+            // 一秒内的请求均匀分布，每次请求后等异步解析完成，保证结果与线程调度无关
+            for (NSUInteger i = 0; i < self.requestsPerSecond; i++) {
+                [clock advanceTo:startTime + second + (double)i / self.requestsPerSecond];
+
+                double sample = HttpdnsSimulationNextUniform(&randomState);
+                NSUInteger index = [cumulativeWeights indexOfObject:@(sample)
+                                                      inSortedRange:NSMakeRange(0, cumulativeWeights.count)
+                                                            options:NSBinarySearchingInsertionIndex
+                                                    usingComparator:^NSComparisonResult(NSNumber *lhs, NSNumber *rhs) {
+                    return [lhs compare:rhs];
+                }];
+                NSString *host = hosts[MIN(index, hosts.count - 1)];
+
+                HttpdnsResult *result = [self.service resolveHostSyncNonBlocking:host byIpType:self.queryIpType];
+                report.requestCount++;
+                if (result) {
+                    report.answeredCount++;
+                }
+                [requestManager waitForAsyncResolveTasks];
+            }
+
+            // 推进到下一秒，网络切换后的延迟任务等在这里执行
+            [clock advanceTo:startTime + second + 1];
+            [requestManager waitForAsyncResolveTasks];
+        }
+    }
+
+    report.wallClockSeconds = (double)(HttpdnsMetricsNow() - wallClockStartTime) / NSEC_PER_SEC;
+    report.simulatedSeconds = clock.now - startTime;
+    [clock uninstall];
+
+    report.cacheHitCount = (NSUInteger)(HttpdnsMetricsCounterValue(HttpdnsMetricCounterCacheHit) - hitCount);
+    report.staleServeCount = (NSUInteger)(HttpdnsMetricsCounterValue(HttpdnsMetricCounterStaleServe) - staleServeCount);
+    report.cacheMissCount = (NSUInteger)(HttpdnsMetricsCounterValue(HttpdnsMetricCounterCacheMiss) - missCount);
+    @synchronized (resolver) {
+        report.serverRequestCount = resolver.requestCount;
+        report.serverFailureCount = resolver.failureCount;
+        report.serverResolvedHostCount = resolver.resolvedHostCount;
+    }
+
+    [mockScheduleCenter stopMocking];
+    [mockResolverClass stopMocking];
+    return report;
+}
+
+@end
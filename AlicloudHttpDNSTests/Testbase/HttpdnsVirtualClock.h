@@ -0,0 +1,38 @@
+//
+//  HttpdnsVirtualClock.h
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "HttpdnsClock.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// 只在被推进时才走动的时钟，延迟任务按到期时间和提交顺序依次执行，结果与机器快慢无关
+@interface HttpdnsVirtualClock : NSObject <HttpdnsClock>
+
+// 尚未执行的延迟任务数
+@property (nonatomic, assign, readonly) NSUInteger pendingTaskCount;
+
+// 被调用方sleep的总时长。sleep不阻塞也不推进时钟，否则并发的重试会把时间叠加起来
+@property (nonatomic, assign, readonly) NSTimeInterval totalSleptInterval;
+
+- (instancetype)initWithStartTime:(NSTimeInterval)startTime;
+
+// 推进时钟，途中到期的延迟任务在推进它的线程上同步派发到各自的队列执行
+// 不能在延迟任务所在的串行队列上调用
+- (void)advanceBy:(NSTimeInterval)interval;
+
+- (void)advanceTo:(NSTimeInterval)time;
+
+// 替换为SDK使用的时钟，uninstall恢复系统时钟
+- (void)install;
+
+- (void)uninstall;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,140 @@
+//
+//  HttpdnsVirtualClock.m
+//  AlicloudHttpDNSTests
+//
+//  Created by xuyecan on 2025/4/29.
+//  Copyright © 2025 alibaba-inc.com. All rights reserved.
+//
+
+#import "HttpdnsVirtualClock.h"
+
+// 所有虚拟时钟走到过的最晚时刻
+static NSTimeInterval sLatestVirtualTime = 0;
+
+@interface HttpdnsVirtualClockTask : NSObject
+
+@property (nonatomic, assign) NSTimeInterval fireTime;
+@property (nonatomic, assign) uint64_t sequence;
+@property (nonatomic, strong) dispatch_queue_t queue;
+@property (nonatomic, copy) dispatch_block_t block;
+
+@end
+
+@implementation HttpdnsVirtualClockTask
+
+@end
+
+@implementation HttpdnsVirtualClock {
+    NSTimeInterval _currentTime;
+    NSTimeInterval _totalSleptInterval;
+    uint64_t _nextSequence;
+    // 按到期时间排序，同时到期的按提交顺序
+    NSMutableArray<HttpdnsVirtualClockTask *> *_tasks;
+}
+
+- (instancetype)init {
+    // SDK会保存上次处理网络变化等时刻，新的时钟从之前走到的最晚时刻之后开始，避免算出负的间隔
+    // 取整到秒，与缓存记录的时间精度一致
+    NSTimeInterval startTime;
+    @synchronized ([HttpdnsVirtualClock class]) {
+        startTime = MAX([[NSDate date] timeIntervalSince1970], sLatestVirtualTime);
+    }
+    return [self initWithStartTime:ceil(startTime)];
+}
+
+- (instancetype)initWithStartTime:(NSTimeInterval)startTime {
+    if (self = [super init]) {
+        _currentTime = startTime;
+        _tasks = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (NSTimeInterval)now {
+    @synchronized (self) {
+        return _currentTime;
+    }
+}
+
+- (void)sleepForTimeInterval:(NSTimeInterval)interval {
+    @synchronized (self) {
+        _totalSleptInterval += interval;
+    }
+}
+
+- (void)dispatchAfter:(NSTimeInterval)delay queue:(dispatch_queue_t)queue block:(dispatch_block_t)block {
+    HttpdnsVirtualClockTask *task = [HttpdnsVirtualClockTask new];
+    task.queue = queue;
+    task.block = block;
+
+    @synchronized (self) {
+        task.fireTime = _currentTime + MAX(delay, 0);
+        task.sequence = _nextSequence++;
+
+        NSUInteger index = [_tasks indexOfObject:task
+                                   inSortedRange:NSMakeRange(0, _tasks.count)
+                                         options:NSBinarySearchingInsertionIndex
+                                 usingComparator:^NSComparisonResult(HttpdnsVirtualClockTask *lhs, HttpdnsVirtualClockTask *rhs) {
+            if (lhs.fireTime != rhs.fireTime) {
+                return lhs.fireTime < rhs.fireTime ? NSOrderedAscending : NSOrderedDescending;
+            }
+            return lhs.sequence < rhs.sequence ? NSOrderedAscending : NSOrderedDescending;
+        }];
+        [_tasks insertObject:task atIndex:index];
+    }
+}
+
+- (NSUInteger)pendingTaskCount {
+    @synchronized (self) {
+        return _tasks.count;
+    }
+}
+
+- (NSTimeInterval)totalSleptInterval {
+    @synchronized (self) {
+        return _totalSleptInterval;
+    }
+}
+
+- (void)advanceBy:(NSTimeInterval)interval {
+    [self advanceTo:[self now] + interval];
+}
+
+- (void)advanceTo:(NSTimeInterval)time {
+    while (YES) {
+        HttpdnsVirtualClockTask *task = nil;
+        @synchronized (self) {
+            HttpdnsVirtualClockTask *firstTask = _tasks.firstObject;
+            if (firstTask && firstTask.fireTime <= time) {
+                task = firstTask;
+                [_tasks removeObjectAtIndex:0];
+                _currentTime = MAX(_currentTime, task.fireTime);
+            } else {
+                _currentTime = MAX(_currentTime, time);
+                [self recordLatestTime:_currentTime];
+                return;
+            }
+        }
+
+        // 任务执行时可能继续提交延迟任务，执行期间不能持有锁
+        dispatch_sync(task.queue, task.block);
+    }
+}
+
+- (void)recordLatestTime:(NSTimeInterval)time {
+    @synchronized ([HttpdnsVirtualClock class]) {
+        sLatestVirtualTime = MAX(sLatestVirtualTime, time);
+    }
+}
+
+- (void)install {
+    HttpdnsClockSetCurrent(self);
+}
+
+- (void)uninstall {
+    if (HttpdnsClockCurrent() == self) {
+        HttpdnsClockSetCurrent(nil);
+    }
+}
+
+@end